@@ -7,6 +7,7 @@ libdrgn bindings
 Don't use this module directly. Instead, use the drgn package.
 """
 
+import array
 import enum
 import os
 import sys
@@ -16,13 +17,17 @@ from typing import (
     Dict,
     Iterable,
     Iterator,
+    List,
     Mapping,
     Optional,
     Sequence,
+    Tuple,
     Union,
     overload,
 )
 
+from _typeshed import SupportsWrite
+
 if sys.version_info < (3, 8):
     from typing_extensions import Protocol
 else:
@@ -57,6 +62,13 @@ class Program:
     The main functionality of a ``Program`` is looking up objects (i.e.,
     variables, constants, or functions). This is usually done with the
     :meth:`[] <.__getitem__>` operator.
+
+    A ``Program`` may be used from multiple threads at once to look up types
+    and objects and to read memory; these release the GIL unless the program
+    has memory segments, finders, or types added from Python. Methods which
+    configure the program (e.g., :meth:`add_memory_segment()`,
+    :meth:`set_core_dump()`, and :meth:`load_debug_info()`) must not be called
+    concurrently with any other method.
     """
 
     def __init__(self, platform: Optional[Platform] = None) -> None:
@@ -89,6 +101,18 @@ class Program:
     this is determined from the language of ``main`` in the program, falling
     back to :attr:`Language.C`. This heuristic may change in the future.
     """
+
+    dedupe_compound_types: bool
+    """
+    Whether to deduplicate structurally equivalent structure, union, and class
+    types from different debugging information files.
+
+    Kernel modules each contain their own copy of common kernel types. If this
+    is ``True``, compound types with the same kind, tag, size, declaration file,
+    and member layout are represented by a single :class:`Type`. This is
+    ``False`` by default and only affects types which are looked up after it is
+    changed.
+    """
     def __getitem__(self, name: str) -> Object:
         """
         Implement ``self[name]``. Get the object (variable, constant, or
@@ -180,6 +204,137 @@ class Program:
             the given file
         """
         ...
+    def eval(self, expr: str) -> Object:
+        """
+        Evaluate an expression in the program's language.
+
+        >>> prog.eval('init_task.tasks.next->prev == &init_task.tasks')
+        Object(prog, 'int', value=1)
+
+        For C, this supports identifiers, integer literals (including the
+        ``U``, ``L``, and ``LL`` suffixes), member access (``.`` and ``->``),
+        subscripts, casts, and the unary, arithmetic, bitwise, comparison, and
+        logical operators. Operators with side effects, like ``++`` and
+        ``--``, are not supported. Unlike :class:`Object` operators, ``.``
+        does not dereference pointers.
+
+        Expressions are compiled the first time they are evaluated and cached
+        by their text, so evaluating the same expression repeatedly is much
+        faster than the equivalent Python code. Identifiers are looked up when
+        the expression is compiled; the cache is cleared when debugging
+        information is loaded or a finder is added. Only the 1024 most
+        recently used expressions are kept compiled, so build expressions that
+        vary (e.g., by address) from a fixed expression and Python operations
+        instead.
+
+        :param expr: Expression to evaluate.
+        :raises SyntaxError: if the expression is invalid
+        :raises LookupError: if an identifier or type name is not found
+        """
+        ...
+    def indexed_types(
+        self,
+        kinds: Optional[Iterable[TypeKind]] = None,
+        module: Optional[str] = None,
+    ) -> Iterator[Type]:
+        """
+        Get all of the named types in the program's debugging information.
+
+        >>> for type in prog.indexed_types({TypeKind.STRUCT}):
+        ...     print(type.tag, type.size)
+
+        The debugging information index is walked in parallel when this is
+        called; each type is parsed as it is yielded. Types are yielded in no
+        particular order, once for each distinct definition. Types in
+        namespaces other than the global namespace and types found by
+        :meth:`add_type_finder()` finders are not included.
+
+        :param kinds: Kinds of types to include. Only integer, boolean,
+            floating-point, structure, union, class, enumerated, and typedef
+            types are indexed by name. If ``None``, all of those kinds are
+            included.
+        :param module: If not ``None``, only include types defined in the
+            module (e.g., kernel module) with this name.
+        """
+        ...
+    def indexed_objects(
+        self,
+        flags: FindObjectFlags = FindObjectFlags.ANY,
+        module: Optional[str] = None,
+    ) -> Iterator[Tuple[str, Object]]:
+        """
+        Get all of the named objects (variables, constants, and functions) in
+        the program's debugging information.
+
+        This is like :meth:`indexed_types()`, but it yields a ``(name,
+        object)`` tuple for each object.
+
+        :param flags: Flags indicating what kinds of objects to include.
+        :param module: If not ``None``, only include objects defined in the
+            module with this name.
+        """
+        ...
+    def accessor(self, type: Union[str, Type], path: str) -> Accessor:
+        """
+        Compile a member access path for objects of the given type.
+
+        The path is parsed and the member offsets are looked up once, so
+        applying the returned :class:`Accessor` only needs to read the pointers
+        along the path. This is much faster than evaluating the path with
+        :meth:`Object.member_()` and :meth:`Object.subscript()` repeatedly.
+
+        >>> next_pid = prog.accessor('struct task_struct *', 'tasks.next->pid')
+        >>> next_pid(task)
+        Object(prog, 'pid_t', address=0xffff8f2d419a57c0)
+
+        :param type: The type that the accessor is applied to, as a
+            :class:`Type` or a type name. If this is a pointer type, the
+            accessor is applied to the pointer value; otherwise, it is applied
+            to the address of an object.
+        :param path: Member access path. This is a sequence of member accesses
+            (``.member`` or ``->member``) and array subscripts with constant
+            indices (``[3]``). The leading ``.`` may be omitted. ``.`` and
+            ``->`` are interchangeable for pointers.
+        :raises LookupError: if a member is not found
+        :raises TypeError: if a member is accessed on a non-structure type or a
+            non-array, non-pointer type is subscripted
+        :raises SyntaxError: if *path* is malformed
+        """
+        ...
+    def columns(
+        self,
+        type: Union[str, Type],
+        paths: Sequence[Union[str, Accessor]],
+        bases: Iterable[Union[Object, IntegerLike]],
+    ) -> List[Union[array.array, List[bytes]]]:
+        """
+        Read several members of many objects into columns.
+
+        This is equivalent to calling :meth:`accessor()` for each path and
+        applying each accessor to each base, but it is done in one pass without
+        creating any intermediate objects. Members which are not behind a
+        pointer are read from each base with a single memory read.
+
+        >>> pids, comms = prog.columns(
+        ...     'struct task_struct *', ['pid', 'comm'], for_each_task(prog)
+        ... )
+        >>> pids[:3]
+        array('q', [1, 2, 3])
+        >>> comms[:3]
+        [b'systemd', b'kthreadd', b'rcu_gp']
+
+        :param type: The type of the bases. See :meth:`accessor()`.
+        :param paths: Member access paths (see :meth:`accessor()`) or
+            precompiled :class:`Accessor` objects.
+        :param bases: Objects or addresses to read from. See
+            :class:`Accessor`.
+        :return: One column per path. Integer, boolean, enumerated, and pointer
+            members are returned as an :class:`array.array` of 64-bit integers
+            (typecode ``'q'`` if signed, ``'Q'`` if unsigned). Other members
+            are returned as a list of the raw bytes of each member, except that
+            character arrays are truncated at the first null byte.
+        """
+        ...
     # address_or_name is positional-only.
     def symbol(self, address_or_name: Union[IntegerLike, str]) -> Symbol:
         """
@@ -417,6 +572,65 @@ class Program:
         This is equivalent to ``load_debug_info(None, True)``.
         """
         ...
+    def prefetch(
+        self,
+        types: Optional[Sequence[str]] = None,
+        objects: Optional[Sequence[str]] = None,
+    ) -> None:
+        """
+        Start parsing types and objects from the loaded debugging information
+        in a background thread.
+
+        This moves the cost of parsing commonly used types off of the critical
+        path of the first lookups. Lookups made while the prefetch is running
+        are safe; they may wait for the type currently being parsed.
+
+        Only debugging information is consulted; finders added with
+        :meth:`add_type_finder()` and :meth:`add_object_finder()` are not
+        called. Names which are not found are ignored. Loading more debugging
+        information stops a running prefetch.
+
+        :param types: Names of types to prefetch. Structure, union, class, and
+            enumerated types are named with their keyword (e.g., ``"struct
+            list_head"``); any other name is looked up as a typedef. If
+            ``None``, a default list of commonly used types is used for the
+            Linux kernel, and nothing is prefetched for other programs.
+        :param objects: Names of objects to prefetch. If ``None``, a default
+            list is used for the Linux kernel like for *types*.
+        """
+        ...
+    def wait_prefetch(self) -> None:
+        """
+        Wait for a prefetch started by :meth:`prefetch()` to finish. This does
+        nothing if no prefetch is running.
+        """
+        ...
+    def load_type_cache(self, path: Path) -> None:
+        """
+        Load a persistent type cache.
+
+        Structure, union, class, and enumerated types found in debugging
+        information are looked up in the cache before their DWARF is parsed.
+        Types are keyed by the build ID of the file containing them, so one
+        cache file can be shared between programs; types from files without a
+        build ID are never cached. Types parsed after this is called are added
+        to the cache, and can be written out with :meth:`save_type_cache()`.
+
+        The cache is not used while :attr:`dedupe_compound_types` is enabled.
+
+        :param path: Path of cache file. If it doesn't exist, an empty cache is
+            used.
+        """
+        ...
+    def save_type_cache(self, path: Path) -> None:
+        """
+        Save the type cache loaded with :meth:`load_type_cache()`. The file is
+        replaced atomically.
+
+        :param path: Path of cache file.
+        :raises ValueError: if no type cache was loaded
+        """
+        ...
     cache: Dict[Any, Any]
     """
     Dictionary for caching program metadata.
@@ -939,6 +1153,16 @@ class Object:
     coerce an object to the appropriate Python type (e.g., :func:`hex()`,
     :func:`round()`, and :meth:`list subscripting <object.__getitem__>`).
 
+    Array, structure, union, and class objects support the :ref:`buffer
+    protocol <python:bufferobjects>`, which exposes the raw bytes of the object
+    as a read-only buffer (e.g., for :class:`memoryview`,
+    :func:`struct.unpack_from()`, or ``numpy.frombuffer()``). The memory of a
+    reference object is read all at once when the buffer is requested, which is
+    much faster than :meth:`value_()` or iterating over a large array:
+
+    >>> bytes(prog['init_task'].comm)
+    b'swapper/0\x00\x00\x00\x00\x00\x00\x00'
+
     Object attributes and methods are named with a trailing underscore to avoid
     conflicting with structure, union, or class members. The attributes and
     methods always take precedence; use :meth:`member_()` if there is a
@@ -1243,6 +1467,38 @@ class Object:
             value (i.e., for C, zero-initialized). Defaults to ``False``.
         """
         ...
+    def print_(
+        self,
+        file: Optional[SupportsWrite[str]] = None,
+        *,
+        columns: Optional[IntegerLike] = None,
+        dereference: Optional[bool] = None,
+        symbolize: Optional[bool] = None,
+        string: Optional[bool] = None,
+        char: Optional[bool] = None,
+        type_name: Optional[bool] = None,
+        member_type_names: Optional[bool] = None,
+        element_type_names: Optional[bool] = None,
+        members_same_line: Optional[bool] = None,
+        elements_same_line: Optional[bool] = None,
+        member_names: Optional[bool] = None,
+        element_indices: Optional[bool] = None,
+        implicit_members: Optional[bool] = None,
+        implicit_elements: Optional[bool] = None,
+    ) -> None:
+        """
+        Format this object and write it to a file, followed by a newline.
+
+        This takes the same options as :meth:`format_()`. Unlike
+        ``print(obj.format_())``, the output is written in pieces as it is
+        formatted instead of being built in memory first, which matters for
+        very large structures and arrays. If an error occurs, some of the
+        output may already have been written.
+
+        :param file: Object with a ``write()`` method taking a :class:`str`.
+            Defaults to :data:`sys.stdout`.
+        """
+        ...
     def __iter__(self) -> Iterator[Object]: ...
     def __bool__(self) -> bool: ...
     def __lt__(self, other: Any) -> bool: ...
@@ -1326,6 +1582,29 @@ def reinterpret(type: Union[str, Type], obj: Object) -> Object:
     """
     ...
 
+def memcmp(lhs: Object, rhs: Object) -> int:
+    """
+    Compare the memory of two structure, union, class, or array objects of
+    the same type.
+
+    Unlike C ``memcmp()``, padding and bits which aren't part of any member or
+    bit field are ignored. The objects are read in bulk, so this is much
+    faster than comparing their members in Python, especially for large
+    arrays.
+
+    >>> memcmp(prog["init_task"].cpus_mask, prog["__cpu_online_mask"])
+    0
+
+    :param lhs: Left hand side.
+    :param rhs: Right hand side.
+    :return: 0 if the objects are equal, -1 if the first differing byte of
+        *lhs* is less than that of *rhs*, and 1 otherwise.
+    :raises TypeError: if either object is not a structure, union, class, or
+        array, or if the objects have different types
+    :raises ValueError: if the objects have different sizes
+    """
+    ...
+
 def container_of(ptr: Object, type: Union[str, Type], member: str) -> Object:
     """
     Get the containing object of a pointer object.
@@ -1345,6 +1624,100 @@ def container_of(ptr: Object, type: Union[str, Type], member: str) -> Object:
     """
     ...
 
+def object_graph(
+    root: Object,
+    max_depth: Optional[IntegerLike] = None,
+    *,
+    types: Optional[Iterable[Union[str, Type]]] = None,
+    members: Optional[Iterable[str]] = None,
+    depth_first: bool = False,
+    paths: bool = True,
+) -> Iterator[Tuple[int, Type, Optional[str]]]:
+    """
+    Iterate over the objects reachable from an object through pointers.
+
+    This visits *root*, then the structures, unions, and classes that its
+    pointer members point to (including pointers in nested structures and
+    arrays), and so on. Each object is visited at most once. Objects which
+    cannot be read are visited, but their pointers are not followed.
+
+    >>> head = prog["init_task"].tasks.address_of_()
+    >>> for address, type, path in object_graph(head, 2, members=["next"]):
+    ...     print(hex(address), type.type_name(), path)
+    ...
+    0xffffffffbe012d38 struct list_head
+    0xffff9b4c80a28a38 struct list_head ->next
+    0xffff9b4c80a2cd78 struct list_head ->next->next
+
+    This is much faster than following pointers in Python.
+
+    :param root: Pointer to a structure, union, or class, or a reference to
+        one. If it is a null pointer, then no objects are visited.
+    :param max_depth: Maximum number of pointers to follow from *root*, or
+        ``None`` for no limit.
+    :param types: Only follow pointers to these types. Structure, union, and
+        class types match types of the same kind with the same tag.
+    :param members: Only follow pointers in members with these names. A pointer
+        in a nested structure or array matches the name of the innermost named
+        member containing it.
+    :param depth_first: Visit objects in depth-first order instead of
+        breadth-first order.
+    :param paths: Return the path of each object. Paths grow with the depth,
+        so pass ``False`` when traversing long chains of objects (e.g., linked
+        lists) and the paths aren't needed.
+    :return: Iterator of (address, type, path) tuples, where path is the chain
+        of pointer members followed from *root*, like ``"->mm->mmap"``, or
+        ``None`` if *paths* is ``False``.
+    """
+    ...
+
+class Accessor:
+    """
+    An ``Accessor`` is a member access path compiled for a given type. It is
+    created with :meth:`Program.accessor()`.
+
+    An accessor is applied to a *base*, which may be an :class:`Object` or an
+    integer address. If the base is a pointer object, its value is used;
+    otherwise, its address is used.
+    """
+
+    prog_: Program
+    """Program that this accessor is from."""
+
+    type_: Type
+    """Type of the result of this accessor."""
+    def __call__(self, base: Union[Object, IntegerLike]) -> Object:
+        """
+        Apply this accessor to a base.
+
+        :return: Reference object.
+        """
+        ...
+    def read(self, base: Union[Object, IntegerLike]) -> int:
+        """
+        Apply this accessor to a base and read the resulting integer. This is
+        equivalent to ``self(base).value_()`` but does not create an
+        intermediate object.
+
+        :raises TypeError: if the result is not an integer type
+        """
+        ...
+    def objects(self, bases: Iterable[Union[Object, IntegerLike]]) -> List[Object]:
+        """
+        Apply this accessor to multiple bases.
+
+        :return: Reference objects, in the same order as *bases*.
+        """
+        ...
+    def values(self, bases: Iterable[Union[Object, IntegerLike]]) -> List[int]:
+        """
+        Apply this accessor to multiple bases and read the resulting integers.
+
+        :return: Values, in the same order as *bases*.
+        :raises TypeError: if the result is not an integer type
+        """
+        ...
+
 class Symbol:
     """
     A ``Symbol`` represents an entry in the symbol table of a program, i.e., an
@@ -1979,6 +2352,46 @@ _with_libkdumpfile: bool
 def _linux_helper_read_vm(
     prog: Program, pgtable: Object, address: IntegerLike, size: IntegerLike
 ) -> bytes: ...
+def _linux_helper_pgtable_ranges(
+    prog: Program,
+    pgtable: Object,
+    start: IntegerLike = 0,
+    end: Optional[IntegerLike] = None,
+) -> Iterator[Tuple[int, int, int, bool, bool, bool, bool]]:
+    """
+    Iterate over the mapped ranges of a page table.
+
+    Contiguous pages with the same attributes are merged.
+
+    :param pgtable: Address of the top-level page table.
+    :param start: First virtual address to include.
+    :param end: Virtual address after the end of the range to include, or
+        ``None`` for the end of the address space.
+    :return: Iterator of (start, size, physical address, writable, user,
+        executable, huge) tuples.
+    """
+    ...
+
+def _linux_helper_write_vm(
+    prog: Program,
+    pgtable: Object,
+    address: IntegerLike,
+    size: IntegerLike,
+    fd: int,
+    offset: IntegerLike,
+) -> int:
+    """
+    Write a range of a virtual address space to a file descriptor at the given
+    offset, reading physical memory in bounded chunks.
+
+    Pages which are not mapped or not in the core dump are skipped, leaving
+    holes in the file.
+
+    :param pgtable: Address of the top-level page table.
+    :return: Number of bytes which were read and written.
+    """
+    ...
+
 def _linux_helper_radix_tree_lookup(root: Object, index: IntegerLike) -> Object:
     """
     Look up the entry at a given index in a radix tree.
@@ -1989,6 +2402,19 @@ def _linux_helper_radix_tree_lookup(root: Object, index: IntegerLike) -> Object:
     """
     ...
 
+def _linux_helper_radix_tree_for_each(root: Object) -> Iterator[Tuple[int, Object]]:
+    """
+    Iterate over all of the entries in a radix tree or XArray in index order.
+
+    Each node's slots are read at once and empty slots are skipped without
+    creating objects. Sibling, retry, and zero entries are skipped.
+
+    :param root: ``struct radix_tree_root *`` or ``struct xarray *``
+    :return: Iterator of (index, ``void *``) tuples.
+    :raises ValueError: if a node's shift doesn't decrease from its parent's
+    """
+    ...
+
 def _linux_helper_idr_find(idr: Object, id: IntegerLike) -> Object:
     """
     Look up the entry with the given ID in an IDR.
@@ -2011,6 +2437,37 @@ def _linux_helper_find_pid(
     """
     ...
 
+def _linux_helper_for_each_pid(
+    prog_or_ns: Union[Program, Object]
+) -> Iterator[Object]:
+    """
+    Iterate over all of the PIDs in a namespace.
+
+    This walks the namespace's IDR or, before Linux v4.15, the global PID hash
+    table in a single native loop.
+
+    :param prog_or_ns: ``struct pid_namespace *`` object, or :class:`Program`
+        to use initial PID namespace.
+    :return: Iterator of ``struct pid *`` objects.
+    """
+    ...
+
+def _linux_helper_for_each_task(
+    prog_or_ns: Union[Program, Object]
+) -> Iterator[Object]:
+    """
+    Iterate over all of the tasks visible in a namespace.
+
+    This is equivalent to calling :func:`_linux_helper_pid_task()` with
+    ``PIDTYPE_PID`` on each PID from :func:`_linux_helper_for_each_pid()` and
+    skipping PIDs without a task, but it is done natively.
+
+    :param prog_or_ns: ``struct pid_namespace *`` object, or :class:`Program`
+        to use initial PID namespace.
+    :return: Iterator of ``struct task_struct *`` objects.
+    """
+    ...
+
 def _linux_helper_pid_task(pid: Object, pid_type: IntegerLike) -> Object:
     """
     Return the ``struct task_struct *`` containing the given ``struct pid *``
@@ -2034,6 +2491,185 @@ def _linux_helper_find_task(
     """
     ...
 
+def _linux_helper_page_stats(
+    prog: Program, start_pfn: IntegerLike = 0, end_pfn: Optional[IntegerLike] = None
+) -> Tuple[int, Tuple[int, ...], Tuple[int, ...]]:
+    """
+    Count the pages in a range of page frame numbers by flag and by mapping
+    type. See :func:`drgn.helpers.linux.mm.page_stats()`.
+
+    :param start_pfn: First page frame number in the range.
+    :param end_pfn: Page frame number after the end of the range. Defaults to
+        ``max_pfn``.
+    :return: Tuple of the number of pages, the number of pages with each bit
+        in ``enum pageflags`` set, and the number of pages with each mapping
+        type (no mapping, file, anonymous, movable, KSM, and compound tail).
+    """
+    ...
+
+def _linux_helper_for_each_page(
+    prog: Program,
+    start_pfn: IntegerLike = 0,
+    end_pfn: Optional[IntegerLike] = None,
+    *,
+    flags_mask: IntegerLike = 0,
+    flags_value: IntegerLike = 0,
+) -> Iterator[Object]:
+    """
+    Iterate over the pages in a range of page frame numbers for which
+    ``(page->flags & flags_mask) == flags_value``. See
+    :func:`drgn.helpers.linux.mm.for_each_page_with_flags()`.
+
+    :param start_pfn: First page frame number in the range.
+    :param end_pfn: Page frame number after the end of the range. Defaults to
+        ``max_pfn``.
+    :return: Iterator of ``struct page *`` objects.
+    """
+    ...
+
+def _linux_helper_slab_for_each_object(
+    prog: Program,
+    cache: Optional[IntegerLike] = None,
+    *,
+    allocated: bool = True,
+    free: bool = False,
+) -> Iterator[Tuple[int, int, bool]]:
+    """
+    Iterate over the objects in SLUB caches. See
+    :func:`drgn.helpers.linux.slab.slab_cache_for_each_allocated_object()`.
+
+    :param cache: Address of the ``struct kmem_cache`` to iterate over.
+        Defaults to all caches.
+    :param allocated: Whether to include allocated objects.
+    :param free: Whether to include free objects.
+    :return: Iterator of (address of ``struct kmem_cache``, address of object,
+        whether the object is allocated) tuples.
+    """
+    ...
+
+def _linux_helper_slab_object_info(
+    prog: Program, address: IntegerLike
+) -> Optional[Tuple[int, int, int, bool]]:
+    """
+    Find the SLUB object containing an address. See
+    :func:`drgn.helpers.linux.slab.slab_object_info()`.
+
+    :return: (address of ``struct kmem_cache``, address of the ``struct page``
+        of the slab, address of the object, whether the object is allocated)
+        tuple, or ``None`` if the address is not in a slab object.
+    """
+    ...
+
+def _linux_helper_per_cpu_ptr(ptr: Object, cpu: IntegerLike) -> Object:
+    """
+    Return the per-CPU pointer for a given CPU.
+
+    >>> prog["init_net"].loopback_dev.pcpu_refcnt
+    (int *)0x2c980
+    >>> per_cpu_ptr(prog["init_net"].loopback_dev.pcpu_refcnt, 7)
+    *(int *)0xffff925e3ddec980 = 4
+
+    :param ptr: Per-CPU pointer, i.e., ``type __percpu *``. For global
+        variables, it's usually easier to use :func:`per_cpu()`.
+    :param cpu: CPU number.
+    :return: ``type *`` object.
+    """
+    ...
+
+def _linux_helper_per_cpu_values(
+    ptr: Object, member: Optional[str] = None, *, online: bool = False
+) -> Dict[int, Object]:
+    """
+    Return the value of a per-CPU pointer on every CPU.
+
+    >>> per_cpu_values(prog["runqueues"].address_of_(), "nr_running")
+    {0: (unsigned int)1, 1: (unsigned int)0, 2: (unsigned int)3, 3: (unsigned int)0}
+
+    :param ptr: Per-CPU pointer, i.e., ``type __percpu *``.
+    :param member: Member designator within ``type`` to get instead of the
+        whole value, e.g., ``"stats.rx_packets"`` or ``"counts[1]"``.
+    :param online: Only include online CPUs instead of all possible CPUs.
+    :return: Dictionary from CPU number to ``type`` (or member type) value
+        object.
+    """
+    ...
+
+def _linux_helper_per_cpu_sum(
+    ptr: Object, member: Optional[str] = None, *, online: bool = False
+) -> int:
+    """
+    Return the sum of an integer per-CPU pointer on every CPU.
+
+    >>> per_cpu_sum(prog["runqueues"].address_of_(), "nr_running")
+    4
+
+    :param ptr: Per-CPU pointer, i.e., ``type __percpu *``.
+    :param member: Member designator within ``type`` to sum instead of the
+        whole value. See :func:`per_cpu_values()`.
+    :param online: Only include online CPUs instead of all possible CPUs.
+    """
+    ...
+
+def _linux_helper_percpu_counter_sum(fbc: Object) -> int:
+    """
+    Return the sum of a per-CPU counter.
+
+    :param fbc: ``struct percpu_counter *``
+    """
+    ...
+
+def _linux_helper_d_path(vfsmnt: Object, dentry: Object) -> bytes:
+    """
+    Return the full path of a dentry given a mount and dentry.
+
+    Paths are memoized by mount and dentry, so paths with a common prefix only
+    read the prefix once. For a core dump, this is remembered for the lifetime
+    of the program. For a live kernel, it is only remembered for one call.
+
+    :param vfsmnt: ``struct vfsmount *``
+    :param dentry: ``struct dentry *``
+    """
+    ...
+
+def _linux_helper_dentry_path(dentry: Object) -> bytes:
+    """
+    Return the path of a dentry from the root of its filesystem. Paths are
+    memoized like :func:`_linux_helper_d_path()`.
+
+    :param dentry: ``struct dentry *``
+    """
+    ...
+
+def _linux_helper_for_each_open_file(
+    prog: Program, *, fds: bool = True, mappings: bool = True
+) -> Iterator[Tuple[Any, ...]]:
+    """
+    Iterate over the open files and memory mappings of every task.
+
+    Open file descriptors are returned as ``(pid, comm, task, fd, file,
+    path)`` tuples. Memory mappings are returned as ``(pid, comm, task, vma,
+    start, end, flags, pgoff, file, path)`` tuples, where ``file`` is 0 and
+    ``path`` is ``None`` for an anonymous mapping. Addresses are returned as
+    integers.
+
+    :param fds: Include open file descriptors.
+    :param mappings: Include memory mappings.
+    """
+    ...
+
+def _linux_helper_for_each_vma(mm: Object) -> Iterator[Object]:
+    """
+    Iterate over the memory mappings of an address space in address order.
+
+    This walks the maple tree ``mm->mm_mt`` or, before Linux 6.1, the
+    red-black tree ``mm->mm_rb``.
+
+    :param mm: ``struct mm_struct *``
+    :return: Iterator of ``struct vm_area_struct *`` objects.
+    :raises ValueError: if the tree is corrupted
+    """
+    ...
+
 def _linux_helper_kaslr_offset(prog: Program) -> int:
     """
     Get the kernel address space layout randomization offset (zero if it is
@@ -2044,3 +2680,65 @@ def _linux_helper_kaslr_offset(prog: Program) -> int:
 def _linux_helper_pgtable_l5_enabled(prog: Program) -> bool:
     """Return whether 5-level paging is enabled."""
     ...
+def _linux_helper_list_for_each_entry(
+    type: Union[str, Type, None],
+    head: Object,
+    member: Optional[str],
+    *,
+    reverse: bool = False,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
+) -> Iterator[Object]:
+    """
+    Iterate over the entries in a ``struct list_head`` list.
+
+    :param type: Entry type, or ``None`` to return the ``struct list_head *``
+        nodes.
+    :param head: ``struct list_head *``
+    :param member: Name of list node member in entry type.
+    :param reverse: Whether to iterate in reverse order.
+    :param max_length: Maximum number of entries, or ``None`` for no limit.
+    :param validate: Whether to check for cycles.
+    """
+    ...
+
+def _linux_helper_hlist_for_each_entry(
+    type: Union[str, Type, None],
+    head: Object,
+    member: Optional[str],
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
+) -> Iterator[Object]:
+    """
+    Iterate over the entries in a ``struct hlist_head`` hash list.
+
+    :param type: Entry type, or ``None`` to return the ``struct hlist_node *``
+        nodes.
+    :param head: ``struct hlist_head *``
+    :param member: Name of list node member in entry type.
+    :param max_length: Maximum number of entries, or ``None`` for no limit.
+    :param validate: Whether to check for cycles.
+    """
+    ...
+
+def _linux_helper_rbtree_inorder_for_each_entry(
+    type: Union[str, Type, None],
+    root: Object,
+    member: Optional[str],
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
+) -> Iterator[Object]:
+    """
+    Iterate over the entries in a red-black tree in sorted order.
+
+    :param type: Entry type, or ``None`` to return the ``struct rb_node *``
+        nodes.
+    :param root: ``struct rb_root *``
+    :param member: Name of red-black node member in entry type.
+    :param max_length: Maximum number of nodes, or ``None`` for no limit.
+    :param validate: Whether to check parent pointers and the depth of the
+        tree.
+    """
+    ...
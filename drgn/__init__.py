@@ -40,13 +40,20 @@ that package should be considered implementation details and should not
 be used.
 """
 
+import collections.abc
 import io
+import itertools
+import os
+import pickle
 import pkgutil
+import signal
 import sys
 import types
+from typing import Callable, Iterable, Iterator, List, Optional, TypeVar
 
 from _drgn import (
     NULL,
+    Accessor,
     Architecture,
     FaultError,
     FindObjectFlags,
@@ -78,6 +85,8 @@ from _drgn import (
     container_of,
     filename_matches,
     host_platform,
+    memcmp,
+    object_graph,
     offsetof,
     program_from_core_dump,
     program_from_kernel,
@@ -88,6 +97,7 @@ from _drgn import (
 from drgn.internal.version import __version__ as __version__
 
 __all__ = (
+    "Accessor",
     "Architecture",
     "FaultError",
     "FindObjectFlags",
@@ -120,7 +130,10 @@ __all__ = (
     "execscript",
     "filename_matches",
     "host_platform",
+    "memcmp",
+    "object_graph",
     "offsetof",
+    "parallel_map",
     "program_from_core_dump",
     "program_from_kernel",
     "program_from_pid",
@@ -242,3 +255,173 @@ def execscript(path: str, *args: str) -> None:
             sys.modules["__main__"] = saved_module[0]
         else:
             del sys.modules["__main__"]
+
+
+_T = TypeVar("_T")
+_U = TypeVar("_U")
+
+
+def _parallel_map_worker(
+    func: Callable[[_T], _U],
+    iterable: Iterable[_T],
+    chunksize: int,
+    worker: int,
+    workers: int,
+    fd: int,
+) -> None:
+    chunks: Iterable[Iterable[_T]]
+    if isinstance(iterable, collections.abc.Sequence):
+        # Only look at this worker's chunks.
+        chunks = (
+            iterable[start : start + chunksize]
+            for start in range(worker * chunksize, len(iterable), workers * chunksize)
+        )
+    else:
+        it = iter(iterable)
+        chunks = (
+            chunk
+            for i, chunk in enumerate(
+                iter(lambda: list(itertools.islice(it, chunksize)), [])
+            )
+            if i % workers == worker
+        )
+    with os.fdopen(fd, "wb") as f:
+        for chunk in chunks:
+            try:
+                results: object = [func(item) for item in chunk]
+                ok = True
+            except Exception as e:
+                results = e
+                ok = False
+            try:
+                data = pickle.dumps((ok, results))
+            except Exception as e:
+                if not ok:
+                    raise
+                data = pickle.dumps((False, e))
+            f.write(data)
+            f.flush()
+            if not ok:
+                break
+
+
+def parallel_map(
+    prog: Program,
+    func: Callable[[_T], _U],
+    iterable: Iterable[_T],
+    workers: Optional[int] = None,
+    chunksize: int = 64,
+) -> Iterator[_U]:
+    """
+    Call a function on every item of an iterable using multiple processes.
+
+    This is like the builtin :func:`map()`, but it forks worker processes
+    which share everything already loaded in the program (debugging
+    information, caches, and core dump mappings) copy-on-write. It should
+    therefore be called after loading debugging information.
+
+    >>> def comm(task):
+    ...     return task.comm.string_()
+    ...
+    >>> comms = list(parallel_map(prog, comm, for_each_task(prog)))
+
+    Every worker calls *func* on every *workers*-th chunk of *chunksize*
+    items, so items don't need to be picklable. If *iterable* is a sequence
+    (e.g., a :class:`range` or :class:`list`), each worker slices out its own
+    chunks. Otherwise, every worker iterates over all of *iterable* and skips
+    the other workers' chunks, so it must yield the same items in every
+    worker, and the iteration itself is not parallelized. To parallelize an
+    expensive iteration, partition it at the source and map over the
+    partitions instead:
+
+    >>> def count_slab_pages(pfns):
+    ...     return sum(1 for _ in for_each_page_with_flags(
+    ...         prog, ["PG_slab"], start_pfn=pfns.start, end_pfn=pfns.stop))
+    ...
+    >>> max_pfn = prog["max_pfn"].value_()
+    >>> step = 1 << 18
+    >>> ranges = [range(pfn, min(pfn + step, max_pfn))
+    ...           for pfn in range(0, max_pfn, step)]
+    >>> sum(parallel_map(prog, count_slab_pages, ranges, chunksize=1))
+    53811
+
+    The results are pickled and returned in order. If *func* raises an
+    exception, it is raised from the returned iterator.
+
+    Worker processes are forked when the returned iterator is first advanced
+    and killed when it is exhausted or closed.
+
+    :param prog: Program that *func* and *iterable* use.
+    :param func: Function to call on each item.
+    :param iterable: Items to map.
+    :param workers: Number of worker processes. Defaults to the number of
+        CPUs.
+    :param chunksize: Number of items processed together by a worker.
+    """
+    if workers is None:
+        workers = os.cpu_count() or 1
+    if workers < 1:
+        raise ValueError("workers must be positive")
+    if chunksize < 1:
+        raise ValueError("chunksize must be positive")
+    # Don't fork while the prefetch thread may be holding locks.
+    prog.wait_prefetch()
+    sys.stdout.flush()
+    sys.stderr.flush()
+
+    pipes = [os.pipe() for _ in range(workers)]
+    pids: List[int] = []
+    files = []
+    try:
+        for worker in range(workers):
+            pid = os.fork()
+            if pid == 0:
+                status = 0
+                try:
+                    for i, (r, w) in enumerate(pipes):
+                        os.close(r)
+                        if i != worker:
+                            os.close(w)
+                    _parallel_map_worker(
+                        func, iterable, chunksize, worker, workers, pipes[worker][1]
+                    )
+                    sys.stdout.flush()
+                    sys.stderr.flush()
+                except BaseException:
+                    status = 1
+                finally:
+                    os._exit(status)
+            pids.append(pid)
+        for r, w in pipes:
+            os.close(w)
+            files.append(os.fdopen(r, "rb"))
+        pipes = []
+
+        for i in itertools.count():
+            worker = i % workers
+            try:
+                ok, results = pickle.load(files[worker])
+            except EOFError:
+                _, status = os.waitpid(pids[worker], 0)
+                pids[worker] = 0
+                if status != 0:
+                    raise ChildProcessError(
+                        f"parallel_map worker exited with status {status}"
+                    )
+                return
+            if not ok:
+                raise results
+            yield from results
+    finally:
+        for r, w in pipes:
+            os.close(r)
+            os.close(w)
+        for f in files:
+            f.close()
+        for pid in pids:
+            if pid:
+                try:
+                    os.kill(pid, signal.SIGKILL)
+                except ProcessLookupError:
+                    pass
+                os.waitpid(pid, 0)
@@ -0,0 +1,307 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+"""
+Core Dumps
+----------
+
+The ``drgn.helpers.linux.coredump`` module provides helpers for extracting a
+core dump of a user process from the kernel, e.g., to debug a process which
+was running when the kernel crashed with gdb. Only x86-64 is currently
+supported.
+"""
+
+import struct
+from typing import Iterator, List, NamedTuple, Optional
+
+from _drgn import _linux_helper_write_vm
+from drgn import Architecture, FaultError, Object, Path, sizeof
+from drgn.helpers.linux.fs import d_path
+from drgn.helpers.linux.list import list_for_each_entry
+from drgn.helpers.linux.mm import cmdline, for_each_vma
+
+__all__ = ("write_process_core",)
+
+
+_PAGE_SIZE = 4096
+
+_NT_PRSTATUS = 1
+_NT_PRPSINFO = 3
+_NT_AUXV = 6
+_NT_FILE = 0x46494C45
+
+_PT_LOAD = 1
+_PT_NOTE = 4
+
+_PF_X = 0x1
+_PF_W = 0x2
+_PF_R = 0x4
+
+_VM_READ = 0x1
+_VM_WRITE = 0x2
+_VM_EXEC = 0x4
+_VM_IO = 0x4000
+_VM_DONTDUMP = 0x4000000
+
+_ELF_HEADER = struct.Struct("<16sHHIQQQIHHHHHH")
+_PROGRAM_HEADER = struct.Struct("<IIQQQQQQ")
+# struct elf_prstatus up to pr_reg, then pr_reg (27 registers) and pr_fpvalid.
+_PRSTATUS = struct.Struct("<3ih2xQQ4i64x27Qi4x")
+_PRPSINFO = struct.Struct("<4b4xQ2I4i16s80s")
+
+
+class _Mapping(NamedTuple):
+    start: int
+    end: int
+    flags: int
+    pgoff: int
+    path: Optional[bytes]
+    dump: bool
+
+
+def _note(type: int, desc: bytes) -> bytes:
+    name = b"CORE\0"
+    return b"".join(
+        (
+            struct.pack("<3I", len(name), len(desc), type),
+            name,
+            bytes(-len(name) % 4),
+            desc,
+            bytes(-len(desc) % 4),
+        )
+    )
+
+
+def _thread_group(task: Object) -> Iterator[Object]:
+    try:
+        thread_head = task.signal.thread_head
+    except AttributeError:
+        # Before Linux kernel commit 0c740d0afc3b ("introduce
+        # for_each_thread() to replace the buggy while_each_thread()") (in
+        # v3.14), the thread group is only linked through thread_group.
+        leader = task.group_leader.read_()
+        yield leader
+        yield from list_for_each_entry(
+            "struct task_struct", leader.thread_group.address_of_(), "thread_group"
+        )
+    else:
+        yield from list_for_each_entry(
+            "struct task_struct", thread_head.address_of_(), "thread_node"
+        )
+
+
+def _thread_member(thread: Object, *names: str) -> int:
+    # The thread_struct member names have changed over time.
+    for name in names:
+        try:
+            return thread.member_(name).value_()
+        except LookupError:
+            pass
+    return 0
+
+
+def _prstatus(task: Object) -> bytes:
+    prog = task.prog_
+    thread_size = sizeof(prog.type("union thread_union"))
+    pt_regs_size = sizeof(prog.type("struct pt_regs"))
+    # task_pt_regs(): the user registers are saved at the top of the stack.
+    pt_regs = task.stack.value_() + thread_size - pt_regs_size
+    # The beginning of the kernel's struct pt_regs has the same layout as
+    # user_regs_struct.
+    regs = list(struct.unpack_from("<21Q", prog.read(pt_regs, 21 * 8)))
+    thread = task.thread
+    regs.append(_thread_member(thread, "fsbase", "fs"))
+    regs.append(_thread_member(thread, "gsbase", "gs"))
+    regs.append(_thread_member(thread, "ds"))
+    regs.append(_thread_member(thread, "es"))
+    regs.append(_thread_member(thread, "fsindex"))
+    regs.append(_thread_member(thread, "gsindex"))
+    return _PRSTATUS.pack(
+        0,  # si_signo
+        0,  # si_code
+        0,  # si_errno
+        0,  # pr_cursig
+        0,  # pr_sigpend
+        0,  # pr_sighold
+        task.pid.value_(),
+        task.real_parent.tgid.value_(),
+        0,  # pr_pgrp
+        0,  # pr_sid
+        *regs,
+        0,  # pr_fpvalid
+    )
+
+
+def _prpsinfo(task: Object) -> bytes:
+    # Like the kernel, describe the process by its thread group leader.
+    task = task.group_leader.read_()
+    try:
+        psargs = b" ".join(cmdline(task))
+    except FaultError:
+        psargs = b""
+    return _PRPSINFO.pack(
+        0,  # pr_state
+        0,  # pr_sname
+        0,  # pr_zomb
+        0,  # pr_nice
+        0,  # pr_flag
+        0,  # pr_uid
+        0,  # pr_gid
+        task.tgid.value_(),
+        task.real_parent.tgid.value_(),
+        0,  # pr_pgrp
+        0,  # pr_sid
+        task.comm.string_(),
+        psargs[:79],
+    )
+
+
+def _auxv(mm: Object) -> bytes:
+    auxv = mm.saved_auxv
+    buf = mm.prog_.read(auxv.address_, sizeof(auxv))
+    # Stop after the AT_NULL entry.
+    for i in range(0, len(buf), 16):
+        if struct.unpack_from("<Q", buf, i)[0] == 0:
+            return buf[: i + 16]
+    return buf
+
+
+def _nt_file(mappings: List[_Mapping]) -> bytes:
+    files = [mapping for mapping in mappings if mapping.path is not None]
+    desc = [struct.pack("<QQ", len(files), _PAGE_SIZE)]
+    desc.extend(struct.pack("<3Q", file.start, file.end, file.pgoff) for file in files)
+    desc.extend(file.path + b"\0" for file in files)  # type: ignore[operator]
+    return b"".join(desc)
+
+
+def _mappings(mm: Object) -> List[_Mapping]:
+    mappings = []
+    for vma in for_each_vma(mm):
+        vm_flags = vma.vm_flags.value_()
+        flags = 0
+        if vm_flags & _VM_READ:
+            flags |= _PF_R
+        if vm_flags & _VM_WRITE:
+            flags |= _PF_W
+        if vm_flags & _VM_EXEC:
+            flags |= _PF_X
+        file = vma.vm_file.read_()
+        mappings.append(
+            _Mapping(
+                vma.vm_start.value_(),
+                vma.vm_end.value_(),
+                flags,
+                vma.vm_pgoff.value_(),
+                d_path(file.f_path) if file else None,
+                not (vm_flags & (_VM_IO | _VM_DONTDUMP)),
+            )
+        )
+    return mappings
+
+
+def write_process_core(task: Object, path: Path) -> int:
+    """
+    Write an ELF core dump of the user process that a task belongs to, which
+    can be debugged with gdb.
+
+    The core dump contains every memory mapping of the process, a
+    ``NT_PRSTATUS`` note for each thread with the registers saved on entry to
+    the kernel, and the process's auxiliary vector and mapped files. The given
+    task is the first thread.
+
+    Memory is read directly from the page tables and copied to the file in
+    bounded chunks, so large processes can be dumped. Pages which are not
+    present (e.g., never faulted in or swapped out) or which are missing from
+    the kernel core dump are left as zeros.
+
+    >>> write_process_core(find_task(prog, 1490152), "core.1490152")
+    28672000
+
+    .. code-block:: console
+
+        $ gdb /usr/bin/myprog core.1490152
+
+    :param task: ``struct task_struct *``
+    :param path: Path of the core dump to write.
+    :return: Number of bytes of memory which were present and written.
+    :raises ValueError: if the program is not x86-64 or the task has no
+        address space (i.e., it is a kernel thread)
+    """
+    prog = task.prog_
+    if prog.platform is None or prog.platform.arch != Architecture.X86_64:
+        raise ValueError("process core dumps are only supported on x86-64")
+    task = task.read_()
+    mm = task.mm.read_()
+    if not mm:
+        raise ValueError("task has no address space")
+
+    mappings = _mappings(mm)
+    threads = [task]
+    threads.extend(
+        thread for thread in _thread_group(task) if thread.value_() != task.value_()
+    )
+    notes = b"".join(
+        [_note(_NT_PRSTATUS, _prstatus(thread)) for thread in threads]
+        + [
+            _note(_NT_PRPSINFO, _prpsinfo(task)),
+            _note(_NT_AUXV, _auxv(mm)),
+            _note(_NT_FILE, _nt_file(mappings)),
+        ]
+    )
+
+    phnum = 1 + len(mappings)
+    notes_offset = _ELF_HEADER.size + phnum * _PROGRAM_HEADER.size
+    offset = -(-(notes_offset + len(notes)) // _PAGE_SIZE) * _PAGE_SIZE
+    headers = [
+        _ELF_HEADER.pack(
+            b"\x7fELF\x02\x01\x01",  # ELFCLASS64, ELFDATA2LSB, EV_CURRENT
+            4,  # e_type = ET_CORE
+            62,  # e_machine = EM_X86_64
+            1,  # e_version = EV_CURRENT
+            0,  # e_entry
+            _ELF_HEADER.size,  # e_phoff
+            0,  # e_shoff
+            0,  # e_flags
+            _ELF_HEADER.size,  # e_ehsize
+            _PROGRAM_HEADER.size,  # e_phentsize
+            phnum,  # e_phnum
+            0,  # e_shentsize
+            0,  # e_shnum
+            0,  # e_shstrndx
+        ),
+        _PROGRAM_HEADER.pack(
+            _PT_NOTE, 0, notes_offset, 0, 0, len(notes), len(notes), 4
+        ),
+    ]
+    segments = []
+    for mapping in mappings:
+        size = mapping.end - mapping.start
+        filesz = size if mapping.dump else 0
+        headers.append(
+            _PROGRAM_HEADER.pack(
+                _PT_LOAD,
+                mapping.flags,
+                offset,
+                mapping.start,
+                0,  # p_paddr
+                filesz,
+                size,
+                _PAGE_SIZE,
+            )
+        )
+        if filesz:
+            segments.append((mapping.start, filesz, offset))
+        offset += filesz
+    headers.append(notes)
+
+    written = 0
+    with open(path, "wb") as f:
+        f.write(b"".join(headers))
+        f.flush()
+        for start, size, file_offset in segments:
+            written += _linux_helper_write_vm(
+                prog, mm.pgd, start, size, f.fileno(), file_offset
+            )
+        # Pages which weren't written are holes.
+        f.truncate(offset)
+    return written
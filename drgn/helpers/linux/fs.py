@@ -7,11 +7,20 @@ Virtual Filesystem Layer
 
 The ``drgn.helpers.linux.fs`` module provides helpers for working with the
 Linux virtual filesystem (VFS) layer, including mounts, dentries, and inodes.
+
+Paths are built in C and memoized by mount and dentry, so listing many paths
+with a common prefix only reads the prefix once. For a core dump, paths are
+remembered for the lifetime of the program.
 """
 
 import os
-from typing import Iterator, Optional, Tuple, Union, overload
+from typing import Iterator, NamedTuple, Optional, Tuple, Union, overload
 
+from _drgn import (
+    _linux_helper_d_path,
+    _linux_helper_dentry_path,
+    _linux_helper_for_each_open_file,
+)
 from drgn import IntegerLike, Object, Path, Program, container_of, sizeof
 from drgn.helpers import escape_ascii_string
 from drgn.helpers.linux.list import (
@@ -35,6 +44,10 @@ __all__ = (
     "fget",
     "for_each_file",
     "print_files",
+    "TaskFile",
+    "TaskMapping",
+    "for_each_open_file",
+    "print_open_files",
 )
 
 
@@ -155,36 +168,9 @@ def d_path(  # type: ignore  # Need positional-only arguments.
     path_or_vfsmnt: Object, dentry: Optional[Object] = None
 ) -> bytes:
     if dentry is None:
-        vfsmnt = path_or_vfsmnt.mnt
-        dentry = path_or_vfsmnt.dentry.read_()
-    else:
-        vfsmnt = path_or_vfsmnt
-        dentry = dentry.read_()
-    mnt = container_of(vfsmnt, "struct mount", "mnt")
-
-    d_op = dentry.d_op.read_()
-    if d_op and d_op.d_dname:
-        return b"[" + dentry.d_inode.i_sb.s_type.name.string_() + b"]"
-
-    components = []
-    while True:
-        if dentry == mnt.mnt.mnt_root:
-            mnt_parent = mnt.mnt_parent.read_()
-            if mnt == mnt_parent:
-                break
-            dentry = mnt.mnt_mountpoint.read_()
-            mnt = mnt_parent
-            continue
-        d_parent = dentry.d_parent.read_()
-        if dentry == d_parent:
-            break
-        components.append(dentry.d_name.name.string_())
-        components.append(b"/")
-        dentry = d_parent
-    if components:
-        return b"".join(reversed(components))
+        return _linux_helper_d_path(path_or_vfsmnt.mnt, path_or_vfsmnt.dentry)
     else:
-        return b"/"
+        return _linux_helper_d_path(path_or_vfsmnt, dentry)
 
 
 def dentry_path(dentry: Object) -> bytes:
@@ -193,14 +179,7 @@ def dentry_path(dentry: Object) -> bytes:
 
     :param dentry: ``struct dentry *``
     """
-    components = []
-    while True:
-        d_parent = dentry.d_parent.read_()
-        if dentry == d_parent:
-            break
-        components.append(dentry.d_name.name.string_())
-        dentry = d_parent
-    return b"/".join(reversed(components))
+    return _linux_helper_dentry_path(dentry)
 
 
 def inode_path(inode: Object) -> Optional[bytes]:
@@ -360,3 +339,85 @@ def print_files(task: Object) -> None:
         path = d_path(file.f_path)
         escaped_path = escape_ascii_string(path, escape_backslash=True)
         print(f"{fd} {escaped_path} ({file.type_.type_name()})0x{file.value_():x}")
+
+
+class TaskFile(NamedTuple):
+    """
+    Open file descriptor returned by :func:`for_each_open_file()`.
+
+    ``task`` and ``file`` are the addresses of the ``struct task_struct`` and
+    ``struct file``.
+    """
+
+    pid: int
+    comm: bytes
+    task: int
+    fd: int
+    file: int
+    path: bytes
+
+
+class TaskMapping(NamedTuple):
+    """
+    Memory mapping returned by :func:`for_each_open_file()`.
+
+    ``task``, ``vma``, and ``file`` are the addresses of the ``struct
+    task_struct``, ``struct vm_area_struct``, and ``struct file``. ``file`` is
+    0 and ``path`` is ``None`` for an anonymous mapping.
+    """
+
+    pid: int
+    comm: bytes
+    task: int
+    vma: int
+    start: int
+    end: int
+    flags: int
+    pgoff: int
+    file: int
+    path: Optional[bytes]
+
+
+def for_each_open_file(
+    prog: Program, *, fds: bool = True, mappings: bool = True
+) -> Iterator[Union[TaskFile, TaskMapping]]:
+    """
+    Iterate over the open files and memory mappings of every task in the
+    system, like ``lsof``.
+
+    This is implemented in C and returns plain records rather than objects, so
+    it is much faster than combining :func:`~drgn.helpers.linux.pid.for_each_task()`
+    and :func:`for_each_file()`. Paths are shared between files with the same
+    prefix. Tasks which share a file descriptor table or address space with a
+    task which was already returned (e.g., threads) are skipped.
+
+    >>> for f in for_each_open_file(prog, mappings=False):
+    ...     print(f.pid, f.fd, f.path)
+    1 0 b'/dev/null'
+    ...
+
+    :param fds: Include open file descriptors.
+    :param mappings: Include memory mappings (``struct vm_area_struct``).
+    """
+    for record in _linux_helper_for_each_open_file(prog, fds=fds, mappings=mappings):
+        if len(record) == len(TaskFile._fields):
+            yield TaskFile._make(record)
+        else:
+            yield TaskMapping._make(record)
+
+
+def print_open_files(prog: Program) -> None:
+    """
+    Print the open files and file mappings of every task in the system. The
+    output format is similar to ``lsof``.
+    """
+    for record in for_each_open_file(prog):
+        if isinstance(record, TaskFile):
+            fd = str(record.fd)
+        elif record.path is not None:
+            fd = "mem"
+        else:
+            continue
+        comm = escape_ascii_string(record.comm, escape_backslash=True)
+        path = escape_ascii_string(record.path, escape_backslash=True)
+        print(f"{comm} {record.pid} {fd} {path}")
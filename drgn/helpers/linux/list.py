@@ -10,9 +10,13 @@ doubly-linked list implementations (``struct list_head`` and ``struct
 hlist_head``) in :linux:`include/linux/list.h`.
 """
 
-from typing import Iterator, Union
+from typing import Iterator, Optional, Union
 
-from drgn import NULL, Object, Type, container_of
+from _drgn import (
+    _linux_helper_hlist_for_each_entry,
+    _linux_helper_list_for_each_entry,
+)
+from drgn import NULL, IntegerLike, Object, Type, container_of
 
 __all__ = (
     "hlist_empty",
@@ -128,49 +132,89 @@ def list_prev_entry(pos: Object, member: str) -> Object:
     return container_of(getattr(pos, member).prev, pos.type_.type, member)
 
 
-def list_for_each(head: Object) -> Iterator[Object]:
+def list_for_each(
+    head: Object,
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
+) -> Iterator[Object]:
     """
     Iterate over all of the nodes in a list.
 
     :param head: ``struct list_head *``
+    :param max_length: Maximum number of entries to return before raising an
+        error, or ``None`` for no limit.
+    :param validate: Whether to check that the list doesn't contain a cycle.
+        This is off by default, in which case iterating over a list with a
+        cycle never ends unless *max_length* is given.
+    :raises ValueError: if *validate* is true and the list contains a
+        cycle, or if the list has more than *max_length* entries
     :return: Iterator of ``struct list_head *`` objects.
     """
-    head = head.read_()
-    pos = head.next.read_()
-    while pos != head:
-        yield pos
-        pos = pos.next.read_()
+    yield from _linux_helper_list_for_each_entry(
+        None, head, None, max_length=max_length, validate=validate
+    )
 
 
-def list_for_each_reverse(head: Object) -> Iterator[Object]:
+def list_for_each_reverse(
+    head: Object,
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
+) -> Iterator[Object]:
     """
     Iterate over all of the nodes in a list in reverse order.
 
     :param head: ``struct list_head *``
+    :param max_length: Maximum number of entries to return before raising an
+        error, or ``None`` for no limit.
+    :param validate: Whether to check that the list doesn't contain a cycle.
+        This is off by default, in which case iterating over a list with a
+        cycle never ends unless *max_length* is given.
+    :raises ValueError: if *validate* is true and the list contains a
+        cycle, or if the list has more than *max_length* entries
     :return: Iterator of ``struct list_head *`` objects.
     """
-    head = head.read_()
-    pos = head.prev.read_()
-    while pos != head:
-        yield pos
-        pos = pos.prev.read_()
-
-
-def list_for_each_entry(type: str, head: Object, member: str) -> Iterator[Object]:
+    yield from _linux_helper_list_for_each_entry(
+        None, head, None, reverse=True, max_length=max_length, validate=validate
+    )
+
+
+def list_for_each_entry(
+    type: Union[str, Type],
+    head: Object,
+    member: str,
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
+) -> Iterator[Object]:
     """
     Iterate over all of the entries in a list.
 
     :param type: Entry type.
     :param head: ``struct list_head *``
     :param member: Name of list node member in entry type.
+    :param max_length: Maximum number of entries to return before raising an
+        error, or ``None`` for no limit.
+    :param validate: Whether to check that the list doesn't contain a cycle.
+        This is off by default, in which case iterating over a list with a
+        cycle never ends unless *max_length* is given.
+    :raises ValueError: if *validate* is true and the list contains a
+        cycle, or if the list has more than *max_length* entries
     :return: Iterator of ``type *`` objects.
     """
-    for pos in list_for_each(head):
-        yield container_of(pos, type, member)
+    yield from _linux_helper_list_for_each_entry(
+        type, head, member, max_length=max_length, validate=validate
+    )
 
 
 def list_for_each_entry_reverse(
-    type: str, head: Object, member: str
+    type: Union[str, Type],
+    head: Object,
+    member: str,
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
 ) -> Iterator[Object]:
     """
     Iterate over all of the entries in a list in reverse order.
@@ -178,10 +222,18 @@ def list_for_each_entry_reverse(
     :param type: Entry type.
     :param head: ``struct list_head *``
     :param member: Name of list node member in entry type.
+    :param max_length: Maximum number of entries to return before raising an
+        error, or ``None`` for no limit.
+    :param validate: Whether to check that the list doesn't contain a cycle.
+        This is off by default, in which case iterating over a list with a
+        cycle never ends unless *max_length* is given.
+    :raises ValueError: if *validate* is true and the list contains a
+        cycle, or if the list has more than *max_length* entries
     :return: Iterator of ``type *`` objects.
     """
-    for pos in list_for_each_reverse(head):
-        yield container_of(pos, type, member)
+    yield from _linux_helper_list_for_each_entry(
+        type, head, member, reverse=True, max_length=max_length, validate=validate
+    )
 
 
 def hlist_empty(head: Object) -> bool:
@@ -193,27 +245,53 @@ def hlist_empty(head: Object) -> bool:
     return not head.first
 
 
-def hlist_for_each(head: Object) -> Iterator[Object]:
+def hlist_for_each(
+    head: Object,
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
+) -> Iterator[Object]:
     """
     Iterate over all of the nodes in a hash list.
 
     :param head: ``struct hlist_head *``
+    :param max_length: Maximum number of entries to return before raising an
+        error, or ``None`` for no limit.
+    :param validate: Whether to check that the list doesn't contain a cycle.
+        This is off by default, in which case iterating over a list with a
+        cycle never ends unless *max_length* is given.
+    :raises ValueError: if *validate* is true and the list contains a
+        cycle, or if the list has more than *max_length* entries
     :return: Iterator of ``struct hlist_node *`` objects.
     """
-    pos = head.first.read_()
-    while pos:
-        yield pos
-        pos = pos.next.read_()
-
-
-def hlist_for_each_entry(type: str, head: Object, member: str) -> Iterator[Object]:
+    yield from _linux_helper_hlist_for_each_entry(
+        None, head, None, max_length=max_length, validate=validate
+    )
+
+
+def hlist_for_each_entry(
+    type: Union[str, Type],
+    head: Object,
+    member: str,
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
+) -> Iterator[Object]:
     """
     Iterate over all of the entries in a hash list.
 
     :param type: Entry type.
     :param head: ``struct hlist_head *``
     :param member: Name of list node member in entry type.
+    :param max_length: Maximum number of entries to return before raising an
+        error, or ``None`` for no limit.
+    :param validate: Whether to check that the list doesn't contain a cycle.
+        This is off by default, in which case iterating over a list with a
+        cycle never ends unless *max_length* is given.
+    :raises ValueError: if *validate* is true and the list contains a
+        cycle, or if the list has more than *max_length* entries
     :return: Iterator of ``type *`` objects.
     """
-    for pos in hlist_for_each(head):
-        yield container_of(pos, type, member)
+    yield from _linux_helper_hlist_for_each_entry(
+        type, head, member, max_length=max_length, validate=validate
+    )
@@ -11,9 +11,25 @@ implemented.
 """
 
 import operator
-from typing import Any, Iterator, List, Optional, Union, overload
+from typing import (
+    Any,
+    Dict,
+    Iterable,
+    Iterator,
+    List,
+    NamedTuple,
+    Optional,
+    Union,
+    overload,
+)
 
-from _drgn import _linux_helper_read_vm
+from _drgn import (
+    _linux_helper_for_each_page,
+    _linux_helper_for_each_vma,
+    _linux_helper_page_stats,
+    _linux_helper_pgtable_ranges,
+    _linux_helper_read_vm,
+)
 from drgn import IntegerLike, Object, Program, cast
 
 __all__ = (
@@ -21,7 +37,13 @@ __all__ = (
     "access_remote_vm",
     "cmdline",
     "environ",
+    "for_each_mapped_range",
     "for_each_page",
+    "for_each_page_with_flags",
+    "for_each_vma",
+    "MappedRange",
+    "PageStats",
+    "page_stats",
     "page_to_pfn",
     "page_to_virt",
     "pfn_to_page",
@@ -42,6 +64,109 @@ def for_each_page(prog: Program) -> Iterator[Object]:
         yield vmemmap + i
 
 
+def _page_flag_bits(prog: Program) -> Dict[str, int]:
+    try:
+        return prog.cache["page_flag_bits"]
+    except KeyError:
+        pass
+    bits: Dict[str, int] = {}
+    seen = set()
+    # Skip __NR_PAGEFLAGS and aliases like PG_checked = PG_owner_priv_1.
+    for name, value in prog.type("enum pageflags").enumerators:  # type: ignore
+        if not name.startswith("__") and value not in seen:
+            bits[name] = value
+            seen.add(value)
+    prog.cache["page_flag_bits"] = bits
+    return bits
+
+
+def for_each_page_with_flags(
+    prog: Program,
+    set_flags: Iterable[str] = (),
+    clear_flags: Iterable[str] = (),
+    start_pfn: IntegerLike = 0,
+    end_pfn: Optional[IntegerLike] = None,
+) -> Iterator[Object]:
+    """
+    Iterate over the pages in a range of page frame numbers which have all of
+    the given flags set and all of the given flags clear.
+
+    The memory map is read in large chunks and filtered without creating an
+    object for every page, and memory sections without a memory map are
+    skipped. A large range can be split into smaller ranges which are scanned
+    in parallel (e.g., with :func:`drgn.parallel_map()`).
+
+    >>> sum(1 for _ in for_each_page_with_flags(prog, ["PG_slab"]))
+    53811
+
+    :param set_flags: Names of flags from ``enum pageflags`` (e.g.,
+        ``"PG_dirty"``) which must be set.
+    :param clear_flags: Names of flags which must be clear.
+    :param start_pfn: First page frame number in the range.
+    :param end_pfn: Page frame number after the end of the range. Defaults to
+        ``max_pfn``.
+    :return: Iterator of ``struct page *`` objects.
+    """
+    mask = value = 0
+    for name in set_flags:
+        bit = 1 << prog.constant(name).value_()
+        mask |= bit
+        value |= bit
+    for name in clear_flags:
+        mask |= 1 << prog.constant(name).value_()
+    return _linux_helper_for_each_page(
+        prog, start_pfn, end_pfn, flags_mask=mask, flags_value=value
+    )
+
+
+class PageStats(NamedTuple):
+    """
+    Page counts returned by :func:`page_stats()`.
+
+    ``pages`` is the number of pages with a readable ``struct page``.
+    ``flags`` maps the name of each flag in ``enum pageflags`` (e.g.,
+    ``"PG_slab"``) to the number of pages with that flag set. ``mapping`` maps
+    each mapping type to the number of pages with that type: ``"none"``,
+    ``"file"``, ``"anon"``, ``"movable"``, ``"ksm"``, or ``"tail"`` for tail
+    pages of compound pages, which don't have a mapping of their own.
+    """
+
+    pages: int
+    flags: Dict[str, int]
+    mapping: Dict[str, int]
+
+
+_PAGE_MAPPING_TYPES = ("none", "file", "anon", "movable", "ksm", "tail")
+
+
+def page_stats(
+    prog: Program, start_pfn: IntegerLike = 0, end_pfn: Optional[IntegerLike] = None
+) -> PageStats:
+    """
+    Count the pages in a range of page frame numbers by flag and by mapping
+    type.
+
+    This scans the memory map natively like :func:`for_each_page_with_flags()`.
+    The counts for separate ranges can be added together.
+
+    >>> stats = page_stats(prog)
+    >>> stats.flags["PG_dirty"], stats.mapping["anon"]
+    (1024, 371865)
+
+    :param start_pfn: First page frame number in the range.
+    :param end_pfn: Page frame number after the end of the range. Defaults to
+        ``max_pfn``.
+    """
+    pages, flag_counts, mapping_counts = _linux_helper_page_stats(
+        prog, start_pfn, end_pfn
+    )
+    return PageStats(
+        pages,
+        {name: flag_counts[bit] for name, bit in _page_flag_bits(prog).items()},
+        dict(zip(_PAGE_MAPPING_TYPES, mapping_counts)),
+    )
+
+
 def page_to_pfn(page: Object) -> Object:
     """
     Get the page frame number (PFN) of a page.
@@ -233,6 +358,73 @@ def access_remote_vm(mm: Object, address: IntegerLike, size: IntegerLike) -> byt
     return _linux_helper_read_vm(mm.prog_, mm.pgd, address, size)
 
 
+class MappedRange(NamedTuple):
+    """
+    Range of virtual addresses returned by :func:`for_each_mapped_range()`.
+
+    ``end`` is exclusive. The permissions are the effective permissions from
+    every level of the page table. ``huge`` is whether the range is mapped by
+    huge pages.
+    """
+
+    start: int
+    end: int
+    phys_addr: int
+    writable: bool
+    user: bool
+    executable: bool
+    huge: bool
+
+
+def for_each_mapped_range(
+    mm: Object, start: IntegerLike = 0, end: Optional[IntegerLike] = None
+) -> Iterator[MappedRange]:
+    """
+    Iterate over the mapped ranges of a virtual address space by walking its
+    page table.
+
+    Adjacent pages which are also physically contiguous and have the same
+    attributes are merged into one range. Unmapped parts of the address space
+    are skipped at the highest level of the page table which is not present,
+    so walking a sparse address space is fast.
+
+    >>> for r in for_each_mapped_range(task.mm, 0x7F8A62B00000, 0x7F8A62C00000):
+    ...     print(hex(r.start), hex(r.end), hex(r.phys_addr), r.writable)
+    0x7f8a62b56000 0x7f8a62b58000 0x1a2c3d000 True
+
+    The kernel address space can be walked with
+    ``prog["init_mm"].address_of_()``.
+
+    :param mm: ``struct mm_struct *``
+    :param start: First virtual address to include.
+    :param end: Virtual address after the end of the range to include. Defaults
+        to the end of the address space.
+    """
+    for range_start, size, *rest in _linux_helper_pgtable_ranges(
+        mm.prog_, mm.pgd, start, end
+    ):
+        yield MappedRange(range_start, range_start + size, *rest)
+
+
+def for_each_vma(mm: Object) -> Iterator[Object]:
+    """
+    Iterate over the memory mappings (virtual memory areas) of a virtual
+    address space in address order.
+
+    This walks the maple tree ``mm->mm_mt`` or, before Linux 6.1, the
+    red-black tree ``mm->mm_rb``.
+
+    >>> for vma in for_each_vma(task.mm):
+    ...     print(hex(vma.vm_start), hex(vma.vm_end))
+    0x55a9e2a5c000 0x55a9e2a5e000
+    ...
+
+    :param mm: ``struct mm_struct *``
+    :return: Iterator of ``struct vm_area_struct *`` objects.
+    """
+    yield from _linux_helper_for_each_vma(mm)
+
+
 def cmdline(task: Object) -> List[bytes]:
     """
     Get the list of command line arguments of a task.
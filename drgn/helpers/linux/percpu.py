@@ -8,14 +8,26 @@ Per-CPU
 The ``drgn.helpers.linux.percpu`` module provides helpers for working with
 per-CPU allocations from :linux:`include/linux/percpu.h` and per-CPU counters
 from :linux:`include/linux/percpu_counter.h`.
+
+``__per_cpu_offset`` is only read once per program, and
+:func:`per_cpu_values()` and :func:`per_cpu_sum()` read every CPU's copy of a
+per-CPU variable in a single call, which is much faster than calling
+:func:`per_cpu_ptr()` in a loop on machines with many CPUs.
 """
 
+from _drgn import (
+    _linux_helper_per_cpu_ptr as per_cpu_ptr,
+    _linux_helper_per_cpu_sum as per_cpu_sum,
+    _linux_helper_per_cpu_values as per_cpu_values,
+    _linux_helper_percpu_counter_sum as percpu_counter_sum,
+)
 from drgn import IntegerLike, Object
-from drgn.helpers.linux.cpumask import for_each_online_cpu
 
 __all__ = (
     "per_cpu",
     "per_cpu_ptr",
+    "per_cpu_sum",
+    "per_cpu_values",
     "percpu_counter_sum",
 )
 
@@ -35,34 +47,3 @@ def per_cpu(var: Object, cpu: IntegerLike) -> Object:
     :return: ``type`` object.
     """
     return per_cpu_ptr(var.address_of_(), cpu)[0]
-
-
-def per_cpu_ptr(ptr: Object, cpu: IntegerLike) -> Object:
-    """
-    Return the per-CPU pointer for a given CPU.
-
-    >>> prog["init_net"].loopback_dev.pcpu_refcnt
-    (int *)0x2c980
-    >>> per_cpu_ptr(prog["init_net"].loopback_dev.pcpu_refcnt, 7)
-    *(int *)0xffff925e3ddec980 = 4
-
-    :param ptr: Per-CPU pointer, i.e., ``type __percpu *``. For global
-        variables, it's usually easier to use :func:`per_cpu()`.
-    :param cpu: CPU number.
-    :return: ``type *`` object.
-    """
-    offset = ptr.prog_["__per_cpu_offset"][cpu].value_()
-    return Object(ptr.prog_, ptr.type_, value=ptr.value_() + offset)
-
-
-def percpu_counter_sum(fbc: Object) -> int:
-    """
-    Return the sum of a per-CPU counter.
-
-    :param fbc: ``struct percpu_counter *``
-    """
-    ret = fbc.count.value_()
-    ptr = fbc.counters
-    for cpu in for_each_online_cpu(fbc.prog_):
-        ret += per_cpu_ptr(ptr, cpu)[0].value_()
-    return ret
@@ -9,9 +9,10 @@ The ``drgn.helpers.linux.rbtree`` module provides helpers for working with
 red-black trees from :linux:`include/linux/rbtree.h`.
 """
 
-from typing import Callable, Iterator, TypeVar
+from typing import Callable, Iterator, Optional, TypeVar, Union
 
-from drgn import NULL, Object, container_of
+from _drgn import _linux_helper_rbtree_inorder_for_each_entry
+from drgn import NULL, IntegerLike, Object, Type, container_of
 
 __all__ = (
     "RB_EMPTY_NODE",
@@ -140,25 +141,38 @@ def rb_prev(node: Object) -> Object:
     return parent
 
 
-def rbtree_inorder_for_each(root: Object) -> Iterator[Object]:
+def rbtree_inorder_for_each(
+    root: Object,
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
+) -> Iterator[Object]:
     """
     Iterate over all of the nodes in a red-black tree, in sort order.
 
     :param root: ``struct rb_root *``
+    :param max_length: Maximum number of nodes to return before raising an
+        error, or ``None`` for no limit.
+    :param validate: Whether to check that each node's parent pointer points
+        to the node it was reached from and that the tree is no deeper than a
+        valid red-black tree.
+    :raises ValueError: if *validate* is true and the tree is corrupted
+        (i.e., a node's parent pointer doesn't match or the tree is too deep),
+        or if the tree has more than *max_length* nodes
     :return: Iterator of ``struct rb_node *`` objects.
     """
-
-    def aux(node: Object) -> Iterator[Object]:
-        if node:
-            yield from aux(node.rb_left.read_())
-            yield node
-            yield from aux(node.rb_right.read_())
-
-    yield from aux(root.rb_node.read_())
+    yield from _linux_helper_rbtree_inorder_for_each_entry(
+        None, root, None, max_length=max_length, validate=validate
+    )
 
 
 def rbtree_inorder_for_each_entry(
-    type: str, root: Object, member: str
+    type: Union[str, Type],
+    root: Object,
+    member: str,
+    *,
+    max_length: Optional[IntegerLike] = None,
+    validate: bool = False,
 ) -> Iterator[Object]:
     """
     Iterate over all of the entries in a red-black tree in sorted order.
@@ -166,10 +180,19 @@ def rbtree_inorder_for_each_entry(
     :param type: Entry type.
     :param root: ``struct rb_root *``
     :param member: Name of red-black node member in entry type.
+    :param max_length: Maximum number of nodes to return before raising an
+        error, or ``None`` for no limit.
+    :param validate: Whether to check that each node's parent pointer points
+        to the node it was reached from and that the tree is no deeper than a
+        valid red-black tree.
+    :raises ValueError: if *validate* is true and the tree is corrupted
+        (i.e., a node's parent pointer doesn't match or the tree is too deep),
+        or if the tree has more than *max_length* nodes
     :return: Iterator of ``type *`` objects.
     """
-    for node in rbtree_inorder_for_each(root):
-        yield container_of(node, type, member)
+    yield from _linux_helper_rbtree_inorder_for_each_entry(
+        type, root, member, max_length=max_length, validate=validate
+    )
 
 
 KeyType = TypeVar("KeyType")
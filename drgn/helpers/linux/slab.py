@@ -0,0 +1,170 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+"""
+Slab Allocator
+--------------
+
+The ``drgn.helpers.linux.slab`` module provides helpers for working with the
+Linux slab allocator. Only SLUB is supported.
+
+Slabs are found by scanning the memory map natively, and free objects are found
+by decoding the freelist of each slab and of each CPU, including the pointer
+obfuscation of ``CONFIG_SLAB_FREELIST_HARDENED``.
+"""
+
+from typing import Iterator, NamedTuple, Optional, Tuple, Union
+
+from _drgn import _linux_helper_slab_for_each_object, _linux_helper_slab_object_info
+from drgn import IntegerLike, Object, Program, Type
+from drgn.helpers.linux.list import list_for_each_entry
+
+__all__ = (
+    "find_slab_cache",
+    "for_each_allocated_slab_object",
+    "for_each_slab_cache",
+    "SlabObjectInfo",
+    "slab_cache_for_each_allocated_object",
+    "slab_cache_for_each_free_object",
+    "slab_object_info",
+)
+
+
+def for_each_slab_cache(prog: Program) -> Iterator[Object]:
+    """
+    Iterate over all slab caches.
+
+    :return: Iterator of ``struct kmem_cache *`` objects.
+    """
+    return list_for_each_entry(
+        "struct kmem_cache", prog["slab_caches"].address_of_(), "list"
+    )
+
+
+def find_slab_cache(prog: Program, name: Union[str, bytes]) -> Optional[Object]:
+    """
+    Return the slab cache with the given name.
+
+    :param name: Slab cache name.
+    :return: ``struct kmem_cache *``, or ``None`` if not found.
+    """
+    if isinstance(name, str):
+        name = name.encode()
+    for s in for_each_slab_cache(prog):
+        if s.name.string_() == name:
+            return s
+    return None
+
+
+def _slab_cache_for_each_object(
+    slab_cache: Object, type: Union[str, Type], allocated: bool
+) -> Iterator[Object]:
+    prog = slab_cache.prog_
+    pointer_type = prog.pointer_type(prog.type(type))  # type: ignore
+    for _, address, _ in _linux_helper_slab_for_each_object(
+        prog, slab_cache.value_(), allocated=allocated, free=not allocated
+    ):
+        yield Object(prog, pointer_type, value=address)
+
+
+def slab_cache_for_each_allocated_object(
+    slab_cache: Object, type: Union[str, Type]
+) -> Iterator[Object]:
+    """
+    Iterate over all allocated objects in a slab cache.
+
+    >>> dentry_cache = find_slab_cache(prog, "dentry")
+    >>> next(slab_cache_for_each_allocated_object(dentry_cache, "struct dentry"))
+    *(struct dentry *)0xffff905e41404000 = {
+        ...
+    }
+
+    :param slab_cache: ``struct kmem_cache *``
+    :param type: Type of the objects.
+    :return: Iterator of ``type *`` objects.
+    """
+    return _slab_cache_for_each_object(slab_cache, type, True)
+
+
+def slab_cache_for_each_free_object(
+    slab_cache: Object, type: Union[str, Type]
+) -> Iterator[Object]:
+    """
+    Iterate over all free objects in a slab cache, including objects on the
+    per-CPU freelists.
+
+    :param slab_cache: ``struct kmem_cache *``
+    :param type: Type of the objects.
+    :return: Iterator of ``type *`` objects.
+    """
+    return _slab_cache_for_each_object(slab_cache, type, False)
+
+
+def for_each_allocated_slab_object(prog: Program) -> Iterator[Tuple[Object, Object]]:
+    """
+    Iterate over all allocated objects in all slab caches.
+
+    This scans the memory map once, so it is much faster than calling
+    :func:`slab_cache_for_each_allocated_object()` for every cache.
+
+    :return: Iterator of (``struct kmem_cache *``, ``void *``) tuples.
+    """
+    cache_type = prog.type("struct kmem_cache *")
+    void_pointer_type = prog.type("void *")
+    caches = {}
+    for cache, address, _ in _linux_helper_slab_for_each_object(prog):
+        try:
+            cache_obj = caches[cache]
+        except KeyError:
+            cache_obj = caches[cache] = Object(prog, cache_type, value=cache)
+        yield cache_obj, Object(prog, void_pointer_type, value=address)
+
+
+class SlabObjectInfo(NamedTuple):
+    """
+    Slab object returned by :func:`slab_object_info()`.
+
+    ``slab_cache`` is the ``struct kmem_cache *`` that the object belongs to,
+    ``slab`` is the ``struct page *`` of its slab, ``address`` is the address
+    of the start of the object, and ``allocated`` is whether the object is
+    currently allocated.
+    """
+
+    slab_cache: Object
+    slab: Object
+    address: int
+    allocated: bool
+
+
+def slab_object_info(prog: Program, addr: IntegerLike) -> Optional[SlabObjectInfo]:
+    """
+    Find the slab object containing an address.
+
+    This only reads the page structure and the slab containing the address,
+    and the allocator state is kept between calls, so it is fast enough to call
+    for many addresses.
+
+    >>> info = slab_object_info(prog, 0xffff905e41404020)
+    >>> info.slab_cache.name.string_(), hex(info.address), info.allocated
+    (b'dentry', '0xffff905e41404000', True)
+
+    :param addr: ``void *`` or address.
+    :return: Information about the object, or ``None`` if the address is not
+        in a slab object.
+    """
+    info = _linux_helper_slab_object_info(prog, addr)
+    if info is None:
+        return None
+    cache, slab, address, allocated = info
+    try:
+        kmem_cache_type, page_type = prog.cache["slab_object_info_types"]
+    except KeyError:
+        kmem_cache_type = prog.type("struct kmem_cache *")
+        page_type = prog.type("struct page *")
+        prog.cache["slab_object_info_types"] = kmem_cache_type, page_type
+    return SlabObjectInfo(
+        Object(prog, kmem_cache_type, value=cache),
+        Object(prog, page_type, value=slab),
+        address,
+        allocated,
+    )
@@ -0,0 +1,31 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+"""
+XArrays
+-------
+
+The ``drgn.helpers.linux.xarray`` module provides helpers for working with the
+XArray data structure from :linux:`include/linux/xarray.h`. XArrays replaced
+radix trees in Linux v4.20.
+"""
+
+from typing import Iterator, Tuple
+
+from _drgn import _linux_helper_radix_tree_for_each
+from drgn import Object
+
+__all__ = ("xa_for_each",)
+
+
+def xa_for_each(xa: Object) -> Iterator[Tuple[int, Object]]:
+    """
+    Iterate over all of the entries in an XArray in index order.
+
+    Value entries (e.g., shadow entries in the page cache) are included. Sibling
+    entries of multi-index entries are not.
+
+    :param xa: ``struct xarray *``
+    :return: Iterator of (index, ``void *``) tuples.
+    """
+    yield from _linux_helper_radix_tree_for_each(xa)
@@ -17,26 +17,40 @@ from typing import Any, Dict
 import drgn
 
 
+class _BackslashReplaceStdout:
+    def write(self, text: str) -> None:
+        try:
+            sys.stdout.write(text)
+        except UnicodeEncodeError:
+            encoded = text.encode(sys.stdout.encoding, "backslashreplace")
+            if hasattr(sys.stdout, "buffer"):
+                sys.stdout.buffer.write(encoded)
+            else:
+                text = encoded.decode(sys.stdout.encoding, "strict")
+                sys.stdout.write(text)
+
+
+_stdout = _BackslashReplaceStdout()
+
+
 def displayhook(value: Any) -> None:
     if value is None:
         return
     setattr(builtins, "_", None)
     if isinstance(value, drgn.Object):
-        text = value.format_(columns=shutil.get_terminal_size((0, 0)).columns)
-    elif isinstance(value, (drgn.StackTrace, drgn.Type)):
-        text = str(value)
+        # Stream objects, which can be huge, rather than formatting them in
+        # memory first.
+        value.print_(
+            _stdout,
+            columns=shutil.get_terminal_size((0, 0)).columns,
+        )
     else:
-        text = repr(value)
-    try:
-        sys.stdout.write(text)
-    except UnicodeEncodeError:
-        encoded = text.encode(sys.stdout.encoding, "backslashreplace")
-        if hasattr(sys.stdout, "buffer"):
-            sys.stdout.buffer.write(encoded)
+        if isinstance(value, (drgn.StackTrace, drgn.Type)):
+            text = str(value)
         else:
-            text = encoded.decode(sys.stdout.encoding, "strict")
-            sys.stdout.write(text)
-    sys.stdout.write("\n")
+            text = repr(value)
+        _stdout.write(text)
+        sys.stdout.write("\n")
     setattr(builtins, "_", value)
 
 
@@ -0,0 +1,478 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// SPDX-License-Identifier: GPL-3.0+
+
+#include <byteswap.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "accessor.h"
+#include "error.h"
+#include "object.h"
+#include "program.h"
+#include "serialize.h"
+#include "type.h"
+#include "util.h"
+#include "vector.h"
+
+DEFINE_VECTOR(drgn_accessor_op_vector, struct drgn_accessor_op)
+
+struct drgn_accessor_compiler {
+	struct drgn_program *prog;
+	struct drgn_accessor_op_vector ops;
+	struct drgn_qualified_type type;
+	uint64_t bit_offset;
+	uint64_t bit_field_size;
+};
+
+/* Dereference the current pointer. */
+static struct drgn_error *
+drgn_accessor_compile_deref(struct drgn_accessor_compiler *compiler,
+			    struct drgn_type *pointer_type)
+{
+	if (compiler->bit_offset % 8) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "pointer is not byte-aligned");
+	}
+	uint64_t size = drgn_type_size(pointer_type);
+	if (size != 4 && size != 8) {
+		return drgn_type_error("'%s' has unsupported size",
+				       pointer_type);
+	}
+	struct drgn_accessor_op *op =
+		drgn_accessor_op_vector_append_entry(&compiler->ops);
+	if (!op)
+		return &drgn_enomem;
+	op->offset = compiler->bit_offset / 8;
+	op->size = size;
+	op->bswap = (drgn_type_little_endian(pointer_type) !=
+		     (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__));
+	compiler->type = drgn_type_type(pointer_type);
+	compiler->bit_offset = 0;
+	return NULL;
+}
+
+static struct drgn_error *
+drgn_accessor_compile_member(struct drgn_accessor_compiler *compiler,
+			     const char *name, size_t name_len, bool arrow)
+{
+	struct drgn_error *err;
+	struct drgn_type *underlying_type =
+		drgn_underlying_type(compiler->type.type);
+	if (drgn_type_kind(underlying_type) == DRGN_TYPE_POINTER) {
+		err = drgn_accessor_compile_deref(compiler, underlying_type);
+		if (err)
+			return err;
+		underlying_type = drgn_underlying_type(compiler->type.type);
+	} else if (arrow) {
+		return drgn_qualified_type_error("'%s' is not a pointer",
+						 compiler->type);
+	}
+
+	struct drgn_type_member *member;
+	uint64_t member_bit_offset;
+	err = drgn_type_find_member_len(underlying_type, name, name_len,
+					&member, &member_bit_offset);
+	if (err)
+		return err;
+	if (__builtin_add_overflow(compiler->bit_offset, member_bit_offset,
+				   &compiler->bit_offset)) {
+		return drgn_error_create(DRGN_ERROR_OVERFLOW,
+					 "offset is too large");
+	}
+	return drgn_member_type(member, &compiler->type,
+				&compiler->bit_field_size);
+}
+
+static struct drgn_error *
+drgn_accessor_compile_subscript(struct drgn_accessor_compiler *compiler,
+				uint64_t index)
+{
+	struct drgn_error *err;
+	struct drgn_type *underlying_type =
+		drgn_underlying_type(compiler->type.type);
+	enum drgn_type_kind kind = drgn_type_kind(underlying_type);
+	if (kind != DRGN_TYPE_ARRAY && kind != DRGN_TYPE_POINTER) {
+		return drgn_qualified_type_error("'%s' is not an array or pointer",
+						 compiler->type);
+	}
+	struct drgn_element_info element;
+	err = drgn_program_element_info(compiler->prog, underlying_type,
+					&element);
+	if (err)
+		return err;
+	if (kind == DRGN_TYPE_POINTER) {
+		err = drgn_accessor_compile_deref(compiler, underlying_type);
+		if (err)
+			return err;
+	}
+	uint64_t element_offset;
+	if (__builtin_mul_overflow(index, element.bit_size, &element_offset) ||
+	    __builtin_add_overflow(compiler->bit_offset, element_offset,
+				   &compiler->bit_offset)) {
+		return drgn_error_create(DRGN_ERROR_OVERFLOW,
+					 "offset is too large");
+	}
+	compiler->type = element.qualified_type;
+	return NULL;
+}
+
+static struct drgn_error *
+drgn_accessor_compile_path(struct drgn_accessor_compiler *compiler,
+			   const char *path)
+{
+	struct drgn_error *err;
+	const char *p = path;
+	bool first = true;
+	for (;;) {
+		while (isspace(*p))
+			p++;
+		if (!*p)
+			return NULL;
+
+		if (compiler->bit_field_size) {
+			return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+						 "cannot access bit field");
+		}
+
+		if (*p == '[') {
+			p++;
+			while (isspace(*p))
+				p++;
+			if (!isdigit(*p)) {
+				return drgn_error_create(DRGN_ERROR_SYNTAX,
+							 "expected number after '['");
+			}
+			char *end;
+			errno = 0;
+			uint64_t index = strtoull(p, &end, 0);
+			if (errno == ERANGE) {
+				return drgn_error_create(DRGN_ERROR_OVERFLOW,
+							 "index is too large");
+			}
+			p = end;
+			while (isspace(*p))
+				p++;
+			if (*p != ']') {
+				return drgn_error_create(DRGN_ERROR_SYNTAX,
+							 "expected ']' after number");
+			}
+			p++;
+			err = drgn_accessor_compile_subscript(compiler, index);
+			if (err)
+				return err;
+		} else {
+			bool arrow = false;
+			if (*p == '.') {
+				p++;
+			} else if (p[0] == '-' && p[1] == '>') {
+				p += 2;
+				arrow = true;
+			} else if (!first) {
+				return drgn_error_create(DRGN_ERROR_SYNTAX,
+							 "expected '.', '->', or '['");
+			}
+			while (isspace(*p))
+				p++;
+			if (!isalpha(*p) && *p != '_') {
+				return drgn_error_format(DRGN_ERROR_SYNTAX,
+							 "expected identifier after '%s'",
+							 arrow ? "->" : ".");
+			}
+			const char *name = p;
+			do {
+				p++;
+			} while (isalnum(*p) || *p == '_');
+			err = drgn_accessor_compile_member(compiler, name,
+							   p - name, arrow);
+			if (err)
+				return err;
+		}
+		first = false;
+	}
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_compile_accessor(struct drgn_program *prog,
+			      struct drgn_qualified_type qualified_type,
+			      const char *path, struct drgn_accessor **ret)
+{
+	struct drgn_error *err;
+	struct drgn_accessor_compiler compiler = {
+		.prog = prog,
+		.ops = VECTOR_INIT,
+		.type = qualified_type,
+	};
+
+	/* Pointers are applied to their value, so skip the first dereference. */
+	struct drgn_type *underlying_type =
+		drgn_underlying_type(qualified_type.type);
+	if (drgn_type_kind(underlying_type) == DRGN_TYPE_POINTER)
+		compiler.type = drgn_type_type(underlying_type);
+
+	err = drgn_accessor_compile_path(&compiler, path);
+	if (err)
+		goto out;
+
+	size_t size;
+	struct drgn_accessor *accessor;
+	if (__builtin_mul_overflow(compiler.ops.size, sizeof(accessor->ops[0]),
+				   &size) ||
+	    __builtin_add_overflow(size, sizeof(*accessor), &size) ||
+	    !(accessor = malloc(size))) {
+		err = &drgn_enomem;
+		goto out;
+	}
+	accessor->prog = prog;
+	accessor->type = compiler.type;
+	accessor->bit_offset = compiler.bit_offset;
+	accessor->bit_field_size = compiler.bit_field_size;
+	err = drgn_object_type(compiler.type, compiler.bit_field_size,
+			       &accessor->object_type);
+	if (err) {
+		free(accessor);
+		goto out;
+	}
+	accessor->num_ops = compiler.ops.size;
+	if (compiler.ops.size) {
+		memcpy(accessor->ops, compiler.ops.data,
+		       compiler.ops.size * sizeof(accessor->ops[0]));
+	}
+	*ret = accessor;
+	err = NULL;
+out:
+	drgn_accessor_op_vector_deinit(&compiler.ops);
+	return err;
+}
+
+LIBDRGN_PUBLIC void drgn_accessor_destroy(struct drgn_accessor *accessor)
+{
+	free(accessor);
+}
+
+LIBDRGN_PUBLIC struct drgn_qualified_type
+drgn_accessor_type(struct drgn_accessor *accessor)
+{
+	return accessor->type;
+}
+
+static struct drgn_error *drgn_accessor_address(struct drgn_accessor *accessor,
+						uint64_t base, uint64_t *ret)
+{
+	struct drgn_error *err;
+	uint64_t address = base;
+	for (size_t i = 0; i < accessor->num_ops; i++) {
+		const struct drgn_accessor_op *op = &accessor->ops[i];
+		if (op->size == 8) {
+			uint64_t value;
+			err = drgn_program_read_memory(accessor->prog, &value,
+						       address + op->offset,
+						       sizeof(value), false);
+			if (err)
+				return err;
+			address = op->bswap ? bswap_64(value) : value;
+		} else {
+			uint32_t value;
+			err = drgn_program_read_memory(accessor->prog, &value,
+						       address + op->offset,
+						       sizeof(value), false);
+			if (err)
+				return err;
+			address = op->bswap ? bswap_32(value) : value;
+		}
+	}
+	*ret = address;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_accessor_apply(struct drgn_accessor *accessor, uint64_t base,
+		    struct drgn_object *ret)
+{
+	uint64_t address;
+	struct drgn_error *err = drgn_accessor_address(accessor, base,
+						       &address);
+	if (err)
+		return err;
+	return drgn_object_set_reference(ret, accessor->type, address,
+					 accessor->bit_offset,
+					 accessor->bit_field_size);
+}
+
+static inline bool drgn_accessor_is_integer(struct drgn_accessor *accessor)
+{
+	return (accessor->object_type.encoding == DRGN_OBJECT_ENCODING_SIGNED ||
+		accessor->object_type.encoding == DRGN_OBJECT_ENCODING_UNSIGNED);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_accessor_column_size(struct drgn_accessor *accessor, uint64_t *ret)
+{
+	if (drgn_accessor_is_integer(accessor)) {
+		*ret = sizeof(uint64_t);
+		return NULL;
+	}
+	if (accessor->bit_offset % 8) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "result is not byte-aligned");
+	}
+	return drgn_type_sizeof(accessor->type.type, ret);
+}
+
+/* Number of bytes that need to be read for the result of an accessor. */
+static uint64_t drgn_accessor_read_size(struct drgn_accessor *accessor,
+					uint64_t column_size)
+{
+	if (drgn_accessor_is_integer(accessor)) {
+		return (accessor->bit_offset % 8 +
+			accessor->object_type.bit_size + 7) / 8;
+	}
+	return column_size;
+}
+
+/*
+ * Store the result of an accessor in a column given a buffer containing the
+ * byte at the result's offset.
+ */
+static void drgn_accessor_store(struct drgn_accessor *accessor,
+				const char *buf, void *column,
+				uint64_t column_size, size_t i)
+{
+	if (drgn_accessor_is_integer(accessor)) {
+		uint64_t bit_size = accessor->object_type.bit_size;
+		uint64_t value = deserialize_bits(buf, accessor->bit_offset % 8,
+						  bit_size,
+						  accessor->object_type.little_endian);
+		if (accessor->object_type.encoding ==
+		    DRGN_OBJECT_ENCODING_SIGNED)
+			value = sign_extend(value, bit_size);
+		((uint64_t *)column)[i] = value;
+	} else {
+		memcpy((char *)column + i * column_size, buf, column_size);
+	}
+}
+
+/* Limit on the size of the single read for accessors without dereferences. */
+#define DRGN_ACCESSOR_MAX_SPAN 4096
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_read_columns(struct drgn_program *prog,
+			  struct drgn_accessor * const *accessors,
+			  size_t num_accessors, const uint64_t *bases,
+			  size_t num_bases, void * const *columns)
+{
+	struct drgn_error *err;
+
+	uint64_t *column_sizes = malloc_array(num_accessors ? num_accessors : 1,
+					      sizeof(*column_sizes));
+	if (!column_sizes)
+		return &drgn_enomem;
+	/*
+	 * Find the range of bytes covering the results of all of the
+	 * accessors without dereferences and the largest result of the others.
+	 */
+	uint64_t span_start = UINT64_MAX, span_end = 0, max_read_size = 0;
+	for (size_t j = 0; j < num_accessors; j++) {
+		struct drgn_accessor *accessor = accessors[j];
+		if (accessor->prog != prog) {
+			err = drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+						"accessor is from different program");
+			goto out_sizes;
+		}
+		err = drgn_accessor_column_size(accessor, &column_sizes[j]);
+		if (err)
+			goto out_sizes;
+		uint64_t read_size = drgn_accessor_read_size(accessor,
+							     column_sizes[j]);
+		if (accessor->num_ops == 0) {
+			uint64_t start = accessor->bit_offset / 8;
+			if (start < span_start)
+				span_start = start;
+			if (start + read_size > span_end)
+				span_end = start + read_size;
+		} else if (read_size > max_read_size) {
+			max_read_size = read_size;
+		}
+	}
+	bool use_span = (span_start < span_end &&
+			 span_end - span_start <= DRGN_ACCESSOR_MAX_SPAN);
+	if (!use_span) {
+		for (size_t j = 0; j < num_accessors; j++) {
+			uint64_t read_size =
+				drgn_accessor_read_size(accessors[j],
+							column_sizes[j]);
+			if (read_size > max_read_size)
+				max_read_size = read_size;
+		}
+	}
+	uint64_t buf_size = max_read_size;
+	if (use_span && span_end - span_start > buf_size)
+		buf_size = span_end - span_start;
+	if (buf_size > SIZE_MAX) {
+		err = &drgn_enomem;
+		goto out_sizes;
+	}
+	char *buf = malloc(buf_size ? buf_size : 1);
+	if (!buf) {
+		err = &drgn_enomem;
+		goto out_sizes;
+	}
+
+	for (size_t i = 0; i < num_bases; i++) {
+		if (use_span) {
+			err = drgn_program_read_memory(prog, buf,
+						       bases[i] + span_start,
+						       span_end - span_start,
+						       false);
+			if (err)
+				goto out_buf;
+			for (size_t j = 0; j < num_accessors; j++) {
+				struct drgn_accessor *accessor = accessors[j];
+				if (accessor->num_ops)
+					continue;
+				drgn_accessor_store(accessor,
+						    buf + accessor->bit_offset / 8 - span_start,
+						    columns[j], column_sizes[j],
+						    i);
+			}
+		}
+		for (size_t j = 0; j < num_accessors; j++) {
+			struct drgn_accessor *accessor = accessors[j];
+			if (use_span && !accessor->num_ops)
+				continue;
+			uint64_t address;
+			err = drgn_accessor_address(accessor, bases[i],
+						    &address);
+			if (err)
+				goto out_buf;
+			err = drgn_program_read_memory(prog, buf,
+						       address + accessor->bit_offset / 8,
+						       drgn_accessor_read_size(accessor,
+									       column_sizes[j]),
+						       false);
+			if (err)
+				goto out_buf;
+			drgn_accessor_store(accessor, buf, columns[j],
+					    column_sizes[j], i);
+		}
+	}
+	err = NULL;
+out_buf:
+	free(buf);
+out_sizes:
+	free(column_sizes);
+	return err;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_accessor_read(struct drgn_accessor *accessor, const uint64_t *bases,
+		   size_t n, uint64_t *values_ret)
+{
+	if (!drgn_accessor_is_integer(accessor)) {
+		return drgn_qualified_type_error("'%s' is not an integer",
+						 accessor->type);
+	}
+	return drgn_program_read_columns(accessor->prog, &accessor, 1, bases,
+					 n, (void **)&values_ret);
+}
@@ -0,0 +1,62 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// SPDX-License-Identifier: GPL-3.0+
+
+/**
+ * @file
+ *
+ * Accessor internals
+ *
+ * See @ref AccessorInternals.
+ */
+
+#ifndef DRGN_ACCESSOR_H
+#define DRGN_ACCESSOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "drgn.h"
+#include "object.h"
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup AccessorInternals Accessors
+ *
+ * Accessor internals.
+ *
+ * An accessor is compiled to a list of pointer dereferences. Member accesses
+ * and array subscripts between dereferences are folded into the offset of the
+ * next dereference (or the final offset), so applying an accessor only reads
+ * the pointers along the path.
+ *
+ * @{
+ */
+
+/** Read a pointer at an offset from the current address. */
+struct drgn_accessor_op {
+	/** Offset of the pointer from the current address, in bytes. */
+	uint64_t offset;
+	/** Size of the pointer in bytes (4 or 8). */
+	uint8_t size;
+	/** Whether the pointer needs to be byte swapped. */
+	bool bswap;
+};
+
+struct drgn_accessor {
+	struct drgn_program *prog;
+	/** Type of the result. */
+	struct drgn_qualified_type type;
+	/** Offset of the result from the final address, in bits. */
+	uint64_t bit_offset;
+	/** Bit field size of the result, or 0 if it is not a bit field. */
+	uint64_t bit_field_size;
+	/** Object type of the result, used to read it without an object. */
+	struct drgn_object_type object_type;
+	size_t num_ops;
+	struct drgn_accessor_op ops[];
+};
+
+/** @} */
+
+#endif /* DRGN_ACCESSOR_H */
@@ -127,6 +127,16 @@ struct binary_search_tree_iterator
 binary_search_tree_search_le(struct binary_search_tree *tree,
 			     const key_type *key);
 
+/**
+ * Like @ref binary_search_tree_search_le(), but don't restructure the tree.
+ *
+ * Unlike the other search functions, this may be called concurrently with
+ * itself.
+ */
+struct binary_search_tree_iterator
+binary_search_tree_search_le_readonly(struct binary_search_tree *tree,
+				      const key_type *key);
+
 
 /**
  * Delete an entry in a @ref binary_search_tree.
@@ -397,8 +407,8 @@ static struct tree##_iterator tree##_search(struct tree *tree,			\
 }										\
 										\
 __attribute__((__unused__))							\
-static struct tree##_iterator tree##_search_le(struct tree *tree,		\
-					       const tree##_key_type *key)	\
+static struct tree##_iterator							\
+tree##_search_le_readonly(struct tree *tree, const tree##_key_type *key)	\
 {										\
 	struct binary_tree_node *node = tree->root;				\
 	tree##_entry_type *entry = NULL;					\
@@ -421,12 +431,21 @@ static struct tree##_iterator tree##_search_le(struct tree *tree,		\
 			break;							\
 		}								\
 	}									\
-	if (entry)								\
-		variant##_tree_found(&tree->root, tree##_entry_to_node(entry));	\
 	return (struct tree##_iterator){ entry, };				\
 }										\
 										\
 __attribute__((__unused__))							\
+static struct tree##_iterator tree##_search_le(struct tree *tree,		\
+					       const tree##_key_type *key)	\
+{										\
+	struct tree##_iterator it = tree##_search_le_readonly(tree, key);	\
+	if (it.entry)								\
+		variant##_tree_found(&tree->root,				\
+				     tree##_entry_to_node(it.entry));		\
+	return it;								\
+}										\
+										\
+__attribute__((__unused__))							\
 static bool tree##_delete(struct tree *tree, const tree##_key_type *key)	\
 {										\
 	struct binary_tree_node *node;						\
@@ -26,6 +26,7 @@
 #include "object.h"
 #include "path.h"
 #include "program.h"
+#include "siphash.h"
 #include "type.h"
 #include "util.h"
 #include "vector.h"
@@ -966,7 +967,14 @@ drgn_debug_info_update_index(struct drgn_debug_info_load_state *load)
 		if (module_err)
 			drgn_dwarf_index_update_cancel(&dindex_state, module_err);
 	}
+	/*
+	 * Reading the modules above only touched the new modules and the
+	 * update state, so concurrent lookups only need to be excluded while
+	 * the results are added to the index.
+	 */
+	drgn_program_lock_types(dbinfo->prog);
 	struct drgn_error *err = drgn_dwarf_index_update_end(&dindex_state);
+	drgn_program_unlock_types(dbinfo->prog);
 	if (err)
 		return err;
 	drgn_debug_info_free_modules(dbinfo, true, false);
@@ -1071,6 +1079,8 @@ bool drgn_debug_info_is_indexed(struct drgn_debug_info *dbinfo,
 
 DEFINE_HASH_TABLE_FUNCTIONS(drgn_dwarf_type_map, ptr_key_hash_pair,
 			    scalar_key_eq)
+DEFINE_HASH_TABLE_FUNCTIONS(drgn_dwarf_compound_type_map, int_key_hash_pair,
+			    scalar_key_eq)
 
 /**
  * Return whether a DWARF DIE is little-endian.
@@ -1798,6 +1808,707 @@ parse_template_parameter(struct drgn_debug_info *dbinfo,
 	return err;
 }
 
+/*
+ * Type cache records (see @ref TypeCache). Only complete structure, union,
+ * class, and enumerated types are cached; other types are a single DIE and
+ * are cheap to parse. Records consist of ULEB128 numbers and null-terminated
+ * strings. Optional strings are prefixed by a number which is 0 if the string
+ * is absent and 1 if it is present. A record is:
+ *
+ * - Kind
+ * - Language index
+ * - Tag (optional string)
+ *
+ * For structure, union, and class types, followed by:
+ *
+ * - Size
+ * - Number of members, then for each member:
+ *   - Name (optional string)
+ *   - Bit offset
+ *   - Bit field size
+ *   - DIE offset of member type
+ *   - Whether the member type can be an incomplete array type
+ *
+ * For enumerated types, followed by:
+ *
+ * - Compatible type name (string), size, signedness, whether it is
+ *   little-endian, and language index
+ * - Number of enumerators, then for each enumerator:
+ *   - Name (string)
+ *   - Value
+ */
+
+static bool string_builder_append_uleb128(struct string_builder *sb,
+					  uint64_t value)
+{
+	do {
+		uint8_t byte = value & 0x7f;
+		value >>= 7;
+		if (value)
+			byte |= 0x80;
+		if (!string_builder_appendc(sb, byte))
+			return false;
+	} while (value);
+	return true;
+}
+
+static bool string_builder_append_cstring(struct string_builder *sb,
+					  const char *s)
+{
+	return string_builder_appendn(sb, s, strlen(s) + 1);
+}
+
+static bool string_builder_append_optional_cstring(struct string_builder *sb,
+						   const char *s)
+{
+	if (!s)
+		return string_builder_append_uleb128(sb, 0);
+	return (string_builder_append_uleb128(sb, 1) &&
+		string_builder_append_cstring(sb, s));
+}
+
+/*
+ * Get the type cache key of a DIE. Returns false if the DIE can't be cached
+ * because its module doesn't have a build ID or it is in a supplementary file.
+ */
+static bool type_cache_key(struct drgn_debug_info_module *module,
+			   Dwarf_Die *die, uint64_t *build_id_hash_ret,
+			   uint64_t *die_offset_ret)
+{
+	if (!module->build_id_len)
+		return false;
+	Dwarf_Addr bias;
+	Dwarf *dwarf = dwfl_module_getdwarf(module->dwfl_module, &bias);
+	if (!dwarf || dwarf_cu_getdwarf(die->cu) != dwarf)
+		return false;
+	*build_id_hash_ret = drgn_type_cache_hash_build_id(module->build_id,
+							   module->build_id_len);
+	*die_offset_ret = dwarf_dieoffset(die);
+	return true;
+}
+
+/* Get the DIE offset of a DIE's DW_AT_type, or return false. */
+static bool type_cache_type_offset(Dwarf_Die *die, Dwarf *dwarf,
+				   uint64_t *ret)
+{
+	Dwarf_Attribute attr_mem, *attr;
+	Dwarf_Die type_die;
+	if (!(attr = dwarf_attr_integrate(die, DW_AT_type, &attr_mem)) ||
+	    !dwarf_formref_die(attr, &type_die) ||
+	    dwarf_cu_getdwarf(type_die.cu) != dwarf)
+		return false;
+	*ret = dwarf_dieoffset(&type_die);
+	return true;
+}
+
+static bool type_cache_record_header(struct string_builder *sb,
+				     struct drgn_type *type)
+{
+	return (string_builder_append_uleb128(sb, drgn_type_kind(type)) &&
+		string_builder_append_uleb128(sb,
+					      drgn_type_language(type) -
+					      drgn_languages) &&
+		string_builder_append_optional_cstring(sb,
+						       drgn_type_tag(type)));
+}
+
+static struct drgn_error *
+type_cache_add_record(struct drgn_debug_info *dbinfo, uint64_t build_id_hash,
+		      uint64_t die_offset, struct string_builder *sb)
+{
+	bool success = drgn_type_cache_add(dbinfo->type_cache, build_id_hash,
+					   die_offset, sb->str, sb->len);
+	free(sb->str);
+	return success ? NULL : &drgn_enomem;
+}
+
+/*
+ * Add a record for a compound type which was just parsed by
+ * drgn_compound_type_from_dwarf() to the type cache.
+ */
+static struct drgn_error *
+type_cache_record_compound(struct drgn_debug_info *dbinfo,
+			   struct drgn_debug_info_module *module,
+			   Dwarf_Die *die, struct drgn_type *type)
+{
+	/* Template parameters aren't cached. */
+	if (drgn_type_num_template_parameters(type))
+		return NULL;
+	uint64_t build_id_hash, die_offset;
+	if (!type_cache_key(module, die, &build_id_hash, &die_offset))
+		return NULL;
+	Dwarf_Addr bias;
+	Dwarf *dwarf = dwfl_module_getdwarf(module->dwfl_module, &bias);
+
+	struct string_builder sb = {};
+	struct drgn_type_member *members = drgn_type_members(type);
+	size_t num_members = drgn_type_num_members(type);
+	if (!type_cache_record_header(&sb, type) ||
+	    !string_builder_append_uleb128(&sb, drgn_type_size(type)) ||
+	    !string_builder_append_uleb128(&sb, num_members))
+		goto enomem;
+	for (size_t i = 0; i < num_members; i++) {
+		union drgn_lazy_object *object = &members[i].object;
+		if (drgn_lazy_object_is_evaluated(object) ||
+		    object->thunk.fn != drgn_dwarf_member_thunk_fn)
+			goto not_cacheable;
+		struct drgn_dwarf_member_thunk_arg *arg = object->thunk.arg;
+
+		uint64_t type_offset;
+		if (!type_cache_type_offset(&arg->die, dwarf, &type_offset))
+			goto not_cacheable;
+		Dwarf_Attribute attr_mem, *attr;
+		Dwarf_Word bit_field_size = 0;
+		if ((attr = dwarf_attr_integrate(&arg->die, DW_AT_bit_size,
+						 &attr_mem)) &&
+		    dwarf_formudata(attr, &bit_field_size))
+			goto not_cacheable;
+
+		if (!string_builder_append_optional_cstring(&sb,
+							    members[i].name) ||
+		    !string_builder_append_uleb128(&sb,
+						   members[i].bit_offset) ||
+		    !string_builder_append_uleb128(&sb, bit_field_size) ||
+		    !string_builder_append_uleb128(&sb, type_offset) ||
+		    !string_builder_append_uleb128(&sb,
+						   arg->can_be_incomplete_array))
+			goto enomem;
+	}
+	return type_cache_add_record(dbinfo, build_id_hash, die_offset, &sb);
+
+not_cacheable:
+	free(sb.str);
+	return NULL;
+
+enomem:
+	free(sb.str);
+	return &drgn_enomem;
+}
+
+/*
+ * Add a record for an enumerated type which was just parsed by
+ * drgn_enum_type_from_dwarf() to the type cache.
+ */
+static struct drgn_error *
+type_cache_record_enum(struct drgn_debug_info *dbinfo,
+		       struct drgn_debug_info_module *module, Dwarf_Die *die,
+		       struct drgn_type *type)
+{
+	uint64_t build_id_hash, die_offset;
+	if (!type_cache_key(module, die, &build_id_hash, &die_offset))
+		return NULL;
+
+	struct string_builder sb = {};
+	struct drgn_type *compatible_type = drgn_type_type(type).type;
+	struct drgn_type_enumerator *enumerators = drgn_type_enumerators(type);
+	size_t num_enumerators = drgn_type_num_enumerators(type);
+	if (!type_cache_record_header(&sb, type) ||
+	    !string_builder_append_cstring(&sb,
+					   drgn_type_name(compatible_type)) ||
+	    !string_builder_append_uleb128(&sb,
+					   drgn_type_size(compatible_type)) ||
+	    !string_builder_append_uleb128(&sb,
+					   drgn_type_is_signed(compatible_type)) ||
+	    !string_builder_append_uleb128(&sb,
+					   drgn_type_little_endian(compatible_type)) ||
+	    !string_builder_append_uleb128(&sb,
+					   drgn_type_language(compatible_type) -
+					   drgn_languages) ||
+	    !string_builder_append_uleb128(&sb, num_enumerators))
+		goto enomem;
+	for (size_t i = 0; i < num_enumerators; i++) {
+		if (!string_builder_append_cstring(&sb, enumerators[i].name) ||
+		    !string_builder_append_uleb128(&sb, enumerators[i].uvalue))
+			goto enomem;
+	}
+	return type_cache_add_record(dbinfo, build_id_hash, die_offset, &sb);
+
+enomem:
+	free(sb.str);
+	return &drgn_enomem;
+}
+
+struct drgn_dwarf_cached_member_thunk_arg {
+	struct drgn_debug_info_module *module;
+	uint64_t type_offset;
+	uint64_t bit_field_size;
+	bool can_be_incomplete_array;
+};
+
+static struct drgn_error *
+drgn_dwarf_cached_member_thunk_fn(struct drgn_object *res, void *arg_)
+{
+	struct drgn_error *err;
+	struct drgn_dwarf_cached_member_thunk_arg *arg = arg_;
+	if (res) {
+		Dwarf_Addr bias;
+		Dwarf *dwarf = dwfl_module_getdwarf(arg->module->dwfl_module,
+						    &bias);
+		if (!dwarf)
+			return drgn_error_libdwfl();
+		Dwarf_Die type_die;
+		if (!dwarf_offdie(dwarf, arg->type_offset, &type_die))
+			return drgn_error_libdw();
+
+		struct drgn_qualified_type qualified_type;
+		err = drgn_type_from_dwarf_internal(drgn_object_program(res)->_dbinfo,
+						    arg->module, &type_die,
+						    arg->can_be_incomplete_array,
+						    NULL, &qualified_type);
+		if (err)
+			return err;
+
+		err = drgn_object_set_absent(res, qualified_type,
+					     arg->bit_field_size);
+		if (err)
+			return err;
+	}
+	free(arg);
+	return NULL;
+}
+
+static struct drgn_error *type_cache_buffer_error(struct binary_buffer *bb,
+						  const char *pos,
+						  const char *message)
+{
+	return drgn_error_format(DRGN_ERROR_OTHER, "invalid type cache record: %s",
+				 message);
+}
+
+static struct drgn_error *
+type_cache_next_optional_string(struct binary_buffer *bb, const char **ret)
+{
+	struct drgn_error *err;
+	uint64_t present;
+	if ((err = binary_buffer_next_uleb128(bb, &present)))
+		return err;
+	if (!present) {
+		*ret = NULL;
+		return NULL;
+	}
+	size_t len;
+	return binary_buffer_next_string(bb, ret, &len);
+}
+
+static struct drgn_error *
+type_cache_next_language(struct binary_buffer *bb,
+			 const struct drgn_language **ret)
+{
+	struct drgn_error *err;
+	uint64_t index;
+	if ((err = binary_buffer_next_uleb128(bb, &index)))
+		return err;
+	if (index >= DRGN_NUM_LANGUAGES)
+		return binary_buffer_error(bb, "unknown language");
+	*ret = &drgn_languages[index];
+	return NULL;
+}
+
+static struct drgn_error *
+compound_type_from_type_cache(struct drgn_debug_info *dbinfo,
+			      struct drgn_debug_info_module *module,
+			      struct binary_buffer *bb,
+			      enum drgn_type_kind kind, const char *tag,
+			      const struct drgn_language *lang,
+			      struct drgn_type **ret)
+{
+	struct drgn_error *err;
+	uint64_t size, num_members;
+	if ((err = binary_buffer_next_uleb128(bb, &size)) ||
+	    (err = binary_buffer_next_uleb128(bb, &num_members)))
+		return err;
+
+	struct drgn_compound_type_builder builder;
+	drgn_compound_type_builder_init(&builder, dbinfo->prog, kind);
+	for (uint64_t i = 0; i < num_members; i++) {
+		const char *name;
+		uint64_t bit_offset, bit_field_size, type_offset;
+		uint64_t can_be_incomplete_array;
+		if ((err = type_cache_next_optional_string(bb, &name)) ||
+		    (err = binary_buffer_next_uleb128(bb, &bit_offset)) ||
+		    (err = binary_buffer_next_uleb128(bb, &bit_field_size)) ||
+		    (err = binary_buffer_next_uleb128(bb, &type_offset)) ||
+		    (err = binary_buffer_next_uleb128(bb,
+						      &can_be_incomplete_array)))
+			goto err;
+
+		struct drgn_dwarf_cached_member_thunk_arg *thunk_arg =
+			malloc(sizeof(*thunk_arg));
+		if (!thunk_arg) {
+			err = &drgn_enomem;
+			goto err;
+		}
+		thunk_arg->module = module;
+		thunk_arg->type_offset = type_offset;
+		thunk_arg->bit_field_size = bit_field_size;
+		thunk_arg->can_be_incomplete_array = can_be_incomplete_array;
+
+		union drgn_lazy_object member_object;
+		drgn_lazy_object_init_thunk(&member_object, dbinfo->prog,
+					    drgn_dwarf_cached_member_thunk_fn,
+					    thunk_arg);
+		err = drgn_compound_type_builder_add_member(&builder,
+							    &member_object,
+							    name, bit_offset);
+		if (err) {
+			drgn_lazy_object_deinit(&member_object);
+			goto err;
+		}
+	}
+
+	err = drgn_compound_type_create(&builder, tag, size, true, lang, ret);
+	if (err)
+		goto err;
+	return NULL;
+
+err:
+	drgn_compound_type_builder_deinit(&builder);
+	return err;
+}
+
+static struct drgn_error *
+enum_type_from_type_cache(struct drgn_debug_info *dbinfo,
+			  struct binary_buffer *bb, const char *tag,
+			  const struct drgn_language *lang,
+			  struct drgn_type **ret)
+{
+	struct drgn_error *err;
+	const char *compatible_name;
+	size_t compatible_name_len;
+	uint64_t compatible_size, is_signed, little_endian, num_enumerators;
+	const struct drgn_language *compatible_lang;
+	if ((err = binary_buffer_next_string(bb, &compatible_name,
+					     &compatible_name_len)) ||
+	    (err = binary_buffer_next_uleb128(bb, &compatible_size)) ||
+	    (err = binary_buffer_next_uleb128(bb, &is_signed)) ||
+	    (err = binary_buffer_next_uleb128(bb, &little_endian)) ||
+	    (err = type_cache_next_language(bb, &compatible_lang)) ||
+	    (err = binary_buffer_next_uleb128(bb, &num_enumerators)))
+		return err;
+
+	struct drgn_type *compatible_type;
+	err = drgn_int_type_create(dbinfo->prog, compatible_name,
+				   compatible_size, is_signed,
+				   little_endian ?
+				   DRGN_LITTLE_ENDIAN : DRGN_BIG_ENDIAN,
+				   compatible_lang, &compatible_type);
+	if (err)
+		return err;
+
+	struct drgn_enum_type_builder builder;
+	drgn_enum_type_builder_init(&builder, dbinfo->prog);
+	for (uint64_t i = 0; i < num_enumerators; i++) {
+		const char *name;
+		size_t name_len;
+		uint64_t value;
+		if ((err = binary_buffer_next_string(bb, &name, &name_len)) ||
+		    (err = binary_buffer_next_uleb128(bb, &value)))
+			goto err;
+		if (is_signed) {
+			err = drgn_enum_type_builder_add_signed(&builder, name,
+								value);
+		} else {
+			err = drgn_enum_type_builder_add_unsigned(&builder,
+								  name, value);
+		}
+		if (err)
+			goto err;
+	}
+
+	err = drgn_enum_type_create(&builder, tag, compatible_type, lang, ret);
+	if (err)
+		goto err;
+	return NULL;
+
+err:
+	drgn_enum_type_builder_deinit(&builder);
+	return err;
+}
+
+static struct drgn_error *
+type_from_type_cache_record(struct drgn_debug_info *dbinfo,
+			    struct drgn_debug_info_module *module,
+			    const char *record, size_t size,
+			    struct drgn_type **ret)
+{
+	struct drgn_error *err;
+	struct binary_buffer bb;
+	binary_buffer_init(&bb, record, size,
+			   __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+			   type_cache_buffer_error);
+
+	uint64_t kind;
+	const struct drgn_language *lang;
+	const char *tag;
+	if ((err = binary_buffer_next_uleb128(&bb, &kind)) ||
+	    (err = type_cache_next_language(&bb, &lang)) ||
+	    (err = type_cache_next_optional_string(&bb, &tag)))
+		return err;
+	switch (kind) {
+	case DRGN_TYPE_STRUCT:
+	case DRGN_TYPE_UNION:
+	case DRGN_TYPE_CLASS:
+		return compound_type_from_type_cache(dbinfo, module, &bb, kind,
+						     tag, lang, ret);
+	case DRGN_TYPE_ENUM:
+		return enum_type_from_type_cache(dbinfo, &bb, tag, lang, ret);
+	default:
+		return binary_buffer_error(&bb, "unknown kind");
+	}
+}
+
+/*
+ * Look up a DIE in the type cache. If it isn't found or the record is invalid,
+ * *ret is set to NULL.
+ */
+static struct drgn_error *
+type_from_type_cache(struct drgn_debug_info *dbinfo,
+		     struct drgn_debug_info_module *module, Dwarf_Die *die,
+		     struct drgn_type **ret)
+{
+	*ret = NULL;
+	switch (dwarf_tag(die)) {
+	case DW_TAG_structure_type:
+	case DW_TAG_union_type:
+	case DW_TAG_class_type:
+	case DW_TAG_enumeration_type:
+		break;
+	default:
+		return NULL;
+	}
+
+	uint64_t build_id_hash, die_offset;
+	const char *record;
+	size_t size;
+	if (!type_cache_key(module, die, &build_id_hash, &die_offset) ||
+	    !drgn_type_cache_find(dbinfo->type_cache, build_id_hash,
+				  die_offset, &record, &size))
+		return NULL;
+
+	struct drgn_error *err = type_from_type_cache_record(dbinfo, module,
+							     record, size,
+							     ret);
+	if (err) {
+		*ret = NULL;
+		/* Fall back to parsing the DIE if the record is invalid. */
+		if (err->code == DRGN_ERROR_NO_MEMORY)
+			return err;
+		drgn_error_destroy(err);
+	}
+	return NULL;
+}
+
+/*
+ * Structural fingerprints of compound types for
+ * drgn_program_set_dedupe_compound_types(). These are 64-bit SipHash values;
+ * like the file name hashes in the DWARF index, we assume that collisions are
+ * improbable enough to ignore. Each function returns false if the DIE can't be
+ * fingerprinted (e.g., because it uses a location expression for a member
+ * offset or has template parameters), in which case the type isn't
+ * deduplicated.
+ */
+
+/* Maximum depth of nested anonymous types that we will fingerprint. */
+#define DWARF_FINGERPRINT_MAX_DEPTH 16
+
+static void siphash_update_u64(struct siphash *hash, uint64_t value)
+{
+	siphash_update(hash, &value, sizeof(value));
+}
+
+/* Hash a string including its null terminator; NULL is hashed as "". */
+static void siphash_update_string(struct siphash *hash, const char *s)
+{
+	if (s)
+		siphash_update(hash, s, strlen(s) + 1);
+	else
+		siphash_update(hash, "", 1);
+}
+
+static bool dwarf_fingerprint_udata_attr(struct siphash *hash, Dwarf_Die *die,
+					 unsigned int name)
+{
+	Dwarf_Attribute attr_mem, *attr;
+	if (!(attr = dwarf_attr_integrate(die, name, &attr_mem)))
+		return true;
+	Dwarf_Word value;
+	if (dwarf_formudata(attr, &value))
+		return false;
+	siphash_update_u64(hash, name);
+	siphash_update_u64(hash, value);
+	return true;
+}
+
+static bool dwarf_fingerprint_decl_file(struct siphash *hash, Dwarf_Die *die)
+{
+	const char *path = dwarf_decl_file(die);
+	if (!path)
+		return false;
+	struct path_iterator it = {
+		.components = (struct path_iterator_component []){
+			{ path, strlen(path) },
+		},
+		.num_components = 1,
+	};
+	const char *component;
+	size_t component_len;
+	while (path_iterator_next(&it, &component, &component_len)) {
+		siphash_update(hash, component, component_len);
+		siphash_update(hash, "/", 1);
+	}
+	return true;
+}
+
+static bool dwarf_fingerprint_members(struct siphash *hash, Dwarf_Die *die,
+				      int depth);
+
+/*
+ * Hash the shape of the type referenced by a DIE's DW_AT_type: the chain of
+ * unnamed type DIEs (pointers, qualifiers, arrays, anonymous types) up to and
+ * including the first named type, which is identified by its tag and name.
+ */
+static bool dwarf_fingerprint_type_attr(struct siphash *hash, Dwarf_Die *die,
+					int depth)
+{
+	Dwarf_Die type_die = *die;
+	for (;;) {
+		if (depth++ >= DWARF_FINGERPRINT_MAX_DEPTH)
+			return false;
+
+		Dwarf_Attribute attr_mem, *attr;
+		if (!(attr = dwarf_attr_integrate(&type_die, DW_AT_type,
+						  &attr_mem))) {
+			/* void */
+			siphash_update_u64(hash, 0);
+			return true;
+		}
+		if (!dwarf_formref_die(attr, &type_die))
+			return false;
+
+		int tag = dwarf_tag(&type_die);
+		siphash_update_u64(hash, tag);
+		const char *name = dwarf_diename(&type_die);
+		if (name) {
+			siphash_update_string(hash, name);
+			return true;
+		}
+		if (!dwarf_fingerprint_udata_attr(hash, &type_die,
+						  DW_AT_byte_size))
+			return false;
+
+		Dwarf_Die child;
+		int r;
+		switch (tag) {
+		case DW_TAG_structure_type:
+		case DW_TAG_union_type:
+		case DW_TAG_class_type:
+			return dwarf_fingerprint_members(hash, &type_die,
+							 depth);
+		case DW_TAG_enumeration_type:
+			r = dwarf_child(&type_die, &child);
+			while (r == 0) {
+				if (dwarf_tag(&child) == DW_TAG_enumerator) {
+					siphash_update_string(hash,
+							      dwarf_diename(&child));
+				}
+				r = dwarf_siblingof(&child, &child);
+			}
+			if (r == -1)
+				return false;
+			break;
+		case DW_TAG_array_type:
+			r = dwarf_child(&type_die, &child);
+			while (r == 0) {
+				if (dwarf_tag(&child) == DW_TAG_subrange_type &&
+				    (!dwarf_fingerprint_udata_attr(hash, &child,
+								   DW_AT_upper_bound) ||
+				     !dwarf_fingerprint_udata_attr(hash, &child,
+								   DW_AT_count)))
+					return false;
+				r = dwarf_siblingof(&child, &child);
+			}
+			if (r == -1)
+				return false;
+			break;
+		case DW_TAG_subroutine_type:
+			r = dwarf_child(&type_die, &child);
+			while (r == 0) {
+				siphash_update_u64(hash, dwarf_tag(&child));
+				if (dwarf_tag(&child) ==
+				    DW_TAG_formal_parameter &&
+				    !dwarf_fingerprint_type_attr(hash, &child,
+								 depth))
+					return false;
+				r = dwarf_siblingof(&child, &child);
+			}
+			if (r == -1)
+				return false;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static bool dwarf_fingerprint_members(struct siphash *hash, Dwarf_Die *die,
+				      int depth)
+{
+	Dwarf_Die child;
+	int r = dwarf_child(die, &child);
+	while (r == 0) {
+		switch (dwarf_tag(&child)) {
+		case DW_TAG_member:
+			siphash_update_string(hash, dwarf_diename(&child));
+			if (!dwarf_fingerprint_udata_attr(hash, &child,
+							  DW_AT_data_member_location) ||
+			    !dwarf_fingerprint_udata_attr(hash, &child,
+							  DW_AT_data_bit_offset) ||
+			    !dwarf_fingerprint_udata_attr(hash, &child,
+							  DW_AT_bit_offset) ||
+			    !dwarf_fingerprint_udata_attr(hash, &child,
+							  DW_AT_bit_size) ||
+			    !dwarf_fingerprint_udata_attr(hash, &child,
+							  DW_AT_byte_size) ||
+			    !dwarf_fingerprint_type_attr(hash, &child, depth))
+				return false;
+			break;
+		case DW_TAG_template_type_parameter:
+		case DW_TAG_template_value_parameter:
+			return false;
+		default:
+			break;
+		}
+		r = dwarf_siblingof(&child, &child);
+	}
+	return r == 0 || r == 1;
+}
+
+/*
+ * Compute the fingerprint of a compound type definition from its kind, tag,
+ * size, byte order, declaration file, and member layout.
+ */
+static bool dwarf_compound_type_fingerprint(Dwarf_Die *die,
+					    const struct drgn_language *lang,
+					    enum drgn_type_kind kind,
+					    const char *tag, uint64_t size,
+					    bool little_endian,
+					    uint64_t *ret)
+{
+	static const uint64_t siphash_key[2];
+	struct siphash hash;
+	siphash_init(&hash, siphash_key);
+	siphash_update_string(&hash, lang->name);
+	siphash_update_u64(&hash, kind);
+	siphash_update_string(&hash, tag);
+	siphash_update_u64(&hash, size);
+	siphash_update_u64(&hash, little_endian);
+	if (!dwarf_fingerprint_decl_file(&hash, die) ||
+	    !dwarf_fingerprint_members(&hash, die, 0))
+		return false;
+	*ret = siphash_final(&hash);
+	return true;
+}
+
 static struct drgn_error *
 drgn_compound_type_from_dwarf(struct drgn_debug_info *dbinfo,
 			      struct drgn_debug_info_module *module,
@@ -1852,6 +2563,26 @@ drgn_compound_type_from_dwarf(struct drgn_debug_info *dbinfo,
 		dwarf_die_is_little_endian(die, false, &little_endian);
 	}
 
+	struct drgn_dwarf_compound_type_map_entry dedupe_entry;
+	struct hash_pair dedupe_hp;
+	bool dedupe = (dbinfo->prog->dedupe_compound_types && !declaration &&
+		       tag &&
+		       dwarf_compound_type_fingerprint(die, lang, kind, tag,
+						       size, little_endian,
+						       &dedupe_entry.key));
+	if (dedupe) {
+		dedupe_hp = drgn_dwarf_compound_type_map_hash(&dedupe_entry.key);
+		struct drgn_dwarf_compound_type_map_iterator it =
+			drgn_dwarf_compound_type_map_search_hashed(&dbinfo->compound_types,
+								   &dedupe_entry.key,
+								   dedupe_hp);
+		if (it.entry) {
+			drgn_compound_type_builder_deinit(&builder);
+			*ret = it.entry->value;
+			return NULL;
+		}
+	}
+
 	Dwarf_Die member = {}, child;
 	int r = dwarf_child(die, &child);
 	while (r == 0) {
@@ -1910,6 +2641,18 @@ drgn_compound_type_from_dwarf(struct drgn_debug_info *dbinfo,
 					ret);
 	if (err)
 		goto err;
+	if (dedupe) {
+		dedupe_entry.value = *ret;
+		/*
+		 * If this fails, the type is still valid; it just won't be
+		 * shared.
+		 */
+		drgn_dwarf_compound_type_map_insert_searched(&dbinfo->compound_types,
+							     &dedupe_entry,
+							     dedupe_hp, NULL);
+	} else if (dbinfo->type_cache && !declaration) {
+		return type_cache_record_compound(dbinfo, module, die, *ret);
+	}
 	return NULL;
 
 err:
@@ -2068,6 +2811,8 @@ drgn_enum_type_from_dwarf(struct drgn_debug_info *dbinfo,
 	err = drgn_enum_type_create(&builder, tag, compatible_type, lang, ret);
 	if (err)
 		goto err;
+	if (dbinfo->type_cache)
+		return type_cache_record_enum(dbinfo, module, die, *ret);
 	return NULL;
 
 err:
@@ -2442,8 +3187,28 @@ drgn_type_from_dwarf_internal(struct drgn_debug_info *dbinfo,
 		}
 	}
 
+	struct drgn_error *err;
+	if (dbinfo->type_cache && !dbinfo->prog->dedupe_compound_types) {
+		err = type_from_type_cache(dbinfo, module, die, &ret->type);
+		if (err)
+			return err;
+		if (ret->type) {
+			ret->qualifiers = 0;
+			entry.value.type = ret->type;
+			entry.value.qualifiers = 0;
+			entry.value.is_incomplete_array = false;
+			if (drgn_dwarf_type_map_insert_searched(&dbinfo->types,
+								&entry, hp,
+								NULL) == -1)
+				return &drgn_enomem;
+			if (is_incomplete_array_ret)
+				*is_incomplete_array_ret = false;
+			return NULL;
+		}
+	}
+
 	const struct drgn_language *lang;
-	struct drgn_error *err = drgn_language_from_die(die, true, &lang);
+	err = drgn_language_from_die(die, true, &lang);
 	if (err)
 		return err;
 
@@ -2552,13 +3317,13 @@ drgn_type_from_dwarf_internal(struct drgn_debug_info *dbinfo,
 	return NULL;
 }
 
-struct drgn_error *drgn_debug_info_find_type(enum drgn_type_kind kind,
-					     const char *name, size_t name_len,
-					     const char *filename, void *arg,
-					     struct drgn_qualified_type *ret)
+static struct drgn_error *
+drgn_debug_info_find_type_impl(struct drgn_debug_info *dbinfo,
+			       enum drgn_type_kind kind, const char *name,
+			       size_t name_len, const char *filename,
+			       struct drgn_qualified_type *ret)
 {
 	struct drgn_error *err;
-	struct drgn_debug_info *dbinfo = arg;
 
 	uint64_t tag;
 	switch (kind) {
@@ -2613,14 +3378,28 @@ struct drgn_error *drgn_debug_info_find_type(enum drgn_type_kind kind,
 	return &drgn_not_found;
 }
 
-struct drgn_error *
-drgn_debug_info_find_object(const char *name, size_t name_len,
-			    const char *filename,
-			    enum drgn_find_object_flags flags, void *arg,
-			    struct drgn_object *ret)
+struct drgn_error *drgn_debug_info_find_type(enum drgn_type_kind kind,
+					     const char *name, size_t name_len,
+					     const char *filename, void *arg,
+					     struct drgn_qualified_type *ret)
 {
-	struct drgn_error *err;
 	struct drgn_debug_info *dbinfo = arg;
+	drgn_program_lock_types(dbinfo->prog);
+	struct drgn_error *err = drgn_debug_info_find_type_impl(dbinfo, kind,
+								name, name_len,
+								filename, ret);
+	drgn_program_unlock_types(dbinfo->prog);
+	return err;
+}
+
+static struct drgn_error *
+drgn_debug_info_find_object_impl(struct drgn_debug_info *dbinfo,
+				 const char *name, size_t name_len,
+				 const char *filename,
+				 enum drgn_find_object_flags flags,
+				 struct drgn_object *ret)
+{
+	struct drgn_error *err;
 
 	struct drgn_dwarf_index_namespace *ns = &dbinfo->dindex.global;
 	if (name_len >= 2 && memcmp(name, "::", 2) == 0) {
@@ -2688,6 +3467,237 @@ drgn_debug_info_find_object(const char *name, size_t name_len,
 	return &drgn_not_found;
 }
 
+struct drgn_error *
+drgn_debug_info_find_object(const char *name, size_t name_len,
+			    const char *filename,
+			    enum drgn_find_object_flags flags, void *arg,
+			    struct drgn_object *ret)
+{
+	struct drgn_debug_info *dbinfo = arg;
+	drgn_program_lock_types(dbinfo->prog);
+	struct drgn_error *err =
+		drgn_debug_info_find_object_impl(dbinfo, name, name_len,
+						 filename, flags, ret);
+	drgn_program_unlock_types(dbinfo->prog);
+	return err;
+}
+
+struct drgn_indexed_name {
+	const char *name;
+	struct drgn_dwarf_index_die die;
+};
+
+DEFINE_VECTOR(drgn_indexed_name_vector, struct drgn_indexed_name)
+
+struct drgn_indexed_names {
+	struct drgn_debug_info *dbinfo;
+	uint64_t type_kinds;
+	struct drgn_indexed_name *entries;
+	size_t num_entries;
+};
+
+static struct drgn_error *add_indexed_name(size_t shard, const char *name,
+					   size_t name_len,
+					   struct drgn_dwarf_index_die *die,
+					   void *arg)
+{
+	/* Each shard has its own vector, so this doesn't need locking. */
+	struct drgn_indexed_name_vector *vectors = arg;
+	struct drgn_indexed_name *entry =
+		drgn_indexed_name_vector_append_entry(&vectors[shard]);
+	if (!entry)
+		return &drgn_enomem;
+	entry->name = name;
+	entry->die = *die;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_indexed_names(struct drgn_program *prog, uint64_t type_kinds,
+			   enum drgn_find_object_flags object_flags,
+			   const char *module_name,
+			   struct drgn_indexed_names **ret)
+{
+	struct drgn_error *err;
+	struct drgn_debug_info *dbinfo;
+	err = drgn_program_get_dbinfo(prog, &dbinfo);
+	if (err)
+		return err;
+
+	uint64_t tags[9];
+	size_t num_tags = 0;
+	if (type_kinds & ((UINT64_C(1) << DRGN_TYPE_INT) |
+			  (UINT64_C(1) << DRGN_TYPE_BOOL) |
+			  (UINT64_C(1) << DRGN_TYPE_FLOAT)))
+		tags[num_tags++] = DW_TAG_base_type;
+	if (type_kinds & (UINT64_C(1) << DRGN_TYPE_STRUCT))
+		tags[num_tags++] = DW_TAG_structure_type;
+	if (type_kinds & (UINT64_C(1) << DRGN_TYPE_UNION))
+		tags[num_tags++] = DW_TAG_union_type;
+	if (type_kinds & (UINT64_C(1) << DRGN_TYPE_CLASS))
+		tags[num_tags++] = DW_TAG_class_type;
+	if (type_kinds & (UINT64_C(1) << DRGN_TYPE_ENUM))
+		tags[num_tags++] = DW_TAG_enumeration_type;
+	if (type_kinds & (UINT64_C(1) << DRGN_TYPE_TYPEDEF))
+		tags[num_tags++] = DW_TAG_typedef;
+	if (object_flags & DRGN_FIND_OBJECT_CONSTANT)
+		tags[num_tags++] = DW_TAG_enumerator;
+	if (object_flags & DRGN_FIND_OBJECT_FUNCTION)
+		tags[num_tags++] = DW_TAG_subprogram;
+	if (object_flags & DRGN_FIND_OBJECT_VARIABLE)
+		tags[num_tags++] = DW_TAG_variable;
+
+	struct drgn_indexed_names *names = malloc(sizeof(*names));
+	if (!names)
+		return &drgn_enomem;
+	names->dbinfo = dbinfo;
+	names->type_kinds = type_kinds;
+	names->entries = NULL;
+	names->num_entries = 0;
+	/* Nothing was requested. */
+	if (!num_tags) {
+		*ret = names;
+		return NULL;
+	}
+
+	struct drgn_dwarf_index_namespace *ns = &dbinfo->dindex.global;
+	struct drgn_indexed_name_vector vectors[ARRAY_SIZE(ns->shards)];
+	for (size_t i = 0; i < ARRAY_SIZE(vectors); i++)
+		drgn_indexed_name_vector_init(&vectors[i]);
+
+	drgn_program_lock_types(prog);
+	err = drgn_dwarf_index_for_each(ns, tags, num_tags, module_name,
+					add_indexed_name, vectors);
+	drgn_program_unlock_types(prog);
+	if (err)
+		goto out;
+
+	size_t num_entries = 0;
+	for (size_t i = 0; i < ARRAY_SIZE(vectors); i++)
+		num_entries += vectors[i].size;
+	if (num_entries) {
+		names->entries = malloc_array(num_entries,
+					      sizeof(*names->entries));
+		if (!names->entries) {
+			err = &drgn_enomem;
+			goto out;
+		}
+		for (size_t i = 0; i < ARRAY_SIZE(vectors); i++) {
+			memcpy(names->entries + names->num_entries,
+			       vectors[i].data,
+			       vectors[i].size * sizeof(*names->entries));
+			names->num_entries += vectors[i].size;
+		}
+	}
+	*ret = names;
+	err = NULL;
+out:
+	for (size_t i = 0; i < ARRAY_SIZE(vectors); i++)
+		drgn_indexed_name_vector_deinit(&vectors[i]);
+	if (err)
+		drgn_indexed_names_destroy(names);
+	return err;
+}
+
+LIBDRGN_PUBLIC void drgn_indexed_names_destroy(struct drgn_indexed_names *names)
+{
+	if (names) {
+		free(names->entries);
+		free(names);
+	}
+}
+
+LIBDRGN_PUBLIC size_t
+drgn_indexed_names_size(struct drgn_indexed_names *names)
+{
+	return names->num_entries;
+}
+
+LIBDRGN_PUBLIC const char *
+drgn_indexed_names_name(struct drgn_indexed_names *names, size_t i)
+{
+	return names->entries[i].name;
+}
+
+LIBDRGN_PUBLIC bool drgn_indexed_names_is_type(struct drgn_indexed_names *names,
+					       size_t i)
+{
+	switch (names->entries[i].die.tag) {
+	case DW_TAG_enumerator:
+	case DW_TAG_subprogram:
+	case DW_TAG_variable:
+		return false;
+	default:
+		return true;
+	}
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_indexed_names_type(struct drgn_indexed_names *names, size_t i,
+			struct drgn_qualified_type *ret)
+{
+	struct drgn_error *err;
+	struct drgn_indexed_name *entry = &names->entries[i];
+	if (!drgn_indexed_names_is_type(names, i)) {
+		return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+					 "%s is not a type", entry->name);
+	}
+	struct drgn_debug_info *dbinfo = names->dbinfo;
+	drgn_program_lock_types(dbinfo->prog);
+	Dwarf_Die die;
+	err = drgn_dwarf_index_get_die(&entry->die, &die);
+	if (!err) {
+		err = drgn_type_from_dwarf(dbinfo, entry->die.module, &die,
+					   ret);
+	}
+	drgn_program_unlock_types(dbinfo->prog);
+	if (!err &&
+	    !(names->type_kinds & (UINT64_C(1) << drgn_type_kind(ret->type))))
+		return &drgn_not_found;
+	return err;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_indexed_names_object(struct drgn_indexed_names *names, size_t i,
+			  struct drgn_object *ret)
+{
+	struct drgn_error *err;
+	struct drgn_indexed_name *entry = &names->entries[i];
+	if (drgn_indexed_names_is_type(names, i)) {
+		return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+					 "%s is not an object", entry->name);
+	}
+	struct drgn_debug_info *dbinfo = names->dbinfo;
+	drgn_program_lock_types(dbinfo->prog);
+	Dwarf_Die die;
+	err = drgn_dwarf_index_get_die(&entry->die, &die);
+	if (err)
+		goto out;
+	switch (entry->die.tag) {
+	case DW_TAG_enumerator:
+		err = drgn_object_from_dwarf_enumerator(dbinfo,
+							entry->die.module,
+							&die, entry->name,
+							ret);
+		break;
+	case DW_TAG_subprogram:
+		err = drgn_object_from_dwarf_subprogram(dbinfo,
+							entry->die.module,
+							&die, ret);
+		break;
+	case DW_TAG_variable:
+		err = drgn_object_from_dwarf_variable(dbinfo,
+						      entry->die.module, &die,
+						      ret);
+		break;
+	default:
+		UNREACHABLE();
+	}
+out:
+	drgn_program_unlock_types(dbinfo->prog);
+	return err;
+}
+
 struct drgn_error *drgn_debug_info_create(struct drgn_program *prog,
 					  struct drgn_debug_info **ret)
 {
@@ -2712,6 +3722,8 @@ struct drgn_error *drgn_debug_info_create(struct drgn_program *prog,
 	drgn_dwarf_index_init(&dbinfo->dindex);
 	drgn_dwarf_type_map_init(&dbinfo->types);
 	drgn_dwarf_type_map_init(&dbinfo->cant_be_incomplete_array_types);
+	drgn_dwarf_compound_type_map_init(&dbinfo->compound_types);
+	dbinfo->type_cache = NULL;
 	dbinfo->depth = 0;
 	*ret = dbinfo;
 	return NULL;
@@ -2721,6 +3733,8 @@ void drgn_debug_info_destroy(struct drgn_debug_info *dbinfo)
 {
 	if (!dbinfo)
 		return;
+	drgn_type_cache_destroy(dbinfo->type_cache);
+	drgn_dwarf_compound_type_map_deinit(&dbinfo->compound_types);
 	drgn_dwarf_type_map_deinit(&dbinfo->cant_be_incomplete_array_types);
 	drgn_dwarf_type_map_deinit(&dbinfo->types);
 	drgn_dwarf_index_deinit(&dbinfo->dindex);
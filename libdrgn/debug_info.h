@@ -20,6 +20,7 @@
 #include "dwarf_index.h"
 #include "hash_table.h"
 #include "string_builder.h"
+#include "type_cache.h"
 #include "vector.h"
 
 /**
@@ -161,14 +162,23 @@ struct drgn_dwarf_type {
 
 DEFINE_HASH_MAP_TYPE(drgn_dwarf_type_map, const void *, struct drgn_dwarf_type);
 
+DEFINE_HASH_MAP_TYPE(drgn_dwarf_compound_type_map, uint64_t,
+		     struct drgn_type *);
+
 /** Cache of debugging information. */
 struct drgn_debug_info {
 	/** Program owning this cache. */
 	struct drgn_program *prog;
 
-	/** DWARF frontend library handle. */
+	/**
+	 * DWARF frontend library handle. Protected by @ref
+	 * drgn_program::dwfl_lock.
+	 */
 	Dwfl *dwfl;
-	/** Modules keyed by build ID and address range. */
+	/**
+	 * Modules keyed by build ID and address range. Protected by @ref
+	 * drgn_program::dwfl_lock.
+	 */
 	struct drgn_debug_info_module_table modules;
 	/**
 	 * Names of indexed modules.
@@ -194,6 +204,18 @@ struct drgn_debug_info {
 	 * See @ref drgn_type_from_dwarf_internal().
 	 */
 	struct drgn_dwarf_type_map cant_be_incomplete_array_types;
+	/**
+	 * Compound types keyed by a structural fingerprint.
+	 *
+	 * This is only used if @ref drgn_program::dedupe_compound_types is
+	 * enabled. See @ref drgn_program_set_dedupe_compound_types().
+	 */
+	struct drgn_dwarf_compound_type_map compound_types;
+	/**
+	 * Persistent type cache, or @c NULL if one hasn't been loaded. See
+	 * @ref drgn_program_load_type_cache().
+	 */
+	struct drgn_type_cache *type_cache;
 	/** Current parsing recursion depth. */
 	int depth;
 };
@@ -276,6 +298,10 @@ drgn_debug_info_report_flush(struct drgn_debug_info_load_state *load);
 /**
  * Load debugging information.
  *
+ * The caller must hold @ref drgn_program::dwfl_lock. @ref
+ * drgn_program::types_lock is only taken while new modules are added to the
+ * index.
+ *
  * @sa drgn_program_load_debug_info
  */
 struct drgn_error *drgn_debug_info_load(struct drgn_debug_info *dbinfo,
@@ -215,6 +215,8 @@ void drgn_dwarf_index_update_begin(struct drgn_dwarf_index_update_state *state,
 {
 	state->dindex = dindex;
 	state->old_cus_size = dindex->cus.size;
+	drgn_dwarf_index_cu_vector_init(&state->cus);
+	drgn_dwarf_index_specification_map_init(&state->specifications);
 	state->err = NULL;
 }
 
@@ -742,7 +744,8 @@ out_directories:
 }
 
 static struct drgn_error *
-index_specification(struct drgn_dwarf_index *dindex, uintptr_t declaration,
+index_specification(struct drgn_dwarf_index_update_state *state,
+		    uintptr_t declaration,
 		    struct drgn_debug_info_module *module, size_t offset)
 {
 	struct drgn_dwarf_index_specification entry = {
@@ -754,7 +757,7 @@ index_specification(struct drgn_dwarf_index *dindex, uintptr_t declaration,
 		drgn_dwarf_index_specification_map_hash(&declaration);
 	int ret;
 	#pragma omp critical(drgn_index_specification)
-	ret = drgn_dwarf_index_specification_map_insert_hashed(&dindex->specifications,
+	ret = drgn_dwarf_index_specification_map_insert_hashed(&state->specifications,
 							       &entry, hp,
 							       NULL);
 	/*
@@ -769,7 +772,7 @@ index_specification(struct drgn_dwarf_index *dindex, uintptr_t declaration,
  * DW_AT_specification. This recurses into namespaces.
  */
 static struct drgn_error *
-index_cu_first_pass(struct drgn_dwarf_index *dindex,
+index_cu_first_pass(struct drgn_dwarf_index_update_state *state,
 		    struct drgn_dwarf_index_cu_buffer *buffer)
 {
 	struct drgn_error *err;
@@ -963,7 +966,7 @@ skip:
 								      stmt_list_ptr,
 								      "DW_AT_stmt_list is out of bounds");
 				}
-				if ((err = read_file_name_table(dindex, cu,
+				if ((err = read_file_name_table(state->dindex, cu,
 								stmt_list)))
 					return err;
 			}
@@ -977,7 +980,7 @@ skip:
 			 * DW_AT_specification "chains" in the future.
 			 */
 			if (!declaration &&
-			    (err = index_specification(dindex, specification,
+			    (err = index_specification(state, specification,
 						       cu->module, die_offset)))
 				return err;
 		}
@@ -1041,12 +1044,12 @@ void drgn_dwarf_index_read_module(struct drgn_dwarf_index_update_state *state,
 			if (cu_err)
 				goto cu_err;
 
-			cu_err = index_cu_first_pass(state->dindex, &cu_buffer);
+			cu_err = index_cu_first_pass(state, &cu_buffer);
 			if (cu_err)
 				goto cu_err;
 
 			#pragma omp critical(drgn_dwarf_index_cus)
-			if (!drgn_dwarf_index_cu_vector_append(&state->dindex->cus,
+			if (!drgn_dwarf_index_cu_vector_append(&state->cus,
 							       &cu))
 				cu_err = &drgn_enomem;
 			if (cu_err) {
@@ -1481,7 +1484,7 @@ static void drgn_dwarf_index_rollback(struct drgn_dwarf_index *dindex)
 		 * entries must also be new, so there's no need to preserve
 		 * them.
 		 */
-		for (size_t index = 0; index < shard->dies.size; i++) {
+		for (size_t index = 0; index < shard->dies.size; index++) {
 			struct drgn_dwarf_index_die *die =
 				&shard->dies.data[index];
 			if (die->next != UINT32_MAX &&
@@ -1522,29 +1525,59 @@ drgn_dwarf_index_update_end(struct drgn_dwarf_index_update_state *state)
 	if (state->err)
 		goto err;
 
-	#pragma omp parallel for schedule(dynamic)
-	for (size_t i = state->old_cus_size; i < dindex->cus.size; i++) {
-		if (drgn_dwarf_index_update_cancelled(state))
-			continue;
-		struct drgn_dwarf_index_cu *cu = &dindex->cus.data[i];
-		struct drgn_dwarf_index_cu_buffer buffer;
-		drgn_dwarf_index_cu_buffer_init(&buffer, cu);
-		buffer.bb.pos += cu->is_64_bit ? 23 : 11;
-		struct drgn_error *cu_err =
-			index_cu_second_pass(&dindex->global, &buffer);
-		if (cu_err)
-			drgn_dwarf_index_update_cancel(state, cu_err);
+	if (!drgn_dwarf_index_cu_vector_reserve(&dindex->cus,
+						dindex->cus.size +
+						state->cus.size)) {
+		state->err = &drgn_enomem;
+		goto err;
+	}
+	memcpy(dindex->cus.data + dindex->cus.size, state->cus.data,
+	       state->cus.size * sizeof(state->cus.data[0]));
+	dindex->cus.size += state->cus.size;
+	state->cus.size = 0;
+	for (struct drgn_dwarf_index_specification_map_iterator it =
+	     drgn_dwarf_index_specification_map_first(&state->specifications);
+	     it.entry; it = drgn_dwarf_index_specification_map_next(it)) {
+		if (drgn_dwarf_index_specification_map_insert(&dindex->specifications,
+							      it.entry,
+							      NULL) == -1) {
+			state->err = &drgn_enomem;
+			break;
+		}
+	}
+
+	if (!state->err) {
+		#pragma omp parallel for schedule(dynamic)
+		for (size_t i = state->old_cus_size; i < dindex->cus.size;
+		     i++) {
+			if (drgn_dwarf_index_update_cancelled(state))
+				continue;
+			struct drgn_dwarf_index_cu *cu = &dindex->cus.data[i];
+			struct drgn_dwarf_index_cu_buffer buffer;
+			drgn_dwarf_index_cu_buffer_init(&buffer, cu);
+			buffer.bb.pos += cu->is_64_bit ? 23 : 11;
+			struct drgn_error *cu_err =
+				index_cu_second_pass(&dindex->global, &buffer);
+			if (cu_err)
+				drgn_dwarf_index_update_cancel(state, cu_err);
+		}
 	}
 	if (state->err) {
 		drgn_dwarf_index_rollback(state->dindex);
 		goto err;
 	}
+	drgn_dwarf_index_specification_map_deinit(&state->specifications);
+	drgn_dwarf_index_cu_vector_deinit(&state->cus);
 	return NULL;
 
 err:
 	for (size_t i = state->old_cus_size; i < dindex->cus.size; i++)
 		drgn_dwarf_index_cu_deinit(&dindex->cus.data[i]);
 	dindex->cus.size = state->old_cus_size;
+	for (size_t i = 0; i < state->cus.size; i++)
+		drgn_dwarf_index_cu_deinit(&state->cus.data[i]);
+	drgn_dwarf_index_specification_map_deinit(&state->specifications);
+	drgn_dwarf_index_cu_vector_deinit(&state->cus);
 	return state->err;
 }
 
@@ -1623,21 +1656,25 @@ drgn_dwarf_index_iterator_init(struct drgn_dwarf_index_iterator *it,
 	return NULL;
 }
 
-static inline bool
-drgn_dwarf_index_iterator_matches_tag(struct drgn_dwarf_index_iterator *it,
-				      struct drgn_dwarf_index_die *die)
+static inline bool die_matches_tags(struct drgn_dwarf_index_die *die,
+				    const uint64_t *tags, size_t num_tags)
 {
-	size_t i;
-
-	if (it->num_tags == 0)
+	if (num_tags == 0)
 		return true;
-	for (i = 0; i < it->num_tags; i++) {
-		if (die->tag == it->tags[i])
+	for (size_t i = 0; i < num_tags; i++) {
+		if (die->tag == tags[i])
 			return true;
 	}
 	return false;
 }
 
+static inline bool
+drgn_dwarf_index_iterator_matches_tag(struct drgn_dwarf_index_iterator *it,
+				      struct drgn_dwarf_index_die *die)
+{
+	return die_matches_tags(die, it->tags, it->num_tags);
+}
+
 struct drgn_dwarf_index_die *
 drgn_dwarf_index_iterator_next(struct drgn_dwarf_index_iterator *it)
 {
@@ -1681,6 +1718,65 @@ drgn_dwarf_index_iterator_next(struct drgn_dwarf_index_iterator *it)
 	return die;
 }
 
+static struct drgn_error *
+for_each_in_shard(struct drgn_dwarf_index_namespace *ns, size_t shard_index,
+		  const uint64_t *tags, size_t num_tags,
+		  const char *module_name, drgn_dwarf_index_for_each_fn *fn,
+		  void *arg)
+{
+	struct drgn_error *err;
+	struct drgn_dwarf_index_shard *shard = &ns->shards[shard_index];
+	for (struct drgn_dwarf_index_die_map_iterator it =
+	     drgn_dwarf_index_die_map_first(&shard->map);
+	     it.entry; it = drgn_dwarf_index_die_map_next(it)) {
+		uint32_t index = it.entry->value;
+		while (index != UINT32_MAX) {
+			struct drgn_dwarf_index_die *die =
+				&shard->dies.data[index];
+			index = die->next;
+			if (!die_matches_tags(die, tags, num_tags))
+				continue;
+			if (module_name &&
+			    (!die->module->name ||
+			     strcmp(die->module->name, module_name) != 0))
+				continue;
+			err = fn(shard_index, it.entry->key.str,
+				 it.entry->key.len, die, arg);
+			if (err)
+				return err;
+		}
+	}
+	return NULL;
+}
+
+struct drgn_error *
+drgn_dwarf_index_for_each(struct drgn_dwarf_index_namespace *ns,
+			  const uint64_t *tags, size_t num_tags,
+			  const char *module_name,
+			  drgn_dwarf_index_for_each_fn *fn, void *arg)
+{
+	struct drgn_error *err = index_namespace(ns);
+	if (err)
+		return err;
+
+	#pragma omp parallel for schedule(dynamic)
+	for (size_t i = 0; i < ARRAY_SIZE(ns->shards); i++) {
+		if (err)
+			continue;
+		struct drgn_error *shard_err =
+			for_each_in_shard(ns, i, tags, num_tags, module_name,
+					  fn, arg);
+		if (shard_err) {
+			#pragma omp critical(drgn_dwarf_index_for_each)
+			if (err)
+				drgn_error_destroy(shard_err);
+			else
+				err = shard_err;
+		}
+	}
+	return err;
+}
+
 struct drgn_error *drgn_dwarf_index_get_die(struct drgn_dwarf_index_die *die,
 					    Dwarf_Die *die_ret)
 {
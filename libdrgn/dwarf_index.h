@@ -188,6 +188,14 @@ void drgn_dwarf_index_deinit(struct drgn_dwarf_index *dindex);
 struct drgn_dwarf_index_update_state {
 	struct drgn_dwarf_index *dindex;
 	size_t old_cus_size;
+	/**
+	 * Compilation units and specifications found by @ref
+	 * drgn_dwarf_index_read_module(). They are only added to @c dindex by
+	 * @ref drgn_dwarf_index_update_end(), so reading modules doesn't
+	 * modify anything that a concurrent search may access.
+	 */
+	struct drgn_dwarf_index_cu_vector cus;
+	struct drgn_dwarf_index_specification_map specifications;
 	struct drgn_error *err;
 };
 
@@ -212,6 +220,9 @@ void drgn_dwarf_index_update_begin(struct drgn_dwarf_index_update_state *state,
  * error while indexing, this rolls back the index and removes the newly
  * reported modules.
  *
+ * This modifies the index, so unlike @ref drgn_dwarf_index_read_module(), it
+ * must not be called concurrently with searches.
+ *
  * @return @c NULL on success, non-@c NULL if the update was cancelled or there
  * was another error.
  */
@@ -305,6 +316,44 @@ drgn_dwarf_index_iterator_init(struct drgn_dwarf_index_iterator *it,
 struct drgn_dwarf_index_die *
 drgn_dwarf_index_iterator_next(struct drgn_dwarf_index_iterator *it);
 
+/**
+ * Callback for @ref drgn_dwarf_index_for_each().
+ *
+ * @param[in] shard Index of the shard containing @p die, less than <tt>1 <<
+ * DRGN_DWARF_INDEX_SHARD_BITS</tt>.
+ * @param[in] name Name of the DIE. This is null-terminated.
+ * @param[in] name_len Length of @p name.
+ * @param[in] die Indexed DIE.
+ * @param[in] arg Argument passed to @ref drgn_dwarf_index_for_each().
+ * @return @c NULL on success, non-@c NULL to stop iterating and return an error.
+ */
+typedef struct drgn_error *
+drgn_dwarf_index_for_each_fn(size_t shard, const char *name, size_t name_len,
+			     struct drgn_dwarf_index_die *die, void *arg);
+
+/**
+ * Call a function for every DIE in a DWARF index namespace.
+ *
+ * The shards of the namespace are visited in parallel, so @p fn may be called
+ * concurrently from multiple threads, but it is never called concurrently for
+ * DIEs in the same shard. Like @ref drgn_dwarf_index_iterator_next(), @p fn is
+ * passed the parent @c DW_TAG_enumeration_type for @c DW_TAG_enumerator DIEs.
+ *
+ * @param[in] ns DWARF index namespace.
+ * @param[in] tags List of DIE tags to visit.
+ * @param[in] num_tags Number of tags in @p tags, or zero to visit any tag.
+ * @param[in] module_name If not @c NULL, only visit DIEs in modules with this
+ * name.
+ * @param[in] fn Callback.
+ * @param[in] arg Argument to pass to @p fn.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *
+drgn_dwarf_index_for_each(struct drgn_dwarf_index_namespace *ns,
+			  const uint64_t *tags, size_t num_tags,
+			  const char *module_name,
+			  drgn_dwarf_index_for_each_fn *fn, void *arg);
+
 /**
  * Get a @c Dwarf_Die from a @ref drgn_dwarf_index_die.
  *
@@ -0,0 +1,546 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// SPDX-License-Identifier: GPL-3.0+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "error.h"
+#include "expression.h"
+#include "hash_table.h"
+#include "language.h"
+#include "object.h"
+#include "program.h"
+#include "util.h"
+#include "vector.h"
+
+DEFINE_VECTOR_FUNCTIONS(drgn_expression_insn_vector)
+DEFINE_VECTOR_FUNCTIONS(drgn_expression_constant_vector)
+DEFINE_HASH_TABLE_FUNCTIONS(drgn_expression_map, c_string_key_hash_pair,
+			    c_string_key_eq)
+
+static bool drgn_expression_opcode_has_name(enum drgn_expression_opcode opcode)
+{
+	return (opcode == DRGN_EXPR_MEMBER ||
+		opcode == DRGN_EXPR_MEMBER_DEREFERENCE);
+}
+
+static void drgn_expression_insns_deinit(struct drgn_expression_insn *insns,
+					 size_t num_insns)
+{
+	for (size_t i = 0; i < num_insns; i++) {
+		if (drgn_expression_opcode_has_name(insns[i].opcode))
+			free(insns[i].name);
+	}
+}
+
+static void drgn_expression_constants_deinit(struct drgn_object *constants,
+					     size_t num_constants)
+{
+	for (size_t i = 0; i < num_constants; i++)
+		drgn_object_deinit(&constants[i]);
+}
+
+void drgn_expression_builder_init(struct drgn_expression_builder *builder,
+				  struct drgn_program *prog)
+{
+	builder->prog = prog;
+	drgn_expression_insn_vector_init(&builder->insns);
+	drgn_expression_constant_vector_init(&builder->constants);
+	builder->depth = 0;
+	builder->max_depth = 0;
+}
+
+void drgn_expression_builder_deinit(struct drgn_expression_builder *builder)
+{
+	drgn_expression_constants_deinit(builder->constants.data,
+					 builder->constants.size);
+	drgn_expression_constant_vector_deinit(&builder->constants);
+	drgn_expression_insns_deinit(builder->insns.data, builder->insns.size);
+	drgn_expression_insn_vector_deinit(&builder->insns);
+}
+
+/* Change in the stack depth after executing an instruction. */
+static int
+drgn_expression_opcode_stack_effect(enum drgn_expression_opcode opcode)
+{
+	switch (opcode) {
+	case DRGN_EXPR_CONSTANT:
+		return 1;
+	case DRGN_EXPR_MEMBER:
+	case DRGN_EXPR_MEMBER_DEREFERENCE:
+	case DRGN_EXPR_DEREFERENCE:
+	case DRGN_EXPR_ADDRESS_OF:
+	case DRGN_EXPR_CAST:
+	case DRGN_EXPR_POS:
+	case DRGN_EXPR_NEG:
+	case DRGN_EXPR_NOT:
+	case DRGN_EXPR_LOGICAL_NOT:
+	case DRGN_EXPR_BOOL:
+		return 0;
+	/*
+	 * Jumps only pop when they fall through, which is the path that the
+	 * following instructions are compiled for.
+	 */
+	default:
+		return -1;
+	}
+}
+
+static struct drgn_error *
+drgn_expression_builder_append_insn(struct drgn_expression_builder *builder,
+				    const struct drgn_expression_insn *insn)
+{
+	if (!drgn_expression_insn_vector_append(&builder->insns, insn))
+		return &drgn_enomem;
+	builder->depth += drgn_expression_opcode_stack_effect(insn->opcode);
+	if (builder->depth > builder->max_depth)
+		builder->max_depth = builder->depth;
+	return NULL;
+}
+
+struct drgn_error *
+drgn_expression_builder_append(struct drgn_expression_builder *builder,
+			       enum drgn_expression_opcode opcode)
+{
+	struct drgn_expression_insn insn = { .opcode = opcode };
+	return drgn_expression_builder_append_insn(builder, &insn);
+}
+
+struct drgn_error *
+drgn_expression_builder_append_constant(struct drgn_expression_builder *builder,
+					const struct drgn_object *obj)
+{
+	struct drgn_error *err;
+
+	struct drgn_object *constant =
+		drgn_expression_constant_vector_append_entry(&builder->constants);
+	if (!constant)
+		return &drgn_enomem;
+	drgn_object_init(constant, builder->prog);
+	err = drgn_object_copy(constant, obj);
+	if (err)
+		goto err;
+
+	struct drgn_expression_insn insn = {
+		.opcode = DRGN_EXPR_CONSTANT,
+		.index = builder->constants.size - 1,
+	};
+	err = drgn_expression_builder_append_insn(builder, &insn);
+	if (err)
+		goto err;
+	return NULL;
+
+err:
+	drgn_object_deinit(constant);
+	builder->constants.size--;
+	return err;
+}
+
+struct drgn_error *
+drgn_expression_builder_append_member(struct drgn_expression_builder *builder,
+				      enum drgn_expression_opcode opcode,
+				      const char *name, size_t name_len)
+{
+	struct drgn_expression_insn insn = {
+		.opcode = opcode,
+		.name = strndup(name, name_len),
+	};
+	if (!insn.name)
+		return &drgn_enomem;
+	struct drgn_error *err = drgn_expression_builder_append_insn(builder,
+								     &insn);
+	if (err)
+		free(insn.name);
+	return err;
+}
+
+struct drgn_error *
+drgn_expression_builder_append_cast(struct drgn_expression_builder *builder,
+				    struct drgn_qualified_type qualified_type)
+{
+	struct drgn_expression_insn insn = {
+		.opcode = DRGN_EXPR_CAST,
+		.type = qualified_type,
+	};
+	return drgn_expression_builder_append_insn(builder, &insn);
+}
+
+struct drgn_error *
+drgn_expression_builder_append_jump(struct drgn_expression_builder *builder,
+				    enum drgn_expression_opcode opcode,
+				    size_t *ret)
+{
+	*ret = builder->insns.size;
+	return drgn_expression_builder_append(builder, opcode);
+}
+
+void
+drgn_expression_builder_set_jump_target(struct drgn_expression_builder *builder,
+					size_t jump)
+{
+	builder->insns.data[jump].target = builder->insns.size;
+}
+
+struct drgn_error *
+drgn_expression_builder_finish(struct drgn_expression_builder *builder,
+			       struct drgn_expression **ret)
+{
+	if (builder->depth != 1) {
+		return drgn_error_create(DRGN_ERROR_SYNTAX,
+					 "expected expression");
+	}
+
+	struct drgn_expression *expr = malloc(sizeof(*expr));
+	if (!expr)
+		return &drgn_enomem;
+	drgn_expression_insn_vector_shrink_to_fit(&builder->insns);
+	drgn_expression_constant_vector_shrink_to_fit(&builder->constants);
+	expr->prog = builder->prog;
+	expr->insns = builder->insns.data;
+	expr->num_insns = builder->insns.size;
+	expr->constants = builder->constants.data;
+	expr->num_constants = builder->constants.size;
+	expr->stack_size = builder->max_depth;
+	expr->text = NULL;
+	expr->refcount = 1;
+	expr->lru_prev = expr->lru_next = NULL;
+
+	drgn_expression_builder_init(builder, builder->prog);
+	*ret = expr;
+	return NULL;
+}
+
+void drgn_expression_destroy(struct drgn_expression *expr)
+{
+	if (!expr)
+		return;
+	drgn_expression_constants_deinit(expr->constants, expr->num_constants);
+	free(expr->constants);
+	drgn_expression_insns_deinit(expr->insns, expr->num_insns);
+	free(expr->insns);
+	free(expr);
+}
+
+/* Replace an object with 0 or 1. */
+static inline struct drgn_error *
+drgn_expression_set_bool(struct drgn_object *obj, bool value)
+{
+	return drgn_object_integer_literal(obj, value);
+}
+
+static struct drgn_error *
+drgn_expression_cmp(struct drgn_object *lhs, const struct drgn_object *rhs,
+		    enum drgn_expression_opcode opcode)
+{
+	int cmp;
+	struct drgn_error *err = drgn_object_cmp(lhs, rhs, &cmp);
+	if (err)
+		return err;
+	bool value;
+	switch (opcode) {
+	case DRGN_EXPR_EQ:
+		value = cmp == 0;
+		break;
+	case DRGN_EXPR_NE:
+		value = cmp != 0;
+		break;
+	case DRGN_EXPR_LT:
+		value = cmp < 0;
+		break;
+	case DRGN_EXPR_GT:
+		value = cmp > 0;
+		break;
+	case DRGN_EXPR_LE:
+		value = cmp <= 0;
+		break;
+	default: /* DRGN_EXPR_GE */
+		value = cmp >= 0;
+		break;
+	}
+	return drgn_expression_set_bool(lhs, value);
+}
+
+static struct drgn_error *
+drgn_expression_subscript(struct drgn_object *obj,
+			  const struct drgn_object *index)
+{
+	union drgn_value value;
+	struct drgn_error *err = drgn_object_read_integer(index, &value);
+	if (err)
+		return err;
+	return drgn_object_subscript(obj, obj, value.svalue);
+}
+
+static drgn_binary_op * const drgn_expression_binary_ops[] = {
+	[DRGN_EXPR_ADD] = drgn_object_add,
+	[DRGN_EXPR_SUB] = drgn_object_sub,
+	[DRGN_EXPR_MUL] = drgn_object_mul,
+	[DRGN_EXPR_DIV] = drgn_object_div,
+	[DRGN_EXPR_MOD] = drgn_object_mod,
+	[DRGN_EXPR_LSHIFT] = drgn_object_lshift,
+	[DRGN_EXPR_RSHIFT] = drgn_object_rshift,
+	[DRGN_EXPR_AND] = drgn_object_and,
+	[DRGN_EXPR_OR] = drgn_object_or,
+	[DRGN_EXPR_XOR] = drgn_object_xor,
+};
+
+static drgn_unary_op * const drgn_expression_unary_ops[] = {
+	[DRGN_EXPR_DEREFERENCE] = drgn_object_dereference,
+	[DRGN_EXPR_ADDRESS_OF] = drgn_object_address_of,
+	[DRGN_EXPR_POS] = drgn_object_pos,
+	[DRGN_EXPR_NEG] = drgn_object_neg,
+	[DRGN_EXPR_NOT] = drgn_object_not,
+};
+
+struct drgn_error *drgn_expression_eval(const struct drgn_expression *expr,
+					struct drgn_object *res)
+{
+	struct drgn_error *err;
+
+	if (drgn_object_program(res) != expr->prog) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "object is from different program");
+	}
+
+	struct drgn_object *stack = malloc_array(expr->stack_size,
+						 sizeof(*stack));
+	if (!stack)
+		return &drgn_enomem;
+	for (size_t i = 0; i < expr->stack_size; i++)
+		drgn_object_init(&stack[i], expr->prog);
+
+	/* Index of the next free stack slot. */
+	size_t sp = 0;
+	size_t pc = 0;
+	while (pc < expr->num_insns) {
+		const struct drgn_expression_insn *insn = &expr->insns[pc++];
+		struct drgn_object *top = sp ? &stack[sp - 1] : NULL;
+		bool value;
+
+		switch (insn->opcode) {
+		case DRGN_EXPR_CONSTANT:
+			err = drgn_object_copy(&stack[sp++],
+					       &expr->constants[insn->index]);
+			break;
+		case DRGN_EXPR_MEMBER:
+			err = drgn_object_member(top, top, insn->name);
+			break;
+		case DRGN_EXPR_MEMBER_DEREFERENCE:
+			err = drgn_object_member_dereference(top, top,
+							     insn->name);
+			break;
+		case DRGN_EXPR_SUBSCRIPT:
+			sp--;
+			err = drgn_expression_subscript(top - 1, top);
+			break;
+		case DRGN_EXPR_CAST:
+			err = drgn_object_cast(top, insn->type, top);
+			break;
+		case DRGN_EXPR_DEREFERENCE:
+		case DRGN_EXPR_ADDRESS_OF:
+		case DRGN_EXPR_POS:
+		case DRGN_EXPR_NEG:
+		case DRGN_EXPR_NOT:
+			err = drgn_expression_unary_ops[insn->opcode](top, top);
+			break;
+		case DRGN_EXPR_LOGICAL_NOT:
+		case DRGN_EXPR_BOOL:
+			err = drgn_object_bool(top, &value);
+			if (err)
+				break;
+			if (insn->opcode == DRGN_EXPR_LOGICAL_NOT)
+				value = !value;
+			err = drgn_expression_set_bool(top, value);
+			break;
+		case DRGN_EXPR_ADD:
+		case DRGN_EXPR_SUB:
+		case DRGN_EXPR_MUL:
+		case DRGN_EXPR_DIV:
+		case DRGN_EXPR_MOD:
+		case DRGN_EXPR_LSHIFT:
+		case DRGN_EXPR_RSHIFT:
+		case DRGN_EXPR_AND:
+		case DRGN_EXPR_OR:
+		case DRGN_EXPR_XOR:
+			sp--;
+			err = drgn_expression_binary_ops[insn->opcode](top - 1,
+								       top - 1,
+								       top);
+			break;
+		case DRGN_EXPR_EQ:
+		case DRGN_EXPR_NE:
+		case DRGN_EXPR_LT:
+		case DRGN_EXPR_GT:
+		case DRGN_EXPR_LE:
+		case DRGN_EXPR_GE:
+			sp--;
+			err = drgn_expression_cmp(top - 1, top, insn->opcode);
+			break;
+		case DRGN_EXPR_JUMP_IF_FALSE:
+		case DRGN_EXPR_JUMP_IF_TRUE:
+			err = drgn_object_bool(top, &value);
+			if (err)
+				break;
+			if (value == (insn->opcode == DRGN_EXPR_JUMP_IF_TRUE)) {
+				err = drgn_expression_set_bool(top, value);
+				pc = insn->target;
+			} else {
+				sp--;
+			}
+			break;
+		default:
+			UNREACHABLE();
+		}
+		if (err)
+			goto out;
+	}
+	err = drgn_object_copy(res, &stack[0]);
+out:
+	for (size_t i = 0; i < expr->stack_size; i++)
+		drgn_object_deinit(&stack[i]);
+	free(stack);
+	return err;
+}
+
+/* Maximum number of compiled expressions cached by each program. */
+#define DRGN_EXPRESSION_CACHE_SIZE 1024
+
+static void drgn_expression_put(struct drgn_expression *expr)
+{
+	if (__atomic_sub_fetch(&expr->refcount, 1, __ATOMIC_ACQ_REL) == 0)
+		drgn_expression_destroy(expr);
+}
+
+static void drgn_expression_lru_remove(struct drgn_program *prog,
+				       struct drgn_expression *expr)
+{
+	if (expr->lru_prev)
+		expr->lru_prev->lru_next = expr->lru_next;
+	else
+		prog->expressions_mru = expr->lru_next;
+	if (expr->lru_next)
+		expr->lru_next->lru_prev = expr->lru_prev;
+	else
+		prog->expressions_lru = expr->lru_prev;
+}
+
+static void drgn_expression_lru_push(struct drgn_program *prog,
+				     struct drgn_expression *expr)
+{
+	expr->lru_prev = NULL;
+	expr->lru_next = prog->expressions_mru;
+	if (prog->expressions_mru)
+		prog->expressions_mru->lru_prev = expr;
+	else
+		prog->expressions_lru = expr;
+	prog->expressions_mru = expr;
+}
+
+void drgn_program_init_expressions(struct drgn_program *prog)
+{
+	drgn_expression_map_init(&prog->expressions);
+	prog->expressions_mru = prog->expressions_lru = NULL;
+}
+
+static void drgn_program_put_expressions(struct drgn_program *prog)
+{
+	for (struct drgn_expression_map_iterator it =
+	     drgn_expression_map_first(&prog->expressions);
+	     it.entry; it = drgn_expression_map_next(it)) {
+		free((char *)it.entry->key);
+		drgn_expression_put(it.entry->value);
+	}
+}
+
+void drgn_program_deinit_expressions(struct drgn_program *prog)
+{
+	drgn_program_put_expressions(prog);
+	drgn_expression_map_deinit(&prog->expressions);
+}
+
+void drgn_program_clear_expressions(struct drgn_program *prog)
+{
+	drgn_program_lock_types(prog);
+	drgn_program_put_expressions(prog);
+	drgn_expression_map_clear(&prog->expressions);
+	prog->expressions_mru = prog->expressions_lru = NULL;
+	drgn_program_unlock_types(prog);
+}
+
+/*
+ * Find or compile an expression and take a reference to it, which must be
+ * released with drgn_expression_put().
+ */
+static struct drgn_error *
+drgn_program_find_expression(struct drgn_program *prog, const char *expr,
+			     struct drgn_expression **ret)
+{
+	struct drgn_error *err;
+
+	struct drgn_expression_map_iterator it =
+		drgn_expression_map_search(&prog->expressions, &expr);
+	if (it.entry) {
+		struct drgn_expression *compiled = it.entry->value;
+		drgn_expression_lru_remove(prog, compiled);
+		drgn_expression_lru_push(prog, compiled);
+		__atomic_add_fetch(&compiled->refcount, 1, __ATOMIC_RELAXED);
+		*ret = compiled;
+		return NULL;
+	}
+
+	const struct drgn_language *lang = drgn_program_language(prog);
+	struct drgn_expression_builder builder;
+	drgn_expression_builder_init(&builder, prog);
+	err = lang->compile_expression(prog, expr, &builder);
+	struct drgn_expression_map_entry entry = {};
+	if (!err)
+		err = drgn_expression_builder_finish(&builder, &entry.value);
+	drgn_expression_builder_deinit(&builder);
+	if (err)
+		return err;
+
+	if (drgn_expression_map_size(&prog->expressions) >=
+	    DRGN_EXPRESSION_CACHE_SIZE) {
+		struct drgn_expression *lru = prog->expressions_lru;
+		it = drgn_expression_map_search(&prog->expressions, &lru->text);
+		drgn_expression_map_delete_iterator(&prog->expressions, it);
+		drgn_expression_lru_remove(prog, lru);
+		free((char *)lru->text);
+		drgn_expression_put(lru);
+	}
+
+	entry.key = strdup(expr);
+	if (!entry.key ||
+	    drgn_expression_map_insert(&prog->expressions, &entry, NULL) == -1) {
+		free((char *)entry.key);
+		drgn_expression_destroy(entry.value);
+		return &drgn_enomem;
+	}
+	entry.value->text = entry.key;
+	drgn_expression_lru_push(prog, entry.value);
+	/* One reference for the cache and one for the caller. */
+	entry.value->refcount = 2;
+	*ret = entry.value;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_eval(struct drgn_program *prog, const char *expr,
+		  struct drgn_object *res)
+{
+	/*
+	 * Compiled expressions are immutable, so only the cache lookup needs
+	 * the lock. The reference keeps the expression alive if it is evicted
+	 * in the meantime.
+	 */
+	struct drgn_expression *compiled;
+	drgn_program_lock_types(prog);
+	struct drgn_error *err = drgn_program_find_expression(prog, expr,
+							      &compiled);
+	drgn_program_unlock_types(prog);
+	if (err)
+		return err;
+	err = drgn_expression_eval(compiled, res);
+	drgn_expression_put(compiled);
+	return err;
+}
@@ -0,0 +1,215 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// SPDX-License-Identifier: GPL-3.0+
+
+/**
+ * @file
+ *
+ * Expression internals
+ *
+ * See @ref ExpressionInternals.
+ */
+
+#ifndef DRGN_EXPRESSION_H
+#define DRGN_EXPRESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "drgn.h"
+#include "vector.h"
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup ExpressionInternals Expressions
+ *
+ * Expression internals.
+ *
+ * An expression is compiled by its language (see @ref
+ * drgn_language::compile_expression) to bytecode for a simple stack machine
+ * whose stack holds @ref drgn_object%s. Identifiers and literals are resolved
+ * when the expression is compiled and stored as constants, so evaluating an
+ * expression only applies operators.
+ *
+ * Compiled expressions are cached by @ref drgn_program_eval(). The least
+ * recently used expression is evicted once the cache is full; expressions are
+ * reference counted so that an evicted expression can finish being evaluated.
+ *
+ * @{
+ */
+
+enum drgn_expression_opcode {
+	/** Push @ref drgn_expression_insn::index from the constants. */
+	DRGN_EXPR_CONSTANT,
+	/**
+	 * Replace the top object with its member @ref
+	 * drgn_expression_insn::name.
+	 */
+	DRGN_EXPR_MEMBER,
+	/**
+	 * Replace the top object with the member @ref
+	 * drgn_expression_insn::name of the object it points to.
+	 */
+	DRGN_EXPR_MEMBER_DEREFERENCE,
+	/** Pop an index and replace the top object with that element. */
+	DRGN_EXPR_SUBSCRIPT,
+	DRGN_EXPR_DEREFERENCE,
+	DRGN_EXPR_ADDRESS_OF,
+	/** Cast the top object to @ref drgn_expression_insn::type. */
+	DRGN_EXPR_CAST,
+	DRGN_EXPR_POS,
+	DRGN_EXPR_NEG,
+	DRGN_EXPR_NOT,
+	DRGN_EXPR_LOGICAL_NOT,
+	/** Replace the top object with 1 if it is true or 0 if it is false. */
+	DRGN_EXPR_BOOL,
+	/* Binary operators pop the right operand and replace the left one. */
+	DRGN_EXPR_ADD,
+	DRGN_EXPR_SUB,
+	DRGN_EXPR_MUL,
+	DRGN_EXPR_DIV,
+	DRGN_EXPR_MOD,
+	DRGN_EXPR_LSHIFT,
+	DRGN_EXPR_RSHIFT,
+	DRGN_EXPR_AND,
+	DRGN_EXPR_OR,
+	DRGN_EXPR_XOR,
+	DRGN_EXPR_EQ,
+	DRGN_EXPR_NE,
+	DRGN_EXPR_LT,
+	DRGN_EXPR_GT,
+	DRGN_EXPR_LE,
+	DRGN_EXPR_GE,
+	/**
+	 * If the top object is false, replace it with 0 and jump to @ref
+	 * drgn_expression_insn::target. Otherwise, pop it. This implements
+	 * <tt>&&</tt>.
+	 */
+	DRGN_EXPR_JUMP_IF_FALSE,
+	/**
+	 * If the top object is true, replace it with 1 and jump to @ref
+	 * drgn_expression_insn::target. Otherwise, pop it. This implements
+	 * <tt>||</tt>.
+	 */
+	DRGN_EXPR_JUMP_IF_TRUE,
+};
+
+struct drgn_expression_insn {
+	enum drgn_expression_opcode opcode;
+	union {
+		/** Index of the constant for @ref DRGN_EXPR_CONSTANT. */
+		size_t index;
+		/** Member name for member opcodes. */
+		char *name;
+		/** Type for @ref DRGN_EXPR_CAST. */
+		struct drgn_qualified_type type;
+		/** Instruction index for jump opcodes. */
+		size_t target;
+	};
+};
+
+struct drgn_expression {
+	struct drgn_program *prog;
+	struct drgn_expression_insn *insns;
+	size_t num_insns;
+	struct drgn_object *constants;
+	size_t num_constants;
+	/** Maximum depth of the evaluation stack. */
+	size_t stack_size;
+	/** Text of the expression, owned by the cache. */
+	const char *text;
+	/** References from the cache and from running evaluations. */
+	size_t refcount;
+	/** Neighbors in the cache, from most to least recently used. */
+	struct drgn_expression *lru_prev, *lru_next;
+};
+
+DEFINE_VECTOR_TYPE(drgn_expression_insn_vector, struct drgn_expression_insn)
+DEFINE_VECTOR_TYPE(drgn_expression_constant_vector, struct drgn_object)
+
+/** Builder used by languages to compile a @ref drgn_expression. */
+struct drgn_expression_builder {
+	struct drgn_program *prog;
+	struct drgn_expression_insn_vector insns;
+	struct drgn_expression_constant_vector constants;
+	size_t depth;
+	size_t max_depth;
+};
+
+void drgn_expression_builder_init(struct drgn_expression_builder *builder,
+				  struct drgn_program *prog);
+
+void drgn_expression_builder_deinit(struct drgn_expression_builder *builder);
+
+/** Append an instruction which doesn't take an operand. */
+struct drgn_error *
+drgn_expression_builder_append(struct drgn_expression_builder *builder,
+			       enum drgn_expression_opcode opcode);
+
+/** Append a @ref DRGN_EXPR_CONSTANT instruction pushing a copy of @p obj. */
+struct drgn_error *
+drgn_expression_builder_append_constant(struct drgn_expression_builder *builder,
+					const struct drgn_object *obj);
+
+/** Append a member instruction for a name which is not null-terminated. */
+struct drgn_error *
+drgn_expression_builder_append_member(struct drgn_expression_builder *builder,
+				      enum drgn_expression_opcode opcode,
+				      const char *name, size_t name_len);
+
+struct drgn_error *
+drgn_expression_builder_append_cast(struct drgn_expression_builder *builder,
+				    struct drgn_qualified_type qualified_type);
+
+/**
+ * Append a jump instruction whose target will be set later with @ref
+ * drgn_expression_builder_set_jump_target().
+ *
+ * @param[out] ret Returned instruction index.
+ */
+struct drgn_error *
+drgn_expression_builder_append_jump(struct drgn_expression_builder *builder,
+				    enum drgn_expression_opcode opcode,
+				    size_t *ret);
+
+/** Make a jump instruction jump to the next instruction appended. */
+void
+drgn_expression_builder_set_jump_target(struct drgn_expression_builder *builder,
+					size_t jump);
+
+/**
+ * Create a @ref drgn_expression from a builder.
+ *
+ * On success, the builder is reset and must still be deinitialized.
+ */
+struct drgn_error *
+drgn_expression_builder_finish(struct drgn_expression_builder *builder,
+			       struct drgn_expression **ret);
+
+void drgn_expression_destroy(struct drgn_expression *expr);
+
+/**
+ * Evaluate a @ref drgn_expression.
+ *
+ * @param[out] res Result. It must have been initialized for the same program.
+ */
+struct drgn_error *drgn_expression_eval(const struct drgn_expression *expr,
+					struct drgn_object *res);
+
+void drgn_program_init_expressions(struct drgn_program *prog);
+
+/** Free the expressions cached by @ref drgn_program_eval(). */
+void drgn_program_deinit_expressions(struct drgn_program *prog);
+
+/**
+ * Drop the expressions cached by @ref drgn_program_eval().
+ *
+ * Compiled expressions hold the objects and types that their identifiers and
+ * casts resolved to, so this must be called whenever new debugging
+ * information or finders could change what a name refers to.
+ */
+void drgn_program_clear_expressions(struct drgn_program *prog);
+
+/** @} */
+
+#endif /* DRGN_EXPRESSION_H */
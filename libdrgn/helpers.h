@@ -13,16 +13,94 @@
 #ifndef DRGN_HELPERS_H
 #define DRGN_HELPERS_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#include "drgn.h"
+#include "hash_table.h"
+#include "string_builder.h"
+#include "vector.h"
+
 struct drgn_object;
 struct drgn_program;
+struct pgtable_iterator;
 
 struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
 					uint64_t pgtable, uint64_t virt_addr,
 					void *buf, size_t count);
 
+/** Mapped range returned by @ref linux_helper_pgtable_range_iterator_next(). */
+struct linux_helper_pgtable_range {
+	uint64_t start;
+	uint64_t size;
+	uint64_t phys_addr;
+	/** Bitmask of @ref pgtable_flags. */
+	unsigned int flags;
+};
+
+/**
+ * Iterator over the mapped ranges of a page table.
+ *
+ * Virtually and physically contiguous ranges with the same flags are merged.
+ * Unmapped ranges are skipped a whole page table entry at a time at the
+ * highest level which is not present.
+ */
+struct linux_helper_pgtable_range_iterator {
+	struct pgtable_iterator *it;
+	/* Last virtual address to return (inclusive). */
+	uint64_t last;
+	bool done;
+	/* Range which was translated but didn't extend the previous one. */
+	bool have_pending;
+	struct linux_helper_pgtable_range pending;
+	struct linux_helper_pgtable_range range;
+};
+
+/**
+ * Initialize a @ref linux_helper_pgtable_range_iterator.
+ *
+ * @param[in] pgtable Address of the top-level page table.
+ * @param[in] start First virtual address to return.
+ * @param[in] last Last virtual address to return (inclusive).
+ */
+struct drgn_error *
+linux_helper_pgtable_range_iterator_init(struct linux_helper_pgtable_range_iterator *it,
+					 struct drgn_program *prog,
+					 uint64_t pgtable, uint64_t start,
+					 uint64_t last);
+
+void
+linux_helper_pgtable_range_iterator_deinit(struct linux_helper_pgtable_range_iterator *it);
+
+/**
+ * Get the next mapped range from a @ref linux_helper_pgtable_range_iterator.
+ *
+ * @param[out] ret Returned range. It is valid until the next call.
+ * @return @c NULL on success, &@ref drgn_stop if there are no more ranges,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_pgtable_range_iterator_next(struct linux_helper_pgtable_range_iterator *it,
+					 const struct linux_helper_pgtable_range **ret);
+
+/**
+ * Write a range of a virtual address space to a file.
+ *
+ * The mapped ranges are read from physical memory in bounded chunks and written
+ * at the corresponding file offsets. Unmapped pages and pages which are
+ * missing from the core dump are not written, so they read back as holes.
+ *
+ * @param[in] pgtable Address of the top-level page table.
+ * @param[in] fd File descriptor to write to.
+ * @param[in] offset File offset to write @p virt_addr at.
+ * @param[out] written_ret Returned number of bytes which were read and written.
+ */
+struct drgn_error *linux_helper_write_vm(struct drgn_program *prog,
+					 uint64_t pgtable, uint64_t virt_addr,
+					 uint64_t size, int fd, uint64_t offset,
+					 uint64_t *written_ret);
+
 struct drgn_error *
 linux_helper_radix_tree_lookup(struct drgn_object *res,
 			       const struct drgn_object *root, uint64_t index);
@@ -43,4 +121,1012 @@ struct drgn_error *linux_helper_find_task(struct drgn_object *res,
 					  const struct drgn_object *ns,
 					  uint64_t pid);
 
+/**
+ * Iterator over a circular doubly-linked list (<tt>struct list_head</tt>) or a
+ * hash list (<tt>struct hlist_head</tt>).
+ *
+ * Nodes are followed by reading raw pointers at precomputed offsets rather
+ * than through objects. Iteration fails if the list is longer than a maximum
+ * length or, if validation is enabled, if it contains a cycle which doesn't go
+ * through the head. Both may happen for corrupted lists in core dumps.
+ */
+struct linux_helper_list_iterator {
+	struct drgn_program *prog;
+	/* Pointer type of the returned entries. */
+	struct drgn_qualified_type entry_type;
+	/* Offset of the list node in an entry. */
+	uint64_t member_offset;
+	/* Offset of the next (or prev) pointer in a list node. */
+	uint64_t next_offset;
+	/* Address of the list head, or 0 for a hash list. */
+	uint64_t head;
+	/* Address of the next list node. */
+	uint64_t pos;
+	uint64_t count;
+	uint64_t max_length;
+	bool validate;
+	/* Brent's cycle detection state. */
+	uint64_t saved_pos;
+	uint64_t power;
+	uint64_t lambda;
+};
+
+/**
+ * Initialize a @ref linux_helper_list_iterator over a <tt>struct
+ * list_head</tt>.
+ *
+ * @param[in] head <tt>struct list_head *</tt>.
+ * @param[in] entry_type Type of the entries containing the list nodes. If @c
+ * NULL, the <tt>struct list_head *</tt> nodes are returned.
+ * @param[in] member Member designator of the list node in @p entry_type.
+ * @param[in] reverse Whether to iterate in reverse order.
+ * @param[in] max_length Maximum number of entries, or @c UINT64_MAX for no
+ * limit.
+ * @param[in] validate Whether to check for cycles.
+ */
+struct drgn_error *
+linux_helper_list_iterator_init(struct linux_helper_list_iterator *it,
+				const struct drgn_object *head,
+				struct drgn_qualified_type entry_type,
+				const char *member, bool reverse,
+				uint64_t max_length, bool validate);
+
+/**
+ * Initialize a @ref linux_helper_list_iterator over a <tt>struct
+ * hlist_head</tt>.
+ *
+ * @param[in] head <tt>struct hlist_head *</tt>.
+ * @param[in] entry_type Type of the entries containing the list nodes. If @c
+ * NULL, the <tt>struct hlist_node *</tt> nodes are returned.
+ * @param[in] member Member designator of the list node in @p entry_type.
+ * @param[in] max_length Maximum number of entries, or @c UINT64_MAX for no
+ * limit.
+ * @param[in] validate Whether to check for cycles.
+ */
+struct drgn_error *
+linux_helper_hlist_iterator_init(struct linux_helper_list_iterator *it,
+				 const struct drgn_object *head,
+				 struct drgn_qualified_type entry_type,
+				 const char *member, uint64_t max_length,
+				 bool validate);
+
+/**
+ * Get the address of the next entry from a @ref linux_helper_list_iterator.
+ *
+ * @return @c NULL on success, &@ref drgn_stop if there are no more entries,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_list_iterator_next(struct linux_helper_list_iterator *it,
+				uint64_t *ret);
+
+struct linux_helper_rbtree_frame {
+	uint64_t node;
+	uint64_t right;
+};
+
+DEFINE_VECTOR_TYPE(linux_helper_rbtree_frame_vector,
+		   struct linux_helper_rbtree_frame)
+
+/**
+ * Iterator over a red-black tree (<tt>struct rb_root</tt>) in sort order.
+ *
+ * Each node is read once. Iteration fails if the tree has more than a maximum
+ * number of nodes or, if validation is enabled, if a child's parent pointer
+ * doesn't point to the node it was reached from or the tree is deeper than any
+ * valid red-black tree.
+ */
+struct linux_helper_rbtree_iterator {
+	struct drgn_program *prog;
+	/* Pointer type of the returned entries. */
+	struct drgn_qualified_type entry_type;
+	/* Offset of the red-black node in an entry. */
+	uint64_t member_offset;
+	/* Size of and offsets of pointers in a red-black node. */
+	uint64_t node_size;
+	uint64_t parent_color_offset;
+	uint64_t right_offset;
+	uint64_t left_offset;
+	/*
+	 * Nodes whose left subtree has been visited but which haven't been
+	 * returned yet, with their right children.
+	 */
+	struct linux_helper_rbtree_frame_vector stack;
+	uint64_t count;
+	uint64_t max_length;
+	bool validate;
+};
+
+/**
+ * Initialize a @ref linux_helper_rbtree_iterator.
+ *
+ * @param[in] root <tt>struct rb_root *</tt>.
+ * @param[in] entry_type Type of the entries containing the red-black nodes. If
+ * @c NULL, the <tt>struct rb_node *</tt> nodes are returned.
+ * @param[in] member Member designator of the red-black node in @p entry_type.
+ * @param[in] max_length Maximum number of entries, or @c UINT64_MAX for no
+ * limit.
+ * @param[in] validate Whether to check parent pointers and the depth of the
+ * tree.
+ */
+struct drgn_error *
+linux_helper_rbtree_iterator_init(struct linux_helper_rbtree_iterator *it,
+				  const struct drgn_object *root,
+				  struct drgn_qualified_type entry_type,
+				  const char *member, uint64_t max_length,
+				  bool validate);
+
+void
+linux_helper_rbtree_iterator_deinit(struct linux_helper_rbtree_iterator *it);
+
+/**
+ * Get the address of the next entry from a @ref linux_helper_rbtree_iterator.
+ *
+ * @return @c NULL on success, &@ref drgn_stop if there are no more entries,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_rbtree_iterator_next(struct linux_helper_rbtree_iterator *it,
+				  uint64_t *ret);
+
+/** Maximum number of slots in a radix tree node supported by iterators. */
+#define LINUX_HELPER_RADIX_TREE_MAX_SLOTS 64
+
+struct linux_helper_radix_tree_frame {
+	/* Address of the node. */
+	uint64_t node;
+	/* Index of the first slot. */
+	uint64_t index;
+	/* Bitmap of the non-empty slots which haven't been visited yet. */
+	uint64_t bitmap;
+	uint8_t shift;
+	uint64_t slots[LINUX_HELPER_RADIX_TREE_MAX_SLOTS];
+};
+
+DEFINE_VECTOR_TYPE(linux_helper_radix_tree_frame_vector,
+		   struct linux_helper_radix_tree_frame)
+
+/**
+ * Iterator over the entries in a radix tree (<tt>struct radix_tree_root</tt>)
+ * or XArray (<tt>struct xarray</tt>) in index order.
+ *
+ * Both the pre-XArray radix tree node format (<tt>struct radix_tree_node</tt>)
+ * and the XArray node format (<tt>struct xa_node</tt>) are supported. The
+ * shift and slot array of each node are read with a single memory read, and
+ * empty slots are skipped using a bitmap of the non-empty slots. Sibling,
+ * retry, and zero entries are skipped.
+ */
+struct linux_helper_radix_tree_iterator {
+	struct drgn_program *prog;
+	/* <tt>void *</tt>. */
+	struct drgn_qualified_type entry_type;
+	/* Tag of internal node entries: 1 for radix trees, 2 for XArrays. */
+	uint64_t internal_node;
+	/* Offsets of the shift and slots members relative to read_offset. */
+	uint64_t shift_offset;
+	uint64_t slots_offset;
+	/* Part of a node which is read. */
+	uint64_t read_offset;
+	uint64_t read_size;
+	uint64_t node_size;
+	unsigned int map_shift;
+	/* Buffer of read_size bytes. */
+	char *buf;
+	/* Entry stored directly in the root, or 0. */
+	uint64_t root_entry;
+	struct linux_helper_radix_tree_frame_vector stack;
+};
+
+/**
+ * Initialize a @ref linux_helper_radix_tree_iterator.
+ *
+ * @param[in] root <tt>struct radix_tree_root *</tt> or <tt>struct xarray
+ * *</tt>.
+ */
+struct drgn_error *
+linux_helper_radix_tree_iterator_init(struct linux_helper_radix_tree_iterator *it,
+				      const struct drgn_object *root);
+
+void
+linux_helper_radix_tree_iterator_deinit(struct linux_helper_radix_tree_iterator *it);
+
+/**
+ * Get the next entry from a @ref linux_helper_radix_tree_iterator.
+ *
+ * @param[out] index_ret Returned index of the entry.
+ * @param[out] entry_ret Returned entry.
+ * @return @c NULL on success, &@ref drgn_stop if there are no more entries,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_radix_tree_iterator_next(struct linux_helper_radix_tree_iterator *it,
+				      uint64_t *index_ret,
+				      uint64_t *entry_ret);
+
+/**
+ * Iterator over the PIDs (<tt>struct pid</tt>) or tasks (<tt>struct
+ * task_struct</tt>) in a PID namespace.
+ *
+ * Since Linux v4.15, this walks the namespace's IDR with a @ref
+ * linux_helper_radix_tree_iterator. Before that, it walks all of the buckets of
+ * the global PID hash table, which are read in chunks, and filters by
+ * namespace.
+ */
+struct linux_helper_pid_iterator {
+	struct drgn_program *prog;
+	/* <tt>struct pid *</tt> or <tt>struct task_struct *</tt>. */
+	struct drgn_qualified_type entry_type;
+	/* Whether to return tasks instead of PIDs. */
+	bool tasks;
+	/* Whether the namespace has an IDR rather than using pid_hash. */
+	bool idr;
+	/* Offset of tasks[PIDTYPE_PID].first in struct pid. */
+	uint64_t tasks_offset;
+	/* Offset of the PIDTYPE_PID list node in struct task_struct. */
+	uint64_t pid_links_offset;
+	union {
+		struct linux_helper_radix_tree_iterator radix_tree;
+		struct {
+			uint64_t ns;
+			/* Offset of numbers[ns->level] in struct pid. */
+			uint64_t numbers_offset;
+			/* Offsets of members in struct upid. */
+			uint64_t pid_chain_offset;
+			uint64_t upid_ns_offset;
+			/* Address of the pid_hash array and number of buckets. */
+			uint64_t pid_hash;
+			uint64_t num_buckets;
+			/* Next bucket to read. */
+			uint64_t bucket;
+			/* Chunk of bucket heads which have been read. */
+			uint64_t chunk[256];
+			unsigned int chunk_pos, chunk_size;
+			/* Next node in the current bucket. */
+			uint64_t node;
+			/* Brent's cycle detection state for the bucket. */
+			uint64_t saved_node;
+			uint64_t power;
+			uint64_t lambda;
+		} pid_hash;
+	};
+};
+
+/**
+ * Initialize a @ref linux_helper_pid_iterator.
+ *
+ * @param[in] ns <tt>struct pid_namespace *</tt>.
+ * @param[in] tasks Whether to return tasks (<tt>struct task_struct *</tt>)
+ * instead of PIDs (<tt>struct pid *</tt>). PIDs which are not attached to a
+ * task are skipped.
+ */
+struct drgn_error *
+linux_helper_pid_iterator_init(struct linux_helper_pid_iterator *it,
+			       const struct drgn_object *ns, bool tasks);
+
+void linux_helper_pid_iterator_deinit(struct linux_helper_pid_iterator *it);
+
+/**
+ * Get the address of the next PID or task from a @ref
+ * linux_helper_pid_iterator.
+ *
+ * @return @c NULL on success, &@ref drgn_stop if there are no more entries,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_pid_iterator_next(struct linux_helper_pid_iterator *it,
+			       uint64_t *ret);
+
+/**
+ * Scanner over the page structures (<tt>struct page</tt>) in a range of page
+ * frame numbers.
+ *
+ * The memory map is read in large chunks. Sections without a memory map are
+ * skipped using <tt>mem_section</tt> if the section size is known from
+ * VMCOREINFO. Any other unreadable parts of the memory map are found by
+ * splitting reads which fault in half.
+ */
+struct linux_helper_page_scanner {
+	struct drgn_program *prog;
+	bool bswap;
+	uint8_t word_size;
+	/* Address of the memory map and sizeof(struct page). */
+	uint64_t vmemmap;
+	uint64_t page_struct_size;
+	/* Offsets of members in struct page, or UINT64_MAX if missing. */
+	uint64_t flags_offset;
+	uint64_t mapping_offset;
+	uint64_t compound_head_offset;
+	/* Mask of the page flags in the flags member. */
+	uint64_t flags_mask;
+	/* Next page frame number to read and end of the range. */
+	uint64_t pfn;
+	uint64_t end_pfn;
+	/* log2 of the number of pages in a section, or 0 if not known. */
+	unsigned int pfn_section_shift;
+	/* Address of the array of mem_section roots. */
+	uint64_t mem_section;
+	/* Whether the roots are pointers (CONFIG_SPARSEMEM_EXTREME). */
+	bool mem_section_extreme;
+	uint64_t sections_per_root;
+	uint64_t mem_section_size;
+	uint64_t section_mem_map_offset;
+	/* Maximum number of pages in a chunk. */
+	uint64_t max_chunk_count;
+	/* Current chunk. */
+	uint64_t chunk_pfn;
+	uint64_t chunk_count;
+	char *buf;
+	/* Bitmap of the pages in the chunk which could be read. */
+	uint64_t *valid;
+};
+
+/**
+ * Initialize a @ref linux_helper_page_scanner.
+ *
+ * @param[in] end_pfn End of the range (exclusive), or @c UINT64_MAX for
+ * <tt>max_pfn</tt>.
+ */
+struct drgn_error *
+linux_helper_page_scanner_init(struct linux_helper_page_scanner *it,
+			       struct drgn_program *prog, uint64_t start_pfn,
+			       uint64_t end_pfn);
+
+void linux_helper_page_scanner_deinit(struct linux_helper_page_scanner *it);
+
+/**
+ * Read the next chunk of page structures into a @ref
+ * linux_helper_page_scanner.
+ *
+ * @return @c NULL on success, &@ref drgn_stop if there are no more pages,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_page_scanner_next_chunk(struct linux_helper_page_scanner *it);
+
+/** Page counts gathered by @ref linux_helper_page_stats(). */
+struct linux_helper_page_stats {
+	/* Number of pages with a readable page structure. */
+	uint64_t pages;
+	/* Number of pages with each bit of enum pageflags set. */
+	uint64_t flags[64];
+	/*
+	 * Number of pages by mapping type: no mapping, file, anonymous,
+	 * movable, KSM, and compound tail pages (which have no mapping of
+	 * their own).
+	 */
+	uint64_t mapping[6];
+};
+
+/** Count the pages in a range by flag and by mapping type. */
+struct drgn_error *linux_helper_page_stats(struct drgn_program *prog,
+					   uint64_t start_pfn,
+					   uint64_t end_pfn,
+					   struct linux_helper_page_stats *ret);
+
+/**
+ * Iterator over the pages in a range whose flags match a mask and value.
+ */
+struct linux_helper_page_iterator {
+	struct linux_helper_page_scanner scanner;
+	/* <tt>struct page *</tt>. */
+	struct drgn_qualified_type entry_type;
+	uint64_t flags_mask;
+	uint64_t flags_value;
+	/* Next index in the current chunk. */
+	uint64_t i;
+};
+
+/**
+ * Initialize a @ref linux_helper_page_iterator over the pages for which
+ * <tt>(page->flags & flags_mask) == flags_value</tt>.
+ */
+struct drgn_error *
+linux_helper_page_iterator_init(struct linux_helper_page_iterator *it,
+				struct drgn_program *prog, uint64_t start_pfn,
+				uint64_t end_pfn, uint64_t flags_mask,
+				uint64_t flags_value);
+
+void linux_helper_page_iterator_deinit(struct linux_helper_page_iterator *it);
+
+/**
+ * Get the address of the next page from a @ref linux_helper_page_iterator.
+ *
+ * @return @c NULL on success, &@ref drgn_stop if there are no more pages,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_page_iterator_next(struct linux_helper_page_iterator *it,
+				uint64_t *ret);
+
+/** Layout and per-CPU state of a SLUB cache (<tt>struct kmem_cache</tt>). */
+struct linux_helper_slab_cache {
+	/* Size of each object including metadata. */
+	uint64_t size;
+	/* Offset of the free pointer in an object. */
+	uint64_t offset;
+	/* Padding before the first object in a slab. */
+	uint64_t red_left_pad;
+	/*
+	 * With CONFIG_SLAB_FREELIST_HARDENED, free pointers are stored XORed
+	 * with random and with the address where they are stored, which is
+	 * byte-swapped since Linux v5.7. swab is -1 until that is determined.
+	 */
+	bool hardened;
+	int8_t swab;
+	uint64_t random;
+	/* Address of the per-CPU struct kmem_cache_cpu. */
+	uint64_t cpu_slab;
+	/*
+	 * For each possible CPU, the address of the page of its active slab
+	 * and the head of its lockless freelist.
+	 */
+	uint64_t *cpu_slabs;
+};
+
+DEFINE_HASH_MAP_TYPE(linux_helper_slab_cache_map, uint64_t,
+		     struct linux_helper_slab_cache)
+
+/** State shared by the SLUB helpers. */
+struct linux_helper_slab_allocator {
+	struct drgn_program *prog;
+	bool bswap;
+	bool little_endian;
+	uint8_t word_size;
+	uint64_t page_offset;
+	unsigned int page_shift;
+	/* Mask of PG_slab in page->flags. */
+	uint64_t pg_slab;
+	/* Address of the memory map and sizeof(struct page). */
+	uint64_t vmemmap;
+	uint64_t page_struct_size;
+	/* Offsets of members in struct page. */
+	uint64_t page_flags_offset;
+	/* UINT64_MAX before Linux v4.6. */
+	uint64_t compound_head_offset;
+	uint64_t slab_cache_offset;
+	uint64_t freelist_offset;
+	uint64_t objects_bit_offset;
+	uint64_t objects_bit_size;
+	/* struct kmem_cache and struct kmem_cache_cpu. */
+	struct drgn_qualified_type kmem_cache_type;
+	uint64_t cpu_freelist_offset;
+	uint64_t cpu_page_offset;
+	/* Per-CPU offsets of the possible CPUs. */
+	uint64_t *cpu_offsets;
+	size_t num_cpus;
+	/* Caches which have been looked up, keyed by address. */
+	struct linux_helper_slab_cache_map caches;
+	/* Buffer for a single struct page. */
+	char *page_buf;
+	/* Contents of the current slab and a bitmap of its free objects. */
+	char *slab_buf;
+	size_t slab_buf_capacity;
+	uint64_t *free;
+	size_t free_capacity;
+};
+
+void
+linux_helper_slab_allocator_deinit(struct linux_helper_slab_allocator *sa);
+
+/**
+ * Iterator over the objects in SLUB caches.
+ *
+ * Slabs are found by scanning the memory map for pages with @c PG_slab set,
+ * since full slabs are not on any list without <tt>CONFIG_SLUB_DEBUG</tt>.
+ * Free objects are found by decoding the freelist of each slab and the
+ * lockless freelist of each CPU.
+ */
+struct linux_helper_slab_object_iterator {
+	struct linux_helper_slab_allocator sa;
+	struct linux_helper_page_scanner scanner;
+	/* Cache to iterate over, or 0 for all caches. */
+	uint64_t cache;
+	bool allocated;
+	bool free;
+	/* Next index in the current chunk. */
+	uint64_t i;
+	/* Current slab, its first object, and its number of objects. */
+	uint64_t slab_cache;
+	uint64_t object_start;
+	uint64_t object_size;
+	uint64_t slab_objects;
+	/* Next object index in the current slab. */
+	uint64_t j;
+};
+
+/**
+ * Initialize a @ref linux_helper_slab_object_iterator.
+ *
+ * @param[in] cache Address of the <tt>struct kmem_cache</tt> to iterate over,
+ * or 0 for all caches.
+ * @param[in] allocated Whether to return allocated objects.
+ * @param[in] free Whether to return free objects.
+ */
+struct drgn_error *
+linux_helper_slab_object_iterator_init(struct linux_helper_slab_object_iterator *it,
+				       struct drgn_program *prog,
+				       uint64_t cache, bool allocated,
+				       bool free);
+
+void
+linux_helper_slab_object_iterator_deinit(struct linux_helper_slab_object_iterator *it);
+
+/**
+ * Get the next object from a @ref linux_helper_slab_object_iterator.
+ *
+ * @param[out] cache_ret Returned address of the object's cache.
+ * @param[out] address_ret Returned address of the object.
+ * @param[out] allocated_ret Returned whether the object is allocated.
+ * @return @c NULL on success, &@ref drgn_stop if there are no more objects,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_slab_object_iterator_next(struct linux_helper_slab_object_iterator *it,
+				       uint64_t *cache_ret,
+				       uint64_t *address_ret,
+				       bool *allocated_ret);
+
+/** SLUB object containing an address. */
+struct linux_helper_slab_object_info {
+	/* Address of the struct kmem_cache. */
+	uint64_t cache;
+	/* Address of the struct page of the slab. */
+	uint64_t slab;
+	/* Address of the start of the object. */
+	uint64_t address;
+	bool allocated;
+};
+
+/**
+ * Find the SLUB object containing an address.
+ *
+ * Only the page structure of the address and the slab containing it are read.
+ * The allocator state and the layouts of the caches are kept in the program
+ * (for a live kernel, the cache layouts and per-CPU slabs are read again on
+ * every call) and are used with the types lock held.
+ *
+ * @param[out] found_ret Returned whether the address is in a slab object. If
+ * not, @p ret is not modified.
+ */
+struct drgn_error *
+linux_helper_slab_object_info(struct drgn_program *prog, uint64_t address,
+			      struct linux_helper_slab_object_info *ret,
+			      bool *found_ret);
+
+/**
+ * Get the per-CPU offsets (<tt>__per_cpu_offset</tt>) of a program, indexed by
+ * CPU number. They are only read the first time and then cached in the program.
+ * Without <tt>CONFIG_SMP</tt>, there is one CPU with an offset of 0.
+ *
+ * @param[out] ret Returned offsets. These are valid for the lifetime of the
+ * program.
+ * @param[out] num_ret Returned number of offsets (@c NR_CPUS).
+ */
+struct drgn_error *linux_helper_per_cpu_offsets(struct drgn_program *prog,
+						const uint64_t **ret,
+						uint64_t *num_ret);
+
+/** Get the copy of a per-CPU pointer for a CPU. */
+struct drgn_error *linux_helper_per_cpu_ptr(struct drgn_object *res,
+					    const struct drgn_object *ptr,
+					    uint64_t cpu);
+
+/** Copies of a per-CPU object read by @ref linux_helper_per_cpu_read(). */
+struct linux_helper_per_cpu_values {
+	/* Type of the values. */
+	struct drgn_qualified_type qualified_type;
+	/* Offset of each value in its buffer and bit field size (or 0). */
+	uint64_t bit_offset;
+	uint64_t bit_field_size;
+	/* Size of the buffer of each value. */
+	uint64_t size;
+	/* Number of CPUs, their numbers, and their values. */
+	size_t num;
+	uint64_t *cpus;
+	char *buf;
+};
+
+/**
+ * Read the copy of a per-CPU object on every possible or online CPU.
+ *
+ * @param[in] ptr Per-CPU pointer (<tt>type __percpu *</tt>).
+ * @param[in] member Member designator within <tt>*ptr</tt> (e.g.,
+ * <tt>"a.b[1]"</tt>) to read instead of the whole object, or @c NULL.
+ * @param[in] online Whether to only read online CPUs instead of all possible
+ * CPUs.
+ * @param[out] ret Returned values. On success, this must be freed with @ref
+ * linux_helper_per_cpu_values_deinit().
+ */
+struct drgn_error *
+linux_helper_per_cpu_read(const struct drgn_object *ptr, const char *member,
+			  bool online, struct linux_helper_per_cpu_values *ret);
+
+void
+linux_helper_per_cpu_values_deinit(struct linux_helper_per_cpu_values *values);
+
+/**
+ * Sum the copies of an integer per-CPU object. The arguments are the same as
+ * for @ref linux_helper_per_cpu_read().
+ *
+ * @param[out] is_signed_ret Returned whether the type is signed.
+ * @param[out] ret Returned sum, truncated to 64 bits.
+ */
+struct drgn_error *linux_helper_per_cpu_sum(const struct drgn_object *ptr,
+					    const char *member, bool online,
+					    bool *is_signed_ret, uint64_t *ret);
+
+/** Sum a <tt>struct percpu_counter *</tt> like @c percpu_counter_sum(). */
+struct drgn_error *
+linux_helper_percpu_counter_sum(const struct drgn_object *fbc, int64_t *ret);
+
+/** Cached members of a mount (<tt>struct mount</tt>). */
+struct linux_helper_mount_info {
+	/* Parent mount (<tt>struct mount *</tt>). */
+	uint64_t parent;
+	/* Dentry which this is mounted on in the parent. */
+	uint64_t mountpoint;
+	/* Root dentry of this mount. */
+	uint64_t root;
+};
+
+/** Mount and dentry which identify a path. */
+struct linux_helper_d_path_key {
+	/* <tt>struct mount *</tt>, or 0 for a path within a filesystem. */
+	uint64_t mnt;
+	/* <tt>struct dentry *</tt>. */
+	uint64_t dentry;
+};
+
+DEFINE_HASH_MAP_TYPE(linux_helper_mount_map, uint64_t,
+		     struct linux_helper_mount_info)
+DEFINE_HASH_MAP_TYPE(linux_helper_d_path_map, struct linux_helper_d_path_key,
+		     struct string)
+DEFINE_HASH_MAP_TYPE(linux_helper_fstype_map, uint64_t, struct string)
+
+struct linux_helper_d_path_frame {
+	struct linux_helper_d_path_key key;
+	/*
+	 * Range of the name of the dentry in @ref
+	 * linux_helper_d_path_cache::names, or <tt>SIZE_MAX</tt> if this is
+	 * the root of a mount, which doesn't add a component.
+	 */
+	size_t name_start, name_len;
+};
+
+DEFINE_VECTOR_TYPE(linux_helper_d_path_frame_vector,
+		   struct linux_helper_d_path_frame)
+
+/**
+ * Memoized path builder for @c d_path().
+ *
+ * Every path built through a mount and dentry is remembered, so paths which
+ * share a prefix only read the dentries and mounts of the prefix once. The
+ * cache assumes that the dcache doesn't change, so it shouldn't be kept across
+ * reads of a live kernel.
+ */
+struct linux_helper_d_path_cache {
+	struct drgn_program *prog;
+	/*
+	 * Whether this is the program's cache, which may be used by multiple
+	 * threads and is only accessed with the types lock held.
+	 */
+	bool shared;
+	bool bswap;
+	uint8_t word_size;
+	/* Offset of struct vfsmount mnt in struct mount. */
+	uint64_t mnt_offset;
+	/* Offsets of the cached members in struct mount. */
+	uint64_t mnt_parent_offset;
+	uint64_t mnt_mountpoint_offset;
+	uint64_t mnt_root_offset;
+	/* Range of struct mount which contains the cached members. */
+	uint64_t mount_read_offset, mount_read_size;
+	/* Offsets of members in struct dentry. */
+	uint64_t d_parent_offset;
+	uint64_t d_name_offset;
+	uint64_t d_len_offset;
+	uint64_t d_op_offset;
+	uint64_t d_sb_offset;
+	/* Range of struct dentry which contains the above members. */
+	uint64_t dentry_read_offset, dentry_read_size;
+	/* Offset of d_dname in struct dentry_operations. */
+	uint64_t d_dname_offset;
+	/* Offsets of sb->s_type and s_type->name. */
+	uint64_t s_type_offset;
+	uint64_t fs_name_offset;
+	struct linux_helper_mount_map mounts;
+	struct linux_helper_d_path_map paths;
+	/* "[fstype]" names of pseudo filesystems by super block. */
+	struct linux_helper_fstype_map fstypes;
+	/* Scratch space for building a path. */
+	struct linux_helper_d_path_frame_vector frames;
+	struct string_builder names;
+	/* Buffer for reading a dentry or a mount. */
+	char *buf;
+};
+
+struct drgn_error *
+linux_helper_d_path_cache_init(struct linux_helper_d_path_cache *cache,
+			       struct drgn_program *prog);
+
+void linux_helper_d_path_cache_deinit(struct linux_helper_d_path_cache *cache);
+
+/**
+ * Get the cache used by @ref linux_helper_d_path() for a program which isn't
+ * live. It is created on first use and freed with the program. @ref
+ * linux_helper_d_path() and @ref linux_helper_dentry_path() take the types lock
+ * while using it, so it may be shared between threads.
+ */
+struct drgn_error *
+linux_helper_program_d_path_cache(struct drgn_program *prog,
+				  struct linux_helper_d_path_cache **ret);
+
+/**
+ * Get the full path of a dentry like @c d_path().
+ *
+ * Dentries with a <tt>d_dname</tt> operation (e.g., pipes and sockets) are
+ * named <tt>"[fstype]"</tt> after their filesystem type.
+ *
+ * @param[in] vfsmnt <tt>struct vfsmount *</tt>.
+ * @param[in] dentry <tt>struct dentry *</tt>.
+ * @param[out] ret Returned path. It is not null-terminated and is valid until
+ * the cache is deinitialized.
+ * @param[out] len_ret Returned length of the path.
+ */
+struct drgn_error *linux_helper_d_path(struct linux_helper_d_path_cache *cache,
+				       uint64_t vfsmnt, uint64_t dentry,
+				       const char **ret, size_t *len_ret);
+
+/**
+ * Get the path of a dentry from the root of its filesystem like @c
+ * dentry_path(), without a leading slash. The arguments are the same as for
+ * @ref linux_helper_d_path().
+ */
+struct drgn_error *
+linux_helper_dentry_path(struct linux_helper_d_path_cache *cache,
+			 uint64_t dentry, const char **ret, size_t *len_ret);
+
+/** Maximum number of slots in a maple tree node supported by iterators. */
+#define LINUX_HELPER_MAPLE_MAX_SLOTS 32
+
+struct linux_helper_maple_frame {
+	/*
+	 * Range of indices covered by the node and first index of the next
+	 * slot.
+	 */
+	uint64_t min;
+	uint64_t max;
+	/* Next slot to visit and number of slots. */
+	unsigned int slot;
+	unsigned int num_slots;
+	bool leaf;
+	uint64_t pivots[LINUX_HELPER_MAPLE_MAX_SLOTS - 1];
+	uint64_t slots[LINUX_HELPER_MAPLE_MAX_SLOTS];
+};
+
+DEFINE_VECTOR_TYPE(linux_helper_maple_frame_vector,
+		   struct linux_helper_maple_frame)
+
+/* Layout of a maple tree node type with pivots. */
+struct linux_helper_maple_layout {
+	uint64_t pivot_offset;
+	uint64_t slot_offset;
+	unsigned int num_slots;
+};
+
+/**
+ * Iterator over the memory mappings (<tt>struct vm_area_struct</tt>) of
+ * address spaces in address order.
+ *
+ * Since Linux v6.1, mappings are stored in the maple tree <tt>mm->mm_mt</tt>.
+ * Each node is read with a single memory read, and reserved entries are
+ * skipped. Before that, <tt>mm->mm_rb</tt> is walked with a @ref
+ * linux_helper_rbtree_iterator with validation enabled.
+ *
+ * The layout of the types is looked up once by @ref
+ * linux_helper_vma_iterator_init(), after which @ref
+ * linux_helper_vma_iterator_start() may be called for any number of address
+ * spaces.
+ */
+struct linux_helper_vma_iterator {
+	struct drgn_program *prog;
+	bool bswap;
+	uint8_t word_size;
+	/* Whether struct mm_struct has mm_mt rather than mm_rb. */
+	bool maple;
+	/* Offset of mm_mt.ma_root or mm_rb in struct mm_struct. */
+	uint64_t mm_root_offset;
+	/* Size of struct maple_node and a buffer of that size. */
+	uint64_t maple_node_size;
+	char *buf;
+	/* Layouts of struct maple_range_64 and struct maple_arange_64. */
+	struct linux_helper_maple_layout range_64;
+	struct linux_helper_maple_layout arange_64;
+	/* Entry stored directly in the root of the maple tree, or 0. */
+	uint64_t root_entry;
+	struct linux_helper_maple_frame_vector stack;
+	/* Offset of vm_rb in struct vm_area_struct. */
+	uint64_t vm_rb_offset;
+	/* <tt>struct rb_root *</tt>. */
+	struct drgn_qualified_type rb_root_type;
+	struct linux_helper_rbtree_iterator rb;
+	bool rb_started;
+};
+
+/** Initialize a @ref linux_helper_vma_iterator with no address space. */
+struct drgn_error *
+linux_helper_vma_iterator_init(struct linux_helper_vma_iterator *it,
+			       struct drgn_program *prog);
+
+void linux_helper_vma_iterator_deinit(struct linux_helper_vma_iterator *it);
+
+/**
+ * Start iterating over the memory mappings of an address space, abandoning
+ * any previous iteration.
+ *
+ * @param[in] mm Address of a <tt>struct mm_struct</tt>.
+ */
+struct drgn_error *
+linux_helper_vma_iterator_start(struct linux_helper_vma_iterator *it,
+				uint64_t mm);
+
+/**
+ * Get the address of the next <tt>struct vm_area_struct</tt> from a @ref
+ * linux_helper_vma_iterator.
+ *
+ * @return @c NULL on success, &@ref drgn_stop if there are no more entries,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_vma_iterator_next(struct linux_helper_vma_iterator *it,
+			       uint64_t *ret);
+
+DEFINE_HASH_SET_TYPE(linux_helper_address_set, uint64_t)
+DEFINE_HASH_MAP_TYPE(linux_helper_file_path_map, uint64_t, struct string)
+
+/** Kind of a @ref linux_helper_file_inventory_entry. */
+enum linux_helper_file_inventory_kind {
+	/** An open file descriptor. */
+	LINUX_HELPER_FILE_INVENTORY_FD,
+	/** A memory mapping (<tt>struct vm_area_struct</tt>). */
+	LINUX_HELPER_FILE_INVENTORY_VMA,
+};
+
+/** Open file or memory mapping returned by a file inventory iterator. */
+struct linux_helper_file_inventory_entry {
+	enum linux_helper_file_inventory_kind kind;
+	/* <tt>struct task_struct *</tt>, its PID, and its null-terminated comm. */
+	uint64_t task;
+	int32_t pid;
+	char comm[17];
+	/* File descriptor, for LINUX_HELPER_FILE_INVENTORY_FD. */
+	uint64_t fd;
+	/*
+	 * <tt>struct vm_area_struct *</tt> and its range, flags, and page
+	 * offset, for LINUX_HELPER_FILE_INVENTORY_VMA.
+	 */
+	uint64_t vma;
+	uint64_t start;
+	uint64_t end;
+	uint64_t flags;
+	uint64_t pgoff;
+	/* <tt>struct file *</tt>, or 0 for an anonymous mapping. */
+	uint64_t file;
+	/*
+	 * Path of the file (see @ref linux_helper_d_path()), valid until the
+	 * iterator is deinitialized.
+	 */
+	const char *path;
+	size_t path_len;
+};
+
+/**
+ * Iterator over the open files and memory mappings of every task, like
+ * <tt>lsof</tt>.
+ *
+ * Tasks are found with a @ref linux_helper_pid_iterator. For each task, the
+ * open file bitmap of its file descriptor table is read at once and scanned a
+ * word at a time, and only the file pointers for set bits are read. Memory
+ * mappings are found with a @ref linux_helper_vma_iterator. Paths are built
+ * with a shared @ref
+ * linux_helper_d_path_cache and are remembered by file.
+ *
+ * Tasks which share a file descriptor table or address space with a task
+ * which was already visited (e.g., threads) are skipped.
+ */
+struct linux_helper_file_inventory_iterator {
+	struct drgn_program *prog;
+	bool bswap;
+	uint8_t word_size;
+	bool fds;
+	bool mappings;
+	struct linux_helper_pid_iterator tasks;
+	/* Offsets of members in struct task_struct and the range to read. */
+	uint64_t task_pid_offset;
+	uint64_t task_comm_offset;
+	uint64_t task_files_offset;
+	uint64_t task_mm_offset;
+	uint64_t task_read_offset, task_read_size;
+	/* Offset of fdt in struct files_struct. */
+	uint64_t files_fdt_offset;
+	/* Offsets of members in struct fdtable and the range to read. */
+	uint64_t fdt_max_fds_offset;
+	uint64_t fdt_fd_offset;
+	uint64_t fdt_open_fds_offset;
+	uint64_t fdt_read_offset, fdt_read_size;
+	/* Offsets of f_path.mnt and f_path.dentry in struct file. */
+	uint64_t file_mnt_offset;
+	uint64_t file_dentry_offset;
+	uint64_t file_read_offset, file_read_size;
+	/* Offsets of members in struct vm_area_struct and the range to read. */
+	uint64_t vma_start_offset;
+	uint64_t vma_end_offset;
+	uint64_t vma_flags_offset;
+	uint64_t vma_pgoff_offset;
+	uint64_t vma_file_offset;
+	uint64_t vma_read_offset, vma_read_size;
+	/*
+	 * Path cache used for a live kernel, which can't use the program's
+	 * cache (see @ref linux_helper_program_d_path_cache()).
+	 */
+	struct linux_helper_d_path_cache own_paths;
+	struct linux_helper_d_path_cache *paths;
+	struct linux_helper_file_path_map file_paths;
+	/* File descriptor tables and address spaces which were visited. */
+	struct linux_helper_address_set seen;
+	/* Current task. */
+	struct linux_helper_file_inventory_entry entry;
+	enum {
+		LINUX_HELPER_FILE_INVENTORY_NEXT_TASK,
+		LINUX_HELPER_FILE_INVENTORY_FDS,
+		LINUX_HELPER_FILE_INVENTORY_VMAS,
+	} state;
+	/* Address space of the current task. */
+	uint64_t mm;
+	/*
+	 * File descriptor array, its size, and open file bitmap of the
+	 * current task.
+	 */
+	uint64_t fd_array;
+	uint64_t max_fds;
+	char *open_fds;
+	size_t open_fds_capacity;
+	uint64_t num_open_fds_words;
+	uint64_t open_fds_word;
+	/*
+	 * Remaining bits of the current word, the first file descriptor of
+	 * the word, and its file pointers.
+	 */
+	uint64_t bits;
+	uint64_t fd_base;
+	char *fd_buf;
+	struct linux_helper_vma_iterator vmas;
+	char *buf;
+};
+
+/**
+ * Initialize a @ref linux_helper_file_inventory_iterator.
+ *
+ * @param[in] fds Whether to return open file descriptors.
+ * @param[in] mappings Whether to return memory mappings.
+ */
+struct drgn_error *
+linux_helper_file_inventory_iterator_init(struct linux_helper_file_inventory_iterator *it,
+					  struct drgn_program *prog, bool fds,
+					  bool mappings);
+
+void
+linux_helper_file_inventory_iterator_deinit(struct linux_helper_file_inventory_iterator *it);
+
+/**
+ * Get the next entry from a @ref linux_helper_file_inventory_iterator.
+ *
+ * @param[out] ret Returned entry, valid until the next call.
+ * @return @c NULL on success, &@ref drgn_stop if there are no more entries,
+ * non-@c NULL on error.
+ */
+struct drgn_error *
+linux_helper_file_inventory_iterator_next(struct linux_helper_file_inventory_iterator *it,
+					  const struct linux_helper_file_inventory_entry **ret);
+
 #endif /* DRGN_HELPERS_H */
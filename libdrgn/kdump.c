@@ -54,17 +54,24 @@ static struct drgn_error *drgn_read_kdump(void *buf, uint64_t address,
 					  size_t count, uint64_t offset,
 					  void *arg, bool physical)
 {
-	kdump_ctx_t *ctx = arg;
+	struct drgn_program *prog = arg;
+	struct drgn_error *err;
 	kdump_status ks;
 
-	ks = kdump_read(ctx, physical ? KDUMP_KPHYSADDR : KDUMP_KVADDR, address,
+	/* libkdumpfile contexts may not be used concurrently. */
+	pthread_mutex_lock(&prog->kdump_lock);
+	ks = kdump_read(prog->kdump_ctx,
+			physical ? KDUMP_KPHYSADDR : KDUMP_KVADDR, address,
 			buf, &count);
 	if (ks != KDUMP_OK) {
-		return drgn_error_format_fault(address,
-					       "could not read memory from kdump: %s",
-					       kdump_get_err(ctx));
+		err = drgn_error_format_fault(address,
+					      "could not read memory from kdump: %s",
+					      kdump_get_err(prog->kdump_ctx));
+	} else {
+		err = NULL;
 	}
-	return NULL;
+	pthread_mutex_unlock(&prog->kdump_lock);
+	return err;
 }
 
 struct drgn_error *drgn_program_set_kdump(struct drgn_program *prog)
@@ -114,11 +121,11 @@ struct drgn_error *drgn_program_set_kdump(struct drgn_program *prog)
 		goto err;
 
 	err = drgn_program_add_memory_segment(prog, 0, UINT64_MAX,
-					      drgn_read_kdump, ctx, false);
+					      drgn_read_kdump, prog, false);
 	if (err)
 		goto err;
 	err = drgn_program_add_memory_segment(prog, 0, UINT64_MAX,
-					      drgn_read_kdump, ctx, true);
+					      drgn_read_kdump, prog, true);
 	if (err) {
 		drgn_memory_reader_deinit(&prog->reader);
 		drgn_memory_reader_init(&prog->reader);
@@ -141,7 +148,8 @@ err:
 	return err;
 }
 
-struct drgn_error *drgn_program_cache_prstatus_kdump(struct drgn_program *prog)
+static struct drgn_error *
+drgn_program_cache_prstatus_kdump_locked(struct drgn_program *prog)
 {
 	struct drgn_error *err;
 	kdump_num_t ncpus, i;
@@ -198,3 +206,11 @@ struct drgn_error *drgn_program_cache_prstatus_kdump(struct drgn_program *prog)
 	}
 	return NULL;
 }
+
+struct drgn_error *drgn_program_cache_prstatus_kdump(struct drgn_program *prog)
+{
+	pthread_mutex_lock(&prog->kdump_lock);
+	struct drgn_error *err = drgn_program_cache_prstatus_kdump_locked(prog);
+	pthread_mutex_unlock(&prog->kdump_lock);
+	return err;
+}
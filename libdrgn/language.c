@@ -14,6 +14,7 @@ const struct drgn_language drgn_languages[] = {
 		.format_object = c_format_object,
 		.find_type = c_find_type,
 		.bit_offset = c_bit_offset,
+		.compile_expression = c_compile_expression,
 		.integer_literal = c_integer_literal,
 		.bool_literal = c_bool_literal,
 		.float_literal = c_float_literal,
@@ -41,6 +42,7 @@ const struct drgn_language drgn_languages[] = {
 		.format_object = c_format_object,
 		.find_type = c_find_type,
 		.bit_offset = c_bit_offset,
+		.compile_expression = c_compile_expression,
 		.integer_literal = c_integer_literal,
 		.bool_literal = c_bool_literal,
 		.float_literal = c_float_literal,
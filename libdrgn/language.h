@@ -16,6 +16,9 @@
 
 #include "drgn.h"
 
+struct drgn_expression_builder;
+struct string_builder;
+
 /**
  * @ingroup Internals
  *
@@ -34,7 +37,7 @@ typedef struct drgn_error *drgn_format_type_fn(struct drgn_qualified_type,
 typedef struct drgn_error *drgn_format_object_fn(const struct drgn_object *,
 						 size_t,
 						 enum drgn_format_object_flags,
-						 char **);
+						 struct string_builder *);
 typedef struct drgn_error *drgn_find_type_fn(struct drgn_program *prog,
 					     const char *name,
 					     const char *filename,
@@ -43,6 +46,9 @@ typedef struct drgn_error *drgn_bit_offset_fn(struct drgn_program *prog,
 					      struct drgn_type *type,
 					      const char *member_designator,
 					      uint64_t *ret);
+typedef struct drgn_error *
+drgn_compile_expression_fn(struct drgn_program *prog, const char *expr,
+			   struct drgn_expression_builder *builder);
 typedef struct drgn_error *drgn_integer_literal_fn(struct drgn_object *res,
 						   uint64_t uvalue);
 typedef struct drgn_error *drgn_bool_literal_fn(struct drgn_object *res,
@@ -72,7 +78,11 @@ struct drgn_language {
 	drgn_format_type_fn *format_type_name;
 	/** Implement @ref drgn_format_type(). */
 	drgn_format_type_fn *format_type;
-	/** Implement @ref drgn_format_object(). */
+	/**
+	 * Implement @ref drgn_format_object() and @ref
+	 * drgn_format_object_stream() by appending to a string builder, which
+	 * should be flushed whenever the output so far is final.
+	 */
 	drgn_format_object_fn *format_object;
 	/**
 	 * Implement @ref drgn_program_find_type().
@@ -89,6 +99,13 @@ struct drgn_language {
 	 * the offset, in bits, of that member from the beginning of @p type.
 	 */
 	drgn_bit_offset_fn *bit_offset;
+	/**
+	 * Implement @ref drgn_program_eval().
+	 *
+	 * This should parse @p expr and append the instructions which evaluate
+	 * it to @p builder.
+	 */
+	drgn_compile_expression_fn *compile_expression;
 	/**
 	 * Set an object to an integer literal.
 	 *
@@ -133,6 +150,7 @@ drgn_format_type_fn c_format_type;
 drgn_format_object_fn c_format_object;
 drgn_find_type_fn c_find_type;
 drgn_bit_offset_fn c_bit_offset;
+drgn_compile_expression_fn c_compile_expression;
 drgn_integer_literal_fn c_integer_literal;
 drgn_bool_literal_fn c_bool_literal;
 drgn_float_literal_fn c_float_literal;
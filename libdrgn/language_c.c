@@ -12,6 +12,7 @@
 
 #include "bitops.h"
 #include "error.h"
+#include "expression.h"
 #include "hash_table.h"
 #include "language.h" // IWYU pragma: associated
 #include "lexer.h"
@@ -943,7 +944,7 @@ static struct drgn_error *c_format_initializer(struct drgn_program *prog,
 						goto out;
 					}
 					remaining_columns -= len + 2;
-					continue;
+					goto next;
 				}
 				if (len < start_columns) {
 					/* It fit on the new line. */
@@ -953,7 +954,7 @@ static struct drgn_error *c_format_initializer(struct drgn_program *prog,
 					}
 					remaining_columns =
 						start_columns - len - 1;
-					continue;
+					goto next;
 				}
 			} else if (err != &drgn_line_wrap) {
 				goto out;
@@ -972,6 +973,14 @@ static struct drgn_error *c_format_initializer(struct drgn_program *prog,
 			goto out;
 		}
 		remaining_columns = 0;
+next:
+		/*
+		 * We only get here when formatting on multiple lines, so
+		 * nothing before this initializer will be rewritten.
+		 */
+		err = string_builder_maybe_flush(sb);
+		if (err)
+			goto out;
 	}
 
 	if (!string_builder_appendc(sb, '\n') || !append_tabs(indent, sb) ||
@@ -1269,6 +1278,7 @@ c_format_pointer_object(const struct drgn_object *obj,
 	uint64_t uvalue;
 	struct drgn_symbol sym;
 	size_t start, type_start, type_end, value_start, value_end;
+	uint64_t flushed = sb->flushed;
 
 	start = sb->len;
 	if (dereference && !c_string && !string_builder_appendc(sb, '*'))
@@ -1344,6 +1354,12 @@ c_format_pointer_object(const struct drgn_object *obj,
 	}
 
 no_dereference:
+	/*
+	 * We can't take back output that was already flushed, so the error is
+	 * fatal in that case.
+	 */
+	if (sb->flushed != flushed)
+		return err;
 	/*
 	 * We hit a non-fatal error. Delete the asterisk and symbol parentheses
 	 * and truncate everything after the address.
@@ -1612,20 +1628,10 @@ c_format_object_impl(const struct drgn_object *obj, size_t indent,
 struct drgn_error *c_format_object(const struct drgn_object *obj,
 				   size_t columns,
 				   enum drgn_format_object_flags flags,
-				   char **ret)
+				   struct string_builder *sb)
 {
-	struct drgn_error *err;
-	struct string_builder sb = {};
-
-	err = c_format_object_impl(obj, 0, columns, max(columns, (size_t)1),
-				   flags, &sb);
-	if (err) {
-		free(sb.str);
-		return err;
-	}
-	if (!string_builder_finalize(&sb, ret))
-		return &drgn_enomem;
-	return NULL;
+	return c_format_object_impl(obj, 0, columns, max(columns, (size_t)1),
+				    flags, sb);
 }
 
 /* This obviously incomplete since we only handle the tokens we care about. */
@@ -1663,6 +1669,28 @@ enum {
 	C_TOKEN_DOT,
 	C_TOKEN_NUMBER,
 	C_TOKEN_IDENTIFIER,
+	C_TOKEN_ARROW,
+	C_TOKEN_PLUS,
+	C_TOKEN_MINUS,
+	C_TOKEN_SLASH,
+	C_TOKEN_PERCENT,
+	C_TOKEN_AMPERSAND,
+	C_TOKEN_PIPE,
+	C_TOKEN_CARET,
+	C_TOKEN_TILDE,
+	C_TOKEN_EXCLAMATION,
+	C_TOKEN_LSHIFT,
+	C_TOKEN_RSHIFT,
+	C_TOKEN_LT,
+	C_TOKEN_GT,
+	C_TOKEN_LE,
+	C_TOKEN_GE,
+	C_TOKEN_EQ,
+	C_TOKEN_NE,
+	C_TOKEN_LOGICAL_AND,
+	C_TOKEN_LOGICAL_OR,
+	C_TOKEN_INCREMENT,
+	C_TOKEN_DECREMENT,
 };
 
 static const char *token_spelling[] = {
@@ -1712,6 +1740,35 @@ static void c_keywords_deinit(void)
 	c_keyword_map_deinit(&c_keywords);
 }
 
+/*
+ * Parse the suffix of an integer constant: u or U, l, L, ll, or LL, or both in
+ * either order. Returns the end of the suffix.
+ */
+static const char *c_parse_integer_suffix(const char *p, bool *is_unsigned,
+					  int *longs)
+{
+	*is_unsigned = false;
+	*longs = 0;
+	if (*p == 'u' || *p == 'U') {
+		*is_unsigned = true;
+		p++;
+	}
+	if (*p == 'l' || *p == 'L') {
+		if (p[1] == p[0]) {
+			*longs = 2;
+			p += 2;
+		} else {
+			*longs = 1;
+			p++;
+		}
+		if (!*is_unsigned && (*p == 'u' || *p == 'U')) {
+			*is_unsigned = true;
+			p++;
+		}
+	}
+	return p;
+}
+
 struct drgn_error *drgn_lexer_c(struct drgn_lexer *lexer,
 				struct drgn_token *token) {
 	const char *p = lexer->p;
@@ -1748,6 +1805,100 @@ struct drgn_error *drgn_lexer_c(struct drgn_lexer *lexer,
 		token->kind = C_TOKEN_DOT;
 		p++;
 		break;
+	case '-':
+		if (p[1] == '>') {
+			token->kind = C_TOKEN_ARROW;
+			p += 2;
+		} else if (p[1] == '-') {
+			token->kind = C_TOKEN_DECREMENT;
+			p += 2;
+		} else {
+			token->kind = C_TOKEN_MINUS;
+			p++;
+		}
+		break;
+	case '+':
+		if (p[1] == '+') {
+			token->kind = C_TOKEN_INCREMENT;
+			p += 2;
+		} else {
+			token->kind = C_TOKEN_PLUS;
+			p++;
+		}
+		break;
+	case '/':
+		token->kind = C_TOKEN_SLASH;
+		p++;
+		break;
+	case '%':
+		token->kind = C_TOKEN_PERCENT;
+		p++;
+		break;
+	case '&':
+		if (p[1] == '&') {
+			token->kind = C_TOKEN_LOGICAL_AND;
+			p += 2;
+		} else {
+			token->kind = C_TOKEN_AMPERSAND;
+			p++;
+		}
+		break;
+	case '|':
+		if (p[1] == '|') {
+			token->kind = C_TOKEN_LOGICAL_OR;
+			p += 2;
+		} else {
+			token->kind = C_TOKEN_PIPE;
+			p++;
+		}
+		break;
+	case '^':
+		token->kind = C_TOKEN_CARET;
+		p++;
+		break;
+	case '~':
+		token->kind = C_TOKEN_TILDE;
+		p++;
+		break;
+	case '!':
+		if (p[1] == '=') {
+			token->kind = C_TOKEN_NE;
+			p += 2;
+		} else {
+			token->kind = C_TOKEN_EXCLAMATION;
+			p++;
+		}
+		break;
+	case '<':
+		if (p[1] == '<') {
+			token->kind = C_TOKEN_LSHIFT;
+			p += 2;
+		} else if (p[1] == '=') {
+			token->kind = C_TOKEN_LE;
+			p += 2;
+		} else {
+			token->kind = C_TOKEN_LT;
+			p++;
+		}
+		break;
+	case '>':
+		if (p[1] == '>') {
+			token->kind = C_TOKEN_RSHIFT;
+			p += 2;
+		} else if (p[1] == '=') {
+			token->kind = C_TOKEN_GE;
+			p += 2;
+		} else {
+			token->kind = C_TOKEN_GT;
+			p++;
+		}
+		break;
+	case '=':
+		if (p[1] != '=')
+			goto invalid;
+		token->kind = C_TOKEN_EQ;
+		p += 2;
+		break;
 	default:
 		if (isalpha(*p) || *p == '_') {
 			struct string key;
@@ -1779,11 +1930,15 @@ struct drgn_error *drgn_lexer_c(struct drgn_lexer *lexer,
 				while ('0' <= *p && *p <= '9')
 					p++;
 			}
-			if (isalpha(*p) || *p == '_') {
+			bool is_unsigned;
+			int longs;
+			p = c_parse_integer_suffix(p, &is_unsigned, &longs);
+			if (isalnum(*p) || *p == '_') {
 				return drgn_error_create(DRGN_ERROR_SYNTAX,
 							 "invalid number");
 			}
 		} else {
+invalid:
 			return drgn_error_format(DRGN_ERROR_SYNTAX,
 						 "invalid character \\x%02x", (unsigned char)*p);
 		}
@@ -1795,6 +1950,15 @@ struct drgn_error *drgn_lexer_c(struct drgn_lexer *lexer,
 	return NULL;
 }
 
+/* Get the length of a number token without its integer suffix. */
+static size_t c_token_number_len(const struct drgn_token *token)
+{
+	size_t len = token->len;
+	while (strchr("uUlL", token->value[len - 1]))
+		len--;
+	return len;
+}
+
 static struct drgn_error *c_token_to_u64(const struct drgn_token *token,
 					 uint64_t *ret)
 {
@@ -1802,18 +1966,18 @@ static struct drgn_error *c_token_to_u64(const struct drgn_token *token,
 	size_t i;
 
 	assert(token->kind == C_TOKEN_NUMBER);
-	if (token->len > 2 && token->value[0] == '0' &&
-	    token->value[1] == 'x') {
-		for (i = 2; i < token->len; i++) {
+	size_t len = c_token_number_len(token);
+	if (len > 2 && token->value[0] == '0' && token->value[1] == 'x') {
+		for (i = 2; i < len; i++) {
 			char c = token->value[i];
 			int digit;
 
 			if ('0' <= c && c <= '9')
 				digit = c - '0';
 			else if ('a' <= c && c <= 'f')
-				digit = c - 'a';
+				digit = c - 'a' + 10;
 			else /* ('A' <= c && c <= 'F') */
-				digit = c - 'A';
+				digit = c - 'A' + 10;
 			if (x > UINT64_MAX / 16)
 				goto overflow;
 			x *= 16;
@@ -1822,7 +1986,7 @@ static struct drgn_error *c_token_to_u64(const struct drgn_token *token,
 			x += digit;
 		}
 	} else if (token->value[0] == '0') {
-		for (i = 1; i < token->len; i++) {
+		for (i = 1; i < len; i++) {
 			int digit;
 
 			digit = token->value[i] - '0';
@@ -1834,7 +1998,7 @@ static struct drgn_error *c_token_to_u64(const struct drgn_token *token,
 			x += digit;
 		}
 	} else {
-		for (i = 0; i < token->len; i++) {
+		for (i = 0; i < len; i++) {
 			int digit;
 
 			digit = token->value[i] - '0';
@@ -2512,31 +2676,25 @@ c_type_from_declarator(struct drgn_program *prog,
 	return err;
 }
 
-struct drgn_error *c_find_type(struct drgn_program *prog, const char *name,
-			       const char *filename,
-			       struct drgn_qualified_type *ret)
+static struct drgn_error *c_parse_type_name(struct drgn_program *prog,
+					    struct drgn_lexer *lexer,
+					    const char *filename,
+					    struct drgn_qualified_type *ret)
 {
 	struct drgn_error *err;
-	struct drgn_lexer lexer;
 	struct drgn_token token;
 
-	drgn_lexer_init(&lexer, drgn_lexer_c, name);
-
-	err = c_parse_specifier_qualifier_list(prog, &lexer, filename, ret);
+	err = c_parse_specifier_qualifier_list(prog, lexer, filename, ret);
 	if (err)
-		goto out;
+		return err;
 
-	err = drgn_lexer_pop(&lexer, &token);
+	err = drgn_lexer_peek(lexer, &token);
 	if (err)
-		goto out;
-	if (token.kind != C_TOKEN_EOF) {
+		return err;
+	if (token.kind != C_TOKEN_EOF && token.kind != C_TOKEN_RPAREN) {
 		struct c_declarator *outer = NULL, *inner;
 
-		err = drgn_lexer_push(&lexer, &token);
-		if (err)
-			return err;
-
-		err = c_parse_abstract_declarator(prog, &lexer, &outer, &inner);
+		err = c_parse_abstract_declarator(prog, lexer, &outer, &inner);
 		if (err) {
 			while (outer) {
 				struct c_declarator *next;
@@ -2545,21 +2703,37 @@ struct drgn_error *c_find_type(struct drgn_program *prog, const char *name,
 				free(outer);
 				outer = next;
 			}
-			goto out;
+			return err;
 		}
 
 		err = c_type_from_declarator(prog, outer, ret);
 		if (err)
-			goto out;
+			return err;
+	}
+	return NULL;
+}
 
-		err = drgn_lexer_pop(&lexer, &token);
-		if (err)
-			goto out;
-		if (token.kind != C_TOKEN_EOF) {
-			err = drgn_error_create(DRGN_ERROR_SYNTAX,
-						"extra tokens after type name");
-			goto out;
-		}
+struct drgn_error *c_find_type(struct drgn_program *prog, const char *name,
+			       const char *filename,
+			       struct drgn_qualified_type *ret)
+{
+	struct drgn_error *err;
+	struct drgn_lexer lexer;
+	struct drgn_token token;
+
+	drgn_lexer_init(&lexer, drgn_lexer_c, name);
+
+	err = c_parse_type_name(prog, &lexer, filename, ret);
+	if (err)
+		goto out;
+
+	err = drgn_lexer_pop(&lexer, &token);
+	if (err)
+		goto out;
+	if (token.kind != C_TOKEN_EOF) {
+		err = drgn_error_create(DRGN_ERROR_SYNTAX,
+					"extra tokens after type name");
+		goto out;
 	}
 
 	err = NULL;
@@ -2700,14 +2874,395 @@ out:
 	return err;
 }
 
-struct drgn_error *c_integer_literal(struct drgn_object *res, uint64_t uvalue)
+struct c_expression_compiler {
+	struct drgn_program *prog;
+	struct drgn_lexer lexer;
+	struct drgn_expression_builder *builder;
+	/* Scratch object for constants. */
+	struct drgn_object tmp;
+};
+
+static struct drgn_error *
+c_compile_binary_expression(struct c_expression_compiler *compiler,
+			    int min_precedence);
+
+static struct drgn_error *c_suffixed_integer_literal(struct drgn_object *res,
+						     uint64_t uvalue,
+						     bool is_unsigned,
+						     int longs);
+
+static inline struct drgn_error *
+c_compile_expression_impl(struct c_expression_compiler *compiler)
 {
-	static const enum drgn_primitive_type types[] = {
-		DRGN_C_TYPE_INT,
-		DRGN_C_TYPE_LONG,
-		DRGN_C_TYPE_LONG_LONG,
-		DRGN_C_TYPE_UNSIGNED_LONG_LONG,
+	return c_compile_binary_expression(compiler, 1);
+}
+
+static struct drgn_error *
+c_expect_token(struct c_expression_compiler *compiler, int kind,
+	       const char *spelling)
+{
+	struct drgn_token token;
+	struct drgn_error *err = drgn_lexer_pop(&compiler->lexer, &token);
+	if (err)
+		return err;
+	if (token.kind != kind) {
+		return drgn_error_format(DRGN_ERROR_SYNTAX, "expected '%s'",
+					 spelling);
+	}
+	return NULL;
+}
+
+/* Side effects can't be evaluated, so ++ and -- are rejected. */
+static struct drgn_error *
+c_increment_decrement_error(const struct drgn_token *token)
+{
+	return drgn_error_format(DRGN_ERROR_SYNTAX,
+				 "'%s' operator is not supported",
+				 token->kind == C_TOKEN_INCREMENT ? "++" : "--");
+}
+
+static struct drgn_error *
+c_compile_primary_expression(struct c_expression_compiler *compiler)
+{
+	struct drgn_error *err;
+	struct drgn_token token;
+
+	err = drgn_lexer_pop(&compiler->lexer, &token);
+	if (err)
+		return err;
+	switch (token.kind) {
+	case C_TOKEN_IDENTIFIER: {
+		char *name = strndup(token.value, token.len);
+		if (!name)
+			return &drgn_enomem;
+		err = drgn_program_find_object(compiler->prog, name, NULL,
+					       DRGN_FIND_OBJECT_ANY,
+					       &compiler->tmp);
+		free(name);
+		if (err)
+			return err;
+		break;
+	}
+	case C_TOKEN_NUMBER: {
+		uint64_t value;
+		err = c_token_to_u64(&token, &value);
+		if (err)
+			return err;
+		bool is_unsigned;
+		int longs;
+		c_parse_integer_suffix(token.value + c_token_number_len(&token),
+				       &is_unsigned, &longs);
+		err = c_suffixed_integer_literal(&compiler->tmp, value,
+						 is_unsigned, longs);
+		if (err)
+			return err;
+		break;
+	}
+	case C_TOKEN_LPAREN:
+		err = c_compile_expression_impl(compiler);
+		if (err)
+			return err;
+		return c_expect_token(compiler, C_TOKEN_RPAREN, ")");
+	default:
+		return drgn_error_create(DRGN_ERROR_SYNTAX,
+					 "expected expression");
+	}
+	return drgn_expression_builder_append_constant(compiler->builder,
+						       &compiler->tmp);
+}
+
+static struct drgn_error *
+c_compile_postfix_expression(struct c_expression_compiler *compiler)
+{
+	struct drgn_error *err;
+
+	err = c_compile_primary_expression(compiler);
+	if (err)
+		return err;
+
+	for (;;) {
+		struct drgn_token token;
+		err = drgn_lexer_pop(&compiler->lexer, &token);
+		if (err)
+			return err;
+		if (token.kind == C_TOKEN_DOT || token.kind == C_TOKEN_ARROW) {
+			enum drgn_expression_opcode opcode =
+				(token.kind == C_TOKEN_DOT ?
+				 DRGN_EXPR_MEMBER :
+				 DRGN_EXPR_MEMBER_DEREFERENCE);
+			err = drgn_lexer_pop(&compiler->lexer, &token);
+			if (err)
+				return err;
+			if (token.kind != C_TOKEN_IDENTIFIER) {
+				return drgn_error_format(DRGN_ERROR_SYNTAX,
+							 "expected identifier after '%s'",
+							 opcode == DRGN_EXPR_MEMBER ?
+							 "." : "->");
+			}
+			err = drgn_expression_builder_append_member(compiler->builder,
+								    opcode,
+								    token.value,
+								    token.len);
+		} else if (token.kind == C_TOKEN_LBRACKET) {
+			err = c_compile_expression_impl(compiler);
+			if (err)
+				return err;
+			err = c_expect_token(compiler, C_TOKEN_RBRACKET, "]");
+			if (err)
+				return err;
+			err = drgn_expression_builder_append(compiler->builder,
+							     DRGN_EXPR_SUBSCRIPT);
+		} else if (token.kind == C_TOKEN_INCREMENT ||
+			   token.kind == C_TOKEN_DECREMENT) {
+			return c_increment_decrement_error(&token);
+		} else {
+			return drgn_lexer_push(&compiler->lexer, &token);
+		}
+		if (err)
+			return err;
+	}
+}
+
+/*
+ * Return whether a token after an opening parenthesis begins a type name (and
+ * thus a cast) rather than an expression.
+ */
+static struct drgn_error *
+c_token_begins_type_name(struct drgn_program *prog,
+			 const struct drgn_token *token, bool *ret)
+{
+	if (MIN_KEYWORD_TOKEN <= token->kind &&
+	    token->kind <= MAX_KEYWORD_TOKEN) {
+		*ret = true;
+		return NULL;
+	}
+	if (token->kind != C_TOKEN_IDENTIFIER) {
+		*ret = false;
+		return NULL;
+	}
+	if ((token->len == sizeof("size_t") - 1 &&
+	     memcmp(token->value, "size_t", token->len) == 0) ||
+	    (token->len == sizeof("ptrdiff_t") - 1 &&
+	     memcmp(token->value, "ptrdiff_t", token->len) == 0)) {
+		*ret = true;
+		return NULL;
+	}
+	struct drgn_qualified_type qualified_type;
+	struct drgn_error *err =
+		drgn_program_find_type_impl(prog, DRGN_TYPE_TYPEDEF,
+					    token->value, token->len, NULL,
+					    &qualified_type);
+	if (err == &drgn_not_found) {
+		*ret = false;
+		return NULL;
+	} else if (err) {
+		return err;
+	}
+	*ret = true;
+	return NULL;
+}
+
+static struct drgn_error *
+c_compile_unary_expression(struct c_expression_compiler *compiler)
+{
+	struct drgn_error *err;
+	struct drgn_token token;
+	enum drgn_expression_opcode opcode;
+
+	err = drgn_lexer_pop(&compiler->lexer, &token);
+	if (err)
+		return err;
+	switch (token.kind) {
+	case C_TOKEN_PLUS:
+		opcode = DRGN_EXPR_POS;
+		break;
+	case C_TOKEN_MINUS:
+		opcode = DRGN_EXPR_NEG;
+		break;
+	case C_TOKEN_TILDE:
+		opcode = DRGN_EXPR_NOT;
+		break;
+	case C_TOKEN_EXCLAMATION:
+		opcode = DRGN_EXPR_LOGICAL_NOT;
+		break;
+	case C_TOKEN_ASTERISK:
+		opcode = DRGN_EXPR_DEREFERENCE;
+		break;
+	case C_TOKEN_AMPERSAND:
+		opcode = DRGN_EXPR_ADDRESS_OF;
+		break;
+	case C_TOKEN_INCREMENT:
+	case C_TOKEN_DECREMENT:
+		return c_increment_decrement_error(&token);
+	case C_TOKEN_LPAREN: {
+		struct drgn_token token2;
+		err = drgn_lexer_peek(&compiler->lexer, &token2);
+		if (err)
+			return err;
+		bool is_cast;
+		err = c_token_begins_type_name(compiler->prog, &token2,
+					       &is_cast);
+		if (err)
+			return err;
+		if (is_cast) {
+			struct drgn_qualified_type qualified_type;
+			err = c_parse_type_name(compiler->prog,
+						&compiler->lexer, NULL,
+						&qualified_type);
+			if (err == &drgn_not_found) {
+				return drgn_error_create(DRGN_ERROR_LOOKUP,
+							 "could not find type in cast");
+			} else if (err) {
+				return err;
+			}
+			err = c_expect_token(compiler, C_TOKEN_RPAREN, ")");
+			if (err)
+				return err;
+			err = c_compile_unary_expression(compiler);
+			if (err)
+				return err;
+			return drgn_expression_builder_append_cast(compiler->builder,
+								   qualified_type);
+		}
+	}
+	/* fallthrough */
+	default:
+		err = drgn_lexer_push(&compiler->lexer, &token);
+		if (err)
+			return err;
+		return c_compile_postfix_expression(compiler);
+	}
+
+	err = c_compile_unary_expression(compiler);
+	if (err)
+		return err;
+	return drgn_expression_builder_append(compiler->builder, opcode);
+}
+
+static const struct {
+	/* Higher binds more tightly. 0 if the token is not a binary operator. */
+	int precedence;
+	enum drgn_expression_opcode opcode;
+} c_binary_operators[] = {
+	[C_TOKEN_LOGICAL_OR] = { 1, DRGN_EXPR_JUMP_IF_TRUE },
+	[C_TOKEN_LOGICAL_AND] = { 2, DRGN_EXPR_JUMP_IF_FALSE },
+	[C_TOKEN_PIPE] = { 3, DRGN_EXPR_OR },
+	[C_TOKEN_CARET] = { 4, DRGN_EXPR_XOR },
+	[C_TOKEN_AMPERSAND] = { 5, DRGN_EXPR_AND },
+	[C_TOKEN_EQ] = { 6, DRGN_EXPR_EQ },
+	[C_TOKEN_NE] = { 6, DRGN_EXPR_NE },
+	[C_TOKEN_LT] = { 7, DRGN_EXPR_LT },
+	[C_TOKEN_GT] = { 7, DRGN_EXPR_GT },
+	[C_TOKEN_LE] = { 7, DRGN_EXPR_LE },
+	[C_TOKEN_GE] = { 7, DRGN_EXPR_GE },
+	[C_TOKEN_LSHIFT] = { 8, DRGN_EXPR_LSHIFT },
+	[C_TOKEN_RSHIFT] = { 8, DRGN_EXPR_RSHIFT },
+	[C_TOKEN_PLUS] = { 9, DRGN_EXPR_ADD },
+	[C_TOKEN_MINUS] = { 9, DRGN_EXPR_SUB },
+	[C_TOKEN_ASTERISK] = { 10, DRGN_EXPR_MUL },
+	[C_TOKEN_SLASH] = { 10, DRGN_EXPR_DIV },
+	[C_TOKEN_PERCENT] = { 10, DRGN_EXPR_MOD },
+};
+
+/* Parse binary operators by precedence climbing. */
+static struct drgn_error *
+c_compile_binary_expression(struct c_expression_compiler *compiler,
+			    int min_precedence)
+{
+	struct drgn_error *err;
+
+	err = c_compile_unary_expression(compiler);
+	if (err)
+		return err;
+
+	for (;;) {
+		struct drgn_token token;
+		err = drgn_lexer_peek(&compiler->lexer, &token);
+		if (err)
+			return err;
+		if (token.kind < 0 ||
+		    token.kind >= ARRAY_SIZE(c_binary_operators) ||
+		    !c_binary_operators[token.kind].precedence ||
+		    c_binary_operators[token.kind].precedence < min_precedence)
+			return NULL;
+		err = drgn_lexer_pop(&compiler->lexer, &token);
+		if (err)
+			return err;
+
+		int precedence = c_binary_operators[token.kind].precedence;
+		enum drgn_expression_opcode opcode =
+			c_binary_operators[token.kind].opcode;
+		if (opcode == DRGN_EXPR_JUMP_IF_TRUE ||
+		    opcode == DRGN_EXPR_JUMP_IF_FALSE) {
+			size_t jump;
+			err = drgn_expression_builder_append_jump(compiler->builder,
+								  opcode,
+								  &jump);
+			if (err)
+				return err;
+			err = c_compile_binary_expression(compiler,
+							  precedence + 1);
+			if (err)
+				return err;
+			err = drgn_expression_builder_append(compiler->builder,
+							     DRGN_EXPR_BOOL);
+			if (err)
+				return err;
+			drgn_expression_builder_set_jump_target(compiler->builder,
+								jump);
+		} else {
+			err = c_compile_binary_expression(compiler,
+							  precedence + 1);
+			if (err)
+				return err;
+			err = drgn_expression_builder_append(compiler->builder,
+							     opcode);
+			if (err)
+				return err;
+		}
+	}
+}
+
+struct drgn_error *c_compile_expression(struct drgn_program *prog,
+					const char *expr,
+					struct drgn_expression_builder *builder)
+{
+	struct drgn_error *err;
+	struct c_expression_compiler compiler = {
+		.prog = prog,
+		.builder = builder,
 	};
+	struct drgn_token token;
+
+	drgn_lexer_init(&compiler.lexer, drgn_lexer_c, expr);
+	drgn_object_init(&compiler.tmp, prog);
+
+	err = c_compile_expression_impl(&compiler);
+	if (err)
+		goto out;
+
+	err = drgn_lexer_pop(&compiler.lexer, &token);
+	if (err)
+		goto out;
+	if (token.kind != C_TOKEN_EOF) {
+		err = drgn_error_create(DRGN_ERROR_SYNTAX,
+					"extra tokens after expression");
+	}
+out:
+	drgn_object_deinit(&compiler.tmp);
+	drgn_lexer_deinit(&compiler.lexer);
+	return err;
+}
+
+/*
+ * Set an integer literal to the first of the given types that can represent
+ * it.
+ */
+static struct drgn_error *
+c_integer_literal_with_types(struct drgn_object *res, uint64_t uvalue,
+			     const enum drgn_primitive_type *types,
+			     size_t num_types)
+{
 	struct drgn_error *err;
 	unsigned int bits;
 	struct drgn_qualified_type qualified_type;
@@ -2715,7 +3270,7 @@ struct drgn_error *c_integer_literal(struct drgn_object *res, uint64_t uvalue)
 
 	bits = fls(uvalue);
 	qualified_type.qualifiers = 0;
-	for (i = 0; i < ARRAY_SIZE(types); i++) {
+	for (i = 0; i < num_types; i++) {
 		err = drgn_program_find_primitive_type(drgn_object_program(res),
 						       types[i],
 						       &qualified_type.type);
@@ -2737,6 +3292,48 @@ struct drgn_error *c_integer_literal(struct drgn_object *res, uint64_t uvalue)
 				 "integer literal is too large");
 }
 
+struct drgn_error *c_integer_literal(struct drgn_object *res, uint64_t uvalue)
+{
+	static const enum drgn_primitive_type types[] = {
+		DRGN_C_TYPE_INT,
+		DRGN_C_TYPE_LONG,
+		DRGN_C_TYPE_LONG_LONG,
+		DRGN_C_TYPE_UNSIGNED_LONG_LONG,
+	};
+	return c_integer_literal_with_types(res, uvalue, types,
+					    ARRAY_SIZE(types));
+}
+
+/*
+ * Set an integer literal with a suffix. Like unsuffixed literals, a literal
+ * which doesn't fit in any signed type becomes unsigned long long.
+ */
+static struct drgn_error *c_suffixed_integer_literal(struct drgn_object *res,
+						     uint64_t uvalue,
+						     bool is_unsigned,
+						     int longs)
+{
+	static const enum drgn_primitive_type types[] = {
+		DRGN_C_TYPE_INT,
+		DRGN_C_TYPE_LONG,
+		DRGN_C_TYPE_LONG_LONG,
+		DRGN_C_TYPE_UNSIGNED_LONG_LONG,
+	};
+	static const enum drgn_primitive_type unsigned_types[] = {
+		DRGN_C_TYPE_UNSIGNED_INT,
+		DRGN_C_TYPE_UNSIGNED_LONG,
+		DRGN_C_TYPE_UNSIGNED_LONG_LONG,
+	};
+	if (is_unsigned) {
+		return c_integer_literal_with_types(res, uvalue,
+						    unsigned_types + longs,
+						    ARRAY_SIZE(unsigned_types) - longs);
+	} else {
+		return c_integer_literal_with_types(res, uvalue, types + longs,
+						    ARRAY_SIZE(types) - longs);
+	}
+}
+
 struct drgn_error *c_bool_literal(struct drgn_object *res, bool bvalue)
 {
 	struct drgn_error *err;
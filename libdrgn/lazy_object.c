@@ -4,6 +4,7 @@
 #include <assert.h>
 
 #include "lazy_object.h"
+#include "program.h"
 
 static_assert(offsetof(union drgn_lazy_object, obj.type) ==
 	      offsetof(union drgn_lazy_object, thunk.dummy_type),
@@ -12,19 +13,57 @@ static_assert(offsetof(union drgn_lazy_object, obj.type) ==
 struct drgn_error *drgn_lazy_object_evaluate(union drgn_lazy_object *lazy_obj)
 {
 	struct drgn_error *err;
-	if (!drgn_lazy_object_is_evaluated(lazy_obj)) {
-		struct drgn_program *prog = lazy_obj->thunk.prog;
-		drgn_object_thunk_fn *fn = lazy_obj->thunk.fn;
-		void *arg = lazy_obj->thunk.arg;
-		drgn_object_init(&lazy_obj->obj, prog);
-		err = fn(&lazy_obj->obj, arg);
-		if (err) {
-			/* Oops, revert back to a thunk so it can be retried. */
-			drgn_lazy_object_init_thunk(lazy_obj, prog, fn, arg);
-			return err;
-		}
+	struct drgn_program *prog;
+
+	/*
+	 * The thunk shares memory with the object, so the program read here is
+	 * only valid if the object still wasn't being stored afterwards.
+	 */
+	do {
+		if (drgn_lazy_object_is_evaluated(lazy_obj))
+			return NULL;
+		prog = __atomic_load_n(&lazy_obj->thunk.prog, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (__atomic_load_n(&lazy_obj->obj.type, __ATOMIC_RELAXED));
+
+	/*
+	 * Thunks parse debugging information and create types, so this is a
+	 * type table mutation that needs the types lock; see
+	 * drgn_program_prefetch(). The lock is only taken on the first
+	 * evaluation, and it also keeps other threads from evaluating the
+	 * thunk concurrently.
+	 */
+	drgn_program_lock_types(prog);
+	if (drgn_lazy_object_is_evaluated(lazy_obj)) {
+		err = NULL;
+		goto out;
 	}
-	return NULL;
+	drgn_object_thunk_fn *fn = lazy_obj->thunk.fn;
+	void *arg = lazy_obj->thunk.arg;
+	struct drgn_object obj;
+	drgn_object_init(&obj, prog);
+	err = fn(&obj, arg);
+	if (err) {
+		/* The thunk is untouched, so it can be retried. */
+		drgn_object_deinit(&obj);
+		goto out;
+	}
+
+	/*
+	 * Threads which haven't taken the lock may be reading the thunk or the
+	 * object, so mark the object as being stored before overwriting the
+	 * thunk and only publish its type once it is complete.
+	 */
+	struct drgn_type *type = obj.type;
+	__atomic_store_n(&lazy_obj->obj.type, DRGN_LAZY_OBJECT_STORING,
+			 __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	obj.type = DRGN_LAZY_OBJECT_STORING;
+	lazy_obj->obj = obj;
+	__atomic_store_n(&lazy_obj->obj.type, type, __ATOMIC_RELEASE);
+out:
+	drgn_program_unlock_types(prog);
+	return err;
 }
 
 void drgn_lazy_object_deinit(union drgn_lazy_object *lazy_obj)
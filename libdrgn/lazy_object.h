@@ -46,11 +46,22 @@ drgn_lazy_object_init_thunk(union drgn_lazy_object *lazy_obj,
 	lazy_obj->thunk.arg = arg;
 }
 
+/**
+ * Placeholder for @ref drgn_object::type while an evaluated object is being
+ * stored in a @ref drgn_lazy_object.
+ */
+#define DRGN_LAZY_OBJECT_STORING ((struct drgn_type *)1)
+
 /** Return whether a @ref drgn_lazy_object has been evaluated. */
 static inline bool
 drgn_lazy_object_is_evaluated(const union drgn_lazy_object *lazy_obj)
 {
-	return lazy_obj->obj.type != NULL;
+	struct drgn_type *type;
+	/* Another thread may be storing the object; it won't take long. */
+	while ((type = __atomic_load_n(&lazy_obj->obj.type, __ATOMIC_ACQUIRE))
+	       == DRGN_LAZY_OBJECT_STORING)
+		;
+	return type != NULL;
 }
 
 /**
@@ -58,7 +69,8 @@ drgn_lazy_object_is_evaluated(const union drgn_lazy_object *lazy_obj)
  *
  * If this success, then the lazy object is considered evaluated and future
  * calls will always succeed. If this fails, then the lazy object remains in a
- * valid, unevaluated state.
+ * valid, unevaluated state. This is safe to call from multiple threads; the
+ * thunk is only called by one of them at a time.
  */
 struct drgn_error *drgn_lazy_object_evaluate(union drgn_lazy_object *lazy_obj);
 
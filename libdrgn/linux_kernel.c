@@ -80,6 +80,7 @@ struct drgn_error *parse_vmcoreinfo(const char *desc, size_t descsz,
 	ret->page_size = 0;
 	ret->kaslr_offset = 0;
 	ret->pgtable_l5_enabled = false;
+	ret->section_size_bits = 0;
 	while (line < end) {
 		const char *newline;
 
@@ -116,6 +117,11 @@ struct drgn_error *parse_vmcoreinfo(const char *desc, size_t descsz,
 			if (err)
 				return err;
 			ret->pgtable_l5_enabled = tmp;
+		} else if (linematch(&line, "NUMBER(SECTION_SIZE_BITS)=")) {
+			err = line_to_u64(line, newline, 0,
+					  &ret->section_size_bits);
+			if (err)
+				return err;
 		}
 		line = newline + 1;
 	}
@@ -131,7 +137,10 @@ struct drgn_error *parse_vmcoreinfo(const char *desc, size_t descsz,
 		return drgn_error_create(DRGN_ERROR_OTHER,
 					 "VMCOREINFO does not contain valid swapper_pg_dir");
 	}
-	/* KERNELOFFSET and pgtable_l5_enabled are optional. */
+	/*
+	 * KERNELOFFSET, pgtable_l5_enabled, and SECTION_SIZE_BITS are
+	 * optional.
+	 */
 	return NULL;
 }
 
@@ -258,15 +267,19 @@ struct drgn_error *linux_kernel_object_find(const char *name, size_t name_len,
 
 		if (name_len == strlen("PAGE_OFFSET") &&
 		    memcmp(name, "PAGE_OFFSET", name_len) == 0) {
-			if (prog->page_offset.kind == DRGN_OBJECT_ABSENT) {
-				if (!prog->has_platform ||
-				    !prog->platform.arch->linux_kernel_get_page_offset)
-					return &drgn_not_found;
+			if (!prog->has_platform ||
+			    !prog->platform.arch->linux_kernel_get_page_offset)
+				return &drgn_not_found;
+			/* The cached object is filled in lazily. */
+			drgn_program_lock_types(prog);
+			if (prog->page_offset.kind == DRGN_OBJECT_ABSENT)
 				err = prog->platform.arch->linux_kernel_get_page_offset(&prog->page_offset);
-				if (err)
-					return err;
-			}
-			return drgn_object_copy(ret, &prog->page_offset);
+			else
+				err = NULL;
+			if (!err)
+				err = drgn_object_copy(ret, &prog->page_offset);
+			drgn_program_unlock_types(prog);
+			return err;
 		} else if (name_len == strlen("PAGE_SHIFT") &&
 			   memcmp(name, "PAGE_SHIFT", name_len) == 0) {
 			err = drgn_program_find_primitive_type(prog,
@@ -319,15 +332,19 @@ struct drgn_error *linux_kernel_object_find(const char *name, size_t name_len,
 							   len + 1, 0, 0);
 		} else if (name_len == strlen("vmemmap") &&
 			   memcmp(name, "vmemmap", name_len) == 0) {
-			if (prog->vmemmap.kind == DRGN_OBJECT_ABSENT) {
-				if (!prog->has_platform ||
-				    !prog->platform.arch->linux_kernel_get_vmemmap)
-					return &drgn_not_found;
+			if (!prog->has_platform ||
+			    !prog->platform.arch->linux_kernel_get_vmemmap)
+				return &drgn_not_found;
+			/* The cached object is filled in lazily. */
+			drgn_program_lock_types(prog);
+			if (prog->vmemmap.kind == DRGN_OBJECT_ABSENT)
 				err = prog->platform.arch->linux_kernel_get_vmemmap(&prog->vmemmap);
-				if (err)
-					return err;
-			}
-			return drgn_object_copy(ret, &prog->vmemmap);
+			else
+				err = NULL;
+			if (!err)
+				err = drgn_object_copy(ret, &prog->vmemmap);
+			drgn_program_unlock_types(prog);
+			return err;
 		}
 	}
 	return &drgn_not_found;
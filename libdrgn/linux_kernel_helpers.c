@@ -1,25 +1,34 @@
 // Copyright (c) Facebook, Inc. and its affiliates.
 // SPDX-License-Identifier: GPL-3.0+
 
+#include <byteswap.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
+#include <unistd.h>
 
+#include "bitops.h"
 #include "drgn.h"
+#include "error.h"
+#include "helpers.h"
 #include "minmax.h"
 #include "platform.h"
 #include "program.h"
+#include "serialize.h"
+#include "type.h"
+#include "util.h"
 
-struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
-					uint64_t pgtable, uint64_t virt_addr,
-					void *buf, size_t count)
-{
-	struct drgn_error *err;
-	struct pgtable_iterator *it;
-	pgtable_iterator_next_fn *next;
-	uint64_t read_addr = 0;
-	size_t read_size = 0;
+/*
+ * Whether this thread is translating an address, used to prevent address
+ * translation from recursing.
+ */
+static __thread bool in_address_translation;
 
+static struct drgn_error *
+linux_helper_check_pgtable_iterator(struct drgn_program *prog)
+{
 	if (!(prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)) {
 		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
 					 "virtual address translation is only available for the Linux kernel");
@@ -33,29 +42,47 @@ struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
 					 "virtual address translation is not implemented for %s architecture",
 					 prog->platform.arch->name);
 	}
+	return NULL;
+}
+
+struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
+					uint64_t pgtable, uint64_t virt_addr,
+					void *buf, size_t count)
+{
+	struct drgn_error *err;
+	struct pgtable_iterator *it;
+	pgtable_iterator_next_fn *next;
+	uint64_t read_addr = 0;
+	size_t read_size = 0;
+
+	err = linux_helper_check_pgtable_iterator(prog);
+	if (err)
+		return err;
 
 	if (!count)
 		return NULL;
 
-	if (prog->pgtable_it_in_use) {
+	if (in_address_translation) {
 		return drgn_error_create_fault("recursive address translation; "
 					       "page table may be missing from core dump",
 					       virt_addr);
 	}
 
-	if (prog->pgtable_it) {
-		it = prog->pgtable_it;
-	} else {
+	/*
+	 * Take the cached iterator. If another thread is using it, allocate
+	 * one for this thread.
+	 */
+	it = __atomic_exchange_n(&prog->pgtable_it, NULL, __ATOMIC_ACQUIRE);
+	if (!it) {
 		it = malloc(sizeof(*it) +
 			    prog->platform.arch->pgtable_iterator_arch_size);
 		if (!it)
 			return &drgn_enomem;
-		prog->pgtable_it = it;
 		it->prog = prog;
 	}
 	it->pgtable = pgtable;
 	it->virt_addr = virt_addr;
-	prog->pgtable_it_in_use = true;
+	in_address_translation = true;
 	prog->platform.arch->pgtable_iterator_arch_init(it->arch);
 	next = prog->platform.arch->linux_kernel_pgtable_iterator_next;
 	do {
@@ -95,7 +122,206 @@ struct drgn_error *linux_helper_read_vm(struct drgn_program *prog,
 		err = drgn_program_read_memory(prog, buf, read_addr, read_size,
 					       true);
 	}
-	prog->pgtable_it_in_use = false;
+	in_address_translation = false;
+	/* Put the iterator back unless another thread already did. */
+	struct pgtable_iterator *expected = NULL;
+	if (!__atomic_compare_exchange_n(&prog->pgtable_it, &expected, it,
+					 false, __ATOMIC_RELEASE,
+					 __ATOMIC_RELAXED))
+		free(it);
+	return err;
+}
+
+struct drgn_error *
+linux_helper_pgtable_range_iterator_init(struct linux_helper_pgtable_range_iterator *it,
+					 struct drgn_program *prog,
+					 uint64_t pgtable, uint64_t start,
+					 uint64_t last)
+{
+	struct drgn_error *err = linux_helper_check_pgtable_iterator(prog);
+	if (err)
+		return err;
+	/*
+	 * Unlike linux_helper_read_vm(), this holds the iterator between calls,
+	 * so it can't use the cached one.
+	 */
+	it->it = malloc(sizeof(*it->it) +
+			prog->platform.arch->pgtable_iterator_arch_size);
+	if (!it->it)
+		return &drgn_enomem;
+	it->it->prog = prog;
+	it->it->pgtable = pgtable;
+	it->it->virt_addr = start;
+	prog->platform.arch->pgtable_iterator_arch_init(it->it->arch);
+	it->last = last;
+	it->done = start > last;
+	it->have_pending = false;
+	return NULL;
+}
+
+void
+linux_helper_pgtable_range_iterator_deinit(struct linux_helper_pgtable_range_iterator *it)
+{
+	free(it->it);
+}
+
+struct drgn_error *
+linux_helper_pgtable_range_iterator_next(struct linux_helper_pgtable_range_iterator *it,
+					 const struct linux_helper_pgtable_range **ret)
+{
+	struct drgn_error *err;
+	pgtable_iterator_next_fn *next =
+		it->it->prog->platform.arch->linux_kernel_pgtable_iterator_next;
+	bool have_range = it->have_pending;
+	if (have_range) {
+		it->range = it->pending;
+		it->have_pending = false;
+	}
+	while (!it->done) {
+		uint64_t virt_addr = it->it->virt_addr;
+		uint64_t start, phys_addr;
+		err = next(it->it, &start, &phys_addr);
+		if (err)
+			return err;
+		/* The end of the address space wraps around to 0. */
+		uint64_t last = it->it->virt_addr - 1;
+		if (last >= it->last || it->it->virt_addr == 0) {
+			last = it->last;
+			it->done = true;
+		}
+		if (phys_addr == UINT64_MAX) {
+			if (have_range)
+				break;
+			continue;
+		}
+		/* The first range may begin before the requested start. */
+		phys_addr += virt_addr - start;
+		uint64_t size = last - virt_addr + 1;
+		if (have_range &&
+		    it->range.start + it->range.size == virt_addr &&
+		    it->range.phys_addr + it->range.size == phys_addr &&
+		    it->range.flags == it->it->flags) {
+			it->range.size += size;
+			continue;
+		}
+		struct linux_helper_pgtable_range *range =
+			have_range ? &it->pending : &it->range;
+		range->start = virt_addr;
+		range->size = size;
+		range->phys_addr = phys_addr;
+		range->flags = it->it->flags;
+		if (have_range) {
+			it->have_pending = true;
+			break;
+		}
+		have_range = true;
+	}
+	if (!have_range)
+		return &drgn_stop;
+	*ret = &it->range;
+	return NULL;
+}
+
+static struct drgn_error *write_all(int fd, const void *buf, size_t count,
+				    uint64_t offset)
+{
+	while (count) {
+		ssize_t ret = pwrite(fd, buf, count, offset);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return drgn_error_create_os("pwrite", errno, NULL);
+		}
+		buf = (const char *)buf + ret;
+		count -= ret;
+		offset += ret;
+	}
+	return NULL;
+}
+
+/*
+ * Copy physical memory to a file. If the whole chunk can't be read, fall back
+ * to copying it a page at a time and skip the pages that are missing (e.g.,
+ * user pages which were filtered out of the core dump).
+ */
+static struct drgn_error *write_vm_chunk(struct drgn_program *prog, void *buf,
+					 uint64_t phys_addr, size_t count,
+					 int fd, uint64_t offset,
+					 uint64_t *written)
+{
+	struct drgn_error *err;
+	err = drgn_program_read_memory(prog, buf, phys_addr, count, true);
+	if (!err) {
+		*written += count;
+		return write_all(fd, buf, count, offset);
+	}
+	if (err->code != DRGN_ERROR_FAULT)
+		return err;
+	drgn_error_destroy(err);
+
+	uint64_t page_size = prog->vmcoreinfo.page_size;
+	size_t pos = 0;
+	while (pos < count) {
+		size_t n = min(page_size - (phys_addr + pos) % page_size,
+			       (uint64_t)(count - pos));
+		err = drgn_program_read_memory(prog, (char *)buf + pos,
+					       phys_addr + pos, n, true);
+		if (!err) {
+			*written += n;
+			err = write_all(fd, (char *)buf + pos, n, offset + pos);
+			if (err)
+				return err;
+		} else if (err->code == DRGN_ERROR_FAULT) {
+			drgn_error_destroy(err);
+		} else {
+			return err;
+		}
+		pos += n;
+	}
+	return NULL;
+}
+
+struct drgn_error *linux_helper_write_vm(struct drgn_program *prog,
+					 uint64_t pgtable, uint64_t virt_addr,
+					 uint64_t size, int fd, uint64_t offset,
+					 uint64_t *written_ret)
+{
+	static const size_t CHUNK_SIZE = 1024 * 1024;
+	struct drgn_error *err;
+
+	*written_ret = 0;
+	if (!size)
+		return NULL;
+
+	struct linux_helper_pgtable_range_iterator it;
+	err = linux_helper_pgtable_range_iterator_init(&it, prog, pgtable,
+						       virt_addr,
+						       virt_addr + size - 1);
+	if (err)
+		return err;
+	void *buf = malloc(CHUNK_SIZE);
+	if (!buf) {
+		err = &drgn_enomem;
+		goto out_it;
+	}
+	const struct linux_helper_pgtable_range *range;
+	while (!(err = linux_helper_pgtable_range_iterator_next(&it, &range))) {
+		uint64_t range_offset = offset + (range->start - virt_addr);
+		for (uint64_t pos = 0; pos < range->size; pos += CHUNK_SIZE) {
+			size_t n = min(range->size - pos, (uint64_t)CHUNK_SIZE);
+			err = write_vm_chunk(prog, buf, range->phys_addr + pos,
+					     n, fd, range_offset + pos,
+					     written_ret);
+			if (err)
+				goto out_buf;
+		}
+	}
+	if (err == &drgn_stop)
+		err = NULL;
+out_buf:
+	free(buf);
+out_it:
+	linux_helper_pgtable_range_iterator_deinit(&it);
 	return err;
 }
 
@@ -531,3 +757,3852 @@ out:
 	drgn_object_deinit(&pid_obj);
 	return err;
 }
+
+DEFINE_VECTOR_FUNCTIONS(linux_helper_rbtree_frame_vector)
+
+/* Find a byte-aligned member of a list or tree node type. */
+static struct drgn_error *
+linux_helper_node_member(struct drgn_type *node_type, const char *name,
+			 uint64_t *offset_ret,
+			 struct drgn_qualified_type *type_ret)
+{
+	struct drgn_error *err;
+	struct drgn_type_member *member;
+	uint64_t bit_offset;
+	err = drgn_type_find_member(node_type, name, &member, &bit_offset);
+	if (err)
+		return err;
+	if (bit_offset % 8) {
+		return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+					 "%s member is not byte-aligned", name);
+	}
+	*offset_ret = bit_offset / 8;
+	if (type_ret) {
+		err = drgn_member_type(member, type_ret, NULL);
+		if (err)
+			return err;
+		if (drgn_type_kind(drgn_underlying_type(type_ret->type)) !=
+		    DRGN_TYPE_POINTER) {
+			return drgn_error_format(DRGN_ERROR_TYPE,
+						 "%s member is not a pointer",
+						 name);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Read a list head or tree root pointer and get the type that it points to.
+ */
+static struct drgn_error *
+linux_helper_read_head(const struct drgn_object *head,
+		       const char *type_error_format, uint64_t *address_ret,
+		       struct drgn_type **type_ret)
+{
+	struct drgn_error *err;
+	struct drgn_type *underlying_type = drgn_underlying_type(head->type);
+	if (drgn_type_kind(underlying_type) != DRGN_TYPE_POINTER) {
+		return drgn_qualified_type_error(type_error_format,
+						 drgn_object_qualified_type(head));
+	}
+	err = drgn_object_read_unsigned(head, address_ret);
+	if (err)
+		return err;
+	*type_ret = drgn_underlying_type(drgn_type_type(underlying_type).type);
+	return NULL;
+}
+
+/*
+ * Get the pointer type of the entries returned by a list or tree iterator and
+ * the offset of the node in an entry. If entry_type is NULL, the nodes
+ * themselves are returned.
+ */
+static struct drgn_error *
+linux_helper_entry_type(struct drgn_program *prog,
+			struct drgn_qualified_type node_pointer_type,
+			struct drgn_qualified_type entry_type,
+			const char *member, struct drgn_qualified_type *ret,
+			uint64_t *offset_ret)
+{
+	struct drgn_error *err;
+	if (!entry_type.type) {
+		*ret = node_pointer_type;
+		*offset_ret = 0;
+		return NULL;
+	}
+	err = drgn_type_offsetof(entry_type.type, member, offset_ret);
+	if (err)
+		return err;
+	uint8_t word_size;
+	err = drgn_program_word_size(prog, &word_size);
+	if (err)
+		return err;
+	err = drgn_pointer_type_create(prog, entry_type, word_size,
+				       DRGN_PROGRAM_ENDIAN,
+				       drgn_type_language(entry_type.type),
+				       &ret->type);
+	if (err)
+		return err;
+	ret->qualifiers = 0;
+	return NULL;
+}
+
+static void
+linux_helper_list_iterator_init_common(struct linux_helper_list_iterator *it,
+				       struct drgn_program *prog,
+				       uint64_t head, uint64_t first,
+				       uint64_t max_length, bool validate)
+{
+	it->prog = prog;
+	it->head = head;
+	it->pos = first;
+	it->count = 0;
+	it->max_length = max_length;
+	it->validate = validate;
+	/* List nodes are aligned, so this never matches a real node. */
+	it->saved_pos = UINT64_MAX;
+	it->power = it->lambda = 1;
+}
+
+struct drgn_error *
+linux_helper_list_iterator_init(struct linux_helper_list_iterator *it,
+				const struct drgn_object *head,
+				struct drgn_qualified_type entry_type,
+				const char *member, bool reverse,
+				uint64_t max_length, bool validate)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(head);
+
+	uint64_t head_address;
+	struct drgn_type *list_head_type;
+	err = linux_helper_read_head(head,
+				     "list head must be a pointer, not '%s'",
+				     &head_address, &list_head_type);
+	if (err)
+		return err;
+	struct drgn_qualified_type node_pointer_type;
+	err = linux_helper_node_member(list_head_type,
+				       reverse ? "prev" : "next",
+				       &it->next_offset, &node_pointer_type);
+	if (err)
+		return err;
+	err = linux_helper_entry_type(prog, node_pointer_type, entry_type,
+				      member, &it->entry_type,
+				      &it->member_offset);
+	if (err)
+		return err;
+
+	uint64_t first;
+	err = drgn_program_read_word(prog, head_address + it->next_offset,
+				     false, &first);
+	if (err)
+		return err;
+	linux_helper_list_iterator_init_common(it, prog, head_address, first,
+					       max_length, validate);
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_hlist_iterator_init(struct linux_helper_list_iterator *it,
+				 const struct drgn_object *head,
+				 struct drgn_qualified_type entry_type,
+				 const char *member, uint64_t max_length,
+				 bool validate)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(head);
+
+	uint64_t head_address;
+	struct drgn_type *hlist_head_type;
+	err = linux_helper_read_head(head,
+				     "hash list head must be a pointer, not '%s'",
+				     &head_address, &hlist_head_type);
+	if (err)
+		return err;
+	uint64_t first_offset;
+	struct drgn_qualified_type node_pointer_type;
+	err = linux_helper_node_member(hlist_head_type, "first", &first_offset,
+				       &node_pointer_type);
+	if (err)
+		return err;
+	struct drgn_type *hlist_node_type =
+		drgn_underlying_type(drgn_type_type(drgn_underlying_type(node_pointer_type.type)).type);
+	err = linux_helper_node_member(hlist_node_type, "next",
+				       &it->next_offset, NULL);
+	if (err)
+		return err;
+	err = linux_helper_entry_type(prog, node_pointer_type, entry_type,
+				      member, &it->entry_type,
+				      &it->member_offset);
+	if (err)
+		return err;
+
+	uint64_t first;
+	err = drgn_program_read_word(prog, head_address + first_offset, false,
+				     &first);
+	if (err)
+		return err;
+	linux_helper_list_iterator_init_common(it, prog, 0, first, max_length,
+					       validate);
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_list_iterator_next(struct linux_helper_list_iterator *it,
+				uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	if (it->pos == it->head)
+		return &drgn_stop;
+	if (it->count >= it->max_length) {
+		return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+					 "list has more than %" PRIu64 " entries",
+					 it->max_length);
+	}
+	/*
+	 * A valid list never visits a node twice before getting back to the
+	 * head. Brent's algorithm finds a cycle in O(1) space.
+	 */
+	if (it->validate) {
+		if (it->pos == it->saved_pos) {
+			return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+						 "list contains a cycle at 0x%" PRIx64,
+						 it->pos);
+		}
+		if (it->lambda == it->power) {
+			it->saved_pos = it->pos;
+			it->power *= 2;
+			it->lambda = 0;
+		}
+		it->lambda++;
+	}
+
+	uint64_t next;
+	err = drgn_program_read_word(it->prog, it->pos + it->next_offset,
+				     false, &next);
+	if (err)
+		return err;
+	*ret = it->pos - it->member_offset;
+	it->pos = next;
+	it->count++;
+	return NULL;
+}
+
+/*
+ * A red-black tree with n nodes has a height of at most 2 log2(n + 1), so no
+ * valid tree in a 64-bit address space is deeper than this.
+ */
+#define RB_TREE_MAX_DEPTH 128
+
+/* Push a node and its chain of left children. */
+static struct drgn_error *
+linux_helper_rbtree_push(struct linux_helper_rbtree_iterator *it,
+			 uint64_t node, uint64_t parent)
+{
+	struct drgn_error *err;
+
+	bool bswap;
+	err = drgn_program_bswap(it->prog, &bswap);
+	if (err)
+		return err;
+	uint8_t word_size;
+	err = drgn_program_word_size(it->prog, &word_size);
+	if (err)
+		return err;
+
+	while (node) {
+		if (it->validate && it->stack.size >= RB_TREE_MAX_DEPTH) {
+			return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+						 "red-black tree is too deep");
+		}
+		/* Read the whole node at once. */
+		char buf[64];
+		err = drgn_memory_reader_read(&it->prog->reader, buf, node,
+					      it->node_size, false);
+		if (err)
+			return err;
+		uint64_t words[3];
+		uint64_t offsets[3] = {
+			it->parent_color_offset, it->right_offset,
+			it->left_offset,
+		};
+		for (int i = 0; i < 3; i++) {
+			if (word_size == 8) {
+				uint64_t word;
+				memcpy(&word, &buf[offsets[i]], sizeof(word));
+				words[i] = bswap ? bswap_64(word) : word;
+			} else {
+				uint32_t word;
+				memcpy(&word, &buf[offsets[i]], sizeof(word));
+				words[i] = bswap ? bswap_32(word) : word;
+			}
+		}
+		if (it->validate && (words[0] & ~UINT64_C(3)) != parent) {
+			return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+						 "red-black tree node 0x%" PRIx64 " has invalid parent",
+						 node);
+		}
+		struct linux_helper_rbtree_frame *frame =
+			linux_helper_rbtree_frame_vector_append_entry(&it->stack);
+		if (!frame)
+			return &drgn_enomem;
+		frame->node = node;
+		frame->right = words[1];
+		parent = node;
+		node = words[2];
+	}
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_rbtree_iterator_init(struct linux_helper_rbtree_iterator *it,
+				  const struct drgn_object *root,
+				  struct drgn_qualified_type entry_type,
+				  const char *member, uint64_t max_length,
+				  bool validate)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(root);
+
+	uint64_t root_address;
+	struct drgn_type *rb_root_type;
+	err = linux_helper_read_head(root,
+				     "red-black tree root must be a pointer, not '%s'",
+				     &root_address, &rb_root_type);
+	if (err)
+		return err;
+	uint64_t rb_node_offset;
+	struct drgn_qualified_type node_pointer_type;
+	err = linux_helper_node_member(rb_root_type, "rb_node",
+				       &rb_node_offset, &node_pointer_type);
+	if (err)
+		return err;
+	struct drgn_type *rb_node_type =
+		drgn_underlying_type(drgn_type_type(drgn_underlying_type(node_pointer_type.type)).type);
+	err = linux_helper_node_member(rb_node_type, "__rb_parent_color",
+				       &it->parent_color_offset, NULL);
+	if (err && err->code == DRGN_ERROR_LOOKUP) {
+		/* Before Linux kernel commit bf7ad8eeab99 (in v3.5). */
+		drgn_error_destroy(err);
+		err = linux_helper_node_member(rb_node_type, "rb_parent_color",
+					       &it->parent_color_offset, NULL);
+	}
+	if (err)
+		return err;
+	err = linux_helper_node_member(rb_node_type, "rb_right",
+				       &it->right_offset, NULL);
+	if (err)
+		return err;
+	err = linux_helper_node_member(rb_node_type, "rb_left",
+				       &it->left_offset, NULL);
+	if (err)
+		return err;
+	uint8_t word_size;
+	err = drgn_program_word_size(prog, &word_size);
+	if (err)
+		return err;
+	it->node_size = max(max(it->parent_color_offset, it->right_offset),
+			    it->left_offset) + word_size;
+	if (it->node_size > 64) {
+		return drgn_error_create(DRGN_ERROR_TYPE,
+					 "struct rb_node is too large");
+	}
+	err = linux_helper_entry_type(prog, node_pointer_type, entry_type,
+				      member, &it->entry_type,
+				      &it->member_offset);
+	if (err)
+		return err;
+
+	uint64_t node;
+	err = drgn_program_read_word(prog, root_address + rb_node_offset,
+				     false, &node);
+	if (err)
+		return err;
+	it->prog = prog;
+	linux_helper_rbtree_frame_vector_init(&it->stack);
+	it->count = 0;
+	it->max_length = max_length;
+	it->validate = validate;
+	err = linux_helper_rbtree_push(it, node, 0);
+	if (err)
+		linux_helper_rbtree_iterator_deinit(it);
+	return err;
+}
+
+void
+linux_helper_rbtree_iterator_deinit(struct linux_helper_rbtree_iterator *it)
+{
+	linux_helper_rbtree_frame_vector_deinit(&it->stack);
+}
+
+struct drgn_error *
+linux_helper_rbtree_iterator_next(struct linux_helper_rbtree_iterator *it,
+				  uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	if (!it->stack.size)
+		return &drgn_stop;
+	if (it->count >= it->max_length) {
+		return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+					 "red-black tree has more than %" PRIu64 " nodes",
+					 it->max_length);
+	}
+	struct linux_helper_rbtree_frame frame =
+		*linux_helper_rbtree_frame_vector_pop(&it->stack);
+	err = linux_helper_rbtree_push(it, frame.right, frame.node);
+	if (err)
+		return err;
+	*ret = frame.node - it->member_offset;
+	it->count++;
+	return NULL;
+}
+
+DEFINE_VECTOR_FUNCTIONS(linux_helper_radix_tree_frame_vector)
+
+/*
+ * XArray internal entries up to this value are sibling, retry, and zero entries
+ * rather than nodes (see xa_is_node()).
+ */
+#define XA_MAX_NON_NODE_INTERNAL_ENTRY 4096
+
+static struct drgn_error *
+linux_helper_radix_tree_push(struct linux_helper_radix_tree_iterator *it,
+			     uint64_t node, uint64_t index,
+			     unsigned int parent_shift)
+{
+	struct drgn_error *err;
+
+	bool bswap;
+	err = drgn_program_bswap(it->prog, &bswap);
+	if (err)
+		return err;
+	uint8_t word_size;
+	err = drgn_program_word_size(it->prog, &word_size);
+	if (err)
+		return err;
+
+	/* Read the shift and all of the slots at once. */
+	err = drgn_memory_reader_read(&it->prog->reader, it->buf,
+				      node + it->read_offset, it->read_size,
+				      false);
+	if (err)
+		return err;
+	/*
+	 * The shift must decrease on every level, which also bounds the depth
+	 * of a corrupted tree.
+	 */
+	uint8_t shift = it->buf[it->shift_offset];
+	if (shift >= parent_shift) {
+		return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+					 "radix tree node 0x%" PRIx64 " has invalid shift %u",
+					 node, (unsigned int)shift);
+	}
+
+	struct linux_helper_radix_tree_frame *frame =
+		linux_helper_radix_tree_frame_vector_append_entry(&it->stack);
+	if (!frame)
+		return &drgn_enomem;
+	frame->node = node;
+	frame->index = index;
+	frame->shift = shift;
+	unsigned int map_size = 1U << it->map_shift;
+	const char *p = &it->buf[it->slots_offset];
+	uint64_t bitmap = 0;
+	if (word_size == 8) {
+		for (unsigned int i = 0; i < map_size; i++) {
+			uint64_t slot;
+			memcpy(&slot, p + 8 * i, sizeof(slot));
+			if (bswap)
+				slot = bswap_64(slot);
+			frame->slots[i] = slot;
+			bitmap |= (uint64_t)(slot != 0) << i;
+		}
+	} else {
+		for (unsigned int i = 0; i < map_size; i++) {
+			uint32_t slot;
+			memcpy(&slot, p + 4 * i, sizeof(slot));
+			if (bswap)
+				slot = bswap_32(slot);
+			frame->slots[i] = slot;
+			bitmap |= (uint64_t)(slot != 0) << i;
+		}
+	}
+	frame->bitmap = bitmap;
+	return NULL;
+}
+
+/*
+ * Return whether an internal entry in the given node points to a child node
+ * rather than being a sibling or retry entry.
+ */
+static bool
+linux_helper_radix_tree_is_node(struct linux_helper_radix_tree_iterator *it,
+				uint64_t node, uint64_t entry)
+{
+	if (it->internal_node == 2)
+		return entry > XA_MAX_NON_NODE_INTERNAL_ENTRY;
+	/*
+	 * Before XArrays, sibling entries point to a slot in the same node, and
+	 * the retry entry is an internal entry pointing to NULL.
+	 */
+	uint64_t child = entry & ~it->internal_node;
+	return child && (child < node || child >= node + it->node_size);
+}
+
+struct drgn_error *
+linux_helper_radix_tree_iterator_init(struct linux_helper_radix_tree_iterator *it,
+				      const struct drgn_object *root)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(root);
+	struct drgn_object tmp;
+	const char *node_type_name;
+
+	drgn_object_init(&tmp, prog);
+	err = drgn_object_member_dereference(&tmp, root, "xa_head");
+	if (!err) {
+		it->internal_node = 2;
+		node_type_name = "struct xa_node";
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		err = drgn_object_member_dereference(&tmp, root, "rnode");
+		if (err)
+			goto out;
+		it->internal_node = 1;
+		node_type_name = "struct radix_tree_node";
+	} else {
+		goto out;
+	}
+	uint64_t head;
+	err = drgn_object_read_unsigned(&tmp, &head);
+	if (err)
+		goto out;
+
+	struct drgn_qualified_type node_type;
+	err = drgn_program_find_type(prog, node_type_name, NULL, &node_type);
+	if (err)
+		goto out;
+	node_type.type = drgn_underlying_type(node_type.type);
+	if (!drgn_type_is_complete(node_type.type)) {
+		err = drgn_error_format(DRGN_ERROR_TYPE, "%s is incomplete",
+					node_type_name);
+		goto out;
+	}
+	it->node_size = drgn_type_size(node_type.type);
+	err = linux_helper_node_member(node_type.type, "shift",
+				       &it->shift_offset, NULL);
+	if (err)
+		goto out;
+	struct drgn_type_member *member;
+	uint64_t slots_bit_offset;
+	err = drgn_type_find_member(node_type.type, "slots", &member,
+				    &slots_bit_offset);
+	if (err)
+		goto out;
+	struct drgn_qualified_type slots_type;
+	err = drgn_member_type(member, &slots_type, NULL);
+	if (err)
+		goto out;
+	slots_type.type = drgn_underlying_type(slots_type.type);
+	uint64_t map_size;
+	if (drgn_type_kind(slots_type.type) != DRGN_TYPE_ARRAY ||
+	    (map_size = drgn_type_length(slots_type.type)) == 0 ||
+	    map_size > LINUX_HELPER_RADIX_TREE_MAX_SLOTS ||
+	    (map_size & (map_size - 1)) || slots_bit_offset % 8) {
+		err = drgn_error_format(DRGN_ERROR_TYPE,
+					"%s slots member is not a supported array",
+					node_type_name);
+		goto out;
+	}
+	it->map_shift = ctz(map_size);
+	uint8_t word_size;
+	err = drgn_program_word_size(prog, &word_size);
+	if (err)
+		goto out;
+	it->slots_offset = slots_bit_offset / 8;
+	it->read_offset = min(it->shift_offset, it->slots_offset);
+	it->read_size = max(it->shift_offset + 1,
+			    it->slots_offset + map_size * word_size) -
+			it->read_offset;
+	it->shift_offset -= it->read_offset;
+	it->slots_offset -= it->read_offset;
+
+	err = drgn_program_find_type(prog, "void *", NULL, &it->entry_type);
+	if (err)
+		goto out;
+
+	it->buf = malloc(it->read_size);
+	if (!it->buf) {
+		err = &drgn_enomem;
+		goto out;
+	}
+	it->prog = prog;
+	it->root_entry = 0;
+	linux_helper_radix_tree_frame_vector_init(&it->stack);
+	if ((head & 3) != it->internal_node) {
+		it->root_entry = head;
+	} else if (linux_helper_radix_tree_is_node(it, 0, head)) {
+		err = linux_helper_radix_tree_push(it, head & ~it->internal_node,
+						   0, 64);
+		if (err)
+			linux_helper_radix_tree_iterator_deinit(it);
+	}
+out:
+	drgn_object_deinit(&tmp);
+	return err;
+}
+
+void
+linux_helper_radix_tree_iterator_deinit(struct linux_helper_radix_tree_iterator *it)
+{
+	linux_helper_radix_tree_frame_vector_deinit(&it->stack);
+	free(it->buf);
+}
+
+struct drgn_error *
+linux_helper_radix_tree_iterator_next(struct linux_helper_radix_tree_iterator *it,
+				      uint64_t *index_ret,
+				      uint64_t *entry_ret)
+{
+	struct drgn_error *err;
+
+	if (it->root_entry) {
+		*index_ret = 0;
+		*entry_ret = it->root_entry;
+		it->root_entry = 0;
+		return NULL;
+	}
+	while (it->stack.size) {
+		struct linux_helper_radix_tree_frame *frame =
+			&it->stack.data[it->stack.size - 1];
+		if (!frame->bitmap) {
+			linux_helper_radix_tree_frame_vector_pop(&it->stack);
+			continue;
+		}
+		unsigned int i = ctz(frame->bitmap);
+		frame->bitmap &= frame->bitmap - 1;
+		uint64_t entry = frame->slots[i];
+		uint64_t index = frame->index + ((uint64_t)i << frame->shift);
+		if ((entry & 3) == it->internal_node) {
+			if (linux_helper_radix_tree_is_node(it, frame->node,
+							    entry)) {
+				err = linux_helper_radix_tree_push(it,
+								   entry & ~it->internal_node,
+								   index,
+								   frame->shift);
+				if (err)
+					return err;
+			}
+			continue;
+		}
+		*index_ret = index;
+		*entry_ret = entry;
+		return NULL;
+	}
+	return &drgn_stop;
+}
+
+static struct drgn_error *
+linux_helper_pid_hash_iterator_init(struct linux_helper_pid_iterator *it,
+				    const struct drgn_object *ns,
+				    struct drgn_type *pid_type)
+{
+	struct drgn_error *err;
+	struct drgn_object tmp;
+
+	drgn_object_init(&tmp, it->prog);
+
+	err = drgn_object_read_unsigned(ns, &it->pid_hash.ns);
+	if (err)
+		goto out;
+	err = drgn_object_member_dereference(&tmp, ns, "level");
+	if (err)
+		goto out;
+	union drgn_value level;
+	err = drgn_object_read_integer(&tmp, &level);
+	if (err)
+		goto out;
+	char member[64];
+	sprintf(member, "numbers[%" PRIu64 "]", level.uvalue);
+	err = drgn_type_offsetof(pid_type, member,
+				 &it->pid_hash.numbers_offset);
+	if (err)
+		goto out;
+
+	struct drgn_qualified_type upid_type;
+	err = drgn_program_find_type(it->prog, "struct upid", NULL,
+				     &upid_type);
+	if (err)
+		goto out;
+	err = linux_helper_node_member(drgn_underlying_type(upid_type.type),
+				       "pid_chain",
+				       &it->pid_hash.pid_chain_offset, NULL);
+	if (err)
+		goto out;
+	err = linux_helper_node_member(drgn_underlying_type(upid_type.type),
+				       "ns", &it->pid_hash.upid_ns_offset,
+				       NULL);
+	if (err)
+		goto out;
+
+	err = drgn_program_find_object(it->prog, "pid_hash", NULL,
+				       DRGN_FIND_OBJECT_ANY, &tmp);
+	if (err)
+		goto out;
+	err = drgn_object_read_unsigned(&tmp, &it->pid_hash.pid_hash);
+	if (err)
+		goto out;
+	err = drgn_program_find_object(it->prog, "pidhash_shift", NULL,
+				       DRGN_FIND_OBJECT_ANY, &tmp);
+	if (err)
+		goto out;
+	union drgn_value pidhash_shift;
+	err = drgn_object_read_integer(&tmp, &pidhash_shift);
+	if (err)
+		goto out;
+	if (pidhash_shift.uvalue >= 64)
+		it->pid_hash.num_buckets = 0;
+	else
+		it->pid_hash.num_buckets = UINT64_C(1) << pidhash_shift.uvalue;
+	it->pid_hash.bucket = 0;
+	it->pid_hash.chunk_pos = it->pid_hash.chunk_size = 0;
+	it->pid_hash.node = 0;
+out:
+	drgn_object_deinit(&tmp);
+	return err;
+}
+
+struct drgn_error *
+linux_helper_pid_iterator_init(struct linux_helper_pid_iterator *it,
+			       const struct drgn_object *ns, bool tasks)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(ns);
+	struct drgn_object tmp;
+
+	drgn_object_init(&tmp, prog);
+	it->prog = prog;
+	it->tasks = tasks;
+
+	struct drgn_qualified_type pid_type;
+	err = drgn_program_find_type(prog, "struct pid", NULL, &pid_type);
+	if (err)
+		goto out;
+	if (tasks) {
+		err = drgn_program_find_object(prog, "PIDTYPE_PID", NULL,
+					       DRGN_FIND_OBJECT_CONSTANT, &tmp);
+		if (err)
+			goto out;
+		union drgn_value pid_type_value;
+		err = drgn_object_read_integer(&tmp, &pid_type_value);
+		if (err)
+			goto out;
+		char member[64];
+		sprintf(member, "tasks[%" PRIu64 "].first",
+			pid_type_value.uvalue);
+		err = drgn_type_offsetof(pid_type.type, member,
+					 &it->tasks_offset);
+		if (err)
+			goto out;
+
+		struct drgn_qualified_type task_struct_type;
+		err = drgn_program_find_type(prog, "struct task_struct", NULL,
+					     &task_struct_type);
+		if (err)
+			goto out;
+		sprintf(member, "pid_links[%" PRIu64 "]", pid_type_value.uvalue);
+		err = drgn_type_offsetof(task_struct_type.type, member,
+					 &it->pid_links_offset);
+		if (err && err->code == DRGN_ERROR_LOOKUP) {
+			drgn_error_destroy(err);
+			sprintf(member, "pids[%" PRIu64 "].node",
+				pid_type_value.uvalue);
+			err = drgn_type_offsetof(task_struct_type.type, member,
+						 &it->pid_links_offset);
+		}
+		if (err)
+			goto out;
+		err = drgn_program_find_type(prog, "struct task_struct *",
+					     NULL, &it->entry_type);
+	} else {
+		err = drgn_program_find_type(prog, "struct pid *", NULL,
+					     &it->entry_type);
+	}
+	if (err)
+		goto out;
+
+	/* Set up the namespace walk last so that nothing needs cleanup. */
+	err = drgn_object_member_dereference(&tmp, ns, "idr");
+	if (!err) {
+		it->idr = true;
+		err = drgn_object_member(&tmp, &tmp, "idr_rt");
+		if (err)
+			goto out;
+		err = drgn_object_address_of(&tmp, &tmp);
+		if (err)
+			goto out;
+		err = linux_helper_radix_tree_iterator_init(&it->radix_tree,
+							    &tmp);
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		it->idr = false;
+		err = linux_helper_pid_hash_iterator_init(it, ns,
+							  pid_type.type);
+	}
+out:
+	drgn_object_deinit(&tmp);
+	return err;
+}
+
+void linux_helper_pid_iterator_deinit(struct linux_helper_pid_iterator *it)
+{
+	if (it->idr)
+		linux_helper_radix_tree_iterator_deinit(&it->radix_tree);
+}
+
+static struct drgn_error *
+linux_helper_pid_hash_read_chunk(struct linux_helper_pid_iterator *it)
+{
+	struct drgn_error *err;
+
+	bool bswap;
+	err = drgn_program_bswap(it->prog, &bswap);
+	if (err)
+		return err;
+	uint8_t word_size;
+	err = drgn_program_word_size(it->prog, &word_size);
+	if (err)
+		return err;
+
+	/* struct hlist_head is a single pointer. */
+	unsigned int n = min(it->pid_hash.num_buckets - it->pid_hash.bucket,
+			     (uint64_t)ARRAY_SIZE(it->pid_hash.chunk));
+	char buf[sizeof(it->pid_hash.chunk)];
+	err = drgn_memory_reader_read(&it->prog->reader, buf,
+				      it->pid_hash.pid_hash +
+				      it->pid_hash.bucket * word_size,
+				      n * word_size, false);
+	if (err)
+		return err;
+	for (unsigned int i = 0; i < n; i++) {
+		if (word_size == 8) {
+			uint64_t word;
+			memcpy(&word, &buf[8 * i], sizeof(word));
+			it->pid_hash.chunk[i] = bswap ? bswap_64(word) : word;
+		} else {
+			uint32_t word;
+			memcpy(&word, &buf[4 * i], sizeof(word));
+			it->pid_hash.chunk[i] = bswap ? bswap_32(word) : word;
+		}
+	}
+	it->pid_hash.bucket += n;
+	it->pid_hash.chunk_pos = 0;
+	it->pid_hash.chunk_size = n;
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_pid_hash_iterator_next(struct linux_helper_pid_iterator *it,
+				    uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	for (;;) {
+		while (!it->pid_hash.node) {
+			if (it->pid_hash.chunk_pos >= it->pid_hash.chunk_size) {
+				if (it->pid_hash.bucket >=
+				    it->pid_hash.num_buckets)
+					return &drgn_stop;
+				err = linux_helper_pid_hash_read_chunk(it);
+				if (err)
+					return err;
+			}
+			it->pid_hash.node =
+				it->pid_hash.chunk[it->pid_hash.chunk_pos++];
+			it->pid_hash.saved_node = UINT64_MAX;
+			it->pid_hash.power = it->pid_hash.lambda = 1;
+		}
+
+		/*
+		 * Like linux_helper_list_iterator_next(), use Brent's algorithm
+		 * so that a corrupted chain can't make us loop forever.
+		 */
+		if (it->pid_hash.node == it->pid_hash.saved_node) {
+			return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+						 "pid_hash chain contains a cycle at 0x%" PRIx64,
+						 it->pid_hash.node);
+		}
+		if (it->pid_hash.lambda == it->pid_hash.power) {
+			it->pid_hash.saved_node = it->pid_hash.node;
+			it->pid_hash.power *= 2;
+			it->pid_hash.lambda = 0;
+		}
+		it->pid_hash.lambda++;
+
+		uint64_t upid = it->pid_hash.node - it->pid_hash.pid_chain_offset;
+		uint64_t upid_ns;
+		err = drgn_program_read_word(it->prog,
+					     upid + it->pid_hash.upid_ns_offset,
+					     false, &upid_ns);
+		if (err)
+			return err;
+		/* next is the first member of struct hlist_node. */
+		err = drgn_program_read_word(it->prog, it->pid_hash.node,
+					     false, &it->pid_hash.node);
+		if (err)
+			return err;
+		if (upid_ns == it->pid_hash.ns) {
+			*ret = upid - it->pid_hash.numbers_offset;
+			return NULL;
+		}
+	}
+}
+
+struct drgn_error *
+linux_helper_pid_iterator_next(struct linux_helper_pid_iterator *it,
+			       uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	for (;;) {
+		uint64_t pid;
+		if (it->idr) {
+			uint64_t index;
+			err = linux_helper_radix_tree_iterator_next(&it->radix_tree,
+								    &index,
+								    &pid);
+		} else {
+			err = linux_helper_pid_hash_iterator_next(it, &pid);
+		}
+		if (err)
+			return err;
+		if (!it->tasks) {
+			*ret = pid;
+			return NULL;
+		}
+		/* pid_task(pid, PIDTYPE_PID) */
+		uint64_t first;
+		err = drgn_program_read_word(it->prog, pid + it->tasks_offset,
+					     false, &first);
+		if (err)
+			return err;
+		if (first) {
+			*ret = first - it->pid_links_offset;
+			return NULL;
+		}
+	}
+}
+
+/* Set if a memory section has a memory map. */
+#define SECTION_HAS_MEM_MAP (UINT64_C(1) << 1)
+
+/* Read at most this many bytes of the memory map at once. */
+#define PAGE_SCANNER_CHUNK_SIZE (1024 * 1024)
+
+/* Get the offset of a member of struct page, or UINT64_MAX if it is missing. */
+static struct drgn_error *page_member_offset(struct drgn_type *page_type,
+					     const char *name, uint64_t *ret)
+{
+	struct drgn_error *err;
+	err = drgn_type_offsetof(page_type, name, ret);
+	if (err && err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		*ret = UINT64_MAX;
+		return NULL;
+	}
+	return err;
+}
+
+static struct drgn_error *
+linux_helper_page_scanner_init_mem_section(struct linux_helper_page_scanner *it)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = it->prog;
+
+	uint64_t page_shift = ctz(prog->vmcoreinfo.page_size);
+	if (prog->vmcoreinfo.section_size_bits <= page_shift ||
+	    prog->vmcoreinfo.section_size_bits >= 64)
+		return NULL;
+
+	struct drgn_object tmp;
+	drgn_object_init(&tmp, prog);
+	err = drgn_program_find_object(prog, "mem_section", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (err) {
+		/* Without CONFIG_SPARSEMEM, there are no sections. */
+		if (err->code == DRGN_ERROR_LOOKUP) {
+			drgn_error_destroy(err);
+			err = NULL;
+		}
+		goto out;
+	}
+
+	struct drgn_qualified_type mem_section_type;
+	err = drgn_program_find_type(prog, "struct mem_section", NULL,
+				     &mem_section_type);
+	if (err)
+		goto out;
+	err = drgn_type_sizeof(mem_section_type.type, &it->mem_section_size);
+	if (err)
+		goto out;
+	err = drgn_type_offsetof(mem_section_type.type, "section_mem_map",
+				 &it->section_mem_map_offset);
+	if (err)
+		goto out;
+
+	/*
+	 * mem_section is a struct mem_section ** or struct mem_section
+	 * *[NR_SECTION_ROOTS] with CONFIG_SPARSEMEM_EXTREME and a struct
+	 * mem_section [NR_SECTION_ROOTS][1] without it.
+	 */
+	struct drgn_type *type = drgn_underlying_type(tmp.type);
+	struct drgn_type *element_type =
+		drgn_underlying_type(drgn_type_type(type).type);
+	if (drgn_type_kind(type) == DRGN_TYPE_POINTER) {
+		err = drgn_object_read_unsigned(&tmp, &it->mem_section);
+		if (err)
+			goto out;
+		it->mem_section_extreme = true;
+	} else if (drgn_type_kind(type) == DRGN_TYPE_ARRAY) {
+		err = drgn_object_address_of(&tmp, &tmp);
+		if (err)
+			goto out;
+		err = drgn_object_read_unsigned(&tmp, &it->mem_section);
+		if (err)
+			goto out;
+		it->mem_section_extreme =
+			drgn_type_kind(element_type) == DRGN_TYPE_POINTER;
+	} else {
+		err = drgn_qualified_type_error("mem_section has unexpected type '%s'",
+						drgn_object_qualified_type(&tmp));
+		goto out;
+	}
+	if (it->mem_section_extreme) {
+		it->sections_per_root = (prog->vmcoreinfo.page_size /
+					 it->mem_section_size);
+	} else if (drgn_type_kind(element_type) == DRGN_TYPE_ARRAY) {
+		it->sections_per_root = drgn_type_length(element_type);
+	} else {
+		it->sections_per_root = 1;
+	}
+	if (it->mem_section && it->sections_per_root) {
+		it->pfn_section_shift = (prog->vmcoreinfo.section_size_bits -
+					 page_shift);
+	}
+out:
+	drgn_object_deinit(&tmp);
+	return err;
+}
+
+struct drgn_error *
+linux_helper_page_scanner_init(struct linux_helper_page_scanner *it,
+			       struct drgn_program *prog, uint64_t start_pfn,
+			       uint64_t end_pfn)
+{
+	struct drgn_error *err;
+	struct drgn_object tmp;
+
+	drgn_object_init(&tmp, prog);
+	it->prog = prog;
+	it->pfn_section_shift = 0;
+	err = drgn_program_bswap(prog, &it->bswap);
+	if (err)
+		goto out;
+	err = drgn_program_word_size(prog, &it->word_size);
+	if (err)
+		goto out;
+
+	err = drgn_program_find_object(prog, "vmemmap", NULL,
+				       DRGN_FIND_OBJECT_ANY, &tmp);
+	if (err)
+		goto out;
+	err = drgn_object_read_unsigned(&tmp, &it->vmemmap);
+	if (err)
+		goto out;
+	if (end_pfn == UINT64_MAX) {
+		err = drgn_program_find_object(prog, "max_pfn", NULL,
+					       DRGN_FIND_OBJECT_ANY, &tmp);
+		if (err)
+			goto out;
+		err = drgn_object_read_unsigned(&tmp, &end_pfn);
+		if (err)
+			goto out;
+	}
+	it->pfn = start_pfn;
+	it->end_pfn = end_pfn;
+
+	struct drgn_qualified_type page_type;
+	err = drgn_program_find_type(prog, "struct page", NULL, &page_type);
+	if (err)
+		goto out;
+	err = drgn_type_sizeof(page_type.type, &it->page_struct_size);
+	if (err)
+		goto out;
+	if (!it->page_struct_size) {
+		err = drgn_error_create(DRGN_ERROR_TYPE,
+					"struct page has size 0");
+		goto out;
+	}
+	err = page_member_offset(page_type.type, "flags", &it->flags_offset);
+	if (err)
+		goto out;
+	err = page_member_offset(page_type.type, "mapping",
+				 &it->mapping_offset);
+	if (err)
+		goto out;
+	/* compound_head was added in Linux v4.6. */
+	err = page_member_offset(page_type.type, "compound_head",
+				 &it->compound_head_offset);
+	if (err)
+		goto out;
+
+	/* Only the bits below __NR_PAGEFLAGS are page flags. */
+	it->flags_mask = UINT64_MAX;
+	struct drgn_qualified_type pageflags_type;
+	err = drgn_program_find_type(prog, "enum pageflags", NULL,
+				     &pageflags_type);
+	if (!err) {
+		struct drgn_type *type =
+			drgn_underlying_type(pageflags_type.type);
+		struct drgn_type_enumerator *enumerators =
+			drgn_type_enumerators(type);
+		size_t num_enumerators = drgn_type_num_enumerators(type);
+		for (size_t i = 0; i < num_enumerators; i++) {
+			if (strcmp(enumerators[i].name, "__NR_PAGEFLAGS") == 0 &&
+			    enumerators[i].uvalue < 64) {
+				it->flags_mask = ((UINT64_C(1) <<
+						   enumerators[i].uvalue) - 1);
+				break;
+			}
+		}
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		err = NULL;
+	} else {
+		goto out;
+	}
+
+	if (prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL) {
+		err = linux_helper_page_scanner_init_mem_section(it);
+		if (err)
+			goto out;
+	}
+
+	it->max_chunk_count = max(PAGE_SCANNER_CHUNK_SIZE / it->page_struct_size,
+				  (uint64_t)1);
+	it->chunk_pfn = start_pfn;
+	it->chunk_count = 0;
+	it->buf = malloc(it->max_chunk_count * it->page_struct_size);
+	it->valid = malloc_array((it->max_chunk_count + 63) / 64,
+				 sizeof(it->valid[0]));
+	if (!it->buf || !it->valid) {
+		free(it->valid);
+		free(it->buf);
+		err = &drgn_enomem;
+		goto out;
+	}
+out:
+	drgn_object_deinit(&tmp);
+	return err;
+}
+
+void linux_helper_page_scanner_deinit(struct linux_helper_page_scanner *it)
+{
+	free(it->valid);
+	free(it->buf);
+}
+
+/* Return whether a memory section has a memory map. */
+static struct drgn_error *
+linux_helper_page_scanner_section_present(struct linux_helper_page_scanner *it,
+					  uint64_t section_nr, bool *ret)
+{
+	struct drgn_error *err;
+	uint64_t ms;
+	if (it->mem_section_extreme) {
+		uint64_t root;
+		err = drgn_program_read_word(it->prog,
+					     it->mem_section +
+					     (section_nr / it->sections_per_root) *
+					     it->word_size,
+					     false, &root);
+		if (err)
+			return err;
+		if (!root) {
+			*ret = false;
+			return NULL;
+		}
+		ms = root + ((section_nr % it->sections_per_root) *
+			     it->mem_section_size);
+	} else {
+		ms = it->mem_section + section_nr * it->mem_section_size;
+	}
+	uint64_t section_mem_map;
+	err = drgn_program_read_word(it->prog,
+				     ms + it->section_mem_map_offset, false,
+				     &section_mem_map);
+	if (err)
+		return err;
+	*ret = section_mem_map & SECTION_HAS_MEM_MAP;
+	return NULL;
+}
+
+/*
+ * Read count page structures starting at index i of the current chunk. If the
+ * read faults, split it in half so that the readable parts are still read.
+ */
+static struct drgn_error *
+linux_helper_page_scanner_read(struct linux_helper_page_scanner *it,
+			       uint64_t i, uint64_t count)
+{
+	struct drgn_error *err;
+	err = drgn_memory_reader_read(&it->prog->reader,
+				      &it->buf[i * it->page_struct_size],
+				      it->vmemmap +
+				      (it->chunk_pfn + i) * it->page_struct_size,
+				      count * it->page_struct_size, false);
+	if (!err) {
+		for (uint64_t j = i; j < i + count; j++)
+			it->valid[j / 64] |= UINT64_C(1) << (j % 64);
+		return NULL;
+	}
+	if (err->code != DRGN_ERROR_FAULT)
+		return err;
+	drgn_error_destroy(err);
+	if (count == 1)
+		return NULL;
+	err = linux_helper_page_scanner_read(it, i, count / 2);
+	if (err)
+		return err;
+	return linux_helper_page_scanner_read(it, i + count / 2,
+					      count - count / 2);
+}
+
+struct drgn_error *
+linux_helper_page_scanner_next_chunk(struct linux_helper_page_scanner *it)
+{
+	struct drgn_error *err;
+
+	while (it->pfn < it->end_pfn) {
+		uint64_t count = min(it->end_pfn - it->pfn,
+				     it->max_chunk_count);
+		if (it->pfn_section_shift) {
+			uint64_t section_nr = it->pfn >> it->pfn_section_shift;
+			uint64_t section_end =
+				(section_nr + 1) << it->pfn_section_shift;
+			bool present;
+			err = linux_helper_page_scanner_section_present(it,
+									section_nr,
+									&present);
+			if (err)
+				return err;
+			if (!present) {
+				it->pfn = section_end;
+				continue;
+			}
+			count = min(count, section_end - it->pfn);
+		}
+		it->chunk_pfn = it->pfn;
+		it->chunk_count = count;
+		memset(it->valid, 0, (count + 63) / 64 * sizeof(it->valid[0]));
+		err = linux_helper_page_scanner_read(it, 0, count);
+		if (err)
+			return err;
+		it->pfn += count;
+		return NULL;
+	}
+	return &drgn_stop;
+}
+
+static inline bool
+linux_helper_page_scanner_valid(struct linux_helper_page_scanner *it,
+				uint64_t i)
+{
+	return it->valid[i / 64] & (UINT64_C(1) << (i % 64));
+}
+
+/* Decode a word read from the program. */
+static inline uint64_t decode_word(const char *p, uint8_t word_size,
+				   bool bswap)
+{
+	if (word_size == 8) {
+		uint64_t word;
+		memcpy(&word, p, sizeof(word));
+		return bswap ? bswap_64(word) : word;
+	} else {
+		uint32_t word;
+		memcpy(&word, p, sizeof(word));
+		return bswap ? bswap_32(word) : word;
+	}
+}
+
+/* Decode a word of the page structure at index i of the current chunk. */
+static inline uint64_t
+linux_helper_page_scanner_word(struct linux_helper_page_scanner *it,
+			       uint64_t i, uint64_t offset)
+{
+	return decode_word(&it->buf[i * it->page_struct_size + offset],
+			   it->word_size, it->bswap);
+}
+
+/* Low bits of page->mapping (see PAGE_MAPPING_FLAGS). */
+#define PAGE_MAPPING_ANON 0x1
+#define PAGE_MAPPING_MOVABLE 0x2
+
+struct drgn_error *linux_helper_page_stats(struct drgn_program *prog,
+					   uint64_t start_pfn,
+					   uint64_t end_pfn,
+					   struct linux_helper_page_stats *ret)
+{
+	struct drgn_error *err;
+	struct linux_helper_page_scanner it;
+
+	err = linux_helper_page_scanner_init(&it, prog, start_pfn, end_pfn);
+	if (err)
+		return err;
+	if (it.flags_offset == UINT64_MAX) {
+		err = drgn_error_create(DRGN_ERROR_TYPE,
+					"struct page has no flags member");
+		goto out;
+	}
+	memset(ret, 0, sizeof(*ret));
+	while (!(err = linux_helper_page_scanner_next_chunk(&it))) {
+		for (uint64_t i = 0; i < it.chunk_count; i++) {
+			if (!linux_helper_page_scanner_valid(&it, i))
+				continue;
+			ret->pages++;
+			uint64_t flags = (linux_helper_page_scanner_word(&it, i,
+									 it.flags_offset) &
+					  it.flags_mask);
+			unsigned int bit;
+			for_each_bit(bit, flags)
+				ret->flags[bit]++;
+
+			if (it.compound_head_offset != UINT64_MAX &&
+			    (linux_helper_page_scanner_word(&it, i,
+							    it.compound_head_offset) & 1)) {
+				ret->mapping[5]++;
+				continue;
+			}
+			if (it.mapping_offset == UINT64_MAX)
+				continue;
+			uint64_t mapping =
+				linux_helper_page_scanner_word(&it, i,
+							       it.mapping_offset);
+			if (!mapping)
+				ret->mapping[0]++;
+			else
+				ret->mapping[1 + (mapping & (PAGE_MAPPING_ANON | PAGE_MAPPING_MOVABLE))]++;
+		}
+	}
+	if (err == &drgn_stop)
+		err = NULL;
+out:
+	linux_helper_page_scanner_deinit(&it);
+	return err;
+}
+
+struct drgn_error *
+linux_helper_page_iterator_init(struct linux_helper_page_iterator *it,
+				struct drgn_program *prog, uint64_t start_pfn,
+				uint64_t end_pfn, uint64_t flags_mask,
+				uint64_t flags_value)
+{
+	struct drgn_error *err;
+	err = drgn_program_find_type(prog, "struct page *", NULL,
+				     &it->entry_type);
+	if (err)
+		return err;
+	err = linux_helper_page_scanner_init(&it->scanner, prog, start_pfn,
+					     end_pfn);
+	if (err)
+		return err;
+	if (flags_mask && it->scanner.flags_offset == UINT64_MAX) {
+		linux_helper_page_scanner_deinit(&it->scanner);
+		return drgn_error_create(DRGN_ERROR_TYPE,
+					 "struct page has no flags member");
+	}
+	it->flags_mask = flags_mask;
+	it->flags_value = flags_value;
+	it->i = 0;
+	return NULL;
+}
+
+void linux_helper_page_iterator_deinit(struct linux_helper_page_iterator *it)
+{
+	linux_helper_page_scanner_deinit(&it->scanner);
+}
+
+struct drgn_error *
+linux_helper_page_iterator_next(struct linux_helper_page_iterator *it,
+				uint64_t *ret)
+{
+	struct drgn_error *err;
+	struct linux_helper_page_scanner *scanner = &it->scanner;
+
+	for (;;) {
+		while (it->i < scanner->chunk_count) {
+			uint64_t i = it->i++;
+			if (!linux_helper_page_scanner_valid(scanner, i))
+				continue;
+			if (it->flags_mask &&
+			    (linux_helper_page_scanner_word(scanner, i,
+							    scanner->flags_offset) &
+			     it->flags_mask) != it->flags_value)
+				continue;
+			*ret = (scanner->vmemmap +
+				(scanner->chunk_pfn + i) * scanner->page_struct_size);
+			return NULL;
+		}
+		err = linux_helper_page_scanner_next_chunk(scanner);
+		if (err)
+			return err;
+		it->i = 0;
+	}
+}
+
+struct drgn_error *linux_helper_per_cpu_offsets(struct drgn_program *prog,
+						const uint64_t **ret,
+						uint64_t *num_ret)
+{
+	struct drgn_error *err;
+
+	/*
+	 * The cache is filled under the types lock and published with a
+	 * release store after num_per_cpu_offsets, so the fast path only needs
+	 * an acquire load.
+	 */
+	const uint64_t *cached = __atomic_load_n(&prog->per_cpu_offsets,
+						 __ATOMIC_ACQUIRE);
+	if (cached) {
+		*ret = cached;
+		*num_ret = prog->num_per_cpu_offsets;
+		return NULL;
+	}
+
+	drgn_program_lock_types(prog);
+	if (prog->per_cpu_offsets) {
+		err = NULL;
+		goto out_cached;
+	}
+
+	struct drgn_object tmp;
+	drgn_object_init(&tmp, prog);
+	uint64_t *offsets = NULL;
+	char *buf = NULL;
+	uint64_t num;
+	err = drgn_program_find_object(prog, "__per_cpu_offset", NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (err) {
+		/* Without CONFIG_SMP, per-CPU variables are not relocated. */
+		if (err->code != DRGN_ERROR_LOOKUP)
+			goto out;
+		drgn_error_destroy(err);
+		err = NULL;
+		num = 1;
+		offsets = malloc(sizeof(offsets[0]));
+		if (!offsets) {
+			err = &drgn_enomem;
+			goto out;
+		}
+		offsets[0] = 0;
+		goto out;
+	}
+	struct drgn_type *type = drgn_underlying_type(tmp.type);
+	if (drgn_type_kind(type) != DRGN_TYPE_ARRAY ||
+	    !drgn_type_is_complete(type) || !drgn_type_length(type)) {
+		err = drgn_qualified_type_error("__per_cpu_offset has unexpected type '%s'",
+						drgn_object_qualified_type(&tmp));
+		goto out;
+	}
+	num = drgn_type_length(type);
+	uint8_t word_size;
+	err = drgn_program_word_size(prog, &word_size);
+	if (err)
+		goto out;
+	bool bswap;
+	err = drgn_program_bswap(prog, &bswap);
+	if (err)
+		goto out;
+	/* Read the whole array at once. */
+	buf = malloc_array(num, word_size);
+	offsets = malloc_array(num, sizeof(offsets[0]));
+	if (!buf || !offsets) {
+		err = &drgn_enomem;
+		goto out;
+	}
+	err = drgn_object_address_of(&tmp, &tmp);
+	if (err)
+		goto out;
+	uint64_t address;
+	err = drgn_object_read_unsigned(&tmp, &address);
+	if (err)
+		goto out;
+	err = drgn_memory_reader_read(&prog->reader, buf, address,
+				      num * word_size, false);
+	if (err)
+		goto out;
+	for (uint64_t i = 0; i < num; i++)
+		offsets[i] = decode_word(&buf[i * word_size], word_size, bswap);
+out:
+	free(buf);
+	drgn_object_deinit(&tmp);
+	if (err) {
+		free(offsets);
+		goto out_unlock;
+	}
+	prog->num_per_cpu_offsets = num;
+	__atomic_store_n(&prog->per_cpu_offsets, offsets, __ATOMIC_RELEASE);
+out_cached:
+	*ret = prog->per_cpu_offsets;
+	*num_ret = prog->num_per_cpu_offsets;
+out_unlock:
+	drgn_program_unlock_types(prog);
+	return err;
+}
+
+/*
+ * Get the numbers and per-CPU offsets of the possible or online CPUs. Either
+ * array may be NULL if it isn't needed. The returned arrays must be freed with
+ * free().
+ */
+static struct drgn_error *linux_helper_cpus(struct drgn_program *prog,
+					    bool online, uint64_t **cpus_ret,
+					    uint64_t **offsets_ret,
+					    size_t *num_ret)
+{
+	struct drgn_error *err;
+	const uint64_t *per_cpu_offsets;
+	uint64_t nr_cpus;
+	err = linux_helper_per_cpu_offsets(prog, &per_cpu_offsets, &nr_cpus);
+	if (err)
+		return err;
+	uint8_t word_size;
+	err = drgn_program_word_size(prog, &word_size);
+	if (err)
+		return err;
+	bool bswap;
+	err = drgn_program_bswap(prog, &bswap);
+	if (err)
+		return err;
+
+	struct drgn_object tmp;
+	drgn_object_init(&tmp, prog);
+	uint64_t *cpus = NULL, *offsets = NULL;
+	char *buf = NULL;
+	const char *name = online ? "__cpu_online_mask" : "__cpu_possible_mask";
+	err = drgn_program_find_object(prog, name, NULL,
+				       DRGN_FIND_OBJECT_VARIABLE, &tmp);
+	if (!err) {
+		err = drgn_object_address_of(&tmp, &tmp);
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		/*
+		 * Before Linux kernel commit c4c54dd1caf1 ("kernel/cpu.c:
+		 * change type of cpu_possible_bits and friends") (in v4.5),
+		 * the masks are struct cpumask *cpu_foo_mask instead of
+		 * struct cpumask __cpu_foo_mask.
+		 */
+		drgn_error_destroy(err);
+		err = drgn_program_find_object(prog, name + 2, NULL,
+					       DRGN_FIND_OBJECT_VARIABLE,
+					       &tmp);
+	}
+	if (err)
+		goto out;
+	uint64_t mask;
+	err = drgn_object_read_unsigned(&tmp, &mask);
+	if (err)
+		goto out;
+
+	uint64_t word_bits = 8 * word_size;
+	uint64_t num_words = (nr_cpus + word_bits - 1) / word_bits;
+	buf = malloc_array(num_words, word_size);
+	if (cpus_ret)
+		cpus = malloc_array(nr_cpus, sizeof(cpus[0]));
+	if (offsets_ret)
+		offsets = malloc_array(nr_cpus, sizeof(offsets[0]));
+	if (!buf || (cpus_ret && !cpus) || (offsets_ret && !offsets)) {
+		err = &drgn_enomem;
+		goto out;
+	}
+	err = drgn_memory_reader_read(&prog->reader, buf, mask,
+				      num_words * word_size, false);
+	if (err)
+		goto out;
+	size_t num = 0;
+	for (uint64_t i = 0; i < num_words; i++) {
+		uint64_t word = decode_word(&buf[i * word_size], word_size,
+					    bswap);
+		unsigned int bit;
+		for_each_bit(bit, word) {
+			uint64_t cpu = i * word_bits + bit;
+			if (cpu >= nr_cpus)
+				break;
+			if (cpus)
+				cpus[num] = cpu;
+			if (offsets)
+				offsets[num] = per_cpu_offsets[cpu];
+			num++;
+		}
+	}
+	if (cpus_ret)
+		*cpus_ret = cpus;
+	if (offsets_ret)
+		*offsets_ret = offsets;
+	*num_ret = num;
+	cpus = offsets = NULL;
+out:
+	free(offsets);
+	free(cpus);
+	free(buf);
+	drgn_object_deinit(&tmp);
+	return err;
+}
+
+struct drgn_error *linux_helper_per_cpu_ptr(struct drgn_object *res,
+					    const struct drgn_object *ptr,
+					    uint64_t cpu)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(ptr);
+
+	if (drgn_type_kind(drgn_underlying_type(ptr->type)) !=
+	    DRGN_TYPE_POINTER) {
+		return drgn_type_error("per_cpu_ptr() argument must be a pointer, not '%s'",
+				       ptr->type);
+	}
+	const uint64_t *per_cpu_offsets;
+	uint64_t nr_cpus;
+	err = linux_helper_per_cpu_offsets(prog, &per_cpu_offsets, &nr_cpus);
+	if (err)
+		return err;
+	if (cpu >= nr_cpus) {
+		return drgn_error_format(DRGN_ERROR_OUT_OF_BOUNDS,
+					 "CPU %" PRIu64 " is out of range",
+					 cpu);
+	}
+	uint64_t address;
+	err = drgn_object_read_unsigned(ptr, &address);
+	if (err)
+		return err;
+	return drgn_object_set_unsigned(res, drgn_object_qualified_type(ptr),
+					address + per_cpu_offsets[cpu], 0);
+}
+
+/* Apply a member designator like "a.b[1]" to an object. */
+static struct drgn_error *
+object_member_designator(struct drgn_object *obj, const char *designator)
+{
+	struct drgn_error *err;
+	const char *p = designator;
+	bool expect_member = true;
+	for (;;) {
+		if (*p == '[' && !expect_member) {
+			char *end;
+			errno = 0;
+			unsigned long long index = strtoull(p + 1, &end, 0);
+			if (end == p + 1 || *end != ']' || errno)
+				goto syntax_error;
+			err = drgn_object_subscript(obj, obj, index);
+			if (err)
+				return err;
+			p = end + 1;
+		} else {
+			size_t len = strcspn(p, ".[");
+			if (!len)
+				goto syntax_error;
+			char *name = strndup(p, len);
+			if (!name)
+				return &drgn_enomem;
+			err = drgn_object_member(obj, obj, name);
+			free(name);
+			if (err)
+				return err;
+			p += len;
+		}
+		if (!*p)
+			return NULL;
+		expect_member = *p == '.';
+		if (expect_member)
+			p++;
+		else if (*p != '[')
+			goto syntax_error;
+	}
+
+syntax_error:
+	return drgn_error_format(DRGN_ERROR_SYNTAX,
+				 "invalid member designator '%s'", designator);
+}
+
+struct drgn_error *
+linux_helper_per_cpu_read(const struct drgn_object *ptr, const char *member,
+			  bool online, struct linux_helper_per_cpu_values *ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(ptr);
+
+	struct drgn_type *type = drgn_underlying_type(ptr->type);
+	if (drgn_type_kind(type) != DRGN_TYPE_POINTER) {
+		return drgn_type_error("per-CPU pointer must be a pointer, not '%s'",
+				       ptr->type);
+	}
+	uint64_t address;
+	err = drgn_object_read_unsigned(ptr, &address);
+	if (err)
+		return err;
+
+	/*
+	 * Resolve the member on a reference to the copy at the per-CPU
+	 * pointer itself to get the type and offset to read.
+	 */
+	struct drgn_object obj;
+	drgn_object_init(&obj, prog);
+	ret->cpus = NULL;
+	ret->buf = NULL;
+	err = drgn_object_set_reference(&obj, drgn_type_type(type), address,
+					0, 0);
+	if (err)
+		goto out;
+	if (member) {
+		err = object_member_designator(&obj, member);
+		if (err)
+			goto out;
+	}
+	ret->qualified_type = drgn_object_qualified_type(&obj);
+	ret->bit_offset = obj.bit_offset;
+	ret->bit_field_size = obj.is_bit_field ? obj.bit_size : 0;
+	ret->size = drgn_value_size(obj.bit_offset + obj.bit_size);
+
+	uint64_t *offsets;
+	err = linux_helper_cpus(prog, online, &ret->cpus, &offsets,
+				&ret->num);
+	if (err)
+		goto out;
+	ret->buf = malloc_array(ret->num, ret->size);
+	if (!ret->buf && ret->num && ret->size) {
+		err = &drgn_enomem;
+		goto out_offsets;
+	}
+	for (size_t i = 0; i < ret->num; i++) {
+		err = drgn_memory_reader_read(&prog->reader,
+					      &ret->buf[i * ret->size],
+					      obj.address + offsets[i],
+					      ret->size, false);
+		if (err)
+			goto out_offsets;
+	}
+out_offsets:
+	free(offsets);
+out:
+	drgn_object_deinit(&obj);
+	if (err)
+		linux_helper_per_cpu_values_deinit(ret);
+	return err;
+}
+
+void
+linux_helper_per_cpu_values_deinit(struct linux_helper_per_cpu_values *values)
+{
+	free(values->buf);
+	free(values->cpus);
+}
+
+struct drgn_error *linux_helper_per_cpu_sum(const struct drgn_object *ptr,
+					    const char *member, bool online,
+					    bool *is_signed_ret, uint64_t *ret)
+{
+	struct drgn_error *err;
+	struct linux_helper_per_cpu_values values;
+	err = linux_helper_per_cpu_read(ptr, member, online, &values);
+	if (err)
+		return err;
+
+	struct drgn_object tmp;
+	drgn_object_init(&tmp, drgn_object_program(ptr));
+	uint64_t sum = 0;
+	for (size_t i = 0; i < values.num; i++) {
+		err = drgn_object_set_from_buffer(&tmp, values.qualified_type,
+						  &values.buf[i * values.size],
+						  values.size,
+						  values.bit_offset,
+						  values.bit_field_size);
+		if (err)
+			goto out;
+		if (tmp.encoding != DRGN_OBJECT_ENCODING_SIGNED &&
+		    tmp.encoding != DRGN_OBJECT_ENCODING_UNSIGNED) {
+			err = drgn_qualified_type_error("cannot sum '%s'",
+							values.qualified_type);
+			goto out;
+		}
+		union drgn_value value;
+		err = drgn_object_read_integer(&tmp, &value);
+		if (err)
+			goto out;
+		sum += value.uvalue;
+	}
+	*is_signed_ret = (values.num &&
+			  tmp.encoding == DRGN_OBJECT_ENCODING_SIGNED);
+	*ret = sum;
+out:
+	drgn_object_deinit(&tmp);
+	linux_helper_per_cpu_values_deinit(&values);
+	return err;
+}
+
+struct drgn_error *
+linux_helper_percpu_counter_sum(const struct drgn_object *fbc, int64_t *ret)
+{
+	struct drgn_error *err;
+	struct drgn_object tmp;
+	drgn_object_init(&tmp, drgn_object_program(fbc));
+
+	int64_t count;
+	err = drgn_object_member_dereference(&tmp, fbc, "count");
+	if (err)
+		goto out;
+	err = drgn_object_read_signed(&tmp, &count);
+	if (err)
+		goto out;
+	err = drgn_object_member_dereference(&tmp, fbc, "counters");
+	if (err)
+		goto out;
+	bool is_signed;
+	uint64_t sum;
+	err = linux_helper_per_cpu_sum(&tmp, NULL, true, &is_signed, &sum);
+	if (err)
+		goto out;
+	*ret = count + (int64_t)sum;
+out:
+	drgn_object_deinit(&tmp);
+	return err;
+}
+
+DEFINE_HASH_TABLE_FUNCTIONS(linux_helper_slab_cache_map, int_key_hash_pair,
+			    scalar_key_eq)
+
+/* Forget the caches which have been looked up. */
+static void
+linux_helper_slab_allocator_clear_caches(struct linux_helper_slab_allocator *sa)
+{
+	for (struct linux_helper_slab_cache_map_iterator it =
+	     linux_helper_slab_cache_map_first(&sa->caches);
+	     it.entry; it = linux_helper_slab_cache_map_next(it))
+		free(it.entry->value.cpu_slabs);
+	linux_helper_slab_cache_map_clear(&sa->caches);
+}
+
+void linux_helper_slab_allocator_deinit(struct linux_helper_slab_allocator *sa)
+{
+	free(sa->free);
+	free(sa->slab_buf);
+	free(sa->page_buf);
+	linux_helper_slab_allocator_clear_caches(sa);
+	linux_helper_slab_cache_map_deinit(&sa->caches);
+	free(sa->cpu_offsets);
+}
+
+static struct drgn_error *
+linux_helper_slab_allocator_init(struct linux_helper_slab_allocator *sa,
+				 struct drgn_program *prog)
+{
+	struct drgn_error *err;
+	struct drgn_object tmp;
+
+	drgn_object_init(&tmp, prog);
+	sa->prog = prog;
+	sa->cpu_offsets = NULL;
+	sa->num_cpus = 0;
+	linux_helper_slab_cache_map_init(&sa->caches);
+	sa->page_buf = NULL;
+	sa->slab_buf = NULL;
+	sa->slab_buf_capacity = 0;
+	sa->free = NULL;
+	sa->free_capacity = 0;
+
+	err = drgn_program_bswap(prog, &sa->bswap);
+	if (err)
+		goto out;
+	err = drgn_program_is_little_endian(prog, &sa->little_endian);
+	if (err)
+		goto out;
+	err = drgn_program_word_size(prog, &sa->word_size);
+	if (err)
+		goto out;
+
+	err = drgn_program_find_object(prog, "PAGE_OFFSET", NULL,
+				       DRGN_FIND_OBJECT_ANY, &tmp);
+	if (err)
+		goto out;
+	err = drgn_object_read_unsigned(&tmp, &sa->page_offset);
+	if (err)
+		goto out;
+	/* Assume 4 KiB pages without VMCOREINFO, like pfn_to_virt(). */
+	sa->page_shift = (prog->vmcoreinfo.page_size ?
+			  ctz(prog->vmcoreinfo.page_size) : 12);
+
+	uint64_t pg_slab;
+	err = drgn_program_find_object(prog, "PG_slab", NULL,
+				       DRGN_FIND_OBJECT_CONSTANT, &tmp);
+	if (err)
+		goto out;
+	err = drgn_object_read_unsigned(&tmp, &pg_slab);
+	if (err)
+		goto out;
+	if (pg_slab >= 64) {
+		err = drgn_error_format(DRGN_ERROR_OUT_OF_BOUNDS,
+					"PG_slab (%" PRIu64 ") is too large",
+					pg_slab);
+		goto out;
+	}
+	sa->pg_slab = UINT64_C(1) << pg_slab;
+
+	err = drgn_program_find_object(prog, "vmemmap", NULL,
+				       DRGN_FIND_OBJECT_ANY, &tmp);
+	if (err)
+		goto out;
+	err = drgn_object_read_unsigned(&tmp, &sa->vmemmap);
+	if (err)
+		goto out;
+
+	struct drgn_qualified_type page_type;
+	err = drgn_program_find_type(prog, "struct page", NULL, &page_type);
+	if (err)
+		goto out;
+	err = drgn_type_sizeof(page_type.type, &sa->page_struct_size);
+	if (err)
+		goto out;
+	if (!sa->page_struct_size) {
+		err = drgn_error_create(DRGN_ERROR_TYPE,
+					"struct page has size 0");
+		goto out;
+	}
+	err = page_member_offset(page_type.type, "flags",
+				 &sa->page_flags_offset);
+	if (err)
+		goto out;
+	if (sa->page_flags_offset == UINT64_MAX) {
+		err = drgn_error_create(DRGN_ERROR_TYPE,
+					"struct page has no flags member");
+		goto out;
+	}
+	err = page_member_offset(page_type.type, "compound_head",
+				 &sa->compound_head_offset);
+	if (err)
+		goto out;
+	err = drgn_type_offsetof(page_type.type, "slab_cache",
+				 &sa->slab_cache_offset);
+	if (err)
+		goto out;
+	err = drgn_type_offsetof(page_type.type, "freelist",
+				 &sa->freelist_offset);
+	if (err)
+		goto out;
+	struct drgn_type_member *member;
+	err = drgn_type_find_member(page_type.type, "objects", &member,
+				    &sa->objects_bit_offset);
+	if (err)
+		goto out;
+	struct drgn_qualified_type member_type;
+	err = drgn_member_type(member, &member_type, &sa->objects_bit_size);
+	if (err)
+		goto out;
+	if (!sa->objects_bit_size) {
+		err = drgn_type_sizeof(member_type.type, &sa->objects_bit_size);
+		if (err)
+			goto out;
+		sa->objects_bit_size *= 8;
+	}
+	if (!sa->objects_bit_size || sa->objects_bit_size > 64) {
+		err = drgn_error_create(DRGN_ERROR_TYPE,
+					"page->objects has unexpected size");
+		goto out;
+	}
+
+	err = drgn_program_find_type(prog, "struct kmem_cache", NULL,
+				     &sa->kmem_cache_type);
+	if (err)
+		goto out;
+	uint64_t cpu_slab_offset;
+	err = drgn_type_offsetof(sa->kmem_cache_type.type, "cpu_slab",
+				 &cpu_slab_offset);
+	if (err) {
+		if (err->code == DRGN_ERROR_LOOKUP) {
+			drgn_error_destroy(err);
+			err = drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+						"slab allocator is not SLUB");
+		}
+		goto out;
+	}
+	struct drgn_qualified_type kmem_cache_cpu_type;
+	err = drgn_program_find_type(prog, "struct kmem_cache_cpu", NULL,
+				     &kmem_cache_cpu_type);
+	if (err)
+		goto out;
+	err = drgn_type_offsetof(kmem_cache_cpu_type.type, "freelist",
+				 &sa->cpu_freelist_offset);
+	if (err)
+		goto out;
+	err = drgn_type_offsetof(kmem_cache_cpu_type.type, "page",
+				 &sa->cpu_page_offset);
+	if (err)
+		goto out;
+
+	err = linux_helper_cpus(prog, false, NULL, &sa->cpu_offsets,
+				&sa->num_cpus);
+	if (err)
+		goto out;
+	sa->page_buf = malloc(sa->page_struct_size);
+	if (!sa->page_buf)
+		err = &drgn_enomem;
+out:
+	drgn_object_deinit(&tmp);
+	if (err)
+		linux_helper_slab_allocator_deinit(sa);
+	return err;
+}
+
+static struct drgn_error *slab_cache_member(const struct drgn_object *obj,
+					    struct drgn_object *tmp,
+					    const char *name, uint64_t *ret)
+{
+	struct drgn_error *err = drgn_object_member(tmp, obj, name);
+	if (err)
+		return err;
+	return drgn_object_read_unsigned(tmp, ret);
+}
+
+/*
+ * Get the layout of a cache. This is read the first time that the cache is
+ * used. The returned pointer is only valid until the next call.
+ */
+static struct drgn_error *
+linux_helper_slab_allocator_cache(struct linux_helper_slab_allocator *sa,
+				  uint64_t address,
+				  struct linux_helper_slab_cache **ret)
+{
+	struct drgn_error *err;
+	struct hash_pair hp = linux_helper_slab_cache_map_hash(&address);
+	struct linux_helper_slab_cache_map_iterator it =
+		linux_helper_slab_cache_map_search_hashed(&sa->caches,
+							  &address, hp);
+	if (it.entry) {
+		*ret = &it.entry->value;
+		return NULL;
+	}
+
+	struct linux_helper_slab_cache_map_entry entry = { .key = address };
+	struct linux_helper_slab_cache *cache = &entry.value;
+	struct drgn_object obj, tmp;
+	drgn_object_init(&obj, sa->prog);
+	drgn_object_init(&tmp, sa->prog);
+	cache->cpu_slabs = NULL;
+	err = drgn_object_set_reference(&obj, sa->kmem_cache_type, address, 0,
+					0);
+	if (err)
+		goto out;
+	err = slab_cache_member(&obj, &tmp, "size", &cache->size);
+	if (err)
+		goto out;
+	err = slab_cache_member(&obj, &tmp, "offset", &cache->offset);
+	if (err)
+		goto out;
+	if (!cache->size || cache->offset + sa->word_size > cache->size) {
+		err = drgn_error_format(DRGN_ERROR_OTHER,
+					"slab cache 0x%" PRIx64 " has invalid size",
+					address);
+		goto out;
+	}
+	/* red_left_pad was added in Linux v4.6. */
+	err = slab_cache_member(&obj, &tmp, "red_left_pad",
+				&cache->red_left_pad);
+	if (err && err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		cache->red_left_pad = 0;
+	} else if (err) {
+		goto out;
+	}
+	err = slab_cache_member(&obj, &tmp, "random", &cache->random);
+	if (!err) {
+		cache->hardened = true;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		drgn_error_destroy(err);
+		cache->hardened = false;
+		cache->random = 0;
+	} else {
+		goto out;
+	}
+	cache->swab = -1;
+
+	err = slab_cache_member(&obj, &tmp, "cpu_slab", &cache->cpu_slab);
+	if (err)
+		goto out;
+	cache->cpu_slabs = malloc_array(max(sa->num_cpus, (size_t)1),
+					2 * sizeof(cache->cpu_slabs[0]));
+	if (!cache->cpu_slabs) {
+		err = &drgn_enomem;
+		goto out;
+	}
+	for (size_t i = 0; i < sa->num_cpus; i++) {
+		uint64_t c = cache->cpu_slab + sa->cpu_offsets[i];
+		err = drgn_program_read_word(sa->prog, c + sa->cpu_page_offset,
+					     false, &cache->cpu_slabs[2 * i]);
+		if (err)
+			goto out;
+		err = drgn_program_read_word(sa->prog,
+					     c + sa->cpu_freelist_offset,
+					     false,
+					     &cache->cpu_slabs[2 * i + 1]);
+		if (err)
+			goto out;
+	}
+
+	if (linux_helper_slab_cache_map_insert_searched(&sa->caches, &entry,
+							hp, &it) == -1) {
+		err = &drgn_enomem;
+		goto out;
+	}
+	*ret = &it.entry->value;
+out:
+	if (err)
+		free(cache->cpu_slabs);
+	drgn_object_deinit(&tmp);
+	drgn_object_deinit(&obj);
+	return err;
+}
+
+/* Get the index of the object starting at an address in a slab. */
+static bool slab_object_index(const struct linux_helper_slab_cache *cache,
+			      uint64_t start, uint64_t objects,
+			      uint64_t address, uint64_t *ret)
+{
+	if (address < start + cache->red_left_pad)
+		return false;
+	uint64_t offset = address - start - cache->red_left_pad;
+	if (offset % cache->size || offset / cache->size >= objects)
+		return false;
+	*ret = offset / cache->size;
+	return true;
+}
+
+/* Decode a free pointer stored at ptr_addr (see freelist_ptr() in SLUB). */
+static uint64_t
+linux_helper_slab_freelist_ptr(struct linux_helper_slab_allocator *sa,
+			       const struct linux_helper_slab_cache *cache,
+			       bool swab, uint64_t ptr, uint64_t ptr_addr)
+{
+	if (!cache->hardened)
+		return ptr;
+	if (swab) {
+		ptr_addr = (sa->word_size == 8 ?
+			    bswap_64(ptr_addr) : bswap_32(ptr_addr));
+	}
+	return ptr ^ cache->random ^ ptr_addr;
+}
+
+/*
+ * Mark the objects on a freelist of a slab as free. The slab is read into
+ * sa->slab_buf the first time that this is called for it.
+ */
+static struct drgn_error *
+linux_helper_slab_walk_freelist(struct linux_helper_slab_allocator *sa,
+				struct linux_helper_slab_cache *cache,
+				uint64_t start, uint64_t objects,
+				uint64_t head, bool *read)
+{
+	struct drgn_error *err;
+
+	if (!*read) {
+		uint64_t slab_size = cache->red_left_pad + objects * cache->size;
+		if (slab_size > sa->slab_buf_capacity) {
+			char *buf = realloc(sa->slab_buf, slab_size);
+			if (!buf)
+				return &drgn_enomem;
+			sa->slab_buf = buf;
+			sa->slab_buf_capacity = slab_size;
+		}
+		err = drgn_memory_reader_read(&sa->prog->reader, sa->slab_buf,
+					      start, slab_size, false);
+		if (err)
+			return err;
+		*read = true;
+	}
+
+	/*
+	 * Stop at a pointer which isn't to an object in this slab or to an
+	 * object which was already seen so that a corrupted freelist can't
+	 * loop forever.
+	 */
+	uint64_t address = head, i;
+	while (slab_object_index(cache, start, objects, address, &i) &&
+	       !(sa->free[i / 64] & (UINT64_C(1) << (i % 64)))) {
+		sa->free[i / 64] |= UINT64_C(1) << (i % 64);
+		uint64_t ptr_addr = address + cache->offset;
+		uint64_t ptr = decode_word(&sa->slab_buf[ptr_addr - start],
+					   sa->word_size, sa->bswap);
+		if (cache->hardened && cache->swab < 0) {
+			/*
+			 * Linux kernel commit 1ad53d9fa3f6 ("slub: improve bit
+			 * diffusion for freelist ptr obfuscation") (in v5.7)
+			 * started byte-swapping the address. Use whichever
+			 * decoding gives a valid pointer.
+			 */
+			uint64_t plain, swabbed, j;
+			plain = linux_helper_slab_freelist_ptr(sa, cache, false,
+							       ptr, ptr_addr);
+			swabbed = linux_helper_slab_freelist_ptr(sa, cache,
+								 true, ptr,
+								 ptr_addr);
+			bool plain_valid = (!plain ||
+					    slab_object_index(cache, start,
+							      objects, plain,
+							      &j));
+			bool swab_valid = (!swabbed ||
+					   slab_object_index(cache, start,
+							     objects, swabbed,
+							     &j));
+			if (plain_valid != swab_valid)
+				cache->swab = swab_valid;
+		}
+		address = linux_helper_slab_freelist_ptr(sa, cache,
+							 cache->swab > 0, ptr,
+							 ptr_addr);
+	}
+	return NULL;
+}
+
+/*
+ * Find the free objects in a slab, which are on the slab's freelist or, if the
+ * slab is active on a CPU, that CPU's lockless freelist. They are marked in
+ * sa->free.
+ */
+static struct drgn_error *
+linux_helper_slab_find_free(struct linux_helper_slab_allocator *sa,
+			    struct linux_helper_slab_cache *cache,
+			    uint64_t page, uint64_t start, uint64_t objects,
+			    uint64_t freelist)
+{
+	struct drgn_error *err;
+
+	size_t words = (objects + 63) / 64;
+	if (words > sa->free_capacity) {
+		uint64_t *bitmap = malloc_array(words, sizeof(*bitmap));
+		if (!bitmap)
+			return &drgn_enomem;
+		free(sa->free);
+		sa->free = bitmap;
+		sa->free_capacity = words;
+	}
+	memset(sa->free, 0, words * sizeof(sa->free[0]));
+
+	bool read = false;
+	if (freelist) {
+		err = linux_helper_slab_walk_freelist(sa, cache, start,
+						      objects, freelist, &read);
+		if (err)
+			return err;
+	}
+	for (size_t i = 0; i < sa->num_cpus; i++) {
+		if (cache->cpu_slabs[2 * i] != page ||
+		    !cache->cpu_slabs[2 * i + 1])
+			continue;
+		err = linux_helper_slab_walk_freelist(sa, cache, start,
+						      objects,
+						      cache->cpu_slabs[2 * i + 1],
+						      &read);
+		if (err)
+			return err;
+	}
+	return NULL;
+}
+
+static inline bool slab_object_free(struct linux_helper_slab_allocator *sa,
+				    uint64_t i)
+{
+	return sa->free[i / 64] & (UINT64_C(1) << (i % 64));
+}
+
+struct drgn_error *
+linux_helper_slab_object_iterator_init(struct linux_helper_slab_object_iterator *it,
+				       struct drgn_program *prog,
+				       uint64_t cache, bool allocated,
+				       bool free)
+{
+	struct drgn_error *err;
+	err = linux_helper_slab_allocator_init(&it->sa, prog);
+	if (err)
+		return err;
+	err = linux_helper_page_scanner_init(&it->scanner, prog, 0,
+					     UINT64_MAX);
+	if (err)
+		goto err_sa;
+	it->cache = cache;
+	it->allocated = allocated;
+	it->free = free;
+	it->i = 0;
+	it->slab_objects = 0;
+	it->j = 0;
+	return NULL;
+
+err_sa:
+	linux_helper_slab_allocator_deinit(&it->sa);
+	return err;
+}
+
+void
+linux_helper_slab_object_iterator_deinit(struct linux_helper_slab_object_iterator *it)
+{
+	linux_helper_page_scanner_deinit(&it->scanner);
+	linux_helper_slab_allocator_deinit(&it->sa);
+}
+
+/* Find the next slab to iterate over. */
+static struct drgn_error *
+linux_helper_slab_object_iterator_next_slab(struct linux_helper_slab_object_iterator *it)
+{
+	struct drgn_error *err;
+	struct linux_helper_slab_allocator *sa = &it->sa;
+	struct linux_helper_page_scanner *scanner = &it->scanner;
+
+	for (;;) {
+		while (it->i < scanner->chunk_count) {
+			uint64_t i = it->i++;
+			if (!linux_helper_page_scanner_valid(scanner, i) ||
+			    !(linux_helper_page_scanner_word(scanner, i,
+							     scanner->flags_offset) &
+			      sa->pg_slab))
+				continue;
+			if (scanner->compound_head_offset != UINT64_MAX &&
+			    (linux_helper_page_scanner_word(scanner, i,
+							    scanner->compound_head_offset) & 1))
+				continue;
+			uint64_t slab_cache =
+				linux_helper_page_scanner_word(scanner, i,
+							       sa->slab_cache_offset);
+			if (!slab_cache || (it->cache && slab_cache != it->cache))
+				continue;
+			uint64_t objects =
+				deserialize_bits(&scanner->buf[i * scanner->page_struct_size],
+						 sa->objects_bit_offset,
+						 sa->objects_bit_size,
+						 sa->little_endian);
+			if (!objects)
+				continue;
+
+			struct linux_helper_slab_cache *cache;
+			err = linux_helper_slab_allocator_cache(sa, slab_cache,
+								&cache);
+			if (err)
+				return err;
+			uint64_t pfn = scanner->chunk_pfn + i;
+			uint64_t start = sa->page_offset + (pfn << sa->page_shift);
+			err = linux_helper_slab_find_free(sa, cache,
+							  scanner->vmemmap +
+							  pfn * scanner->page_struct_size,
+							  start, objects,
+							  linux_helper_page_scanner_word(scanner,
+											 i,
+											 sa->freelist_offset));
+			if (err)
+				return err;
+			it->slab_cache = slab_cache;
+			it->object_start = start + cache->red_left_pad;
+			it->object_size = cache->size;
+			it->slab_objects = objects;
+			it->j = 0;
+			return NULL;
+		}
+		err = linux_helper_page_scanner_next_chunk(scanner);
+		if (err)
+			return err;
+		it->i = 0;
+	}
+}
+
+struct drgn_error *
+linux_helper_slab_object_iterator_next(struct linux_helper_slab_object_iterator *it,
+				       uint64_t *cache_ret,
+				       uint64_t *address_ret,
+				       bool *allocated_ret)
+{
+	struct drgn_error *err;
+
+	for (;;) {
+		while (it->j < it->slab_objects) {
+			uint64_t j = it->j++;
+			bool allocated = !slab_object_free(&it->sa, j);
+			if (allocated ? !it->allocated : !it->free)
+				continue;
+			*cache_ret = it->slab_cache;
+			*address_ret = it->object_start + j * it->object_size;
+			*allocated_ret = allocated;
+			return NULL;
+		}
+		err = linux_helper_slab_object_iterator_next_slab(it);
+		if (err)
+			return err;
+	}
+}
+
+/*
+ * Read the page structure for a page frame number into sa->page_buf. If it is
+ * not mapped (e.g., because the page doesn't exist), ret is set to false.
+ */
+static struct drgn_error *
+linux_helper_slab_read_page(struct linux_helper_slab_allocator *sa,
+			    uint64_t pfn, bool *ret)
+{
+	struct drgn_error *err;
+	err = drgn_memory_reader_read(&sa->prog->reader, sa->page_buf,
+				      sa->vmemmap + pfn * sa->page_struct_size,
+				      sa->page_struct_size, false);
+	if (err && err->code == DRGN_ERROR_FAULT) {
+		drgn_error_destroy(err);
+		*ret = false;
+		return NULL;
+	} else if (err) {
+		return err;
+	}
+	*ret = true;
+	return NULL;
+}
+
+static inline uint64_t
+linux_helper_slab_page_word(struct linux_helper_slab_allocator *sa,
+			    uint64_t offset)
+{
+	return decode_word(&sa->page_buf[offset], sa->word_size, sa->bswap);
+}
+
+/*
+ * Get the slab allocator state of a program, creating it on first use. The
+ * types lock must be held.
+ */
+static struct drgn_error *
+linux_helper_program_slab_allocator(struct drgn_program *prog,
+				    struct linux_helper_slab_allocator **ret)
+{
+	if (!prog->slab_allocator) {
+		struct linux_helper_slab_allocator *sa = malloc(sizeof(*sa));
+		if (!sa)
+			return &drgn_enomem;
+		struct drgn_error *err =
+			linux_helper_slab_allocator_init(sa, prog);
+		if (err) {
+			free(sa);
+			return err;
+		}
+		prog->slab_allocator = sa;
+	} else if (prog->flags & DRGN_PROGRAM_IS_LIVE) {
+		/*
+		 * The caches and their per-CPU slabs of a live kernel can
+		 * change between calls.
+		 */
+		linux_helper_slab_allocator_clear_caches(prog->slab_allocator);
+	}
+	*ret = prog->slab_allocator;
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_slab_object_info_locked(struct linux_helper_slab_allocator *sa,
+				     uint64_t address,
+				     struct linux_helper_slab_object_info *ret,
+				     bool *found_ret)
+{
+	struct drgn_error *err;
+
+	if (address < sa->page_offset)
+		return NULL;
+	uint64_t pfn = (address - sa->page_offset) >> sa->page_shift;
+	bool valid;
+	err = linux_helper_slab_read_page(sa, pfn, &valid);
+	if (err || !valid)
+		return err;
+	/* Objects in slabs of more than one page may be in a tail page. */
+	if (sa->compound_head_offset != UINT64_MAX) {
+		uint64_t head =
+			linux_helper_slab_page_word(sa,
+						    sa->compound_head_offset);
+		if (head & 1) {
+			head -= 1;
+			if (head < sa->vmemmap ||
+			    (head - sa->vmemmap) % sa->page_struct_size)
+				return NULL;
+			pfn = (head - sa->vmemmap) / sa->page_struct_size;
+			err = linux_helper_slab_read_page(sa, pfn, &valid);
+			if (err || !valid)
+				return err;
+		}
+	}
+	if (!(linux_helper_slab_page_word(sa, sa->page_flags_offset) &
+	      sa->pg_slab))
+		return NULL;
+	uint64_t slab_cache =
+		linux_helper_slab_page_word(sa, sa->slab_cache_offset);
+	uint64_t objects = deserialize_bits(sa->page_buf,
+					    sa->objects_bit_offset,
+					    sa->objects_bit_size,
+					    sa->little_endian);
+	uint64_t freelist = linux_helper_slab_page_word(sa,
+							sa->freelist_offset);
+	if (!slab_cache)
+		return NULL;
+
+	struct linux_helper_slab_cache *cache;
+	err = linux_helper_slab_allocator_cache(sa, slab_cache, &cache);
+	if (err)
+		return err;
+	uint64_t start = sa->page_offset + (pfn << sa->page_shift);
+	if (address < start + cache->red_left_pad)
+		return NULL;
+	uint64_t index = (address - start - cache->red_left_pad) / cache->size;
+	if (index >= objects)
+		return NULL;
+	uint64_t page = sa->vmemmap + pfn * sa->page_struct_size;
+	err = linux_helper_slab_find_free(sa, cache, page, start, objects,
+					  freelist);
+	if (err)
+		return err;
+	ret->cache = slab_cache;
+	ret->slab = page;
+	ret->address = start + cache->red_left_pad + index * cache->size;
+	ret->allocated = !slab_object_free(sa, index);
+	*found_ret = true;
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_slab_object_info(struct drgn_program *prog, uint64_t address,
+			      struct linux_helper_slab_object_info *ret,
+			      bool *found_ret)
+{
+	struct drgn_error *err;
+
+	*found_ret = false;
+	drgn_program_lock_types(prog);
+	struct linux_helper_slab_allocator *sa;
+	err = linux_helper_program_slab_allocator(prog, &sa);
+	if (!err) {
+		err = linux_helper_slab_object_info_locked(sa, address, ret,
+							   found_ret);
+	}
+	drgn_program_unlock_types(prog);
+	return err;
+}
+
+static struct hash_pair
+linux_helper_d_path_key_hash_pair(const struct linux_helper_d_path_key *key)
+{
+	return hash_pair_from_avalanching_hash(hash_combine(key->mnt,
+							    key->dentry));
+}
+
+static bool linux_helper_d_path_key_eq(const struct linux_helper_d_path_key *a,
+				       const struct linux_helper_d_path_key *b)
+{
+	return a->mnt == b->mnt && a->dentry == b->dentry;
+}
+
+DEFINE_HASH_TABLE_FUNCTIONS(linux_helper_mount_map, int_key_hash_pair,
+			    scalar_key_eq)
+DEFINE_HASH_TABLE_FUNCTIONS(linux_helper_d_path_map,
+			    linux_helper_d_path_key_hash_pair,
+			    linux_helper_d_path_key_eq)
+DEFINE_HASH_TABLE_FUNCTIONS(linux_helper_fstype_map, int_key_hash_pair,
+			    scalar_key_eq)
+DEFINE_VECTOR_FUNCTIONS(linux_helper_d_path_frame_vector)
+
+/* Give up on paths deeper than this, which are probably corrupted. */
+#define D_PATH_MAX_DEPTH 4096
+/* Longest dentry name that we accept. */
+#define D_PATH_MAX_NAME 4096
+
+/* Get the offset of a member and extend [*start, *end) to contain it. */
+static struct drgn_error *member_in_range(struct drgn_type *type,
+					  const char *member, uint64_t size,
+					  uint64_t *ret, uint64_t *start,
+					  uint64_t *end)
+{
+	struct drgn_error *err = drgn_type_offsetof(type, member, ret);
+	if (err)
+		return err;
+	*start = min(*start, *ret);
+	*end = max(*end, *ret + size);
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_d_path_cache_init(struct linux_helper_d_path_cache *cache,
+			       struct drgn_program *prog)
+{
+	struct drgn_error *err;
+
+	cache->prog = prog;
+	cache->shared = false;
+	err = drgn_program_bswap(prog, &cache->bswap);
+	if (err)
+		return err;
+	err = drgn_program_word_size(prog, &cache->word_size);
+	if (err)
+		return err;
+
+	struct drgn_qualified_type type;
+	err = drgn_program_find_type(prog, "struct mount", NULL, &type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(type.type, "mnt", &cache->mnt_offset);
+	if (err)
+		return err;
+	uint64_t start = UINT64_MAX, end = 0;
+	if ((err = member_in_range(type.type, "mnt_parent", cache->word_size,
+				   &cache->mnt_parent_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "mnt_mountpoint", cache->word_size,
+				   &cache->mnt_mountpoint_offset, &start,
+				   &end)) ||
+	    (err = member_in_range(type.type, "mnt.mnt_root", cache->word_size,
+				   &cache->mnt_root_offset, &start, &end)))
+		return err;
+	cache->mount_read_offset = start;
+	cache->mount_read_size = end - start;
+
+	err = drgn_program_find_type(prog, "struct dentry", NULL, &type);
+	if (err)
+		return err;
+	start = UINT64_MAX;
+	end = 0;
+	/* d_name.len is a u32. */
+	if ((err = member_in_range(type.type, "d_parent", cache->word_size,
+				   &cache->d_parent_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "d_name.name", cache->word_size,
+				   &cache->d_name_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "d_name.len", 4,
+				   &cache->d_len_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "d_op", cache->word_size,
+				   &cache->d_op_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "d_sb", cache->word_size,
+				   &cache->d_sb_offset, &start, &end)))
+		return err;
+	cache->dentry_read_offset = start;
+	cache->dentry_read_size = end - start;
+
+	err = drgn_program_find_type(prog, "struct dentry_operations", NULL,
+				     &type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(type.type, "d_dname", &cache->d_dname_offset);
+	if (err)
+		return err;
+	err = drgn_program_find_type(prog, "struct super_block", NULL, &type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(type.type, "s_type", &cache->s_type_offset);
+	if (err)
+		return err;
+	err = drgn_program_find_type(prog, "struct file_system_type", NULL,
+				     &type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(type.type, "name", &cache->fs_name_offset);
+	if (err)
+		return err;
+
+	cache->buf = malloc(max(cache->mount_read_size,
+				cache->dentry_read_size));
+	if (!cache->buf)
+		return &drgn_enomem;
+	linux_helper_mount_map_init(&cache->mounts);
+	linux_helper_d_path_map_init(&cache->paths);
+	linux_helper_fstype_map_init(&cache->fstypes);
+	linux_helper_d_path_frame_vector_init(&cache->frames);
+	cache->names = (struct string_builder){};
+	return NULL;
+}
+
+void linux_helper_d_path_cache_deinit(struct linux_helper_d_path_cache *cache)
+{
+	free(cache->names.str);
+	linux_helper_d_path_frame_vector_deinit(&cache->frames);
+	for (struct linux_helper_fstype_map_iterator it =
+	     linux_helper_fstype_map_first(&cache->fstypes);
+	     it.entry; it = linux_helper_fstype_map_next(it))
+		free((char *)it.entry->value.str);
+	linux_helper_fstype_map_deinit(&cache->fstypes);
+	for (struct linux_helper_d_path_map_iterator it =
+	     linux_helper_d_path_map_first(&cache->paths);
+	     it.entry; it = linux_helper_d_path_map_next(it))
+		free((char *)it.entry->value.str);
+	linux_helper_d_path_map_deinit(&cache->paths);
+	linux_helper_mount_map_deinit(&cache->mounts);
+	free(cache->buf);
+}
+
+struct drgn_error *
+linux_helper_program_d_path_cache(struct drgn_program *prog,
+				  struct linux_helper_d_path_cache **ret)
+{
+	struct drgn_error *err = NULL;
+	struct linux_helper_d_path_cache *cache =
+		__atomic_load_n(&prog->d_path_cache, __ATOMIC_ACQUIRE);
+	if (cache) {
+		*ret = cache;
+		return NULL;
+	}
+
+	drgn_program_lock_types(prog);
+	cache = prog->d_path_cache;
+	if (!cache) {
+		cache = malloc(sizeof(*cache));
+		if (!cache) {
+			err = &drgn_enomem;
+			goto out;
+		}
+		err = linux_helper_d_path_cache_init(cache, prog);
+		if (err) {
+			free(cache);
+			goto out;
+		}
+		cache->shared = true;
+		__atomic_store_n(&prog->d_path_cache, cache, __ATOMIC_RELEASE);
+	}
+	*ret = cache;
+out:
+	drgn_program_unlock_types(prog);
+	return err;
+}
+
+static struct drgn_error *
+linux_helper_d_path_mount(struct linux_helper_d_path_cache *cache,
+			  uint64_t mnt, struct linux_helper_mount_info *ret)
+{
+	struct hash_pair hp = linux_helper_mount_map_hash(&mnt);
+	struct linux_helper_mount_map_iterator it =
+		linux_helper_mount_map_search_hashed(&cache->mounts, &mnt, hp);
+	if (it.entry) {
+		*ret = it.entry->value;
+		return NULL;
+	}
+
+	struct drgn_error *err =
+		drgn_memory_reader_read(&cache->prog->reader, cache->buf,
+					mnt + cache->mount_read_offset,
+					cache->mount_read_size, false);
+	if (err)
+		return err;
+	const char *buf = cache->buf - cache->mount_read_offset;
+	struct linux_helper_mount_map_entry entry = {
+		.key = mnt,
+		.value = {
+			.parent = decode_word(buf + cache->mnt_parent_offset,
+					      cache->word_size, cache->bswap),
+			.mountpoint =
+				decode_word(buf + cache->mnt_mountpoint_offset,
+					    cache->word_size, cache->bswap),
+			.root = decode_word(buf + cache->mnt_root_offset,
+					    cache->word_size, cache->bswap),
+		},
+	};
+	if (linux_helper_mount_map_insert_searched(&cache->mounts, &entry, hp,
+						   NULL) == -1)
+		return &drgn_enomem;
+	*ret = entry.value;
+	return NULL;
+}
+
+/* Members of struct dentry used to build a path. */
+struct linux_helper_d_path_dentry {
+	uint64_t parent;
+	uint64_t name;
+	uint32_t len;
+	uint64_t op;
+	uint64_t sb;
+};
+
+static struct drgn_error *
+linux_helper_d_path_dentry(struct linux_helper_d_path_cache *cache,
+			   uint64_t dentry,
+			   struct linux_helper_d_path_dentry *ret)
+{
+	struct drgn_error *err =
+		drgn_memory_reader_read(&cache->prog->reader, cache->buf,
+					dentry + cache->dentry_read_offset,
+					cache->dentry_read_size, false);
+	if (err)
+		return err;
+	const char *buf = cache->buf - cache->dentry_read_offset;
+	ret->parent = decode_word(buf + cache->d_parent_offset,
+				  cache->word_size, cache->bswap);
+	ret->name = decode_word(buf + cache->d_name_offset, cache->word_size,
+				cache->bswap);
+	ret->len = decode_word(buf + cache->d_len_offset, 4, cache->bswap);
+	ret->op = decode_word(buf + cache->d_op_offset, cache->word_size,
+			      cache->bswap);
+	ret->sb = decode_word(buf + cache->d_sb_offset, cache->word_size,
+			      cache->bswap);
+	return NULL;
+}
+
+/* Get "[fstype]" for a super block. */
+static struct drgn_error *
+linux_helper_d_path_fstype(struct linux_helper_d_path_cache *cache,
+			   uint64_t sb, const char **ret, size_t *len_ret)
+{
+	struct drgn_error *err;
+
+	struct hash_pair hp = linux_helper_fstype_map_hash(&sb);
+	struct linux_helper_fstype_map_iterator it =
+		linux_helper_fstype_map_search_hashed(&cache->fstypes, &sb, hp);
+	if (!it.entry) {
+		uint64_t s_type, name;
+		err = drgn_program_read_word(cache->prog,
+					     sb + cache->s_type_offset, false,
+					     &s_type);
+		if (err)
+			return err;
+		err = drgn_program_read_word(cache->prog,
+					     s_type + cache->fs_name_offset,
+					     false, &name);
+		if (err)
+			return err;
+		char *fs_name;
+		err = drgn_program_read_c_string(cache->prog, name, false,
+						 SIZE_MAX, &fs_name);
+		if (err)
+			return err;
+		size_t len = strlen(fs_name);
+		char *str = malloc(len + 2);
+		if (!str) {
+			free(fs_name);
+			return &drgn_enomem;
+		}
+		str[0] = '[';
+		memcpy(str + 1, fs_name, len);
+		str[len + 1] = ']';
+		free(fs_name);
+		struct linux_helper_fstype_map_entry entry = {
+			.key = sb,
+			.value = { str, len + 2 },
+		};
+		if (linux_helper_fstype_map_insert_searched(&cache->fstypes,
+							    &entry, hp,
+							    &it) == -1) {
+			free(str);
+			return &drgn_enomem;
+		}
+	}
+	*ret = it.entry->value.str;
+	*len_ret = it.entry->value.len;
+	return NULL;
+}
+
+/*
+ * Walk up from a mount and dentry until reaching a cached path or the root,
+ * then remember the path of every mount and dentry on the way back down. If
+ * key.mnt is 0, mounts aren't crossed. dentry is the already read dentry of
+ * key.
+ */
+static struct drgn_error *
+linux_helper_d_path_build(struct linux_helper_d_path_cache *cache,
+			  struct linux_helper_d_path_key key,
+			  struct linux_helper_d_path_dentry *dentry,
+			  struct string *ret)
+{
+	struct drgn_error *err;
+
+	cache->frames.size = 0;
+	cache->names.len = 0;
+	struct string prefix = { "", 0 };
+	bool have_dentry = true;
+	for (;;) {
+		if (cache->frames.size > 0) {
+			struct linux_helper_d_path_map_iterator it =
+				linux_helper_d_path_map_search(&cache->paths,
+							       &key);
+			if (it.entry) {
+				prefix = it.entry->value;
+				break;
+			}
+		}
+		if (cache->frames.size >= D_PATH_MAX_DEPTH) {
+			return drgn_error_create(DRGN_ERROR_OTHER,
+						 "path is too deep");
+		}
+
+		struct linux_helper_mount_info mnt = {};
+		if (key.mnt) {
+			err = linux_helper_d_path_mount(cache, key.mnt, &mnt);
+			if (err)
+				return err;
+		}
+		struct linux_helper_d_path_frame *frame;
+		if (key.mnt && key.dentry == mnt.root) {
+			if (mnt.parent == key.mnt)
+				break;
+			frame = linux_helper_d_path_frame_vector_append_entry(&cache->frames);
+			if (!frame)
+				return &drgn_enomem;
+			frame->key = key;
+			frame->name_start = SIZE_MAX;
+			key.mnt = mnt.parent;
+			key.dentry = mnt.mountpoint;
+			have_dentry = false;
+			continue;
+		}
+
+		if (!have_dentry) {
+			err = linux_helper_d_path_dentry(cache, key.dentry,
+							 dentry);
+			if (err)
+				return err;
+		}
+		have_dentry = false;
+		if (dentry->parent == key.dentry)
+			break;
+		if (dentry->len > D_PATH_MAX_NAME) {
+			return drgn_error_format(DRGN_ERROR_OTHER,
+						 "dentry name at 0x%" PRIx64 " is too long",
+						 key.dentry);
+		}
+		if (!string_builder_reserve(&cache->names,
+					    cache->names.len + dentry->len))
+			return &drgn_enomem;
+		char *name = cache->names.str + cache->names.len;
+		err = drgn_memory_reader_read(&cache->prog->reader, name,
+					      dentry->name, dentry->len, false);
+		if (err)
+			return err;
+		frame = linux_helper_d_path_frame_vector_append_entry(&cache->frames);
+		if (!frame)
+			return &drgn_enomem;
+		frame->key = key;
+		frame->name_start = cache->names.len;
+		/* Like string_(), stop at a null byte. */
+		frame->name_len = strnlen(name, dentry->len);
+		cache->names.len += frame->name_len;
+		key.dentry = dentry->parent;
+	}
+
+	for (size_t i = cache->frames.size; i-- > 0;) {
+		struct linux_helper_d_path_frame *frame = &cache->frames.data[i];
+		size_t len = prefix.len;
+		if (frame->name_start != SIZE_MAX)
+			len += 1 + frame->name_len;
+		char *str = malloc(len + 1);
+		if (!str)
+			return &drgn_enomem;
+		memcpy(str, prefix.str, prefix.len);
+		if (frame->name_start != SIZE_MAX) {
+			str[prefix.len] = '/';
+			memcpy(str + prefix.len + 1,
+			       cache->names.str + frame->name_start,
+			       frame->name_len);
+		}
+		struct linux_helper_d_path_map_entry entry = {
+			.key = frame->key,
+			.value = { str, len },
+		};
+		struct linux_helper_d_path_map_iterator it;
+		int r = linux_helper_d_path_map_insert(&cache->paths, &entry,
+						       &it);
+		if (r <= 0)
+			free(str);
+		if (r < 0)
+			return &drgn_enomem;
+		/* If the same mount and dentry repeated, keep the first path. */
+		prefix = it.entry->value;
+	}
+	*ret = prefix;
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_d_path_unlocked(struct linux_helper_d_path_cache *cache,
+			     uint64_t vfsmnt, uint64_t dentry,
+			     const char **ret, size_t *len_ret)
+{
+	struct drgn_error *err;
+
+	struct linux_helper_d_path_key key = {
+		.mnt = vfsmnt - cache->mnt_offset,
+		.dentry = dentry,
+	};
+	struct string path;
+	struct linux_helper_d_path_map_iterator it =
+		linux_helper_d_path_map_search(&cache->paths, &key);
+	if (it.entry) {
+		path = it.entry->value;
+	} else {
+		struct linux_helper_d_path_dentry d;
+		err = linux_helper_d_path_dentry(cache, dentry, &d);
+		if (err)
+			return err;
+		if (d.op) {
+			uint64_t d_dname;
+			err = drgn_program_read_word(cache->prog,
+						     d.op + cache->d_dname_offset,
+						     false, &d_dname);
+			if (err)
+				return err;
+			if (d_dname) {
+				return linux_helper_d_path_fstype(cache, d.sb,
+								  ret, len_ret);
+			}
+		}
+		err = linux_helper_d_path_build(cache, key, &d, &path);
+		if (err)
+			return err;
+	}
+	if (path.len) {
+		*ret = path.str;
+		*len_ret = path.len;
+	} else {
+		*ret = "/";
+		*len_ret = 1;
+	}
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_dentry_path_unlocked(struct linux_helper_d_path_cache *cache,
+				  uint64_t dentry, const char **ret,
+				  size_t *len_ret)
+{
+	struct drgn_error *err;
+
+	struct linux_helper_d_path_key key = { .dentry = dentry };
+	struct string path;
+	struct linux_helper_d_path_map_iterator it =
+		linux_helper_d_path_map_search(&cache->paths, &key);
+	if (it.entry) {
+		path = it.entry->value;
+	} else {
+		struct linux_helper_d_path_dentry d;
+		err = linux_helper_d_path_dentry(cache, dentry, &d);
+		if (err)
+			return err;
+		err = linux_helper_d_path_build(cache, key, &d, &path);
+		if (err)
+			return err;
+	}
+	/* Paths are built with a leading slash, which dentry_path() omits. */
+	if (path.len) {
+		*ret = path.str + 1;
+		*len_ret = path.len - 1;
+	} else {
+		*ret = "";
+		*len_ret = 0;
+	}
+	return NULL;
+}
+
+struct drgn_error *linux_helper_d_path(struct linux_helper_d_path_cache *cache,
+				       uint64_t vfsmnt, uint64_t dentry,
+				       const char **ret, size_t *len_ret)
+{
+	if (!cache->shared)
+		return linux_helper_d_path_unlocked(cache, vfsmnt, dentry, ret,
+						    len_ret);
+	drgn_program_lock_types(cache->prog);
+	struct drgn_error *err = linux_helper_d_path_unlocked(cache, vfsmnt,
+							      dentry, ret,
+							      len_ret);
+	drgn_program_unlock_types(cache->prog);
+	return err;
+}
+
+struct drgn_error *
+linux_helper_dentry_path(struct linux_helper_d_path_cache *cache,
+			 uint64_t dentry, const char **ret, size_t *len_ret)
+{
+	if (!cache->shared)
+		return linux_helper_dentry_path_unlocked(cache, dentry, ret,
+							 len_ret);
+	drgn_program_lock_types(cache->prog);
+	struct drgn_error *err =
+		linux_helper_dentry_path_unlocked(cache, dentry, ret, len_ret);
+	drgn_program_unlock_types(cache->prog);
+	return err;
+}
+
+DEFINE_VECTOR_FUNCTIONS(linux_helper_maple_frame_vector)
+
+/* Encoding of maple tree node pointers (see mte_to_node()). */
+#define MAPLE_NODE_MASK 255
+#define MAPLE_NODE_TYPE_SHIFT 3
+#define MAPLE_NODE_TYPE_MASK 15
+/* Maximum height of a maple tree (MAPLE_HEIGHT_MAX). */
+#define MAPLE_HEIGHT_MAX 31
+
+enum {
+	MAPLE_DENSE,
+	MAPLE_LEAF_64,
+	MAPLE_RANGE_64,
+	MAPLE_ARANGE_64,
+};
+
+/* Get the layout of the pivots and slots of a member of struct maple_node. */
+static struct drgn_error *
+linux_helper_maple_layout(struct drgn_type *node_type, const char *name,
+			  uint8_t word_size,
+			  struct linux_helper_maple_layout *ret)
+{
+	struct drgn_error *err;
+	struct drgn_type_member *member;
+	uint64_t bit_offset;
+	err = drgn_type_find_member(node_type, name, &member, &bit_offset);
+	if (err)
+		return err;
+	struct drgn_qualified_type type;
+	err = drgn_member_type(member, &type, NULL);
+	if (err)
+		return err;
+	type.type = drgn_underlying_type(type.type);
+
+	uint64_t lengths[2];
+	uint64_t *offsets[] = { &ret->pivot_offset, &ret->slot_offset };
+	static const char * const array_names[] = { "pivot", "slot" };
+	for (int i = 0; i < 2; i++) {
+		struct drgn_type_member *array_member;
+		uint64_t array_bit_offset;
+		err = drgn_type_find_member(type.type, array_names[i],
+					    &array_member, &array_bit_offset);
+		if (err)
+			return err;
+		struct drgn_qualified_type array_type;
+		err = drgn_member_type(array_member, &array_type, NULL);
+		if (err)
+			return err;
+		array_type.type = drgn_underlying_type(array_type.type);
+		if (drgn_type_kind(array_type.type) != DRGN_TYPE_ARRAY ||
+		    (bit_offset + array_bit_offset) % 8) {
+			return drgn_error_format(DRGN_ERROR_TYPE,
+						 "maple tree node %s.%s member is not a supported array",
+						 name, array_names[i]);
+		}
+		lengths[i] = drgn_type_length(array_type.type);
+		*offsets[i] = (bit_offset + array_bit_offset) / 8;
+	}
+	if (lengths[1] == 0 || lengths[1] > LINUX_HELPER_MAPLE_MAX_SLOTS ||
+	    lengths[0] != lengths[1] - 1 ||
+	    ret->slot_offset + lengths[1] * word_size >
+	    drgn_type_size(node_type) ||
+	    ret->pivot_offset + lengths[0] * word_size >
+	    drgn_type_size(node_type)) {
+		return drgn_error_format(DRGN_ERROR_TYPE,
+					 "maple tree node %s member has unsupported layout",
+					 name);
+	}
+	ret->num_slots = lengths[1];
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_vma_iterator_init(struct linux_helper_vma_iterator *it,
+			       struct drgn_program *prog)
+{
+	struct drgn_error *err;
+
+	it->prog = prog;
+	err = drgn_program_bswap(prog, &it->bswap);
+	if (err)
+		return err;
+	err = drgn_program_word_size(prog, &it->word_size);
+	if (err)
+		return err;
+
+	struct drgn_qualified_type type;
+	err = drgn_program_find_type(prog, "struct mm_struct", NULL, &type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(type.type, "mm_mt.ma_root",
+				 &it->mm_root_offset);
+	if (!err) {
+		it->maple = true;
+	} else if (err->code == DRGN_ERROR_LOOKUP) {
+		/* Before Linux kernel commit 524e00b36e8c (in v6.1). */
+		drgn_error_destroy(err);
+		err = drgn_type_offsetof(type.type, "mm_rb",
+					 &it->mm_root_offset);
+		if (err)
+			return err;
+		it->maple = false;
+	} else {
+		return err;
+	}
+
+	if (it->maple) {
+		err = drgn_program_find_type(prog, "struct maple_node", NULL,
+					     &type);
+		if (err)
+			return err;
+		type.type = drgn_underlying_type(type.type);
+		if (!drgn_type_is_complete(type.type)) {
+			return drgn_error_create(DRGN_ERROR_TYPE,
+						 "struct maple_node is incomplete");
+		}
+		it->maple_node_size = drgn_type_size(type.type);
+		err = linux_helper_maple_layout(type.type, "mr64",
+						it->word_size, &it->range_64);
+		if (err)
+			return err;
+		err = linux_helper_maple_layout(type.type, "ma64",
+						it->word_size, &it->arange_64);
+		if (err)
+			return err;
+		it->buf = malloc(it->maple_node_size);
+		if (!it->buf)
+			return &drgn_enomem;
+	} else {
+		err = drgn_program_find_type(prog, "struct vm_area_struct",
+					     NULL, &type);
+		if (err)
+			return err;
+		err = drgn_type_offsetof(type.type, "vm_rb",
+					 &it->vm_rb_offset);
+		if (err)
+			return err;
+		err = drgn_program_find_type(prog, "struct rb_root *", NULL,
+					     &it->rb_root_type);
+		if (err)
+			return err;
+		it->buf = NULL;
+	}
+	it->root_entry = 0;
+	linux_helper_maple_frame_vector_init(&it->stack);
+	it->rb_started = false;
+	return NULL;
+}
+
+void linux_helper_vma_iterator_deinit(struct linux_helper_vma_iterator *it)
+{
+	if (it->rb_started)
+		linux_helper_rbtree_iterator_deinit(&it->rb);
+	linux_helper_maple_frame_vector_deinit(&it->stack);
+	free(it->buf);
+}
+
+static struct drgn_error *
+linux_helper_maple_push(struct linux_helper_vma_iterator *it, uint64_t entry,
+			uint64_t min, uint64_t max)
+{
+	struct drgn_error *err;
+
+	if (it->stack.size >= MAPLE_HEIGHT_MAX) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "maple tree is too deep");
+	}
+	uint64_t node = entry & ~(uint64_t)MAPLE_NODE_MASK;
+	unsigned int type = ((entry >> MAPLE_NODE_TYPE_SHIFT) &
+			     MAPLE_NODE_TYPE_MASK);
+	const struct linux_helper_maple_layout *layout;
+	if (type == MAPLE_LEAF_64 || type == MAPLE_RANGE_64) {
+		layout = &it->range_64;
+	} else if (type == MAPLE_ARANGE_64) {
+		layout = &it->arange_64;
+	} else {
+		return drgn_error_format(DRGN_ERROR_INVALID_ARGUMENT,
+					 "maple tree node 0x%" PRIx64 " has unsupported type %u",
+					 node, type);
+	}
+	err = drgn_memory_reader_read(&it->prog->reader, it->buf, node,
+				      it->maple_node_size, false);
+	if (err)
+		return err;
+
+	struct linux_helper_maple_frame *frame =
+		linux_helper_maple_frame_vector_append_entry(&it->stack);
+	if (!frame)
+		return &drgn_enomem;
+	frame->min = min;
+	frame->max = max;
+	frame->slot = 0;
+	frame->num_slots = layout->num_slots;
+	frame->leaf = type == MAPLE_LEAF_64;
+	for (unsigned int i = 0; i < layout->num_slots - 1; i++) {
+		frame->pivots[i] = decode_word(it->buf + layout->pivot_offset +
+					       i * it->word_size,
+					       it->word_size, it->bswap);
+	}
+	for (unsigned int i = 0; i < layout->num_slots; i++) {
+		frame->slots[i] = decode_word(it->buf + layout->slot_offset +
+					      i * it->word_size,
+					      it->word_size, it->bswap);
+	}
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_vma_iterator_start(struct linux_helper_vma_iterator *it,
+				uint64_t mm)
+{
+	struct drgn_error *err;
+
+	if (it->rb_started) {
+		linux_helper_rbtree_iterator_deinit(&it->rb);
+		it->rb_started = false;
+	}
+	it->root_entry = 0;
+	it->stack.size = 0;
+
+	if (!it->maple) {
+		struct drgn_object root;
+		drgn_object_init(&root, it->prog);
+		err = drgn_object_set_unsigned(&root, it->rb_root_type,
+					       mm + it->mm_root_offset, 0);
+		if (!err) {
+			err = linux_helper_rbtree_iterator_init(&it->rb, &root,
+								(struct drgn_qualified_type){},
+								NULL,
+								UINT64_MAX,
+								true);
+		}
+		drgn_object_deinit(&root);
+		if (err)
+			return err;
+		it->rb_started = true;
+		return NULL;
+	}
+
+	uint64_t root;
+	err = drgn_program_read_word(it->prog, mm + it->mm_root_offset, false,
+				     &root);
+	if (err)
+		return err;
+	if ((root & 3) != 2) {
+		/* A single entry for index 0 is stored in the root. */
+		it->root_entry = root;
+		return NULL;
+	} else if (root > XA_MAX_NON_NODE_INTERNAL_ENTRY) {
+		uint64_t max = (it->word_size == 8 ?
+				UINT64_MAX : UINT32_MAX);
+		return linux_helper_maple_push(it, root, 0, max);
+	} else {
+		return NULL;
+	}
+}
+
+struct drgn_error *
+linux_helper_vma_iterator_next(struct linux_helper_vma_iterator *it,
+			       uint64_t *ret)
+{
+	struct drgn_error *err;
+
+	if (!it->maple) {
+		if (!it->rb_started)
+			return &drgn_stop;
+		uint64_t node;
+		err = linux_helper_rbtree_iterator_next(&it->rb, &node);
+		if (err)
+			return err;
+		*ret = node - it->vm_rb_offset;
+		return NULL;
+	}
+
+	if (it->root_entry) {
+		*ret = it->root_entry;
+		it->root_entry = 0;
+		return NULL;
+	}
+	while (it->stack.size) {
+		struct linux_helper_maple_frame *frame =
+			&it->stack.data[it->stack.size - 1];
+		if (frame->slot >= frame->num_slots) {
+			linux_helper_maple_frame_vector_pop(&it->stack);
+			continue;
+		}
+		unsigned int i = frame->slot++;
+		/*
+		 * The last slot has no pivot. A zero pivot after the first slot
+		 * means the maximum of the node (see mas_logical_pivot()), so
+		 * that is the last used slot.
+		 */
+		uint64_t pivot = (i < frame->num_slots - 1 ?
+				  frame->pivots[i] : frame->max);
+		if ((i > 0 && pivot == 0) || pivot >= frame->max) {
+			pivot = frame->max;
+			frame->slot = frame->num_slots;
+		}
+		uint64_t min = frame->min;
+		frame->min = pivot + 1;
+		uint64_t entry = frame->slots[i];
+		if (!entry)
+			continue;
+		if (!frame->leaf) {
+			err = linux_helper_maple_push(it, entry, min, pivot);
+			if (err)
+				return err;
+			continue;
+		}
+		/* Skip reserved entries (e.g., XA_ZERO_ENTRY). */
+		if ((entry & 3) == 2)
+			continue;
+		*ret = entry;
+		return NULL;
+	}
+	return &drgn_stop;
+}
+
+DEFINE_HASH_TABLE_FUNCTIONS(linux_helper_address_set, int_key_hash_pair,
+			    scalar_key_eq)
+DEFINE_HASH_TABLE_FUNCTIONS(linux_helper_file_path_map, int_key_hash_pair,
+			    scalar_key_eq)
+
+/* Size of task_struct::comm (TASK_COMM_LEN). */
+#define TASK_COMM_LEN 16
+
+struct drgn_error *
+linux_helper_file_inventory_iterator_init(struct linux_helper_file_inventory_iterator *it,
+					  struct drgn_program *prog, bool fds,
+					  bool mappings)
+{
+	struct drgn_error *err;
+
+	it->prog = prog;
+	it->fds = fds;
+	it->mappings = mappings;
+	err = drgn_program_bswap(prog, &it->bswap);
+	if (err)
+		return err;
+	err = drgn_program_word_size(prog, &it->word_size);
+	if (err)
+		return err;
+	uint8_t word_size = it->word_size;
+
+	struct drgn_qualified_type type;
+	err = drgn_program_find_type(prog, "struct task_struct", NULL, &type);
+	if (err)
+		return err;
+	uint64_t start = UINT64_MAX, end = 0;
+	if ((err = member_in_range(type.type, "pid", 4, &it->task_pid_offset,
+				   &start, &end)) ||
+	    (err = member_in_range(type.type, "comm", TASK_COMM_LEN,
+				   &it->task_comm_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "files", word_size,
+				   &it->task_files_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "mm", word_size,
+				   &it->task_mm_offset, &start, &end)))
+		return err;
+	it->task_read_offset = start;
+	it->task_read_size = end - start;
+	uint64_t buf_size = it->task_read_size;
+
+	err = drgn_program_find_type(prog, "struct files_struct", NULL, &type);
+	if (err)
+		return err;
+	err = drgn_type_offsetof(type.type, "fdt", &it->files_fdt_offset);
+	if (err)
+		return err;
+
+	err = drgn_program_find_type(prog, "struct fdtable", NULL, &type);
+	if (err)
+		return err;
+	start = UINT64_MAX;
+	end = 0;
+	if ((err = member_in_range(type.type, "max_fds", 4,
+				   &it->fdt_max_fds_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "fd", word_size,
+				   &it->fdt_fd_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "open_fds", word_size,
+				   &it->fdt_open_fds_offset, &start, &end)))
+		return err;
+	it->fdt_read_offset = start;
+	it->fdt_read_size = end - start;
+	buf_size = max(buf_size, it->fdt_read_size);
+
+	err = drgn_program_find_type(prog, "struct file", NULL, &type);
+	if (err)
+		return err;
+	start = UINT64_MAX;
+	end = 0;
+	if ((err = member_in_range(type.type, "f_path.mnt", word_size,
+				   &it->file_mnt_offset, &start, &end)) ||
+	    (err = member_in_range(type.type, "f_path.dentry", word_size,
+				   &it->file_dentry_offset, &start, &end)))
+		return err;
+	it->file_read_offset = start;
+	it->file_read_size = end - start;
+	buf_size = max(buf_size, it->file_read_size);
+
+	if (mappings) {
+		err = drgn_program_find_type(prog, "struct vm_area_struct",
+					     NULL, &type);
+		if (err)
+			return err;
+		start = UINT64_MAX;
+		end = 0;
+		if ((err = member_in_range(type.type, "vm_start", word_size,
+					   &it->vma_start_offset, &start,
+					   &end)) ||
+		    (err = member_in_range(type.type, "vm_end", word_size,
+					   &it->vma_end_offset, &start,
+					   &end)) ||
+		    (err = member_in_range(type.type, "vm_flags", word_size,
+					   &it->vma_flags_offset, &start,
+					   &end)) ||
+		    (err = member_in_range(type.type, "vm_pgoff", word_size,
+					   &it->vma_pgoff_offset, &start,
+					   &end)) ||
+		    (err = member_in_range(type.type, "vm_file", word_size,
+					   &it->vma_file_offset, &start,
+					   &end)))
+			return err;
+		it->vma_read_offset = start;
+		it->vma_read_size = end - start;
+		buf_size = max(buf_size, it->vma_read_size);
+		err = linux_helper_vma_iterator_init(&it->vmas, prog);
+		if (err)
+			return err;
+	}
+
+	struct drgn_object ns;
+	drgn_object_init(&ns, prog);
+	err = drgn_program_find_object(prog, "init_pid_ns", NULL,
+				       DRGN_FIND_OBJECT_ANY, &ns);
+	if (!err)
+		err = drgn_object_address_of(&ns, &ns);
+	if (!err)
+		err = linux_helper_pid_iterator_init(&it->tasks, &ns, true);
+	drgn_object_deinit(&ns);
+	if (err)
+		goto err_vmas;
+
+	if (prog->flags & DRGN_PROGRAM_IS_LIVE) {
+		err = linux_helper_d_path_cache_init(&it->own_paths, prog);
+		it->paths = &it->own_paths;
+	} else {
+		err = linux_helper_program_d_path_cache(prog, &it->paths);
+	}
+	if (err)
+		goto err_tasks;
+
+	it->buf = malloc(buf_size);
+	if (!it->buf) {
+		err = &drgn_enomem;
+		goto err_paths;
+	}
+	/* A word of the open file bitmap has one bit per byte of the word. */
+	it->fd_buf = malloc_array(8 * word_size, word_size);
+	if (!it->fd_buf) {
+		err = &drgn_enomem;
+		goto err_buf;
+	}
+	it->open_fds = NULL;
+	it->open_fds_capacity = 0;
+	linux_helper_file_path_map_init(&it->file_paths);
+	linux_helper_address_set_init(&it->seen);
+	it->state = LINUX_HELPER_FILE_INVENTORY_NEXT_TASK;
+	return NULL;
+
+err_buf:
+	free(it->buf);
+err_paths:
+	if (it->paths == &it->own_paths)
+		linux_helper_d_path_cache_deinit(&it->own_paths);
+err_tasks:
+	linux_helper_pid_iterator_deinit(&it->tasks);
+err_vmas:
+	if (mappings)
+		linux_helper_vma_iterator_deinit(&it->vmas);
+	return err;
+}
+
+void
+linux_helper_file_inventory_iterator_deinit(struct linux_helper_file_inventory_iterator *it)
+{
+	if (it->mappings)
+		linux_helper_vma_iterator_deinit(&it->vmas);
+	linux_helper_address_set_deinit(&it->seen);
+	linux_helper_file_path_map_deinit(&it->file_paths);
+	free(it->open_fds);
+	free(it->fd_buf);
+	free(it->buf);
+	if (it->paths == &it->own_paths)
+		linux_helper_d_path_cache_deinit(&it->own_paths);
+	linux_helper_pid_iterator_deinit(&it->tasks);
+}
+
+/* Set the path of the current entry from its file. */
+static struct drgn_error *
+linux_helper_file_inventory_path(struct linux_helper_file_inventory_iterator *it)
+{
+	struct drgn_error *err;
+
+	uint64_t file = it->entry.file;
+	struct hash_pair hp = linux_helper_file_path_map_hash(&file);
+	struct linux_helper_file_path_map_iterator path_it =
+		linux_helper_file_path_map_search_hashed(&it->file_paths,
+							 &file, hp);
+	if (!path_it.entry) {
+		err = drgn_memory_reader_read(&it->prog->reader, it->buf,
+					      file + it->file_read_offset,
+					      it->file_read_size, false);
+		if (err)
+			return err;
+		const char *buf = it->buf - it->file_read_offset;
+		uint64_t mnt = decode_word(buf + it->file_mnt_offset,
+					   it->word_size, it->bswap);
+		uint64_t dentry = decode_word(buf + it->file_dentry_offset,
+					      it->word_size, it->bswap);
+		struct linux_helper_file_path_map_entry entry = { .key = file };
+		err = linux_helper_d_path(it->paths, mnt, dentry,
+					  &entry.value.str, &entry.value.len);
+		if (err)
+			return err;
+		if (linux_helper_file_path_map_insert_searched(&it->file_paths,
+							       &entry, hp,
+							       &path_it) == -1)
+			return &drgn_enomem;
+	}
+	it->entry.path = path_it.entry->value.str;
+	it->entry.path_len = path_it.entry->value.len;
+	return NULL;
+}
+
+/*
+ * Return whether a file descriptor table or address space hasn't been visited
+ * yet and mark it as visited.
+ */
+static struct drgn_error *
+linux_helper_file_inventory_visit(struct linux_helper_file_inventory_iterator *it,
+				  uint64_t address, bool *ret)
+{
+	if (!address) {
+		*ret = false;
+		return NULL;
+	}
+	int r = linux_helper_address_set_insert(&it->seen, &address, NULL);
+	if (r < 0)
+		return &drgn_enomem;
+	*ret = r > 0;
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_file_inventory_start_vmas(struct linux_helper_file_inventory_iterator *it)
+{
+	struct drgn_error *err;
+
+	if (!it->mm) {
+		it->state = LINUX_HELPER_FILE_INVENTORY_NEXT_TASK;
+		return NULL;
+	}
+	err = linux_helper_vma_iterator_start(&it->vmas, it->mm);
+	if (err)
+		return err;
+	it->state = LINUX_HELPER_FILE_INVENTORY_VMAS;
+	return NULL;
+}
+
+static struct drgn_error *
+linux_helper_file_inventory_next_task(struct linux_helper_file_inventory_iterator *it)
+{
+	struct drgn_error *err;
+
+	uint64_t task;
+	err = linux_helper_pid_iterator_next(&it->tasks, &task);
+	if (err)
+		return err;
+	err = drgn_memory_reader_read(&it->prog->reader, it->buf,
+				      task + it->task_read_offset,
+				      it->task_read_size, false);
+	if (err)
+		return err;
+	const char *buf = it->buf - it->task_read_offset;
+	it->entry.task = task;
+	it->entry.pid = decode_word(buf + it->task_pid_offset, 4, it->bswap);
+	memcpy(it->entry.comm, buf + it->task_comm_offset, TASK_COMM_LEN);
+	it->entry.comm[TASK_COMM_LEN] = '\0';
+	uint64_t files = decode_word(buf + it->task_files_offset,
+				     it->word_size, it->bswap);
+	uint64_t mm = decode_word(buf + it->task_mm_offset, it->word_size,
+				  it->bswap);
+
+	bool visit;
+	if (it->mappings) {
+		err = linux_helper_file_inventory_visit(it, mm, &visit);
+		if (err)
+			return err;
+		it->mm = visit ? mm : 0;
+	} else {
+		it->mm = 0;
+	}
+
+	visit = false;
+	if (it->fds) {
+		err = linux_helper_file_inventory_visit(it, files, &visit);
+		if (err)
+			return err;
+	}
+	if (!visit)
+		return linux_helper_file_inventory_start_vmas(it);
+
+	uint64_t fdt;
+	err = drgn_program_read_word(it->prog, files + it->files_fdt_offset,
+				     false, &fdt);
+	if (err)
+		return err;
+	err = drgn_memory_reader_read(&it->prog->reader, it->buf,
+				      fdt + it->fdt_read_offset,
+				      it->fdt_read_size, false);
+	if (err)
+		return err;
+	buf = it->buf - it->fdt_read_offset;
+	it->max_fds = decode_word(buf + it->fdt_max_fds_offset, 4, it->bswap);
+	it->fd_array = decode_word(buf + it->fdt_fd_offset, it->word_size,
+				   it->bswap);
+	uint64_t open_fds = decode_word(buf + it->fdt_open_fds_offset,
+					it->word_size, it->bswap);
+
+	/* Read the whole open file bitmap at once. */
+	uint64_t bits_per_word = 8 * it->word_size;
+	it->num_open_fds_words = ((it->max_fds + bits_per_word - 1) /
+				  bits_per_word);
+	size_t size = it->num_open_fds_words * it->word_size;
+	if (size > it->open_fds_capacity) {
+		free(it->open_fds);
+		it->open_fds = malloc(size);
+		if (!it->open_fds) {
+			it->open_fds_capacity = 0;
+			return &drgn_enomem;
+		}
+		it->open_fds_capacity = size;
+	}
+	err = drgn_memory_reader_read(&it->prog->reader, it->open_fds,
+				      open_fds, size, false);
+	if (err)
+		return err;
+	it->open_fds_word = 0;
+	it->bits = 0;
+	it->state = LINUX_HELPER_FILE_INVENTORY_FDS;
+	return NULL;
+}
+
+/*
+ * Advance to the next open file descriptor of the current task. Returns
+ * whether one was found.
+ */
+static struct drgn_error *
+linux_helper_file_inventory_next_fd(struct linux_helper_file_inventory_iterator *it,
+				    bool *ret)
+{
+	struct drgn_error *err;
+
+	uint64_t bits_per_word = 8 * it->word_size;
+	while (!it->bits) {
+		if (it->open_fds_word >= it->num_open_fds_words) {
+			*ret = false;
+			return linux_helper_file_inventory_start_vmas(it);
+		}
+		it->fd_base = it->open_fds_word * bits_per_word;
+		it->bits = decode_word(it->open_fds +
+				       it->open_fds_word * it->word_size,
+				       it->word_size, it->bswap);
+		it->open_fds_word++;
+		/* Ignore bits past the end of the file descriptor array. */
+		uint64_t n = min(bits_per_word, it->max_fds - it->fd_base);
+		if (n < 64)
+			it->bits &= (UINT64_C(1) << n) - 1;
+		if (!it->bits)
+			continue;
+		/* Read all of the file pointers for this word at once. */
+		err = drgn_memory_reader_read(&it->prog->reader, it->fd_buf,
+					      it->fd_array +
+					      it->fd_base * it->word_size,
+					      fls(it->bits) * it->word_size,
+					      false);
+		if (err)
+			return err;
+	}
+	unsigned int bit;
+	for_each_bit(bit, it->bits) {
+		uint64_t file = decode_word(it->fd_buf + bit * it->word_size,
+					    it->word_size, it->bswap);
+		/* The file may not be installed yet. */
+		if (!file)
+			continue;
+		it->entry.kind = LINUX_HELPER_FILE_INVENTORY_FD;
+		it->entry.fd = it->fd_base + bit;
+		it->entry.file = file;
+		*ret = true;
+		return linux_helper_file_inventory_path(it);
+	}
+	*ret = false;
+	return NULL;
+}
+
+/*
+ * Advance to the next memory mapping of the current task. Returns whether one
+ * was found.
+ */
+static struct drgn_error *
+linux_helper_file_inventory_next_vma(struct linux_helper_file_inventory_iterator *it,
+				     bool *ret)
+{
+	struct drgn_error *err;
+
+	uint64_t vma;
+	err = linux_helper_vma_iterator_next(&it->vmas, &vma);
+	if (err == &drgn_stop) {
+		it->state = LINUX_HELPER_FILE_INVENTORY_NEXT_TASK;
+		*ret = false;
+		return NULL;
+	} else if (err) {
+		return err;
+	}
+	err = drgn_memory_reader_read(&it->prog->reader, it->buf,
+				      vma + it->vma_read_offset,
+				      it->vma_read_size, false);
+	if (err)
+		return err;
+	const char *buf = it->buf - it->vma_read_offset;
+	it->entry.kind = LINUX_HELPER_FILE_INVENTORY_VMA;
+	it->entry.vma = vma;
+	it->entry.start = decode_word(buf + it->vma_start_offset,
+				      it->word_size, it->bswap);
+	it->entry.end = decode_word(buf + it->vma_end_offset, it->word_size,
+				    it->bswap);
+	it->entry.flags = decode_word(buf + it->vma_flags_offset,
+				      it->word_size, it->bswap);
+	it->entry.pgoff = decode_word(buf + it->vma_pgoff_offset,
+				      it->word_size, it->bswap);
+	it->entry.file = decode_word(buf + it->vma_file_offset, it->word_size,
+				     it->bswap);
+	*ret = true;
+	if (it->entry.file)
+		return linux_helper_file_inventory_path(it);
+	it->entry.path = NULL;
+	it->entry.path_len = 0;
+	return NULL;
+}
+
+struct drgn_error *
+linux_helper_file_inventory_iterator_next(struct linux_helper_file_inventory_iterator *it,
+					  const struct linux_helper_file_inventory_entry **ret)
+{
+	struct drgn_error *err;
+
+	for (;;) {
+		bool found = false;
+		switch (it->state) {
+		case LINUX_HELPER_FILE_INVENTORY_NEXT_TASK:
+			err = linux_helper_file_inventory_next_task(it);
+			break;
+		case LINUX_HELPER_FILE_INVENTORY_FDS:
+			err = linux_helper_file_inventory_next_fd(it, &found);
+			break;
+		case LINUX_HELPER_FILE_INVENTORY_VMAS:
+			err = linux_helper_file_inventory_next_vma(it, &found);
+			break;
+		default:
+			UNREACHABLE();
+		}
+		if (err)
+			return err;
+		if (found) {
+			*ret = &it->entry;
+			return NULL;
+		}
+	}
+}
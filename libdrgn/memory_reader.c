@@ -16,6 +16,7 @@ void drgn_memory_reader_init(struct drgn_memory_reader *reader)
 {
 	drgn_memory_segment_tree_init(&reader->virtual_segments);
 	drgn_memory_segment_tree_init(&reader->physical_segments);
+	pthread_rwlock_init(&reader->lock, NULL);
 }
 
 static void free_memory_segment_tree(struct drgn_memory_segment_tree *tree)
@@ -35,6 +36,7 @@ void drgn_memory_reader_deinit(struct drgn_memory_reader *reader)
 {
 	free_memory_segment_tree(&reader->physical_segments);
 	free_memory_segment_tree(&reader->virtual_segments);
+	pthread_rwlock_destroy(&reader->lock);
 }
 
 bool drgn_memory_reader_empty(struct drgn_memory_reader *reader)
@@ -43,11 +45,11 @@ bool drgn_memory_reader_empty(struct drgn_memory_reader *reader)
 		drgn_memory_segment_tree_empty(&reader->physical_segments));
 }
 
-struct drgn_error *
-drgn_memory_reader_add_segment(struct drgn_memory_reader *reader,
-			       uint64_t address, uint64_t size,
-			       drgn_memory_read_fn read_fn, void *arg,
-			       bool physical)
+static struct drgn_error *
+drgn_memory_reader_add_segment_locked(struct drgn_memory_reader *reader,
+				      uint64_t address, uint64_t size,
+				      drgn_memory_read_fn read_fn, void *arg,
+				      bool physical)
 {
 	struct drgn_memory_segment_tree *tree = (physical ?
 						 &reader->physical_segments :
@@ -224,6 +226,20 @@ insert:
 	return NULL;
 }
 
+struct drgn_error *
+drgn_memory_reader_add_segment(struct drgn_memory_reader *reader,
+			       uint64_t address, uint64_t size,
+			       drgn_memory_read_fn read_fn, void *arg,
+			       bool physical)
+{
+	pthread_rwlock_wrlock(&reader->lock);
+	struct drgn_error *err =
+		drgn_memory_reader_add_segment_locked(reader, address, size,
+						      read_fn, arg, physical);
+	pthread_rwlock_unlock(&reader->lock);
+	return err;
+}
+
 struct drgn_error *drgn_memory_reader_read(struct drgn_memory_reader *reader,
 					   void *buf, uint64_t address,
 					   size_t count, bool physical)
@@ -238,18 +254,23 @@ struct drgn_error *drgn_memory_reader_read(struct drgn_memory_reader *reader,
 		struct drgn_memory_segment *segment;
 		size_t n;
 
-		segment = drgn_memory_segment_tree_search_le(tree,
-							     &address).entry;
+		pthread_rwlock_rdlock(&reader->lock);
+		segment = drgn_memory_segment_tree_search_le_readonly(tree,
+								      &address).entry;
 		if (!segment || segment->address + segment->size <= address) {
+			pthread_rwlock_unlock(&reader->lock);
 			return drgn_error_create_fault("could not find memory segment",
 						       address);
 		}
 
 		n = min(segment->address + segment->size - address,
 			(uint64_t)(count - read));
-		err = segment->read_fn((char *)buf + read, address, n,
-				       address - segment->orig_address,
-				       segment->arg, physical);
+		drgn_memory_read_fn read_fn = segment->read_fn;
+		void *arg = segment->arg;
+		uint64_t offset = address - segment->orig_address;
+		pthread_rwlock_unlock(&reader->lock);
+		err = read_fn((char *)buf + read, address, n, offset, arg,
+			      physical);
 		if (err)
 			return err;
 
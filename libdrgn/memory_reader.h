@@ -12,6 +12,8 @@
 #ifndef DRGN_MEMORY_READER_H
 #define DRGN_MEMORY_READER_H
 
+#include <pthread.h>
+
 #include "binary_search_tree.h"
 #include "drgn.h"
 
@@ -69,6 +71,12 @@ struct drgn_memory_reader {
 	struct drgn_memory_segment_tree virtual_segments;
 	/** Physical memory segments. */
 	struct drgn_memory_segment_tree physical_segments;
+	/**
+	 * Lock protecting the segment trees. Reads only take it for reading
+	 * and don't splay the trees, so they don't block each other. Callbacks
+	 * are called without the lock held.
+	 */
+	pthread_rwlock_t lock;
 };
 
 /**
@@ -14,6 +14,7 @@
 #include "object.h"
 #include "program.h"
 #include "serialize.h"
+#include "string_builder.h"
 #include "type.h"
 #include "util.h"
 
@@ -770,13 +771,47 @@ LIBDRGN_PUBLIC struct drgn_error *
 drgn_format_object(const struct drgn_object *obj, size_t columns,
 		   enum drgn_format_object_flags flags, char **ret)
 {
+	struct drgn_error *err;
+	const struct drgn_language *lang = drgn_object_language(obj);
+
+	if (flags & ~DRGN_FORMAT_OBJECT_VALID_FLAGS) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "invalid format object flags");
+	}
+	struct string_builder sb = {};
+	err = lang->format_object(obj, columns, flags, &sb);
+	if (err) {
+		free(sb.str);
+		return err;
+	}
+	if (!string_builder_finalize(&sb, ret)) {
+		free(sb.str);
+		return &drgn_enomem;
+	}
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_format_object_stream(const struct drgn_object *obj, size_t columns,
+			  enum drgn_format_object_flags flags,
+			  drgn_format_object_write_fn *write_fn, void *arg)
+{
+	struct drgn_error *err;
 	const struct drgn_language *lang = drgn_object_language(obj);
 
 	if (flags & ~DRGN_FORMAT_OBJECT_VALID_FLAGS) {
 		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
 					 "invalid format object flags");
 	}
-	return lang->format_object(obj, columns, flags, ret);
+	struct string_builder sb = {
+		.flush_fn = write_fn,
+		.flush_arg = arg,
+	};
+	err = lang->format_object(obj, columns, flags, &sb);
+	if (!err)
+		err = string_builder_flush(&sb);
+	free(sb.str);
+	return err;
 }
 
 static struct drgn_error *
@@ -864,6 +899,266 @@ drgn_object_convert_float(const struct drgn_object *obj, double *fvalue)
 	return err;
 }
 
+/* Objects compared in bulk are read in chunks of about this size. */
+#define DRGN_OBJECT_BULK_CHUNK_SIZE (64 * 1024)
+
+/*
+ * These are written so that the compiler can vectorize them: there is no early
+ * exit inside of a block.
+ */
+static bool bytes_are_zero(const unsigned char *buf, size_t len)
+{
+	uint64_t acc = 0;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, &buf[i], sizeof(word));
+		acc |= word;
+	}
+	for (; i < len; i++)
+		acc |= buf[i];
+	return !acc;
+}
+
+static bool masked_bytes_are_zero(const unsigned char *buf,
+				  const unsigned char *mask, size_t len)
+{
+	uint64_t acc = 0;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t word, mask_word;
+		memcpy(&word, &buf[i], sizeof(word));
+		memcpy(&mask_word, &mask[i], sizeof(mask_word));
+		acc |= word & mask_word;
+	}
+	for (; i < len; i++)
+		acc |= buf[i] & mask[i];
+	return !acc;
+}
+
+/*
+ * Reader for the bytes of a buffer-encoded object. Values are used in place;
+ * references are read into a buffer one chunk at a time.
+ */
+struct drgn_object_bulk_reader {
+	const struct drgn_object *obj;
+	unsigned char *buf;
+};
+
+static struct drgn_error *
+drgn_object_bulk_read(struct drgn_object_bulk_reader *reader, uint64_t offset,
+		      uint64_t len, const unsigned char **ret)
+{
+	const struct drgn_object *obj = reader->obj;
+	SWITCH_ENUM(obj->kind,
+	case DRGN_OBJECT_VALUE:
+		*ret = (const unsigned char *)drgn_object_buffer(obj) + offset;
+		return NULL;
+	case DRGN_OBJECT_REFERENCE: {
+		struct drgn_error *err =
+			drgn_memory_reader_read(&drgn_object_program(obj)->reader,
+						reader->buf,
+						obj->address + offset, len,
+						false);
+		if (err)
+			return err;
+		*ret = reader->buf;
+		return NULL;
+	}
+	case DRGN_OBJECT_ABSENT:
+		return &drgn_error_object_absent;
+	)
+}
+
+/*
+ * Get the value mask for a buffer-encoded object. Arrays are treated as a
+ * number of elements of the innermost element type so that the mask stays
+ * small.
+ *
+ * Returns &drgn_not_found if there is no mask.
+ */
+static struct drgn_error *
+drgn_object_value_mask(const struct drgn_object *obj,
+		       const struct drgn_type_value_mask **mask_ret,
+		       uint64_t *count_ret)
+{
+	struct drgn_error *err;
+	struct drgn_type *type = drgn_underlying_type(obj->type);
+	uint64_t count = 1;
+	while (drgn_type_kind(type) == DRGN_TYPE_ARRAY) {
+		if (__builtin_mul_overflow(count, drgn_type_length(type),
+					   &count))
+			return &drgn_not_found;
+		type = drgn_underlying_type(drgn_type_type(type).type);
+	}
+	const struct drgn_type_value_mask *mask;
+	err = drgn_type_value_mask(type, &mask);
+	if (err)
+		return err;
+	uint64_t size;
+	if (!mask->size ||
+	    __builtin_mul_overflow(mask->size, count, &size) ||
+	    size != drgn_object_size(obj))
+		return &drgn_not_found;
+	*mask_ret = mask;
+	*count_ret = count;
+	return NULL;
+}
+
+/* Get the number of bytes of whole elements to read at once. */
+static uint64_t drgn_object_bulk_chunk_size(uint64_t element_size,
+					    uint64_t total_size)
+{
+	uint64_t chunk_size;
+	if (element_size >= DRGN_OBJECT_BULK_CHUNK_SIZE)
+		chunk_size = element_size;
+	else
+		chunk_size = (DRGN_OBJECT_BULK_CHUNK_SIZE / element_size *
+			      element_size);
+	return min(chunk_size, total_size);
+}
+
+/*
+ * Check whether a buffer-encoded object is zero by reading it in bulk and
+ * comparing it against its value mask. Returns &drgn_not_found if this isn't
+ * possible for the object's type.
+ */
+static struct drgn_error *
+drgn_buffer_object_is_zero(const struct drgn_object *obj, bool *ret)
+{
+	struct drgn_error *err;
+	const struct drgn_type_value_mask *mask;
+	uint64_t count;
+	err = drgn_object_value_mask(obj, &mask, &count);
+	if (err)
+		return err;
+	/* -0.0 is zero, so floating-point values need the slow path. */
+	if (mask->has_float)
+		return &drgn_not_found;
+
+	uint64_t size = mask->size * count;
+	uint64_t chunk_size = drgn_object_bulk_chunk_size(mask->size, size);
+	struct drgn_object_bulk_reader reader = { .obj = obj };
+	if (obj->kind == DRGN_OBJECT_REFERENCE && chunk_size) {
+		reader.buf = malloc64(chunk_size);
+		if (!reader.buf)
+			return &drgn_enomem;
+	}
+	for (uint64_t offset = 0; offset < size; offset += chunk_size) {
+		uint64_t len = min(chunk_size, size - offset);
+		const unsigned char *buf;
+		err = drgn_object_bulk_read(&reader, offset, len, &buf);
+		if (err)
+			goto out;
+		bool zero;
+		if (mask->dense) {
+			zero = bytes_are_zero(buf, len);
+		} else {
+			zero = true;
+			for (uint64_t i = 0; zero && i < len; i += mask->size) {
+				zero = masked_bytes_are_zero(&buf[i],
+							     mask->mask,
+							     mask->size);
+			}
+		}
+		if (!zero) {
+			*ret = false;
+			break;
+		}
+	}
+	err = NULL;
+out:
+	free(reader.buf);
+	return err;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_object_memcmp(const struct drgn_object *lhs,
+		   const struct drgn_object *rhs, int *ret)
+{
+	struct drgn_error *err;
+
+	if (drgn_object_program(lhs) != drgn_object_program(rhs)) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "objects are from different programs");
+	}
+	if (lhs->kind == DRGN_OBJECT_ABSENT || rhs->kind == DRGN_OBJECT_ABSENT)
+		return &drgn_error_object_absent;
+	if (lhs->encoding != DRGN_OBJECT_ENCODING_BUFFER ||
+	    rhs->encoding != DRGN_OBJECT_ENCODING_BUFFER) {
+		return drgn_error_create(DRGN_ERROR_TYPE,
+					 "memcmp() requires structure, union, class, or array objects");
+	}
+	if (lhs->bit_size != rhs->bit_size) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "memcmp() objects have different sizes");
+	}
+	bool types_eq;
+	err = drgn_type_eq(lhs->type, rhs->type, &types_eq);
+	if (err)
+		return err;
+	if (!types_eq) {
+		return drgn_error_create(DRGN_ERROR_TYPE,
+					 "memcmp() objects have different types");
+	}
+
+	const struct drgn_type_value_mask *mask;
+	uint64_t count;
+	err = drgn_object_value_mask(lhs, &mask, &count);
+	if (err == &drgn_not_found) {
+		return drgn_error_create(DRGN_ERROR_TYPE,
+					 "memcmp() type is too large");
+	} else if (err) {
+		return err;
+	}
+
+	uint64_t size = mask->size * count;
+	uint64_t chunk_size = drgn_object_bulk_chunk_size(mask->size, size);
+	struct drgn_object_bulk_reader lhs_reader = { .obj = lhs };
+	struct drgn_object_bulk_reader rhs_reader = { .obj = rhs };
+	if (lhs->kind == DRGN_OBJECT_REFERENCE && chunk_size) {
+		lhs_reader.buf = malloc64(chunk_size);
+		if (!lhs_reader.buf)
+			return &drgn_enomem;
+	}
+	if (rhs->kind == DRGN_OBJECT_REFERENCE && chunk_size) {
+		rhs_reader.buf = malloc64(chunk_size);
+		if (!rhs_reader.buf) {
+			err = &drgn_enomem;
+			goto out;
+		}
+	}
+	*ret = 0;
+	for (uint64_t offset = 0; offset < size; offset += chunk_size) {
+		uint64_t len = min(chunk_size, size - offset);
+		const unsigned char *lhs_buf, *rhs_buf;
+		err = drgn_object_bulk_read(&lhs_reader, offset, len,
+					    &lhs_buf);
+		if (err)
+			goto out;
+		err = drgn_object_bulk_read(&rhs_reader, offset, len,
+					    &rhs_buf);
+		if (err)
+			goto out;
+		if (mask->dense) {
+			*ret = memcmp(lhs_buf, rhs_buf, len);
+		} else {
+			for (uint64_t i = 0; !*ret && i < len; i++) {
+				unsigned char m = mask->mask[i % mask->size];
+				*ret = ((int)(lhs_buf[i] & m) -
+					(int)(rhs_buf[i] & m));
+			}
+		}
+		if (*ret)
+			break;
+	}
+	err = NULL;
+out:
+	free(rhs_reader.buf);
+	free(lhs_reader.buf);
+	return err;
+}
+
 static struct drgn_error *
 drgn_object_is_zero_impl(const struct drgn_object *obj, bool *ret);
 
@@ -980,6 +1275,18 @@ drgn_object_is_zero_impl(const struct drgn_object *obj, bool *ret)
 		switch (drgn_type_kind(underlying_type)) {
 		case DRGN_TYPE_STRUCT:
 		case DRGN_TYPE_UNION:
+		case DRGN_TYPE_CLASS:
+		case DRGN_TYPE_ARRAY:
+			err = drgn_buffer_object_is_zero(obj, ret);
+			if (err != &drgn_not_found)
+				return err;
+			break;
+		default:
+			break;
+		}
+		switch (drgn_type_kind(underlying_type)) {
+		case DRGN_TYPE_STRUCT:
+		case DRGN_TYPE_UNION:
 		case DRGN_TYPE_CLASS:
 			return drgn_compound_object_is_zero(obj,
 							    underlying_type,
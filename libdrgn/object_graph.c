@@ -0,0 +1,654 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// SPDX-License-Identifier: GPL-3.0+
+
+#include <byteswap.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "error.h"
+#include "hash_table.h"
+#include "object.h"
+#include "program.h"
+#include "string_builder.h"
+#include "type.h"
+#include "util.h"
+#include "vector.h"
+
+/* Pointer to a structure, union, or class found in the layout of a type. */
+struct drgn_object_graph_slot {
+	/* Offset of the pointer in bytes. */
+	uint64_t offset;
+	/* Size of the pointer in bytes (4 or 8). */
+	uint8_t size;
+	bool bswap;
+	/* Complete type that the pointer points to. */
+	struct drgn_qualified_type qualified_type;
+	/* Name of the innermost named member containing the pointer. */
+	const char *name;
+	/* Member designator relative to the object, like "a.b[2]". */
+	char *designator;
+};
+
+DEFINE_VECTOR(drgn_object_graph_slot_vector, struct drgn_object_graph_slot)
+
+struct drgn_object_graph_layout {
+	uint64_t size;
+	struct drgn_object_graph_slot_vector slots;
+};
+
+DEFINE_HASH_MAP(drgn_object_graph_layout_map, struct drgn_type *,
+		struct drgn_object_graph_layout *, ptr_key_hash_pair,
+		scalar_key_eq)
+
+struct drgn_object_graph_key {
+	uint64_t address;
+	struct drgn_type *type;
+};
+
+static struct hash_pair
+drgn_object_graph_key_hash_pair(const struct drgn_object_graph_key *key)
+{
+	return hash_pair_from_avalanching_hash(hash_combine(key->address,
+							    (uintptr_t)key->type));
+}
+
+static bool drgn_object_graph_key_eq(const struct drgn_object_graph_key *a,
+				     const struct drgn_object_graph_key *b)
+{
+	return a->address == b->address && a->type == b->type;
+}
+
+DEFINE_HASH_SET(drgn_object_graph_visited_set, struct drgn_object_graph_key,
+		drgn_object_graph_key_hash_pair, drgn_object_graph_key_eq)
+
+/* Pointer member followed to reach an object. */
+struct drgn_object_graph_edge {
+	/* Index of the edge followed to reach the parent, or SIZE_MAX. */
+	size_t parent;
+	/* Member designator in the parent, owned by its layout. */
+	const char *designator;
+};
+
+DEFINE_VECTOR(drgn_object_graph_edge_vector, struct drgn_object_graph_edge)
+
+struct drgn_object_graph_pending {
+	uint64_t address;
+	struct drgn_qualified_type qualified_type;
+	uint64_t depth;
+	/* Index of the edge followed to reach the object, or SIZE_MAX. */
+	size_t edge;
+};
+
+DEFINE_VECTOR(drgn_object_graph_pending_vector,
+	      struct drgn_object_graph_pending)
+DEFINE_VECTOR(drgn_object_graph_type_vector, struct drgn_type *)
+DEFINE_VECTOR(drgn_object_graph_name_vector, char *)
+
+struct drgn_object_graph_iterator {
+	struct drgn_program *prog;
+	uint64_t max_depth;
+	bool depth_first;
+	bool paths;
+	/* Layouts of the types seen so far, keyed by underlying type. */
+	struct drgn_object_graph_layout_map layouts;
+	/* Objects which have been visited or are pending. */
+	struct drgn_object_graph_visited_set visited;
+	/*
+	 * Objects to visit. Breadth-first traversals take from pending_head;
+	 * depth-first traversals take from the end.
+	 */
+	struct drgn_object_graph_pending_vector pending;
+	size_t pending_head;
+	/*
+	 * Edges followed to reach the visited and pending objects. Paths are
+	 * only built from these when an object is returned, since copying the
+	 * whole path for every object would take quadratic time.
+	 */
+	struct drgn_object_graph_edge_vector edges;
+	struct drgn_object_graph_type_vector types;
+	struct drgn_object_graph_name_vector members;
+	/* Last returned object. Its path is owned by the iterator. */
+	struct drgn_object_graph_node node;
+	size_t node_edge;
+	char *path;
+	size_t path_capacity;
+	void *buf;
+	uint64_t buf_capacity;
+};
+
+/*
+ * Get the complete type for a structure, union, or class type, looking up the
+ * definition of an incomplete type by its tag. Other types and types without a
+ * definition are returned as NULL.
+ */
+static struct drgn_error *
+drgn_object_graph_complete_type(struct drgn_program *prog,
+				struct drgn_qualified_type *qualified_type)
+{
+	struct drgn_error *err;
+	struct drgn_type *type = drgn_underlying_type(qualified_type->type);
+	enum drgn_type_kind kind = drgn_type_kind(type);
+	if (kind != DRGN_TYPE_STRUCT && kind != DRGN_TYPE_UNION &&
+	    kind != DRGN_TYPE_CLASS) {
+		qualified_type->type = NULL;
+		return NULL;
+	}
+	if (drgn_type_is_complete(type)) {
+		qualified_type->type = type;
+		return NULL;
+	}
+	qualified_type->type = NULL;
+	const char *tag = drgn_type_tag(type);
+	if (!tag)
+		return NULL;
+	char *name;
+	if (asprintf(&name, "%s %s", drgn_type_kind_spelling[kind], tag) == -1)
+		return &drgn_enomem;
+	struct drgn_qualified_type complete;
+	err = drgn_program_find_type(prog, name, NULL, &complete);
+	free(name);
+	if (err == &drgn_not_found)
+		return NULL;
+	else if (err)
+		return err;
+	complete.type = drgn_underlying_type(complete.type);
+	if (drgn_type_kind(complete.type) == kind &&
+	    drgn_type_is_complete(complete.type))
+		qualified_type->type = complete.type;
+	return NULL;
+}
+
+static struct drgn_error *
+drgn_object_graph_add_slots(struct drgn_object_graph_iterator *it,
+			    struct drgn_object_graph_layout *layout,
+			    struct drgn_type *type, uint64_t bit_offset,
+			    uint64_t bit_field_size, const char *name,
+			    struct string_builder *designator)
+{
+	struct drgn_error *err;
+	struct drgn_type *underlying_type = drgn_underlying_type(type);
+
+	switch (drgn_type_kind(underlying_type)) {
+	case DRGN_TYPE_POINTER: {
+		uint64_t size = drgn_type_size(underlying_type);
+		if (bit_field_size || bit_offset % 8 || (size != 4 && size != 8))
+			return NULL;
+		struct drgn_qualified_type qualified_type =
+			drgn_type_type(underlying_type);
+		err = drgn_object_graph_complete_type(it->prog,
+						      &qualified_type);
+		if (err || !qualified_type.type)
+			return err;
+		char *designator_copy = strndup(designator->str,
+						designator->len);
+		if (!designator_copy)
+			return &drgn_enomem;
+		struct drgn_object_graph_slot *slot =
+			drgn_object_graph_slot_vector_append_entry(&layout->slots);
+		if (!slot) {
+			free(designator_copy);
+			return &drgn_enomem;
+		}
+		slot->offset = bit_offset / 8;
+		slot->size = size;
+		slot->bswap = (drgn_type_little_endian(underlying_type) !=
+			       (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__));
+		slot->qualified_type = qualified_type;
+		slot->name = name;
+		slot->designator = designator_copy;
+		return NULL;
+	}
+	case DRGN_TYPE_STRUCT:
+	case DRGN_TYPE_UNION:
+	case DRGN_TYPE_CLASS: {
+		if (!drgn_type_is_complete(underlying_type))
+			return NULL;
+		struct drgn_type_member *members =
+			drgn_type_members(underlying_type);
+		size_t num_members = drgn_type_num_members(underlying_type);
+		size_t len = designator->len;
+		for (size_t i = 0; i < num_members; i++) {
+			struct drgn_qualified_type member_type;
+			uint64_t member_bit_field_size;
+			err = drgn_member_type(&members[i], &member_type,
+					       &member_bit_field_size);
+			if (err)
+				return err;
+			const char *member_name = name;
+			if (members[i].name) {
+				member_name = members[i].name;
+				if ((designator->len &&
+				     !string_builder_appendc(designator, '.')) ||
+				    !string_builder_append(designator,
+							   member_name))
+					return &drgn_enomem;
+			}
+			err = drgn_object_graph_add_slots(it, layout,
+							  member_type.type,
+							  bit_offset +
+							  members[i].bit_offset,
+							  member_bit_field_size,
+							  member_name,
+							  designator);
+			designator->len = len;
+			if (err)
+				return err;
+		}
+		return NULL;
+	}
+	case DRGN_TYPE_ARRAY: {
+		uint64_t length = drgn_type_length(underlying_type);
+		struct drgn_type *element_type =
+			drgn_type_type(underlying_type).type;
+		uint64_t element_bit_size;
+		err = drgn_type_bit_size(element_type, &element_bit_size);
+		if (err)
+			return err;
+		size_t len = designator->len;
+		size_t num_slots = layout->slots.size;
+		for (uint64_t i = 0; i < length; i++) {
+			if (!string_builder_appendf(designator, "[%" PRIu64 "]",
+						    i))
+				return &drgn_enomem;
+			err = drgn_object_graph_add_slots(it, layout,
+							  element_type,
+							  bit_offset +
+							  i * element_bit_size,
+							  0, name, designator);
+			designator->len = len;
+			if (err)
+				return err;
+			/* Don't bother with the rest if there are no pointers. */
+			if (layout->slots.size == num_slots)
+				break;
+		}
+		return NULL;
+	}
+	default:
+		return NULL;
+	}
+}
+
+static void drgn_object_graph_layout_destroy(struct drgn_object_graph_layout *layout)
+{
+	if (layout) {
+		for (size_t i = 0; i < layout->slots.size; i++)
+			free(layout->slots.data[i].designator);
+		drgn_object_graph_slot_vector_deinit(&layout->slots);
+		free(layout);
+	}
+}
+
+static struct drgn_error *
+drgn_object_graph_layout(struct drgn_object_graph_iterator *it,
+			 struct drgn_type *type,
+			 struct drgn_object_graph_layout **ret)
+{
+	struct drgn_error *err;
+
+	struct hash_pair hp = drgn_object_graph_layout_map_hash(&type);
+	struct drgn_object_graph_layout_map_iterator map_it =
+		drgn_object_graph_layout_map_search_hashed(&it->layouts, &type,
+							   hp);
+	if (map_it.entry) {
+		*ret = map_it.entry->value;
+		return NULL;
+	}
+
+	struct drgn_object_graph_layout *layout = malloc(sizeof(*layout));
+	if (!layout)
+		return &drgn_enomem;
+	layout->size = drgn_type_size(type);
+	drgn_object_graph_slot_vector_init(&layout->slots);
+	struct string_builder designator = {};
+	drgn_program_lock_types(it->prog);
+	err = drgn_object_graph_add_slots(it, layout, type, 0, 0, NULL,
+					  &designator);
+	drgn_program_unlock_types(it->prog);
+	free(designator.str);
+	if (err)
+		goto err;
+	drgn_object_graph_slot_vector_shrink_to_fit(&layout->slots);
+
+	struct drgn_object_graph_layout_map_entry entry = {
+		.key = type,
+		.value = layout,
+	};
+	if (drgn_object_graph_layout_map_insert_searched(&it->layouts, &entry,
+							 hp, NULL) == -1) {
+		err = &drgn_enomem;
+		goto err;
+	}
+	*ret = layout;
+	return NULL;
+
+err:
+	drgn_object_graph_layout_destroy(layout);
+	return err;
+}
+
+/* Add an object to visit unless it has already been visited. */
+static struct drgn_error *
+drgn_object_graph_push(struct drgn_object_graph_iterator *it,
+		       uint64_t address,
+		       struct drgn_qualified_type qualified_type,
+		       size_t parent_edge, const char *designator,
+		       uint64_t depth)
+{
+	struct drgn_object_graph_key key = {
+		.address = address,
+		.type = qualified_type.type,
+	};
+	int r = drgn_object_graph_visited_set_insert(&it->visited, &key, NULL);
+	if (r == -1)
+		return &drgn_enomem;
+	else if (r == 0)
+		return NULL;
+
+	size_t edge = SIZE_MAX;
+	if (designator && it->paths) {
+		struct drgn_object_graph_edge *entry =
+			drgn_object_graph_edge_vector_append_entry(&it->edges);
+		if (!entry)
+			return &drgn_enomem;
+		entry->parent = parent_edge;
+		entry->designator = designator;
+		edge = it->edges.size - 1;
+	}
+	struct drgn_object_graph_pending *node =
+		drgn_object_graph_pending_vector_append_entry(&it->pending);
+	if (!node)
+		return &drgn_enomem;
+	node->address = address;
+	node->qualified_type = qualified_type;
+	node->depth = depth;
+	node->edge = edge;
+	return NULL;
+}
+
+/* Build the path of the current object from its edges. */
+static struct drgn_error *
+drgn_object_graph_build_path(struct drgn_object_graph_iterator *it)
+{
+	size_t len = 0;
+	for (size_t i = it->node_edge; i != SIZE_MAX;
+	     i = it->edges.data[i].parent)
+		len += 2 + strlen(it->edges.data[i].designator);
+	if (len >= it->path_capacity) {
+		size_t capacity = max(len + 1, 2 * it->path_capacity);
+		char *path = realloc(it->path, capacity);
+		if (!path)
+			return &drgn_enomem;
+		it->path = path;
+		it->path_capacity = capacity;
+	}
+	/* The edges go from the object to the root, so fill in backwards. */
+	char *p = it->path + len;
+	*p = '\0';
+	for (size_t i = it->node_edge; i != SIZE_MAX;
+	     i = it->edges.data[i].parent) {
+		size_t n = strlen(it->edges.data[i].designator);
+		p -= n;
+		memcpy(p, it->edges.data[i].designator, n);
+		p -= 2;
+		memcpy(p, "->", 2);
+	}
+	it->node.path = it->path;
+	return NULL;
+}
+
+static bool drgn_object_graph_follow(struct drgn_object_graph_iterator *it,
+				     const struct drgn_object_graph_slot *slot)
+{
+	if (it->members.size) {
+		size_t i;
+		for (i = 0; i < it->members.size; i++) {
+			if (slot->name && strcmp(slot->name,
+						 it->members.data[i]) == 0)
+				break;
+		}
+		if (i == it->members.size)
+			return false;
+	}
+	if (it->types.size) {
+		struct drgn_type *type = slot->qualified_type.type;
+		const char *tag = drgn_type_tag(type);
+		size_t i;
+		for (i = 0; i < it->types.size; i++) {
+			struct drgn_type *filter = it->types.data[i];
+			if (filter == type ||
+			    (drgn_type_kind(filter) == drgn_type_kind(type) &&
+			     tag && drgn_type_tag(filter) &&
+			     strcmp(tag, drgn_type_tag(filter)) == 0))
+				break;
+		}
+		if (i == it->types.size)
+			return false;
+	}
+	return true;
+}
+
+/* Queue the objects pointed to by the current object. */
+static struct drgn_error *
+drgn_object_graph_expand(struct drgn_object_graph_iterator *it)
+{
+	struct drgn_error *err;
+	const struct drgn_object_graph_node *node = &it->node;
+
+	struct drgn_object_graph_layout *layout;
+	err = drgn_object_graph_layout(it, node->qualified_type.type, &layout);
+	if (err || !layout->slots.size)
+		return err;
+
+	if (layout->size > it->buf_capacity) {
+		void *buf = malloc64(layout->size);
+		if (!buf)
+			return &drgn_enomem;
+		free(it->buf);
+		it->buf = buf;
+		it->buf_capacity = layout->size;
+	}
+	err = drgn_memory_reader_read(&it->prog->reader, it->buf,
+				      node->address, layout->size, false);
+	if (err) {
+		/* Visit the object, but don't follow a bad pointer further. */
+		if (err->code == DRGN_ERROR_FAULT) {
+			drgn_error_destroy(err);
+			err = NULL;
+		}
+		return err;
+	}
+
+	/*
+	 * Depth-first traversals take from the end, so push in reverse to visit
+	 * members in order.
+	 */
+	for (size_t j = 0; j < layout->slots.size; j++) {
+		size_t i = it->depth_first ? layout->slots.size - 1 - j : j;
+		const struct drgn_object_graph_slot *slot =
+			&layout->slots.data[i];
+		const char *p = (const char *)it->buf + slot->offset;
+		uint64_t address;
+		if (slot->size == 8) {
+			uint64_t value;
+			memcpy(&value, p, sizeof(value));
+			address = slot->bswap ? bswap_64(value) : value;
+		} else {
+			uint32_t value;
+			memcpy(&value, p, sizeof(value));
+			address = slot->bswap ? bswap_32(value) : value;
+		}
+		if (!address || !drgn_object_graph_follow(it, slot))
+			continue;
+		err = drgn_object_graph_push(it, address, slot->qualified_type,
+					     it->node_edge, slot->designator,
+					     node->depth + 1);
+		if (err)
+			return err;
+	}
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_object_graph_iterator_create(const struct drgn_object *root,
+				  uint64_t max_depth,
+				  enum drgn_object_graph_flags flags,
+				  struct drgn_object_graph_iterator **ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_object_program(root);
+
+	if (flags & ~(DRGN_OBJECT_GRAPH_DEPTH_FIRST |
+		      DRGN_OBJECT_GRAPH_NO_PATHS)) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "invalid object graph flags");
+	}
+
+	struct drgn_type *underlying_type = drgn_underlying_type(root->type);
+	uint64_t address;
+	struct drgn_qualified_type qualified_type;
+	if (drgn_type_kind(underlying_type) == DRGN_TYPE_POINTER) {
+		err = drgn_object_read_unsigned(root, &address);
+		if (err)
+			return err;
+		qualified_type = drgn_type_type(underlying_type);
+	} else if (root->kind == DRGN_OBJECT_REFERENCE && !root->bit_offset) {
+		address = root->address;
+		qualified_type = drgn_object_qualified_type(root);
+	} else {
+		return drgn_qualified_type_error("object graph root must be a pointer or reference, not '%s'",
+						 drgn_object_qualified_type(root));
+	}
+	struct drgn_qualified_type complete_type = qualified_type;
+	err = drgn_object_graph_complete_type(prog, &complete_type);
+	if (err)
+		return err;
+	if (!complete_type.type) {
+		return drgn_qualified_type_error("object graph root must be a complete structure, union, or class, not '%s'",
+						 qualified_type);
+	}
+
+	struct drgn_object_graph_iterator *it = calloc(1, sizeof(*it));
+	if (!it)
+		return &drgn_enomem;
+	it->prog = prog;
+	it->max_depth = max_depth;
+	it->depth_first = flags & DRGN_OBJECT_GRAPH_DEPTH_FIRST;
+	it->paths = !(flags & DRGN_OBJECT_GRAPH_NO_PATHS);
+	drgn_object_graph_layout_map_init(&it->layouts);
+	drgn_object_graph_visited_set_init(&it->visited);
+	drgn_object_graph_pending_vector_init(&it->pending);
+	drgn_object_graph_edge_vector_init(&it->edges);
+	drgn_object_graph_type_vector_init(&it->types);
+	drgn_object_graph_name_vector_init(&it->members);
+	if (address) {
+		err = drgn_object_graph_push(it, address, complete_type,
+					     SIZE_MAX, NULL, 0);
+		if (err) {
+			drgn_object_graph_iterator_destroy(it);
+			return err;
+		}
+	}
+	*ret = it;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC void
+drgn_object_graph_iterator_destroy(struct drgn_object_graph_iterator *it)
+{
+	if (!it)
+		return;
+	free(it->buf);
+	free(it->path);
+	for (size_t i = 0; i < it->members.size; i++)
+		free(it->members.data[i]);
+	drgn_object_graph_name_vector_deinit(&it->members);
+	drgn_object_graph_type_vector_deinit(&it->types);
+	drgn_object_graph_edge_vector_deinit(&it->edges);
+	drgn_object_graph_pending_vector_deinit(&it->pending);
+	drgn_object_graph_visited_set_deinit(&it->visited);
+	for (struct drgn_object_graph_layout_map_iterator map_it =
+	     drgn_object_graph_layout_map_first(&it->layouts);
+	     map_it.entry;
+	     map_it = drgn_object_graph_layout_map_next(map_it))
+		drgn_object_graph_layout_destroy(map_it.entry->value);
+	drgn_object_graph_layout_map_deinit(&it->layouts);
+	free(it);
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_object_graph_iterator_add_type(struct drgn_object_graph_iterator *it,
+				    struct drgn_type *type)
+{
+	if (drgn_type_program(type) != it->prog) {
+		return drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					 "type is from different program");
+	}
+	type = drgn_underlying_type(type);
+	if (!drgn_object_graph_type_vector_append(&it->types, &type))
+		return &drgn_enomem;
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_object_graph_iterator_add_member(struct drgn_object_graph_iterator *it,
+				      const char *name)
+{
+	char *copy = strdup(name);
+	if (!copy)
+		return &drgn_enomem;
+	if (!drgn_object_graph_name_vector_append(&it->members, &copy)) {
+		free(copy);
+		return &drgn_enomem;
+	}
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_object_graph_iterator_next(struct drgn_object_graph_iterator *it,
+				const struct drgn_object_graph_node **ret)
+{
+	struct drgn_error *err;
+
+	if (it->pending_head == it->pending.size) {
+		*ret = NULL;
+		return NULL;
+	}
+	struct drgn_object_graph_pending pending;
+	if (it->depth_first) {
+		pending = *drgn_object_graph_pending_vector_pop(&it->pending);
+	} else {
+		pending = it->pending.data[it->pending_head++];
+		if (it->pending_head == it->pending.size) {
+			it->pending_head = it->pending.size = 0;
+		} else if (it->pending_head >= 1024 &&
+			   it->pending_head >= it->pending.size / 2) {
+			/* Reclaim the space of visited objects. */
+			memmove(it->pending.data,
+				&it->pending.data[it->pending_head],
+				(it->pending.size - it->pending_head) *
+				sizeof(it->pending.data[0]));
+			it->pending.size -= it->pending_head;
+			it->pending_head = 0;
+		}
+	}
+	it->node.address = pending.address;
+	it->node.qualified_type = pending.qualified_type;
+	it->node.depth = pending.depth;
+	it->node_edge = pending.edge;
+	if (it->paths) {
+		err = drgn_object_graph_build_path(it);
+		if (err)
+			return err;
+	} else {
+		it->node.path = NULL;
+	}
+	if (it->node.depth < it->max_depth) {
+		err = drgn_object_graph_expand(it);
+		if (err)
+			return err;
+	}
+	*ret = &it->node;
+	return NULL;
+}
@@ -21,10 +21,24 @@ struct pgtable_iterator {
 	uint64_t pgtable;
 	/* Current virtual address to translate. */
 	uint64_t virt_addr;
+	/*
+	 * Bitmask of @ref pgtable_flags for the range most recently returned by
+	 * @ref pgtable_iterator_next_fn, or 0 if it is not mapped.
+	 */
+	unsigned int flags;
 	/* Architecture-specific data. */
 	char arch[0];
 };
 
+/* Attributes of a mapped range returned by a page table iterator. */
+enum pgtable_flags {
+	PGTABLE_WRITABLE = 1 << 0,
+	PGTABLE_USER = 1 << 1,
+	PGTABLE_EXECUTABLE = 1 << 2,
+	/* Mapped by a page table entry above the lowest level. */
+	PGTABLE_HUGE = 1 << 3,
+};
+
 /*
  * Translate the current virtual address from a page table iterator.
  *
@@ -32,8 +46,10 @@ struct pgtable_iterator {
  * space. A range may be a mapped page, a page table gap, or a range of invalid
  * addresses (e.g., non-canonical addresses on x86-64). This finds the range
  * containing the current virtual address, returns the first virtual address of
- * that range and the physical address it maps to (if any), and updates the
- * current virtual address to the end of the range.
+ * that range and the physical address it maps to (if any), sets the flags of
+ * the range, and updates the current virtual address to the end of the range.
+ * The permission flags are the effective permissions, i.e., they include the
+ * restrictions of every level of the page table.
  *
  * This does not merge contiguous ranges. For example, if two adjacent mapped
  * pages have adjacent physical addresses, this returns each page separately.
@@ -19,6 +19,8 @@
 #include "debug_info.h"
 #include "dwarf_index.h"
 #include "error.h"
+#include "expression.h"
+#include "helpers.h"
 #include "language.h"
 #include "linux_kernel.h"
 #include "memory_reader.h"
@@ -56,6 +58,19 @@ drgn_program_language(struct drgn_program *prog)
 	return prog->lang ? prog->lang : &drgn_default_language;
 }
 
+LIBDRGN_PUBLIC bool
+drgn_program_dedupe_compound_types(struct drgn_program *prog)
+{
+	return prog->dedupe_compound_types;
+}
+
+LIBDRGN_PUBLIC void
+drgn_program_set_dedupe_compound_types(struct drgn_program *prog,
+				       bool enabled)
+{
+	prog->dedupe_compound_types = enabled;
+}
+
 void drgn_program_set_platform(struct drgn_program *prog,
 			       const struct drgn_platform *platform)
 {
@@ -70,8 +85,19 @@ void drgn_program_init(struct drgn_program *prog,
 {
 	memset(prog, 0, sizeof(*prog));
 	drgn_memory_reader_init(&prog->reader);
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&prog->types_lock, &attr);
+	pthread_mutex_init(&prog->dwfl_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+	pthread_mutex_init(&prog->prstatus_lock, NULL);
+#ifdef WITH_LIBKDUMPFILE
+	pthread_mutex_init(&prog->kdump_lock, NULL);
+#endif
 	drgn_program_init_types(prog);
 	drgn_object_index_init(&prog->oindex);
+	drgn_program_init_expressions(prog);
 	prog->core_fd = -1;
 	if (platform)
 		drgn_program_set_platform(prog, platform);
@@ -81,6 +107,8 @@ void drgn_program_init(struct drgn_program *prog,
 
 void drgn_program_deinit(struct drgn_program *prog)
 {
+	drgn_program_stop_prefetch(prog);
+
 	if (prog->prstatus_cached) {
 		if (prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL)
 			drgn_prstatus_vector_deinit(&prog->prstatus_vector);
@@ -88,10 +116,20 @@ void drgn_program_deinit(struct drgn_program *prog)
 			drgn_prstatus_map_deinit(&prog->prstatus_map);
 	}
 	free(prog->pgtable_it);
+	free(prog->per_cpu_offsets);
+	if (prog->d_path_cache) {
+		linux_helper_d_path_cache_deinit(prog->d_path_cache);
+		free(prog->d_path_cache);
+	}
+	if (prog->slab_allocator) {
+		linux_helper_slab_allocator_deinit(prog->slab_allocator);
+		free(prog->slab_allocator);
+	}
 
 	drgn_object_deinit(&prog->vmemmap);
 	drgn_object_deinit(&prog->page_offset);
 
+	drgn_program_deinit_expressions(prog);
 	drgn_object_index_deinit(&prog->oindex);
 	drgn_program_deinit_types(prog);
 	drgn_memory_reader_deinit(&prog->reader);
@@ -101,12 +139,16 @@ void drgn_program_deinit(struct drgn_program *prog)
 #ifdef WITH_LIBKDUMPFILE
 	if (prog->kdump_ctx)
 		kdump_free(prog->kdump_ctx);
+	pthread_mutex_destroy(&prog->kdump_lock);
 #endif
 	elf_end(prog->core);
 	if (prog->core_fd != -1)
 		close(prog->core_fd);
 
 	drgn_debug_info_destroy(prog->_dbinfo);
+	pthread_mutex_destroy(&prog->prstatus_lock);
+	pthread_mutex_destroy(&prog->dwfl_lock);
+	pthread_mutex_destroy(&prog->types_lock);
 }
 
 LIBDRGN_PUBLIC struct drgn_error *
@@ -144,7 +186,11 @@ LIBDRGN_PUBLIC struct drgn_error *
 drgn_program_add_object_finder(struct drgn_program *prog,
 			       drgn_object_find_fn fn, void *arg)
 {
-	return drgn_object_index_add_finder(&prog->oindex, fn, arg);
+	struct drgn_error *err = drgn_object_index_add_finder(&prog->oindex,
+							      fn, arg);
+	if (!err)
+		drgn_program_clear_expressions(prog);
+	return err;
 }
 
 static struct drgn_error *
@@ -631,7 +677,15 @@ drgn_program_load_debug_info(struct drgn_program *prog, const char **paths,
 	if (err)
 		return err;
 
+	drgn_program_stop_prefetch(prog);
+	/*
+	 * Finding and reading files only needs to exclude other users of
+	 * libdwfl. drgn_debug_info_load() takes the types lock itself while it
+	 * updates the index.
+	 */
+	drgn_program_lock_dwfl(prog);
 	err = drgn_debug_info_load(dbinfo, paths, n, load_default, load_main);
+	drgn_program_lock_types(prog);
 	if ((!err || err->code == DRGN_ERROR_MISSING_DEBUG_INFO)) {
 		if (!prog->lang &&
 		    !(prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL))
@@ -641,9 +695,248 @@ drgn_program_load_debug_info(struct drgn_program *prog, const char **paths,
 				      drgn_set_platform_from_dwarf, prog, 0);
 		}
 	}
+	drgn_program_clear_expressions(prog);
+	drgn_program_unlock_types(prog);
+	drgn_program_unlock_dwfl(prog);
+	return err;
+}
+
+static const char * const drgn_linux_kernel_prefetch_types[] = {
+	"struct cred",
+	"struct dentry",
+	"struct file",
+	"struct files_struct",
+	"struct hlist_head",
+	"struct hlist_node",
+	"struct inode",
+	"struct kmem_cache",
+	"struct list_head",
+	"struct mm_struct",
+	"struct module",
+	"struct mount",
+	"struct page",
+	"struct pid",
+	"struct rb_node",
+	"struct rb_root",
+	"struct super_block",
+	"struct task_struct",
+	"struct vm_area_struct",
+};
+
+static const char * const drgn_linux_kernel_prefetch_objects[] = {
+	"init_pid_ns",
+	"init_task",
+	"modules",
+	"slab_caches",
+	"super_blocks",
+};
+
+struct drgn_prefetch {
+	struct drgn_program *prog;
+	pthread_t thread;
+	/* Set by drgn_program_stop_prefetch(); accessed atomically. */
+	bool cancel;
+	char **type_names;
+	size_t num_type_names;
+	char **object_names;
+	size_t num_object_names;
+};
+
+static void drgn_prefetch_destroy(struct drgn_prefetch *prefetch)
+{
+	for (size_t i = 0; i < prefetch->num_object_names; i++)
+		free(prefetch->object_names[i]);
+	free(prefetch->object_names);
+	for (size_t i = 0; i < prefetch->num_type_names; i++)
+		free(prefetch->type_names[i]);
+	free(prefetch->type_names);
+	free(prefetch);
+}
+
+static struct drgn_error *copy_names(const char * const *names, size_t n,
+				     char ***ret)
+{
+	char **copy = malloc_array(n, sizeof(*copy));
+	if (!copy && n)
+		return &drgn_enomem;
+	for (size_t i = 0; i < n; i++) {
+		copy[i] = strdup(names[i]);
+		if (!copy[i]) {
+			while (i--)
+				free(copy[i]);
+			free(copy);
+			return &drgn_enomem;
+		}
+	}
+	*ret = copy;
+	return NULL;
+}
+
+static void drgn_prefetch_type(struct drgn_debug_info *dbinfo,
+			       const char *name)
+{
+	static const struct {
+		const char *keyword;
+		size_t len;
+		enum drgn_type_kind kind;
+	} keywords[] = {
+		{ "struct ", 7, DRGN_TYPE_STRUCT },
+		{ "union ", 6, DRGN_TYPE_UNION },
+		{ "class ", 6, DRGN_TYPE_CLASS },
+		{ "enum ", 5, DRGN_TYPE_ENUM },
+	};
+	enum drgn_type_kind kind = DRGN_TYPE_TYPEDEF;
+	for (size_t i = 0; i < ARRAY_SIZE(keywords); i++) {
+		if (strncmp(name, keywords[i].keyword, keywords[i].len) == 0) {
+			name += keywords[i].len;
+			kind = keywords[i].kind;
+			break;
+		}
+	}
+	struct drgn_qualified_type qualified_type;
+	drgn_error_destroy(drgn_debug_info_find_type(kind, name, strlen(name),
+						     NULL, dbinfo,
+						     &qualified_type));
+}
+
+static void drgn_prefetch_object(struct drgn_debug_info *dbinfo,
+				 const char *name)
+{
+	struct drgn_object obj;
+	drgn_object_init(&obj, dbinfo->prog);
+	drgn_error_destroy(drgn_debug_info_find_object(name, strlen(name), NULL,
+						       DRGN_FIND_OBJECT_ANY,
+						       dbinfo, &obj));
+	drgn_object_deinit(&obj);
+}
+
+static void *drgn_prefetch_thread_fn(void *arg)
+{
+	struct drgn_prefetch *prefetch = arg;
+	struct drgn_debug_info *dbinfo = prefetch->prog->_dbinfo;
+	for (size_t i = 0; i < prefetch->num_type_names; i++) {
+		if (__atomic_load_n(&prefetch->cancel, __ATOMIC_RELAXED))
+			return NULL;
+		drgn_prefetch_type(dbinfo, prefetch->type_names[i]);
+	}
+	for (size_t i = 0; i < prefetch->num_object_names; i++) {
+		if (__atomic_load_n(&prefetch->cancel, __ATOMIC_RELAXED))
+			return NULL;
+		drgn_prefetch_object(dbinfo, prefetch->object_names[i]);
+	}
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_prefetch(struct drgn_program *prog,
+		      const char * const *type_names, size_t num_type_names,
+		      const char * const *object_names, size_t num_object_names)
+{
+	struct drgn_error *err;
+
+	drgn_program_wait_prefetch(prog);
+	if (!prog->_dbinfo)
+		return NULL;
+
+	if (prog->flags & DRGN_PROGRAM_IS_LINUX_KERNEL) {
+		if (!type_names) {
+			type_names = drgn_linux_kernel_prefetch_types;
+			num_type_names =
+				ARRAY_SIZE(drgn_linux_kernel_prefetch_types);
+		}
+		if (!object_names) {
+			object_names = drgn_linux_kernel_prefetch_objects;
+			num_object_names =
+				ARRAY_SIZE(drgn_linux_kernel_prefetch_objects);
+		}
+	}
+	if (!type_names)
+		num_type_names = 0;
+	if (!object_names)
+		num_object_names = 0;
+	if (!num_type_names && !num_object_names)
+		return NULL;
+
+	struct drgn_prefetch *prefetch = calloc(1, sizeof(*prefetch));
+	if (!prefetch)
+		return &drgn_enomem;
+	prefetch->prog = prog;
+	err = copy_names(type_names, num_type_names, &prefetch->type_names);
+	if (err)
+		goto err;
+	prefetch->num_type_names = num_type_names;
+	err = copy_names(object_names, num_object_names,
+			 &prefetch->object_names);
+	if (err)
+		goto err;
+	prefetch->num_object_names = num_object_names;
+
+	int r = pthread_create(&prefetch->thread, NULL, drgn_prefetch_thread_fn,
+			       prefetch);
+	if (r) {
+		err = drgn_error_create_os("pthread_create", r, NULL);
+		goto err;
+	}
+	prog->prefetch = prefetch;
+	return NULL;
+
+err:
+	drgn_prefetch_destroy(prefetch);
+	return err;
+}
+
+LIBDRGN_PUBLIC void drgn_program_wait_prefetch(struct drgn_program *prog)
+{
+	if (!prog->prefetch)
+		return;
+	pthread_join(prog->prefetch->thread, NULL);
+	drgn_prefetch_destroy(prog->prefetch);
+	prog->prefetch = NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_load_type_cache(struct drgn_program *prog, const char *path)
+{
+	struct drgn_error *err;
+	struct drgn_debug_info *dbinfo;
+	err = drgn_program_get_dbinfo(prog, &dbinfo);
+	if (err)
+		return err;
+	struct drgn_type_cache *cache;
+	err = drgn_type_cache_create(path, &cache);
+	if (err)
+		return err;
+	drgn_program_lock_types(prog);
+	drgn_type_cache_destroy(dbinfo->type_cache);
+	dbinfo->type_cache = cache;
+	drgn_program_unlock_types(prog);
+	return NULL;
+}
+
+LIBDRGN_PUBLIC struct drgn_error *
+drgn_program_save_type_cache(struct drgn_program *prog, const char *path)
+{
+	struct drgn_error *err;
+	drgn_program_lock_types(prog);
+	if (prog->_dbinfo && prog->_dbinfo->type_cache) {
+		err = drgn_type_cache_save(prog->_dbinfo->type_cache, path);
+	} else {
+		err = drgn_error_create(DRGN_ERROR_INVALID_ARGUMENT,
+					"type cache has not been loaded");
+	}
+	drgn_program_unlock_types(prog);
 	return err;
 }
 
+void drgn_program_stop_prefetch(struct drgn_program *prog)
+{
+	if (prog->prefetch) {
+		__atomic_store_n(&prog->prefetch->cancel, true,
+				 __ATOMIC_RELAXED);
+		drgn_program_wait_prefetch(prog);
+	}
+}
+
 static struct drgn_error *get_prstatus_pid(struct drgn_program *prog, const char *data,
 					   size_t size, uint32_t *ret)
 {
@@ -694,7 +987,8 @@ struct drgn_error *drgn_program_cache_prstatus_entry(struct drgn_program *prog,
 	return NULL;
 }
 
-static struct drgn_error *drgn_program_cache_prstatus(struct drgn_program *prog)
+static struct drgn_error *
+drgn_program_cache_prstatus_locked(struct drgn_program *prog)
 {
 	struct drgn_error *err;
 	size_t phnum, i;
@@ -771,11 +1065,22 @@ out:
 		else
 			drgn_prstatus_map_deinit(&prog->prstatus_map);
 	} else {
-		prog->prstatus_cached = true;
+		__atomic_store_n(&prog->prstatus_cached, true,
+				 __ATOMIC_RELEASE);
 	}
 	return err;
 }
 
+static struct drgn_error *drgn_program_cache_prstatus(struct drgn_program *prog)
+{
+	if (__atomic_load_n(&prog->prstatus_cached, __ATOMIC_ACQUIRE))
+		return NULL;
+	pthread_mutex_lock(&prog->prstatus_lock);
+	struct drgn_error *err = drgn_program_cache_prstatus_locked(prog);
+	pthread_mutex_unlock(&prog->prstatus_lock);
+	return err;
+}
+
 struct drgn_error *drgn_program_find_prstatus_by_cpu(struct drgn_program *prog,
 						     uint32_t cpu,
 						     struct string *ret,
@@ -1057,20 +1362,18 @@ bool drgn_program_find_symbol_by_address_internal(struct drgn_program *prog,
 						  Dwfl_Module *module,
 						  struct drgn_symbol *ret)
 {
-	if (!module) {
-		if (prog->_dbinfo) {
-			module = dwfl_addrmodule(prog->_dbinfo->dwfl, address);
-			if (!module)
-				return false;
-		} else {
-			return false;
-		}
-	}
-
+	/* libdwfl isn't safe to use concurrently with loading or unwinding. */
+	drgn_program_lock_dwfl(prog);
+	if (!module && prog->_dbinfo)
+		module = dwfl_addrmodule(prog->_dbinfo->dwfl, address);
 	GElf_Off offset;
 	GElf_Sym elf_sym;
-	const char *name = dwfl_module_addrinfo(module, address, &offset,
-						&elf_sym, NULL, NULL, NULL);
+	const char *name = NULL;
+	if (module) {
+		name = dwfl_module_addrinfo(module, address, &offset, &elf_sym,
+					    NULL, NULL, NULL);
+	}
+	drgn_program_unlock_dwfl(prog);
 	if (!name)
 		return false;
 	ret->name = name;
@@ -1158,9 +1461,13 @@ drgn_program_find_symbol_by_name(struct drgn_program *prog,
 		.ret = ret,
 	};
 
-	if (prog->_dbinfo &&
-	    dwfl_getmodules(prog->_dbinfo->dwfl, find_symbol_by_name_cb,
-			    &arg, 0))
+	/* libdwfl isn't safe to use concurrently with loading or unwinding. */
+	drgn_program_lock_dwfl(prog);
+	bool found = (prog->_dbinfo &&
+		      dwfl_getmodules(prog->_dbinfo->dwfl,
+				      find_symbol_by_name_cb, &arg, 0));
+	drgn_program_unlock_dwfl(prog);
+	if (found)
 		return arg.err;
 	return drgn_error_format(DRGN_ERROR_LOOKUP,
 				 "could not find symbol with name '%s'%s", name,
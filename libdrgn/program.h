@@ -14,6 +14,7 @@
 
 #include <elfutils/libdwfl.h>
 #include <libelf.h>
+#include <pthread.h>
 #include <sys/types.h>
 #ifdef WITH_LIBKDUMPFILE
 #include <libkdumpfile/kdumpfile.h>
@@ -29,7 +30,10 @@
 #include "vector.h"
 
 struct drgn_debug_info;
+struct drgn_expression;
 struct drgn_symbol;
+struct linux_helper_d_path_cache;
+struct linux_helper_slab_allocator;
 
 /**
  * @defgroup Internals Internals
@@ -63,11 +67,15 @@ struct vmcoreinfo {
 	uint64_t swapper_pg_dir;
 	/** Whether 5-level paging was enabled. */
 	bool pgtable_l5_enabled;
+	/** log2 of the size of a memory section, or 0 if not known. */
+	uint64_t section_size_bits;
 };
 
 DEFINE_VECTOR_TYPE(drgn_typep_vector, struct drgn_type *)
 DEFINE_VECTOR_TYPE(drgn_prstatus_vector, struct string)
 DEFINE_HASH_MAP_TYPE(drgn_prstatus_map, uint32_t, struct string)
+DEFINE_HASH_MAP_TYPE(drgn_expression_map, const char *,
+		     struct drgn_expression *)
 
 struct drgn_program {
 	/** @privatesection */
@@ -86,6 +94,8 @@ struct drgn_program {
 	pid_t pid;
 #ifdef WITH_LIBKDUMPFILE
 	kdump_ctx_t *kdump_ctx;
+	/* Lock serializing uses of kdump_ctx. */
+	pthread_mutex_t kdump_lock;
 #endif
 
 	/*
@@ -97,6 +107,8 @@ struct drgn_program {
 	struct drgn_type void_types[DRGN_NUM_LANGUAGES];
 	/** Cache of primitive types. */
 	struct drgn_type *primitive_types[DRGN_PRIMITIVE_TYPE_NUM];
+	/** Interned type, member, and enumerator names. */
+	struct drgn_interned_string_set interned_strings;
 	/** Cache of deduplicated types. */
 	struct drgn_dedupe_type_set dedupe_types;
 	/**
@@ -110,6 +122,8 @@ struct drgn_program {
 	 * effort to hash and compare them.
 	 */
 	struct drgn_typep_vector created_types;
+	/** See @ref drgn_program_set_dedupe_compound_types(). */
+	bool dedupe_compound_types;
 	/** Cache for @ref drgn_program_find_member(). */
 	struct drgn_member_map members;
 	/**
@@ -117,12 +131,41 @@ struct drgn_program {
 	 * drgn_program::members.
 	 */
 	struct drgn_type_set members_cached;
+	/** Cache for @ref drgn_type_value_mask(). */
+	struct drgn_type_value_mask_map value_masks;
 
 	/*
 	 * Debugging information.
 	 */
 	struct drgn_object_index oindex;
 	struct drgn_debug_info *_dbinfo;
+	/**
+	 * Lock serializing type creation, debugging information parsing, and
+	 * updates of the DWARF index with the prefetch thread (see @ref
+	 * drgn_program_prefetch()).
+	 *
+	 * This is recursive because parsing a type creates types and may parse
+	 * other types.
+	 */
+	pthread_mutex_t types_lock;
+	/**
+	 * Lock serializing uses of libdwfl: loading debugging information,
+	 * symbol lookups, and unwinding. If both locks are needed, this must
+	 * be taken before @ref drgn_program::types_lock.
+	 *
+	 * This is recursive because loading debugging information may read
+	 * objects, which may look up symbols.
+	 */
+	pthread_mutex_t dwfl_lock;
+	/** Running prefetch, or @c NULL. */
+	struct drgn_prefetch *prefetch;
+	/**
+	 * Compiled expressions for @ref drgn_program_eval(), keyed by text.
+	 * Protected by @ref drgn_program::types_lock.
+	 */
+	struct drgn_expression_map expressions;
+	/** Most and least recently used entries in @c expressions. */
+	struct drgn_expression *expressions_mru, *expressions_lru;
 
 	/*
 	 * Program information.
@@ -151,6 +194,9 @@ struct drgn_program {
 	/* See @ref drgn_object_stack_trace_next_thread(). */
 	const struct drgn_object *stack_trace_obj;
 	uint32_t stack_trace_tid;
+	/* Lock serializing caching of PRSTATUS notes. */
+	pthread_mutex_t prstatus_lock;
+	/* Set with release semantics once the PRSTATUS notes are cached. */
 	bool prstatus_cached;
 	bool attached_dwfl_state;
 
@@ -162,13 +208,22 @@ struct drgn_program {
 	struct drgn_object page_offset;
 	/* Cached vmemmap. */
 	struct drgn_object vmemmap;
-	/* Page table iterator for linux_helper_read_vm(). */
+	/*
+	 * Cached page table iterator for linux_helper_read_vm(). A thread
+	 * takes it while translating an address; threads which find it taken
+	 * allocate their own.
+	 */
 	struct pgtable_iterator *pgtable_it;
 	/*
-	 * Whether @ref drgn_program::pgtable_it is currently being used. Used
-	 * to prevent address translation from recursing.
+	 * Cached __per_cpu_offset, indexed by CPU number (see
+	 * linux_helper_per_cpu_offsets()). Filled in under the types lock.
 	 */
-	bool pgtable_it_in_use;
+	uint64_t *per_cpu_offsets;
+	uint64_t num_per_cpu_offsets;
+	/* See linux_helper_program_d_path_cache(). */
+	struct linux_helper_d_path_cache *d_path_cache;
+	/* Slab allocator state for linux_helper_slab_object_info(). */
+	struct linux_helper_slab_allocator *slab_allocator;
 };
 
 /** Initialize a @ref drgn_program. */
@@ -255,6 +310,39 @@ drgn_program_word_size(struct drgn_program *prog, uint8_t *ret)
 struct drgn_error *drgn_program_get_dbinfo(struct drgn_program *prog,
 					   struct drgn_debug_info **ret);
 
+/** Lock @ref drgn_program::types_lock. */
+static inline void drgn_program_lock_types(struct drgn_program *prog)
+{
+	pthread_mutex_lock(&prog->types_lock);
+}
+
+/** Unlock @ref drgn_program::types_lock. */
+static inline void drgn_program_unlock_types(struct drgn_program *prog)
+{
+	pthread_mutex_unlock(&prog->types_lock);
+}
+
+/** Lock @ref drgn_program::dwfl_lock. */
+static inline void drgn_program_lock_dwfl(struct drgn_program *prog)
+{
+	pthread_mutex_lock(&prog->dwfl_lock);
+}
+
+/** Unlock @ref drgn_program::dwfl_lock. */
+static inline void drgn_program_unlock_dwfl(struct drgn_program *prog)
+{
+	pthread_mutex_unlock(&prog->dwfl_lock);
+}
+
+/**
+ * Stop a prefetch started by @ref drgn_program_prefetch() without waiting for
+ * the remaining names to be resolved.
+ *
+ * This must be called before anything that modifies the debugging information
+ * that the prefetch thread reads.
+ */
+void drgn_program_stop_prefetch(struct drgn_program *prog);
+
 /**
  * Find the @c NT_PRSTATUS note for the given CPU.
  *
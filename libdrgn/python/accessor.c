@@ -0,0 +1,493 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// SPDX-License-Identifier: GPL-3.0+
+
+#include "drgnpy.h"
+#include "../type.h"
+#include "../util.h"
+
+static Accessor *accessor_compile(Program *prog,
+				  struct drgn_qualified_type qualified_type,
+				  const char *path)
+{
+	struct drgn_error *err;
+	Accessor *ret = (Accessor *)Accessor_type.tp_alloc(&Accessor_type, 0);
+	if (!ret)
+		return NULL;
+	err = drgn_program_compile_accessor(&prog->prog, qualified_type, path,
+					    &ret->accessor);
+	if (err) {
+		Py_DECREF(ret);
+		return set_drgn_error(err);
+	}
+	ret->prog = prog;
+	Py_INCREF(prog);
+	return ret;
+}
+
+Accessor *Program_accessor(Program *self, PyObject *args, PyObject *kwds)
+{
+	static char *keywords[] = {"type", "path", NULL};
+	PyObject *type_obj;
+	const char *path;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "Os:accessor", keywords,
+					 &type_obj, &path))
+		return NULL;
+
+	struct drgn_qualified_type qualified_type;
+	if (Program_type_arg(self, type_obj, false, &qualified_type) == -1)
+		return NULL;
+	return accessor_compile(self, qualified_type, path);
+}
+
+static void Accessor_dealloc(Accessor *self)
+{
+	if (self->accessor)
+		drgn_accessor_destroy(self->accessor);
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+/*
+ * Get the address that an accessor is applied to from an Object (the value of
+ * a pointer or the address of a reference) or an integer.
+ */
+static int accessor_base_arg(Program *prog, PyObject *arg, uint64_t *ret)
+{
+	struct drgn_error *err;
+	if (PyObject_TypeCheck(arg, &DrgnObject_type)) {
+		DrgnObject *obj = (DrgnObject *)arg;
+		if (DrgnObject_prog(obj) != prog) {
+			PyErr_SetString(PyExc_ValueError,
+					"object is from different program");
+			return -1;
+		}
+		if (drgn_type_kind(drgn_underlying_type(obj->obj.type)) ==
+		    DRGN_TYPE_POINTER) {
+			err = drgn_object_read_unsigned(&obj->obj, ret);
+			if (err) {
+				set_drgn_error(err);
+				return -1;
+			}
+			return 0;
+		}
+		if (obj->obj.kind != DRGN_OBJECT_REFERENCE ||
+		    obj->obj.bit_offset) {
+			PyErr_SetString(PyExc_ValueError,
+					"object is not a pointer or byte-aligned reference");
+			return -1;
+		}
+		*ret = obj->obj.address;
+		return 0;
+	}
+
+	struct index_arg base = {};
+	if (!index_converter(arg, &base))
+		return -1;
+	*ret = base.uvalue;
+	return 0;
+}
+
+/* Convert an iterable of bases to an array. */
+static uint64_t *accessor_bases_arg(Program *prog, PyObject *bases_obj,
+				    size_t *n_ret)
+{
+	PyObject *seq = PySequence_Fast(bases_obj, "bases must be iterable");
+	if (!seq)
+		return NULL;
+	size_t n = PySequence_Fast_GET_SIZE(seq);
+	uint64_t *bases = malloc_array(n ? n : 1, sizeof(*bases));
+	if (!bases) {
+		PyErr_NoMemory();
+		goto out;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (accessor_base_arg(prog, PySequence_Fast_GET_ITEM(seq, i),
+				      &bases[i]) == -1) {
+			free(bases);
+			bases = NULL;
+			goto out;
+		}
+	}
+	*n_ret = n;
+out:
+	Py_DECREF(seq);
+	return bases;
+}
+
+static DrgnObject *Accessor_apply(Accessor *self, uint64_t base)
+{
+	struct drgn_error *err;
+	DrgnObject *res = DrgnObject_alloc(self->prog);
+	if (!res)
+		return NULL;
+	bool clear = set_drgn_in_python();
+	Program_BEGIN_ALLOW_THREADS(self->prog)
+	err = drgn_accessor_apply(self->accessor, base, &res->obj);
+	Program_END_ALLOW_THREADS
+	if (clear)
+		clear_drgn_in_python();
+	if (err) {
+		Py_DECREF(res);
+		return set_drgn_error(err);
+	}
+	return res;
+}
+
+static PyObject *Accessor_value_wrap(Accessor *self, uint64_t value)
+{
+	struct drgn_qualified_type qualified_type =
+		drgn_accessor_type(self->accessor);
+	if (drgn_type_object_encoding(qualified_type.type) ==
+	    DRGN_OBJECT_ENCODING_SIGNED)
+		return PyLong_FromLongLong((int64_t)value);
+	else
+		return PyLong_FromUnsignedLongLong(value);
+}
+
+static DrgnObject *Accessor_call(Accessor *self, PyObject *args,
+				 PyObject *kwds)
+{
+	static char *keywords[] = {"base", NULL};
+	PyObject *base_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O:__call__", keywords,
+					 &base_obj))
+		return NULL;
+	uint64_t base;
+	if (accessor_base_arg(self->prog, base_obj, &base) == -1)
+		return NULL;
+	return Accessor_apply(self, base);
+}
+
+static PyObject *Accessor_read(Accessor *self, PyObject *args, PyObject *kwds)
+{
+	static char *keywords[] = {"base", NULL};
+	struct drgn_error *err;
+	PyObject *base_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O:read", keywords,
+					 &base_obj))
+		return NULL;
+	uint64_t base;
+	if (accessor_base_arg(self->prog, base_obj, &base) == -1)
+		return NULL;
+	uint64_t value;
+	bool clear = set_drgn_in_python();
+	Program_BEGIN_ALLOW_THREADS(self->prog)
+	err = drgn_accessor_read(self->accessor, &base, 1, &value);
+	Program_END_ALLOW_THREADS
+	if (clear)
+		clear_drgn_in_python();
+	if (err)
+		return set_drgn_error(err);
+	return Accessor_value_wrap(self, value);
+}
+
+static PyObject *Accessor_objects(Accessor *self, PyObject *args,
+				  PyObject *kwds)
+{
+	static char *keywords[] = {"bases", NULL};
+	PyObject *bases_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O:objects", keywords,
+					 &bases_obj))
+		return NULL;
+	size_t n;
+	uint64_t *bases = accessor_bases_arg(self->prog, bases_obj, &n);
+	if (!bases)
+		return NULL;
+	PyObject *ret = PyList_New(n);
+	if (!ret)
+		goto out;
+	for (size_t i = 0; i < n; i++) {
+		DrgnObject *obj = Accessor_apply(self, bases[i]);
+		if (!obj) {
+			Py_CLEAR(ret);
+			goto out;
+		}
+		PyList_SET_ITEM(ret, i, (PyObject *)obj);
+	}
+out:
+	free(bases);
+	return ret;
+}
+
+static PyObject *Accessor_values(Accessor *self, PyObject *args,
+				 PyObject *kwds)
+{
+	static char *keywords[] = {"bases", NULL};
+	struct drgn_error *err;
+	PyObject *bases_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O:values", keywords,
+					 &bases_obj))
+		return NULL;
+	size_t n;
+	uint64_t *bases = accessor_bases_arg(self->prog, bases_obj, &n);
+	if (!bases)
+		return NULL;
+	PyObject *ret = NULL;
+	/* The values are read in place. */
+	bool clear = set_drgn_in_python();
+	Program_BEGIN_ALLOW_THREADS(self->prog)
+	err = drgn_accessor_read(self->accessor, bases, n, bases);
+	Program_END_ALLOW_THREADS
+	if (clear)
+		clear_drgn_in_python();
+	if (err) {
+		set_drgn_error(err);
+		goto out;
+	}
+	ret = PyList_New(n);
+	if (!ret)
+		goto out;
+	for (size_t i = 0; i < n; i++) {
+		PyObject *value = Accessor_value_wrap(self, bases[i]);
+		if (!value) {
+			Py_CLEAR(ret);
+			goto out;
+		}
+		PyList_SET_ITEM(ret, i, value);
+	}
+out:
+	free(bases);
+	return ret;
+}
+
+/* Convert a column of raw results to a list of bytes. */
+static PyObject *raw_column_to_list(struct drgn_accessor *accessor,
+				    const char *buf, size_t n,
+				    uint64_t column_size)
+{
+	struct drgn_type *underlying_type =
+		drgn_underlying_type(drgn_accessor_type(accessor).type);
+	bool is_string = false;
+	if (drgn_type_kind(underlying_type) == DRGN_TYPE_ARRAY) {
+		struct drgn_type *element_type =
+			drgn_underlying_type(drgn_type_type(underlying_type).type);
+		is_string = (drgn_type_kind(element_type) == DRGN_TYPE_INT &&
+			     drgn_type_size(element_type) == 1);
+	}
+
+	PyObject *ret = PyList_New(n);
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < n; i++) {
+		const char *element = buf + i * column_size;
+		/* Character arrays are truncated at the first null byte. */
+		size_t len = (is_string ? strnlen(element, column_size) :
+			      column_size);
+		PyObject *item = PyBytes_FromStringAndSize(element, len);
+		if (!item) {
+			Py_DECREF(ret);
+			return NULL;
+		}
+		PyList_SET_ITEM(ret, i, item);
+	}
+	return ret;
+}
+
+PyObject *Program_columns(Program *self, PyObject *args, PyObject *kwds)
+{
+	static char *keywords[] = {"type", "paths", "bases", NULL};
+	struct drgn_error *err;
+	PyObject *type_obj, *paths_obj, *bases_obj;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO:columns", keywords,
+					 &type_obj, &paths_obj, &bases_obj))
+		return NULL;
+
+	struct drgn_qualified_type qualified_type;
+	if (Program_type_arg(self, type_obj, false, &qualified_type) == -1)
+		return NULL;
+
+	PyObject *paths = PySequence_Fast(paths_obj, "paths must be iterable");
+	if (!paths)
+		return NULL;
+	size_t num_columns = PySequence_Fast_GET_SIZE(paths);
+	PyObject *ret = NULL;
+	/* Accessor objects, replaced by the columns when they are created. */
+	PyObject *accessors_list = PyList_New(num_columns);
+	struct drgn_accessor **accessors =
+		malloc_array(num_columns ? num_columns : 1, sizeof(*accessors));
+	void **columns = malloc_array(num_columns ? num_columns : 1,
+				      sizeof(*columns));
+	uint64_t *column_sizes = malloc_array(num_columns ? num_columns : 1,
+					      sizeof(*column_sizes));
+	Py_buffer *views = calloc(num_columns ? num_columns : 1,
+				  sizeof(*views));
+	PyObject *result_list = PyList_New(num_columns);
+	uint64_t *bases = NULL;
+	PyObject *array_type = NULL;
+	if (!accessors_list || !result_list)
+		goto out;
+	if (!accessors || !columns || !column_sizes || !views) {
+		PyErr_NoMemory();
+		goto out;
+	}
+	for (size_t j = 0; j < num_columns; j++) {
+		PyObject *path = PySequence_Fast_GET_ITEM(paths, j);
+		Accessor *accessor;
+		if (PyObject_TypeCheck(path, &Accessor_type)) {
+			accessor = (Accessor *)path;
+			if (accessor->prog != self) {
+				PyErr_SetString(PyExc_ValueError,
+						"accessor is from different program");
+				goto out;
+			}
+			Py_INCREF(accessor);
+		} else if (PyUnicode_Check(path)) {
+			const char *path_str = PyUnicode_AsUTF8(path);
+			if (!path_str)
+				goto out;
+			accessor = accessor_compile(self, qualified_type,
+						    path_str);
+			if (!accessor)
+				goto out;
+		} else {
+			PyErr_SetString(PyExc_TypeError,
+					"path must be str or Accessor");
+			goto out;
+		}
+		PyList_SET_ITEM(accessors_list, j, (PyObject *)accessor);
+		accessors[j] = accessor->accessor;
+		err = drgn_accessor_column_size(accessors[j], &column_sizes[j]);
+		if (err) {
+			set_drgn_error(err);
+			goto out;
+		}
+	}
+
+	size_t n;
+	bases = accessor_bases_arg(self, bases_obj, &n);
+	if (!bases)
+		goto out;
+
+	for (size_t j = 0; j < num_columns; j++) {
+		enum drgn_object_encoding encoding =
+			drgn_type_object_encoding(drgn_accessor_type(accessors[j]).type);
+		PyObject *column;
+		if (encoding == DRGN_OBJECT_ENCODING_SIGNED ||
+		    encoding == DRGN_OBJECT_ENCODING_UNSIGNED) {
+			if (!array_type) {
+				PyObject *array_module =
+					PyImport_ImportModule("array");
+				if (!array_module)
+					goto out;
+				array_type = PyObject_GetAttrString(array_module,
+								    "array");
+				Py_DECREF(array_module);
+				if (!array_type)
+					goto out;
+			}
+			/* Allocate the array without creating n ints. */
+			PyObject *zero = PyObject_CallFunction(array_type,
+							       "s[i]",
+							       encoding == DRGN_OBJECT_ENCODING_SIGNED ?
+							       "q" : "Q",
+							       0);
+			if (!zero)
+				goto out;
+			column = PySequence_Repeat(zero, n);
+			Py_DECREF(zero);
+			if (!column)
+				goto out;
+			PyList_SET_ITEM(result_list, j, column);
+			if (PyObject_GetBuffer(column, &views[j],
+					       PyBUF_WRITABLE) == -1)
+				goto out;
+			columns[j] = views[j].buf;
+		} else {
+			/*
+			 * The raw results are read into a temporary bytes
+			 * object which is split into a list afterwards.
+			 */
+			uint64_t size;
+			if (__builtin_mul_overflow(column_sizes[j], n, &size) ||
+			    size > PY_SSIZE_T_MAX) {
+				PyErr_NoMemory();
+				goto out;
+			}
+			column = PyBytes_FromStringAndSize(NULL, size);
+			if (!column)
+				goto out;
+			PyList_SET_ITEM(result_list, j, column);
+			columns[j] = PyBytes_AS_STRING(column);
+		}
+	}
+
+	bool clear = set_drgn_in_python();
+	Program_BEGIN_ALLOW_THREADS(self)
+	err = drgn_program_read_columns(&self->prog, accessors, num_columns,
+					bases, n, columns);
+	Program_END_ALLOW_THREADS
+	if (clear)
+		clear_drgn_in_python();
+	if (err) {
+		set_drgn_error(err);
+		goto out;
+	}
+
+	for (size_t j = 0; j < num_columns; j++) {
+		PyObject *column = PyList_GET_ITEM(result_list, j);
+		if (!PyBytes_Check(column))
+			continue;
+		PyObject *list = raw_column_to_list(accessors[j],
+						    PyBytes_AS_STRING(column),
+						    n, column_sizes[j]);
+		if (!list)
+			goto out;
+		PyList_SetItem(result_list, j, list);
+	}
+	ret = result_list;
+	result_list = NULL;
+out:
+	for (size_t j = 0; views && j < num_columns; j++) {
+		if (views[j].obj)
+			PyBuffer_Release(&views[j]);
+	}
+	Py_XDECREF(array_type);
+	free(bases);
+	free(views);
+	free(column_sizes);
+	free(columns);
+	free(accessors);
+	Py_XDECREF(result_list);
+	Py_XDECREF(accessors_list);
+	Py_DECREF(paths);
+	return ret;
+}
+
+static PyObject *Accessor_get_type(Accessor *self, void *arg)
+{
+	return DrgnType_wrap(drgn_accessor_type(self->accessor));
+}
+
+static PyObject *Accessor_get_prog(Accessor *self, void *arg)
+{
+	Py_INCREF(self->prog);
+	return (PyObject *)self->prog;
+}
+
+static PyMethodDef Accessor_methods[] = {
+	{"read", (PyCFunction)Accessor_read, METH_VARARGS | METH_KEYWORDS,
+	 drgn_Accessor_read_DOC},
+	{"objects", (PyCFunction)Accessor_objects,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Accessor_objects_DOC},
+	{"values", (PyCFunction)Accessor_values, METH_VARARGS | METH_KEYWORDS,
+	 drgn_Accessor_values_DOC},
+	{},
+};
+
+static PyGetSetDef Accessor_getset[] = {
+	{"prog_", (getter)Accessor_get_prog, NULL, drgn_Accessor_prog__DOC},
+	{"type_", (getter)Accessor_get_type, NULL, drgn_Accessor_type__DOC},
+	{},
+};
+
+PyTypeObject Accessor_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn.Accessor",
+	.tp_basicsize = sizeof(Accessor),
+	.tp_dealloc = (destructor)Accessor_dealloc,
+	.tp_call = (ternaryfunc)Accessor_call,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_doc = drgn_Accessor_DOC,
+	.tp_methods = Accessor_methods,
+	.tp_getset = Accessor_getset,
+};
@@ -95,8 +95,69 @@ typedef struct {
 	 * lifetime of the Program.
 	 */
 	struct pyobjectp_set objects;
+	/*
+	 * Whether any memory segment, finder, or lazy object calls back into
+	 * Python. If so, libdrgn may need the GIL while holding its own locks,
+	 * so we must not release the GIL around calls into libdrgn.
+	 */
+	bool python_callbacks;
 } Program;
 
+/*
+ * Release the GIL around a call into libdrgn which may block (e.g., to read
+ * memory) unless the program calls back into Python.
+ */
+#define Program_BEGIN_ALLOW_THREADS(prog) {				\
+	PyThreadState *_save = NULL;					\
+	if (!(prog)->python_callbacks)					\
+		_save = PyEval_SaveThread();
+#define Program_END_ALLOW_THREADS					\
+	if (_save)							\
+		PyEval_RestoreThread(_save);				\
+}
+
+/*
+ * Mark an iterator which releases the GIL in tp_iternext as executing. Like a
+ * generator, it may not be advanced again until the current next() returns.
+ * Returns -1 with ValueError set if it is already executing.
+ */
+static inline int iterator_begin_next(bool *running)
+{
+	if (*running) {
+		PyErr_SetString(PyExc_ValueError, "iterator already executing");
+		return -1;
+	}
+	*running = true;
+	return 0;
+}
+
+static inline void iterator_end_next(bool *running)
+{
+	*running = false;
+}
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct drgn_accessor *accessor;
+} Accessor;
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct drgn_object_graph_iterator *it;
+	bool running;
+} ObjectGraphIterator;
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct drgn_indexed_names *names;
+	size_t index;
+	/* Whether to yield (name, Object) tuples instead of Types. */
+	bool objects;
+} IndexedNamesIterator;
+
 typedef struct {
 	PyObject_HEAD
 	const struct drgn_register *reg;
@@ -162,10 +223,22 @@ extern PyObject *PrimitiveType_class;
 extern PyObject *ProgramFlags_class;
 extern PyObject *Qualifiers_class;
 extern PyObject *TypeKind_class;
+extern PyTypeObject Accessor_type;
 extern PyTypeObject DrgnObject_type;
 extern PyTypeObject DrgnType_type;
 extern PyTypeObject FaultError_type;
+extern PyTypeObject IndexedNamesIterator_type;
 extern PyTypeObject Language_type;
+extern PyTypeObject LinuxHelperFileInventoryIterator_type;
+extern PyTypeObject LinuxHelperListIterator_type;
+extern PyTypeObject LinuxHelperPageIterator_type;
+extern PyTypeObject LinuxHelperPgtableRangeIterator_type;
+extern PyTypeObject LinuxHelperPidIterator_type;
+extern PyTypeObject LinuxHelperRadixTreeIterator_type;
+extern PyTypeObject LinuxHelperRbtreeIterator_type;
+extern PyTypeObject LinuxHelperSlabObjectIterator_type;
+extern PyTypeObject LinuxHelperVmaIterator_type;
+extern PyTypeObject ObjectGraphIterator_type;
 extern PyTypeObject ObjectIterator_type;
 extern PyTypeObject Platform_type;
 extern PyTypeObject Program_type;
@@ -212,13 +285,19 @@ static inline Program *DrgnObject_prog(DrgnObject *obj)
 PyObject *DrgnObject_NULL(PyObject *self, PyObject *args, PyObject *kwds);
 DrgnObject *cast(PyObject *self, PyObject *args, PyObject *kwds);
 DrgnObject *reinterpret(PyObject *self, PyObject *args, PyObject *kwds);
+PyObject *memcmp_(PyObject *self, PyObject *args, PyObject *kwds);
 DrgnObject *DrgnObject_container_of(PyObject *self, PyObject *args,
 				    PyObject *kwds);
 
+ObjectGraphIterator *object_graph(PyObject *self, PyObject *args,
+				  PyObject *kwds);
+
 PyObject *Platform_wrap(const struct drgn_platform *platform);
 
 int Program_hold_object(Program *prog, PyObject *obj);
 bool Program_hold_reserve(Program *prog, size_t n);
+Accessor *Program_accessor(Program *self, PyObject *args, PyObject *kwds);
+PyObject *Program_columns(Program *self, PyObject *args, PyObject *kwds);
 int Program_type_arg(Program *prog, PyObject *type_obj, bool can_be_none,
 		     struct drgn_qualified_type *ret);
 Program *program_from_core_dump(PyObject *self, PyObject *args, PyObject *kwds);
@@ -287,9 +366,16 @@ int enum_converter(PyObject *o, void *p);
 
 PyObject *drgnpy_linux_helper_read_vm(PyObject *self, PyObject *args,
 				      PyObject *kwds);
+PyObject *drgnpy_linux_helper_pgtable_ranges(PyObject *self, PyObject *args,
+					     PyObject *kwds);
+PyObject *drgnpy_linux_helper_write_vm(PyObject *self, PyObject *args,
+				       PyObject *kwds);
 DrgnObject *drgnpy_linux_helper_radix_tree_lookup(PyObject *self,
 						  PyObject *args,
 						  PyObject *kwds);
+PyObject *drgnpy_linux_helper_radix_tree_for_each(PyObject *self,
+						  PyObject *args,
+						  PyObject *kwds);
 DrgnObject *drgnpy_linux_helper_idr_find(PyObject *self, PyObject *args,
 					 PyObject *kwds);
 DrgnObject *drgnpy_linux_helper_find_pid(PyObject *self, PyObject *args,
@@ -304,5 +390,46 @@ PyObject *drgnpy_linux_helper_kaslr_offset(PyObject *self, PyObject *args,
 					   PyObject *kwds);
 PyObject *drgnpy_linux_helper_pgtable_l5_enabled(PyObject *self, PyObject *args,
 						 PyObject *kwds);
+PyObject *drgnpy_linux_helper_for_each_pid(PyObject *self, PyObject *args,
+					    PyObject *kwds);
+PyObject *drgnpy_linux_helper_for_each_task(PyObject *self, PyObject *args,
+					     PyObject *kwds);
+PyObject *drgnpy_linux_helper_page_stats(PyObject *self, PyObject *args,
+					  PyObject *kwds);
+PyObject *drgnpy_linux_helper_for_each_page(PyObject *self, PyObject *args,
+					     PyObject *kwds);
+PyObject *drgnpy_linux_helper_slab_for_each_object(PyObject *self,
+						   PyObject *args,
+						   PyObject *kwds);
+PyObject *drgnpy_linux_helper_slab_object_info(PyObject *self,
+					       PyObject *args,
+					       PyObject *kwds);
+DrgnObject *drgnpy_linux_helper_per_cpu_ptr(PyObject *self, PyObject *args,
+					    PyObject *kwds);
+PyObject *drgnpy_linux_helper_per_cpu_values(PyObject *self, PyObject *args,
+					     PyObject *kwds);
+PyObject *drgnpy_linux_helper_per_cpu_sum(PyObject *self, PyObject *args,
+					  PyObject *kwds);
+PyObject *drgnpy_linux_helper_percpu_counter_sum(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds);
+PyObject *drgnpy_linux_helper_d_path(PyObject *self, PyObject *args,
+				     PyObject *kwds);
+PyObject *drgnpy_linux_helper_dentry_path(PyObject *self, PyObject *args,
+					  PyObject *kwds);
+PyObject *drgnpy_linux_helper_for_each_open_file(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds);
+PyObject *drgnpy_linux_helper_for_each_vma(PyObject *self, PyObject *args,
+					    PyObject *kwds);
+PyObject *drgnpy_linux_helper_list_for_each_entry(PyObject *self,
+						  PyObject *args,
+						  PyObject *kwds);
+PyObject *drgnpy_linux_helper_hlist_for_each_entry(PyObject *self,
+						   PyObject *args,
+						   PyObject *kwds);
+PyObject *drgnpy_linux_helper_rbtree_inorder_for_each_entry(PyObject *self,
+							    PyObject *args,
+							    PyObject *kwds);
 
 #endif /* DRGNPY_H */
@@ -2,7 +2,9 @@
 // SPDX-License-Identifier: GPL-3.0+
 
 #include "drgnpy.h"
+#include "../error.h"
 #include "../helpers.h"
+#include "../platform.h"
 #include "../program.h"
 
 PyObject *drgnpy_linux_helper_read_vm(PyObject *self, PyObject *args,
@@ -38,6 +40,130 @@ PyObject *drgnpy_linux_helper_read_vm(PyObject *self, PyObject *args,
 	return buf;
 }
 
+PyObject *drgnpy_linux_helper_write_vm(PyObject *self, PyObject *args,
+				       PyObject *kwds)
+{
+	static char *keywords[] = {
+		"prog", "pgtable", "address", "size", "fd", "offset", NULL,
+	};
+	struct drgn_error *err;
+	Program *prog;
+	struct index_arg pgtable = {};
+	struct index_arg address = {};
+	struct index_arg size = {};
+	int fd;
+	struct index_arg offset = {};
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O&O&O&iO&:write_vm",
+					 keywords, &Program_type, &prog,
+					 index_converter, &pgtable,
+					 index_converter, &address,
+					 index_converter, &size, &fd,
+					 index_converter, &offset))
+		return NULL;
+
+	uint64_t written;
+	Program_BEGIN_ALLOW_THREADS(prog);
+	err = linux_helper_write_vm(&prog->prog, pgtable.uvalue,
+				    address.uvalue, size.uvalue, fd,
+				    offset.uvalue, &written);
+	Program_END_ALLOW_THREADS;
+	if (err)
+		return set_drgn_error(err);
+	return PyLong_FromUnsignedLongLong(written);
+}
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_pgtable_range_iterator it;
+	bool running;
+} LinuxHelperPgtableRangeIterator;
+
+PyObject *drgnpy_linux_helper_pgtable_ranges(PyObject *self, PyObject *args,
+					     PyObject *kwds)
+{
+	static char *keywords[] = {"prog", "pgtable", "start", "end", NULL};
+	struct drgn_error *err;
+	Program *prog;
+	struct index_arg pgtable = {};
+	struct index_arg start = {};
+	struct index_arg end = { .allow_none = true, .is_none = true };
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "O!O&|O&O&:pgtable_ranges", keywords,
+					 &Program_type, &prog,
+					 index_converter, &pgtable,
+					 index_converter, &start,
+					 index_converter, &end))
+		return NULL;
+
+	LinuxHelperPgtableRangeIterator *it =
+		(LinuxHelperPgtableRangeIterator *)LinuxHelperPgtableRangeIterator_type.tp_alloc(&LinuxHelperPgtableRangeIterator_type,
+												 0);
+	if (!it)
+		return NULL;
+	err = linux_helper_pgtable_range_iterator_init(&it->it, &prog->prog,
+						       pgtable.uvalue,
+						       start.uvalue,
+						       end.is_none ?
+						       UINT64_MAX :
+						       end.uvalue - 1);
+	if (err) {
+		Py_DECREF(it);
+		return set_drgn_error(err);
+	}
+	/* end == 0 can't be represented as an inclusive last address. */
+	if (!end.is_none && end.uvalue <= start.uvalue)
+		it->it.done = true;
+	/* Only set prog once it is initialized so that dealloc can check. */
+	it->prog = prog;
+	Py_INCREF(it->prog);
+	return (PyObject *)it;
+}
+
+static void
+LinuxHelperPgtableRangeIterator_dealloc(LinuxHelperPgtableRangeIterator *self)
+{
+	if (self->prog) {
+		linux_helper_pgtable_range_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+LinuxHelperPgtableRangeIterator_next(LinuxHelperPgtableRangeIterator *self)
+{
+	struct drgn_error *err;
+	const struct linux_helper_pgtable_range *range;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = linux_helper_pgtable_range_iterator_next(&self->it, &range);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	if (err == &drgn_stop)
+		return NULL;
+	if (err)
+		return set_drgn_error(err);
+	return Py_BuildValue("KKKNNNN", (unsigned long long)range->start,
+			     (unsigned long long)range->size,
+			     (unsigned long long)range->phys_addr,
+			     PyBool_FromLong(range->flags & PGTABLE_WRITABLE),
+			     PyBool_FromLong(range->flags & PGTABLE_USER),
+			     PyBool_FromLong(range->flags & PGTABLE_EXECUTABLE),
+			     PyBool_FromLong(range->flags & PGTABLE_HUGE));
+}
+
+PyTypeObject LinuxHelperPgtableRangeIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperPgtableRangeIterator",
+	.tp_basicsize = sizeof(LinuxHelperPgtableRangeIterator),
+	.tp_dealloc = (destructor)LinuxHelperPgtableRangeIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperPgtableRangeIterator_next,
+};
+
 DrgnObject *drgnpy_linux_helper_radix_tree_lookup(PyObject *self,
 						  PyObject *args,
 						  PyObject *kwds)
@@ -249,3 +375,1082 @@ PyObject *drgnpy_linux_helper_pgtable_l5_enabled(PyObject *self, PyObject *args,
 		return PyErr_Format(PyExc_ValueError, "not Linux kernel");
 	Py_RETURN_BOOL(prog->prog.vmcoreinfo.pgtable_l5_enabled);
 }
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_list_iterator it;
+	bool running;
+} LinuxHelperListIterator;
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_rbtree_iterator it;
+	bool running;
+} LinuxHelperRbtreeIterator;
+
+struct entry_args {
+	DrgnObject *head;
+	struct drgn_qualified_type entry_type;
+	const char *member;
+	uint64_t max_length;
+	bool validate;
+};
+
+/* Parse the (type, head, member) arguments common to the iterators. */
+static int entry_args_init(struct entry_args *args, PyObject *type_obj,
+			   DrgnObject *head, const char *member,
+			   struct index_arg *max_length, int validate)
+{
+	args->head = head;
+	if (Program_type_arg(DrgnObject_prog(head), type_obj, true,
+			     &args->entry_type))
+		return -1;
+	if (args->entry_type.type && !member) {
+		PyErr_SetString(PyExc_TypeError,
+				"member must be given with type");
+		return -1;
+	}
+	args->member = member;
+	args->max_length =
+		max_length->is_none ? UINT64_MAX : max_length->uvalue;
+	args->validate = validate;
+	return 0;
+}
+
+static PyObject *
+linux_helper_list_iterator_wrap(struct entry_args *args, bool hlist,
+				bool reverse)
+{
+	struct drgn_error *err;
+	LinuxHelperListIterator *it =
+		(LinuxHelperListIterator *)LinuxHelperListIterator_type.tp_alloc(&LinuxHelperListIterator_type,
+										 0);
+	if (!it)
+		return NULL;
+	it->prog = DrgnObject_prog(args->head);
+	Py_INCREF(it->prog);
+	if (hlist) {
+		err = linux_helper_hlist_iterator_init(&it->it,
+						       &args->head->obj,
+						       args->entry_type,
+						       args->member,
+						       args->max_length,
+						       args->validate);
+	} else {
+		err = linux_helper_list_iterator_init(&it->it,
+						      &args->head->obj,
+						      args->entry_type,
+						      args->member, reverse,
+						      args->max_length,
+						      args->validate);
+	}
+	if (err) {
+		Py_DECREF(it);
+		return set_drgn_error(err);
+	}
+	return (PyObject *)it;
+}
+
+PyObject *drgnpy_linux_helper_list_for_each_entry(PyObject *self,
+						  PyObject *args,
+						  PyObject *kwds)
+{
+	static char *keywords[] = {
+		"type", "head", "member", "reverse", "max_length", "validate",
+		NULL,
+	};
+	PyObject *type_obj;
+	DrgnObject *head;
+	const char *member;
+	int reverse = 0;
+	struct index_arg max_length = { .allow_none = true, .is_none = true };
+	int validate = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "OO!z|$pO&p:list_for_each_entry",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &head, &member, &reverse,
+					 index_converter, &max_length,
+					 &validate))
+		return NULL;
+
+	struct entry_args entry_args;
+	if (entry_args_init(&entry_args, type_obj, head, member, &max_length,
+			    validate))
+		return NULL;
+	return linux_helper_list_iterator_wrap(&entry_args, false, reverse);
+}
+
+PyObject *drgnpy_linux_helper_hlist_for_each_entry(PyObject *self,
+						   PyObject *args,
+						   PyObject *kwds)
+{
+	static char *keywords[] = {
+		"type", "head", "member", "max_length", "validate", NULL,
+	};
+	PyObject *type_obj;
+	DrgnObject *head;
+	const char *member;
+	struct index_arg max_length = { .allow_none = true, .is_none = true };
+	int validate = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "OO!z|$O&p:hlist_for_each_entry",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &head, &member, index_converter,
+					 &max_length, &validate))
+		return NULL;
+
+	struct entry_args entry_args;
+	if (entry_args_init(&entry_args, type_obj, head, member, &max_length,
+			    validate))
+		return NULL;
+	return linux_helper_list_iterator_wrap(&entry_args, true, false);
+}
+
+PyObject *drgnpy_linux_helper_rbtree_inorder_for_each_entry(PyObject *self,
+							    PyObject *args,
+							    PyObject *kwds)
+{
+	static char *keywords[] = {
+		"type", "root", "member", "max_length", "validate", NULL,
+	};
+	struct drgn_error *err;
+	PyObject *type_obj;
+	DrgnObject *root;
+	const char *member;
+	struct index_arg max_length = { .allow_none = true, .is_none = true };
+	int validate = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "OO!z|$O&p:rbtree_inorder_for_each_entry",
+					 keywords, &type_obj, &DrgnObject_type,
+					 &root, &member, index_converter,
+					 &max_length, &validate))
+		return NULL;
+
+	struct entry_args entry_args;
+	if (entry_args_init(&entry_args, type_obj, root, member, &max_length,
+			    validate))
+		return NULL;
+
+	LinuxHelperRbtreeIterator *it =
+		(LinuxHelperRbtreeIterator *)LinuxHelperRbtreeIterator_type.tp_alloc(&LinuxHelperRbtreeIterator_type,
+										     0);
+	if (!it)
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(DrgnObject_prog(root));
+	err = linux_helper_rbtree_iterator_init(&it->it, &root->obj,
+						entry_args.entry_type,
+						entry_args.member,
+						entry_args.max_length,
+						entry_args.validate);
+	Program_END_ALLOW_THREADS;
+	if (err) {
+		Py_DECREF(it);
+		return set_drgn_error(err);
+	}
+	/* Only set prog once it is initialized so that dealloc can check. */
+	it->prog = DrgnObject_prog(root);
+	Py_INCREF(it->prog);
+	return (PyObject *)it;
+}
+
+static DrgnObject *linux_helper_entry_object(Program *prog,
+					     struct drgn_qualified_type type,
+					     struct drgn_error *err,
+					     uint64_t address)
+{
+	if (err == &drgn_stop)
+		return NULL;
+	if (err)
+		return set_drgn_error(err);
+	DrgnObject *res = DrgnObject_alloc(prog);
+	if (!res)
+		return NULL;
+	err = drgn_object_set_unsigned(&res->obj, type, address, 0);
+	if (err) {
+		Py_DECREF(res);
+		return set_drgn_error(err);
+	}
+	return res;
+}
+
+static void LinuxHelperListIterator_dealloc(LinuxHelperListIterator *self)
+{
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static DrgnObject *LinuxHelperListIterator_next(LinuxHelperListIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t address;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = linux_helper_list_iterator_next(&self->it, &address);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	return linux_helper_entry_object(self->prog, self->it.entry_type, err,
+					 address);
+}
+
+PyTypeObject LinuxHelperListIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperListIterator",
+	.tp_basicsize = sizeof(LinuxHelperListIterator),
+	.tp_dealloc = (destructor)LinuxHelperListIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperListIterator_next,
+};
+
+static void LinuxHelperRbtreeIterator_dealloc(LinuxHelperRbtreeIterator *self)
+{
+	if (self->prog) {
+		linux_helper_rbtree_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static DrgnObject *
+LinuxHelperRbtreeIterator_next(LinuxHelperRbtreeIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t address;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = linux_helper_rbtree_iterator_next(&self->it, &address);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	return linux_helper_entry_object(self->prog, self->it.entry_type, err,
+					 address);
+}
+
+PyTypeObject LinuxHelperRbtreeIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperRbtreeIterator",
+	.tp_basicsize = sizeof(LinuxHelperRbtreeIterator),
+	.tp_dealloc = (destructor)LinuxHelperRbtreeIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperRbtreeIterator_next,
+};
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_radix_tree_iterator it;
+	bool running;
+} LinuxHelperRadixTreeIterator;
+
+PyObject *drgnpy_linux_helper_radix_tree_for_each(PyObject *self,
+						  PyObject *args,
+						  PyObject *kwds)
+{
+	static char *keywords[] = {"root", NULL};
+	struct drgn_error *err;
+	DrgnObject *root;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!:radix_tree_for_each",
+					 keywords, &DrgnObject_type, &root))
+		return NULL;
+
+	LinuxHelperRadixTreeIterator *it =
+		(LinuxHelperRadixTreeIterator *)LinuxHelperRadixTreeIterator_type.tp_alloc(&LinuxHelperRadixTreeIterator_type,
+											   0);
+	if (!it)
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(DrgnObject_prog(root));
+	err = linux_helper_radix_tree_iterator_init(&it->it, &root->obj);
+	Program_END_ALLOW_THREADS;
+	if (err) {
+		Py_DECREF(it);
+		return set_drgn_error(err);
+	}
+	/* Only set prog once it is initialized so that dealloc can check. */
+	it->prog = DrgnObject_prog(root);
+	Py_INCREF(it->prog);
+	return (PyObject *)it;
+}
+
+static void
+LinuxHelperRadixTreeIterator_dealloc(LinuxHelperRadixTreeIterator *self)
+{
+	if (self->prog) {
+		linux_helper_radix_tree_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+LinuxHelperRadixTreeIterator_next(LinuxHelperRadixTreeIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t index, entry;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = linux_helper_radix_tree_iterator_next(&self->it, &index, &entry);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	DrgnObject *entry_obj = linux_helper_entry_object(self->prog,
+							  self->it.entry_type,
+							  err, entry);
+	if (!entry_obj)
+		return NULL;
+	return Py_BuildValue("KN", (unsigned long long)index, entry_obj);
+}
+
+PyTypeObject LinuxHelperRadixTreeIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperRadixTreeIterator",
+	.tp_basicsize = sizeof(LinuxHelperRadixTreeIterator),
+	.tp_dealloc = (destructor)LinuxHelperRadixTreeIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperRadixTreeIterator_next,
+};
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_pid_iterator it;
+	bool running;
+} LinuxHelperPidIterator;
+
+static PyObject *linux_helper_pid_iterator_wrap(PyObject *args, PyObject *kwds,
+						const char *format, bool tasks)
+{
+	static char *keywords[] = {"prog_or_ns", NULL};
+	struct drgn_error *err;
+	struct prog_or_ns_arg prog_or_ns;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, format, keywords,
+					 &prog_or_pid_ns_converter,
+					 &prog_or_ns))
+		return NULL;
+
+	LinuxHelperPidIterator *it =
+		(LinuxHelperPidIterator *)LinuxHelperPidIterator_type.tp_alloc(&LinuxHelperPidIterator_type,
+									       0);
+	if (!it)
+		goto out;
+	Program_BEGIN_ALLOW_THREADS(prog_or_ns.prog);
+	err = linux_helper_pid_iterator_init(&it->it, prog_or_ns.ns, tasks);
+	Program_END_ALLOW_THREADS;
+	if (err) {
+		Py_DECREF(it);
+		set_drgn_error(err);
+		it = NULL;
+		goto out;
+	}
+	/* Only set prog once it is initialized so that dealloc can check. */
+	it->prog = prog_or_ns.prog;
+	Py_INCREF(it->prog);
+out:
+	prog_or_ns_cleanup(&prog_or_ns);
+	return (PyObject *)it;
+}
+
+PyObject *drgnpy_linux_helper_for_each_pid(PyObject *self, PyObject *args,
+					    PyObject *kwds)
+{
+	return linux_helper_pid_iterator_wrap(args, kwds, "O&:for_each_pid",
+					      false);
+}
+
+PyObject *drgnpy_linux_helper_for_each_task(PyObject *self, PyObject *args,
+					     PyObject *kwds)
+{
+	return linux_helper_pid_iterator_wrap(args, kwds, "O&:for_each_task",
+					      true);
+}
+
+static void LinuxHelperPidIterator_dealloc(LinuxHelperPidIterator *self)
+{
+	if (self->prog) {
+		linux_helper_pid_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static DrgnObject *LinuxHelperPidIterator_next(LinuxHelperPidIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t address;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = linux_helper_pid_iterator_next(&self->it, &address);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	return linux_helper_entry_object(self->prog, self->it.entry_type, err,
+					 address);
+}
+
+PyTypeObject LinuxHelperPidIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperPidIterator",
+	.tp_basicsize = sizeof(LinuxHelperPidIterator),
+	.tp_dealloc = (destructor)LinuxHelperPidIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperPidIterator_next,
+};
+
+static PyObject *u64_tuple(const uint64_t *values, size_t n)
+{
+	PyObject *ret = PyTuple_New(n);
+	if (!ret)
+		return NULL;
+	for (size_t i = 0; i < n; i++) {
+		PyObject *item = PyLong_FromUnsignedLongLong(values[i]);
+		if (!item) {
+			Py_DECREF(ret);
+			return NULL;
+		}
+		PyTuple_SET_ITEM(ret, i, item);
+	}
+	return ret;
+}
+
+PyObject *drgnpy_linux_helper_page_stats(PyObject *self, PyObject *args,
+					  PyObject *kwds)
+{
+	static char *keywords[] = {"prog", "start_pfn", "end_pfn", NULL};
+	struct drgn_error *err;
+	Program *prog;
+	struct index_arg start_pfn = {};
+	struct index_arg end_pfn = { .allow_none = true, .is_none = true };
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|O&O&:page_stats",
+					 keywords, &Program_type, &prog,
+					 index_converter, &start_pfn,
+					 index_converter, &end_pfn))
+		return NULL;
+
+	struct linux_helper_page_stats stats;
+	Program_BEGIN_ALLOW_THREADS(prog);
+	err = linux_helper_page_stats(&prog->prog, start_pfn.uvalue,
+				      end_pfn.is_none ?
+				      UINT64_MAX : end_pfn.uvalue, &stats);
+	Program_END_ALLOW_THREADS;
+	if (err)
+		return set_drgn_error(err);
+	return Py_BuildValue("KNN", (unsigned long long)stats.pages,
+			     u64_tuple(stats.flags, ARRAY_SIZE(stats.flags)),
+			     u64_tuple(stats.mapping,
+				       ARRAY_SIZE(stats.mapping)));
+}
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_page_iterator it;
+	bool running;
+} LinuxHelperPageIterator;
+
+PyObject *drgnpy_linux_helper_for_each_page(PyObject *self, PyObject *args,
+					     PyObject *kwds)
+{
+	static char *keywords[] = {
+		"prog", "start_pfn", "end_pfn", "flags_mask", "flags_value",
+		NULL,
+	};
+	struct drgn_error *err;
+	Program *prog;
+	struct index_arg start_pfn = {};
+	struct index_arg end_pfn = { .allow_none = true, .is_none = true };
+	struct index_arg flags_mask = {};
+	struct index_arg flags_value = {};
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "O!|O&O&$O&O&:for_each_page",
+					 keywords, &Program_type, &prog,
+					 index_converter, &start_pfn,
+					 index_converter, &end_pfn,
+					 index_converter, &flags_mask,
+					 index_converter, &flags_value))
+		return NULL;
+
+	LinuxHelperPageIterator *it =
+		(LinuxHelperPageIterator *)LinuxHelperPageIterator_type.tp_alloc(&LinuxHelperPageIterator_type,
+										 0);
+	if (!it)
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(prog);
+	err = linux_helper_page_iterator_init(&it->it, &prog->prog,
+					      start_pfn.uvalue,
+					      end_pfn.is_none ?
+					      UINT64_MAX : end_pfn.uvalue,
+					      flags_mask.uvalue,
+					      flags_value.uvalue);
+	Program_END_ALLOW_THREADS;
+	if (err) {
+		Py_DECREF(it);
+		return set_drgn_error(err);
+	}
+	/* Only set prog once it is initialized so that dealloc can check. */
+	it->prog = prog;
+	Py_INCREF(it->prog);
+	return (PyObject *)it;
+}
+
+static void LinuxHelperPageIterator_dealloc(LinuxHelperPageIterator *self)
+{
+	if (self->prog) {
+		linux_helper_page_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static DrgnObject *LinuxHelperPageIterator_next(LinuxHelperPageIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t address;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = linux_helper_page_iterator_next(&self->it, &address);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	return linux_helper_entry_object(self->prog, self->it.entry_type, err,
+					 address);
+}
+
+PyTypeObject LinuxHelperPageIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperPageIterator",
+	.tp_basicsize = sizeof(LinuxHelperPageIterator),
+	.tp_dealloc = (destructor)LinuxHelperPageIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperPageIterator_next,
+};
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_slab_object_iterator it;
+	bool running;
+} LinuxHelperSlabObjectIterator;
+
+PyObject *drgnpy_linux_helper_slab_for_each_object(PyObject *self,
+						   PyObject *args,
+						   PyObject *kwds)
+{
+	static char *keywords[] = {
+		"prog", "cache", "allocated", "free", NULL,
+	};
+	struct drgn_error *err;
+	Program *prog;
+	struct index_arg cache = { .allow_none = true, .is_none = true };
+	int allocated = 1, free = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "O!|O&$pp:slab_for_each_object",
+					 keywords, &Program_type, &prog,
+					 index_converter, &cache, &allocated,
+					 &free))
+		return NULL;
+
+	LinuxHelperSlabObjectIterator *it =
+		(LinuxHelperSlabObjectIterator *)LinuxHelperSlabObjectIterator_type.tp_alloc(&LinuxHelperSlabObjectIterator_type,
+											     0);
+	if (!it)
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(prog);
+	err = linux_helper_slab_object_iterator_init(&it->it, &prog->prog,
+						     cache.is_none ?
+						     0 : cache.uvalue,
+						     allocated, free);
+	Program_END_ALLOW_THREADS;
+	if (err) {
+		Py_DECREF(it);
+		return set_drgn_error(err);
+	}
+	/* Only set prog once it is initialized so that dealloc can check. */
+	it->prog = prog;
+	Py_INCREF(it->prog);
+	return (PyObject *)it;
+}
+
+static void
+LinuxHelperSlabObjectIterator_dealloc(LinuxHelperSlabObjectIterator *self)
+{
+	if (self->prog) {
+		linux_helper_slab_object_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+LinuxHelperSlabObjectIterator_next(LinuxHelperSlabObjectIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t cache, address;
+	bool allocated;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = linux_helper_slab_object_iterator_next(&self->it, &cache,
+						     &address, &allocated);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	if (err == &drgn_stop)
+		return NULL;
+	if (err)
+		return set_drgn_error(err);
+	return Py_BuildValue("KKO", (unsigned long long)cache,
+			     (unsigned long long)address,
+			     allocated ? Py_True : Py_False);
+}
+
+PyTypeObject LinuxHelperSlabObjectIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperSlabObjectIterator",
+	.tp_basicsize = sizeof(LinuxHelperSlabObjectIterator),
+	.tp_dealloc = (destructor)LinuxHelperSlabObjectIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperSlabObjectIterator_next,
+};
+
+PyObject *drgnpy_linux_helper_slab_object_info(PyObject *self,
+					       PyObject *args,
+					       PyObject *kwds)
+{
+	static char *keywords[] = {"prog", "address", NULL};
+	struct drgn_error *err;
+	Program *prog;
+	struct index_arg address = {};
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O&:slab_object_info",
+					 keywords, &Program_type, &prog,
+					 index_converter, &address))
+		return NULL;
+
+	struct linux_helper_slab_object_info info;
+	bool found;
+	Program_BEGIN_ALLOW_THREADS(prog);
+	err = linux_helper_slab_object_info(&prog->prog, address.uvalue,
+					    &info, &found);
+	Program_END_ALLOW_THREADS;
+	if (err)
+		return set_drgn_error(err);
+	if (!found)
+		Py_RETURN_NONE;
+	return Py_BuildValue("KKKO", (unsigned long long)info.cache,
+			     (unsigned long long)info.slab,
+			     (unsigned long long)info.address,
+			     info.allocated ? Py_True : Py_False);
+}
+
+DrgnObject *drgnpy_linux_helper_per_cpu_ptr(PyObject *self, PyObject *args,
+					    PyObject *kwds)
+{
+	static char *keywords[] = {"ptr", "cpu", NULL};
+	struct drgn_error *err;
+	DrgnObject *ptr;
+	struct index_arg cpu = {};
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O&:per_cpu_ptr",
+					 keywords, &DrgnObject_type, &ptr,
+					 index_converter, &cpu))
+		return NULL;
+
+	DrgnObject *res = DrgnObject_alloc(DrgnObject_prog(ptr));
+	if (!res)
+		return NULL;
+	err = linux_helper_per_cpu_ptr(&res->obj, &ptr->obj, cpu.uvalue);
+	if (err) {
+		Py_DECREF(res);
+		return set_drgn_error(err);
+	}
+	return res;
+}
+
+PyObject *drgnpy_linux_helper_per_cpu_values(PyObject *self, PyObject *args,
+					     PyObject *kwds)
+{
+	static char *keywords[] = {"ptr", "member", "online", NULL};
+	struct drgn_error *err;
+	DrgnObject *ptr;
+	const char *member = NULL;
+	int online = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|z$p:per_cpu_values",
+					 keywords, &DrgnObject_type, &ptr,
+					 &member, &online))
+		return NULL;
+
+	struct linux_helper_per_cpu_values values;
+	Program *prog = DrgnObject_prog(ptr);
+	Program_BEGIN_ALLOW_THREADS(prog);
+	err = linux_helper_per_cpu_read(&ptr->obj, member, online, &values);
+	Program_END_ALLOW_THREADS;
+	if (err)
+		return set_drgn_error(err);
+
+	PyObject *ret = PyDict_New();
+	if (!ret)
+		goto out;
+	for (size_t i = 0; i < values.num; i++) {
+		DrgnObject *value = DrgnObject_alloc(prog);
+		if (!value)
+			goto err;
+		err = drgn_object_set_from_buffer(&value->obj,
+						  values.qualified_type,
+						  &values.buf[i * values.size],
+						  values.size,
+						  values.bit_offset,
+						  values.bit_field_size);
+		if (err) {
+			Py_DECREF(value);
+			set_drgn_error(err);
+			goto err;
+		}
+		PyObject *cpu = PyLong_FromUnsignedLongLong(values.cpus[i]);
+		if (!cpu) {
+			Py_DECREF(value);
+			goto err;
+		}
+		int r = PyDict_SetItem(ret, cpu, (PyObject *)value);
+		Py_DECREF(cpu);
+		Py_DECREF(value);
+		if (r)
+			goto err;
+	}
+out:
+	linux_helper_per_cpu_values_deinit(&values);
+	return ret;
+
+err:
+	Py_CLEAR(ret);
+	goto out;
+}
+
+PyObject *drgnpy_linux_helper_per_cpu_sum(PyObject *self, PyObject *args,
+					  PyObject *kwds)
+{
+	static char *keywords[] = {"ptr", "member", "online", NULL};
+	struct drgn_error *err;
+	DrgnObject *ptr;
+	const char *member = NULL;
+	int online = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|z$p:per_cpu_sum",
+					 keywords, &DrgnObject_type, &ptr,
+					 &member, &online))
+		return NULL;
+
+	bool is_signed;
+	uint64_t sum;
+	Program_BEGIN_ALLOW_THREADS(DrgnObject_prog(ptr));
+	err = linux_helper_per_cpu_sum(&ptr->obj, member, online, &is_signed,
+				       &sum);
+	Program_END_ALLOW_THREADS;
+	if (err)
+		return set_drgn_error(err);
+	if (is_signed)
+		return PyLong_FromLongLong((int64_t)sum);
+	else
+		return PyLong_FromUnsignedLongLong(sum);
+}
+
+PyObject *drgnpy_linux_helper_percpu_counter_sum(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds)
+{
+	static char *keywords[] = {"fbc", NULL};
+	struct drgn_error *err;
+	DrgnObject *fbc;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!:percpu_counter_sum",
+					 keywords, &DrgnObject_type, &fbc))
+		return NULL;
+
+	int64_t sum;
+	Program_BEGIN_ALLOW_THREADS(DrgnObject_prog(fbc));
+	err = linux_helper_percpu_counter_sum(&fbc->obj, &sum);
+	Program_END_ALLOW_THREADS;
+	if (err)
+		return set_drgn_error(err);
+	return PyLong_FromLongLong(sum);
+}
+
+static int d_path_arg(DrgnObject *obj, const char *name, uint64_t *ret)
+{
+	struct drgn_type *underlying_type =
+		drgn_underlying_type(obj->obj.type);
+	if (drgn_type_kind(underlying_type) != DRGN_TYPE_POINTER) {
+		PyErr_Format(PyExc_TypeError, "%s must be a pointer", name);
+		return -1;
+	}
+	struct drgn_error *err = drgn_object_read_unsigned(&obj->obj, ret);
+	if (err) {
+		set_drgn_error(err);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Get the d_path() of a mount and dentry, or the dentry_path() of a dentry if
+ * vfsmnt is 0.
+ */
+static PyObject *d_path_common(Program *prog, uint64_t vfsmnt, uint64_t dentry)
+{
+	struct drgn_error *err;
+	/*
+	 * The dcache of a live kernel can change between calls, so only
+	 * remember paths for the duration of this call.
+	 */
+	struct linux_helper_d_path_cache live_cache, *cache = &live_cache;
+	bool deinit_cache = false;
+	const char *path;
+	size_t len;
+	Program_BEGIN_ALLOW_THREADS(prog);
+	if (prog->prog.flags & DRGN_PROGRAM_IS_LIVE) {
+		err = linux_helper_d_path_cache_init(cache, &prog->prog);
+		deinit_cache = !err;
+	} else {
+		err = linux_helper_program_d_path_cache(&prog->prog, &cache);
+	}
+	if (!err && vfsmnt) {
+		err = linux_helper_d_path(cache, vfsmnt, dentry, &path, &len);
+	} else if (!err) {
+		err = linux_helper_dentry_path(cache, dentry, &path, &len);
+	}
+	Program_END_ALLOW_THREADS;
+	PyObject *ret;
+	if (err)
+		ret = set_drgn_error(err);
+	else
+		ret = PyBytes_FromStringAndSize(path, len);
+	if (deinit_cache)
+		linux_helper_d_path_cache_deinit(cache);
+	return ret;
+}
+
+PyObject *drgnpy_linux_helper_d_path(PyObject *self, PyObject *args,
+				     PyObject *kwds)
+{
+	static char *keywords[] = {"vfsmnt", "dentry", NULL};
+	DrgnObject *vfsmnt, *dentry;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O!:d_path", keywords,
+					 &DrgnObject_type, &vfsmnt,
+					 &DrgnObject_type, &dentry))
+		return NULL;
+	Program *prog = DrgnObject_prog(vfsmnt);
+	if (DrgnObject_prog(dentry) != prog) {
+		PyErr_SetString(PyExc_ValueError,
+				"objects are from different programs");
+		return NULL;
+	}
+	uint64_t vfsmnt_value, dentry_value;
+	if (d_path_arg(vfsmnt, "vfsmnt", &vfsmnt_value) ||
+	    d_path_arg(dentry, "dentry", &dentry_value))
+		return NULL;
+	if (!vfsmnt_value) {
+		PyErr_SetString(PyExc_ValueError, "vfsmnt is NULL");
+		return NULL;
+	}
+	return d_path_common(prog, vfsmnt_value, dentry_value);
+}
+
+PyObject *drgnpy_linux_helper_dentry_path(PyObject *self, PyObject *args,
+					  PyObject *kwds)
+{
+	static char *keywords[] = {"dentry", NULL};
+	DrgnObject *dentry;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!:dentry_path",
+					 keywords, &DrgnObject_type, &dentry))
+		return NULL;
+	uint64_t dentry_value;
+	if (d_path_arg(dentry, "dentry", &dentry_value))
+		return NULL;
+	return d_path_common(DrgnObject_prog(dentry), 0, dentry_value);
+}
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_file_inventory_iterator it;
+	bool running;
+} LinuxHelperFileInventoryIterator;
+
+PyObject *drgnpy_linux_helper_for_each_open_file(PyObject *self,
+						 PyObject *args,
+						 PyObject *kwds)
+{
+	static char *keywords[] = {"prog", "fds", "mappings", NULL};
+	struct drgn_error *err;
+	Program *prog;
+	int fds = 1, mappings = 1;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds,
+					 "O!|$pp:for_each_open_file", keywords,
+					 &Program_type, &prog, &fds,
+					 &mappings))
+		return NULL;
+
+	LinuxHelperFileInventoryIterator *it =
+		(LinuxHelperFileInventoryIterator *)LinuxHelperFileInventoryIterator_type.tp_alloc(&LinuxHelperFileInventoryIterator_type,
+												   0);
+	if (!it)
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(prog);
+	err = linux_helper_file_inventory_iterator_init(&it->it, &prog->prog,
+							fds, mappings);
+	Program_END_ALLOW_THREADS;
+	if (err) {
+		Py_DECREF(it);
+		return set_drgn_error(err);
+	}
+	/* Only set prog once it is initialized so that dealloc can check. */
+	it->prog = prog;
+	Py_INCREF(it->prog);
+	return (PyObject *)it;
+}
+
+static void
+LinuxHelperFileInventoryIterator_dealloc(LinuxHelperFileInventoryIterator *self)
+{
+	if (self->prog) {
+		linux_helper_file_inventory_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+LinuxHelperFileInventoryIterator_next(LinuxHelperFileInventoryIterator *self)
+{
+	struct drgn_error *err;
+	const struct linux_helper_file_inventory_entry *entry;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = linux_helper_file_inventory_iterator_next(&self->it, &entry);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	if (err == &drgn_stop)
+		return NULL;
+	if (err)
+		return set_drgn_error(err);
+	if (entry->kind == LINUX_HELPER_FILE_INVENTORY_FD) {
+		return Py_BuildValue("iyKKKy#", (int)entry->pid, entry->comm,
+				     (unsigned long long)entry->task,
+				     (unsigned long long)entry->fd,
+				     (unsigned long long)entry->file,
+				     entry->path, (Py_ssize_t)entry->path_len);
+	}
+	PyObject *path;
+	if (entry->path) {
+		path = PyBytes_FromStringAndSize(entry->path, entry->path_len);
+		if (!path)
+			return NULL;
+	} else {
+		path = Py_None;
+		Py_INCREF(path);
+	}
+	return Py_BuildValue("iyKKKKKKKN", (int)entry->pid, entry->comm,
+			     (unsigned long long)entry->task,
+			     (unsigned long long)entry->vma,
+			     (unsigned long long)entry->start,
+			     (unsigned long long)entry->end,
+			     (unsigned long long)entry->flags,
+			     (unsigned long long)entry->pgoff,
+			     (unsigned long long)entry->file, path);
+}
+
+PyTypeObject LinuxHelperFileInventoryIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperFileInventoryIterator",
+	.tp_basicsize = sizeof(LinuxHelperFileInventoryIterator),
+	.tp_dealloc = (destructor)LinuxHelperFileInventoryIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperFileInventoryIterator_next,
+};
+
+typedef struct {
+	PyObject_HEAD
+	Program *prog;
+	struct linux_helper_vma_iterator it;
+	/* <tt>struct vm_area_struct *</tt>. */
+	struct drgn_qualified_type entry_type;
+	bool running;
+} LinuxHelperVmaIterator;
+
+PyObject *drgnpy_linux_helper_for_each_vma(PyObject *self, PyObject *args,
+					    PyObject *kwds)
+{
+	static char *keywords[] = {"mm", NULL};
+	struct drgn_error *err;
+	DrgnObject *mm;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!:for_each_vma",
+					 keywords, &DrgnObject_type, &mm))
+		return NULL;
+
+	LinuxHelperVmaIterator *it =
+		(LinuxHelperVmaIterator *)LinuxHelperVmaIterator_type.tp_alloc(&LinuxHelperVmaIterator_type,
+									       0);
+	if (!it)
+		return NULL;
+	Program *prog = DrgnObject_prog(mm);
+	Program_BEGIN_ALLOW_THREADS(prog);
+	uint64_t mm_address;
+	err = drgn_object_read_unsigned(&mm->obj, &mm_address);
+	if (!err) {
+		err = drgn_program_find_type(&prog->prog,
+					     "struct vm_area_struct *", NULL,
+					     &it->entry_type);
+	}
+	if (!err)
+		err = linux_helper_vma_iterator_init(&it->it, &prog->prog);
+	if (!err) {
+		err = linux_helper_vma_iterator_start(&it->it, mm_address);
+		if (err)
+			linux_helper_vma_iterator_deinit(&it->it);
+	}
+	Program_END_ALLOW_THREADS;
+	if (err) {
+		Py_DECREF(it);
+		return set_drgn_error(err);
+	}
+	/* Only set prog once it is initialized so that dealloc can check. */
+	it->prog = prog;
+	Py_INCREF(it->prog);
+	return (PyObject *)it;
+}
+
+static void LinuxHelperVmaIterator_dealloc(LinuxHelperVmaIterator *self)
+{
+	if (self->prog) {
+		linux_helper_vma_iterator_deinit(&self->it);
+		Py_DECREF(self->prog);
+	}
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static DrgnObject *LinuxHelperVmaIterator_next(LinuxHelperVmaIterator *self)
+{
+	struct drgn_error *err;
+	uint64_t address;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = linux_helper_vma_iterator_next(&self->it, &address);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	return linux_helper_entry_object(self->prog, self->entry_type, err,
+					 address);
+}
+
+PyTypeObject LinuxHelperVmaIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._LinuxHelperVmaIterator",
+	.tp_basicsize = sizeof(LinuxHelperVmaIterator),
+	.tp_dealloc = (destructor)LinuxHelperVmaIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)LinuxHelperVmaIterator_next,
+};
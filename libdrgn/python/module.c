@@ -113,8 +113,12 @@ static PyMethodDef drgn_methods[] = {
 	 drgn_cast_DOC},
 	{"reinterpret", (PyCFunction)reinterpret, METH_VARARGS | METH_KEYWORDS,
 	 drgn_reinterpret_DOC},
+	{"memcmp", (PyCFunction)memcmp_, METH_VARARGS | METH_KEYWORDS,
+	 drgn_memcmp_DOC},
 	{"container_of", (PyCFunction)DrgnObject_container_of,
 	 METH_VARARGS | METH_KEYWORDS, drgn_container_of_DOC},
+	{"object_graph", (PyCFunction)object_graph,
+	 METH_VARARGS | METH_KEYWORDS, drgn_object_graph_DOC},
 	{"program_from_core_dump", (PyCFunction)program_from_core_dump,
 	 METH_VARARGS | METH_KEYWORDS, drgn_program_from_core_dump_DOC},
 	{"program_from_kernel", (PyCFunction)program_from_kernel,
@@ -123,9 +127,17 @@ static PyMethodDef drgn_methods[] = {
 	 METH_VARARGS | METH_KEYWORDS, drgn_program_from_pid_DOC},
 	{"_linux_helper_read_vm", (PyCFunction)drgnpy_linux_helper_read_vm,
 	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_pgtable_ranges",
+	 (PyCFunction)drgnpy_linux_helper_pgtable_ranges,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_write_vm", (PyCFunction)drgnpy_linux_helper_write_vm,
+	 METH_VARARGS | METH_KEYWORDS},
 	{"_linux_helper_radix_tree_lookup",
 	 (PyCFunction)drgnpy_linux_helper_radix_tree_lookup,
 	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_radix_tree_for_each",
+	 (PyCFunction)drgnpy_linux_helper_radix_tree_for_each,
+	 METH_VARARGS | METH_KEYWORDS},
 	{"_linux_helper_idr_find", (PyCFunction)drgnpy_linux_helper_idr_find,
 	 METH_VARARGS | METH_KEYWORDS},
 	{"_linux_helper_find_pid", (PyCFunction)drgnpy_linux_helper_find_pid,
@@ -134,6 +146,56 @@ static PyMethodDef drgn_methods[] = {
 	 METH_VARARGS | METH_KEYWORDS},
 	{"_linux_helper_find_task", (PyCFunction)drgnpy_linux_helper_find_task,
 	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_for_each_pid",
+	 (PyCFunction)drgnpy_linux_helper_for_each_pid,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_for_each_task",
+	 (PyCFunction)drgnpy_linux_helper_for_each_task,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_list_for_each_entry",
+	 (PyCFunction)drgnpy_linux_helper_list_for_each_entry,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_hlist_for_each_entry",
+	 (PyCFunction)drgnpy_linux_helper_hlist_for_each_entry,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_rbtree_inorder_for_each_entry",
+	 (PyCFunction)drgnpy_linux_helper_rbtree_inorder_for_each_entry,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_page_stats",
+	 (PyCFunction)drgnpy_linux_helper_page_stats,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_for_each_page",
+	 (PyCFunction)drgnpy_linux_helper_for_each_page,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_slab_for_each_object",
+	 (PyCFunction)drgnpy_linux_helper_slab_for_each_object,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_slab_object_info",
+	 (PyCFunction)drgnpy_linux_helper_slab_object_info,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_per_cpu_ptr",
+	 (PyCFunction)drgnpy_linux_helper_per_cpu_ptr,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_per_cpu_values",
+	 (PyCFunction)drgnpy_linux_helper_per_cpu_values,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_per_cpu_sum",
+	 (PyCFunction)drgnpy_linux_helper_per_cpu_sum,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_percpu_counter_sum",
+	 (PyCFunction)drgnpy_linux_helper_percpu_counter_sum,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_d_path", (PyCFunction)drgnpy_linux_helper_d_path,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_dentry_path",
+	 (PyCFunction)drgnpy_linux_helper_dentry_path,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_for_each_open_file",
+	 (PyCFunction)drgnpy_linux_helper_for_each_open_file,
+	 METH_VARARGS | METH_KEYWORDS},
+	{"_linux_helper_for_each_vma",
+	 (PyCFunction)drgnpy_linux_helper_for_each_vma,
+	 METH_VARARGS | METH_KEYWORDS},
 	{"_linux_helper_kaslr_offset",
 	 (PyCFunction)drgnpy_linux_helper_kaslr_offset,
 	 METH_VARARGS | METH_KEYWORDS},
@@ -221,7 +283,19 @@ DRGNPY_PUBLIC PyMODINIT_FUNC PyInit__drgn(void)
 	    add_type_aliases(m) ||
 	    add_type(m, &Language_type) || add_languages() ||
 	    add_type(m, &DrgnObject_type) ||
+	    add_type(m, &Accessor_type) ||
+	    PyType_Ready(&LinuxHelperFileInventoryIterator_type) ||
+	    PyType_Ready(&LinuxHelperListIterator_type) ||
+	    PyType_Ready(&LinuxHelperPageIterator_type) ||
+	    PyType_Ready(&LinuxHelperPgtableRangeIterator_type) ||
+	    PyType_Ready(&LinuxHelperPidIterator_type) ||
+	    PyType_Ready(&LinuxHelperRadixTreeIterator_type) ||
+	    PyType_Ready(&LinuxHelperRbtreeIterator_type) ||
+	    PyType_Ready(&LinuxHelperSlabObjectIterator_type) ||
+	    PyType_Ready(&LinuxHelperVmaIterator_type) ||
+	    PyType_Ready(&ObjectGraphIterator_type) ||
 	    PyType_Ready(&ObjectIterator_type) ||
+	    PyType_Ready(&IndexedNamesIterator_type) ||
 	    add_type(m, &Platform_type) ||
 	    add_type(m, &Program_type) ||
 	    add_type(m, &Register_type) ||
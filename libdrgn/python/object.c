@@ -696,7 +696,9 @@ static PyObject *DrgnObject_string(DrgnObject *self)
 	char *str;
 	PyObject *ret;
 
+	Program_BEGIN_ALLOW_THREADS(DrgnObject_prog(self))
 	err = drgn_object_read_c_string(&self->obj, &str);
+	Program_END_ALLOW_THREADS
 	if (err)
 		return set_drgn_error(err);
 
@@ -736,7 +738,9 @@ static DrgnObject *DrgnObject_read(DrgnObject *self)
 		if (!res)
 			return NULL;
 
+		Program_BEGIN_ALLOW_THREADS(DrgnObject_prog(self))
 		err = drgn_object_read(&res->obj, &self->obj);
+		Program_END_ALLOW_THREADS
 		if (err) {
 			Py_DECREF(res);
 			return set_drgn_error(err);
@@ -867,10 +871,7 @@ static int format_object_flag_converter(PyObject *o, void *p)
 	return 1;
 }
 
-static PyObject *DrgnObject_format(DrgnObject *self, PyObject *args,
-				   PyObject *kwds)
-{
-#define FLAGS								\
+#define FORMAT_OBJECT_FLAGS							\
 	X(dereference, DRGN_FORMAT_OBJECT_DEREFERENCE)			\
 	X(symbolize, DRGN_FORMAT_OBJECT_SYMBOLIZE)			\
 	X(string, DRGN_FORMAT_OBJECT_STRING)				\
@@ -885,44 +886,66 @@ static PyObject *DrgnObject_format(DrgnObject *self, PyObject *args,
 	X(implicit_members, DRGN_FORMAT_OBJECT_IMPLICIT_MEMBERS)	\
 	X(implicit_elements, DRGN_FORMAT_OBJECT_IMPLICIT_ELEMENTS)
 
+static int format_object_args(PyObject *args, PyObject *kwds,
+			      const char *format, size_t *columns_ret,
+			      enum drgn_format_object_flags *flags_ret)
+{
 	static char *keywords[] = {
 #define X(name, value) #name,
-		FLAGS
+		FORMAT_OBJECT_FLAGS
 #undef X
 		"columns",
 		NULL,
 	};
-	struct drgn_error *err;
 	PyObject *columns_obj = Py_None;
 	size_t columns = SIZE_MAX;
 	enum drgn_format_object_flags flags = DRGN_FORMAT_OBJECT_PRETTY;
 #define X(name, value)	\
 	struct format_object_flag_arg name##_arg = { &flags, value };
-	FLAGS
+	FORMAT_OBJECT_FLAGS
 #undef X
-	char *str;
-	PyObject *ret;
 
-	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|$"
-#define X(name, value) "O&"
-					 FLAGS
-#undef X
-					 "O", keywords,
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, format, keywords,
 #define X(name, value) format_object_flag_converter, &name##_arg,
-					 FLAGS
+					 FORMAT_OBJECT_FLAGS
 #undef X
 					 &columns_obj))
-		return NULL;
+		return -1;
 
 	if (columns_obj != Py_None) {
 		columns_obj = PyNumber_Index(columns_obj);
 		if (!columns_obj)
-			return NULL;
+			return -1;
 		columns = PyLong_AsSize_t(columns_obj);
 		Py_DECREF(columns_obj);
 		if (columns == (size_t)-1 && PyErr_Occurred())
-			return NULL;
+			return -1;
 	}
+	*columns_ret = columns;
+	*flags_ret = flags;
+	return 0;
+}
+
+/*
+ * Argument format for format_object_args() without the function name. X must
+ * be defined to "O&" where this is used.
+ */
+#define FORMAT_OBJECT_ARGS "|$" FORMAT_OBJECT_FLAGS "O"
+
+static PyObject *DrgnObject_format(DrgnObject *self, PyObject *args,
+				   PyObject *kwds)
+{
+	struct drgn_error *err;
+	size_t columns;
+	enum drgn_format_object_flags flags;
+	char *str;
+	PyObject *ret;
+
+#define X(name, value) "O&"
+	if (format_object_args(args, kwds, FORMAT_OBJECT_ARGS ":format_",
+			       &columns, &flags) == -1)
+		return NULL;
+#undef X
 
 	err = drgn_format_object(&self->obj, columns, flags, &str);
 	if (err)
@@ -931,8 +954,96 @@ static PyObject *DrgnObject_format(DrgnObject *self, PyObject *args,
 	ret = PyUnicode_FromString(str);
 	free(str);
 	return ret;
+}
+
+static struct drgn_error *py_format_object_write_fn(const char *str,
+						    size_t len, void *arg)
+{
+	_Py_IDENTIFIER(write);
+	PyObject *ret = _PyObject_CallMethodId(arg, &PyId_write, "s#", str,
+					       (Py_ssize_t)len);
+	if (!ret)
+		return drgn_error_from_python();
+	Py_DECREF(ret);
+	return NULL;
+}
+
+static PyObject *DrgnObject_print(DrgnObject *self, PyObject *args,
+				  PyObject *kwds)
+{
+	struct drgn_error *err;
+	PyObject *file = Py_None;
+	size_t columns;
+	enum drgn_format_object_flags flags;
+
+	if (!PyArg_UnpackTuple(args, "print_", 0, 1, &file))
+		return NULL;
+	PyObject *format_kwds = NULL;
+	if (kwds) {
+		format_kwds = PyDict_Copy(kwds);
+		if (!format_kwds)
+			return NULL;
+		PyObject *file_kwd = PyDict_GetItemString(format_kwds, "file");
+		if (file_kwd) {
+			if (PyTuple_GET_SIZE(args)) {
+				PyErr_SetString(PyExc_TypeError,
+						"print_() got multiple values for argument 'file'");
+				goto err;
+			}
+			file = file_kwd;
+			Py_INCREF(file);
+			if (PyDict_DelItemString(format_kwds, "file") == -1) {
+				Py_DECREF(file);
+				goto err;
+			}
+		} else {
+			Py_INCREF(file);
+		}
+	} else {
+		Py_INCREF(file);
+	}
+	if (file == Py_None) {
+		Py_DECREF(file);
+		file = PySys_GetObject("stdout");
+		if (!file || file == Py_None) {
+			PyErr_SetString(PyExc_RuntimeError, "lost sys.stdout");
+			goto err;
+		}
+		Py_INCREF(file);
+	}
 
-#undef FLAGS
+	PyObject *empty = PyTuple_New(0);
+	if (!empty)
+		goto err_file;
+#define X(name, value) "O&"
+	int ret = format_object_args(empty, format_kwds,
+				     FORMAT_OBJECT_ARGS ":print_", &columns,
+				     &flags);
+#undef X
+	Py_DECREF(empty);
+	if (ret == -1)
+		goto err_file;
+
+	bool clear = set_drgn_in_python();
+	err = drgn_format_object_stream(&self->obj, columns, flags,
+					py_format_object_write_fn, file);
+	if (!err)
+		err = py_format_object_write_fn("\n", 1, file);
+	if (clear)
+		clear_drgn_in_python();
+	if (err) {
+		set_drgn_error(err);
+		goto err_file;
+	}
+	Py_DECREF(file);
+	Py_XDECREF(format_kwds);
+	Py_RETURN_NONE;
+
+err_file:
+	Py_DECREF(file);
+err:
+	Py_XDECREF(format_kwds);
+	return NULL;
 }
 
 static Program *DrgnObject_get_prog(DrgnObject *self, void *arg)
@@ -1316,18 +1427,11 @@ out:
 		Py_RETURN_RICHCOMPARE(cmp, 0, op);
 }
 
-static DrgnObject *DrgnObject_member(DrgnObject *self, PyObject *args,
-				     PyObject *kwds)
+static DrgnObject *DrgnObject_member_impl(DrgnObject *self, const char *name)
 {
-	static char *keywords[] = {"name", NULL};
 	struct drgn_error *err;
-	const char *name;
 	DrgnObject *res;
 
-	if (!PyArg_ParseTupleAndKeywords(args, kwds, "s:member_", keywords,
-					 &name))
-		return NULL;
-
 	res = DrgnObject_alloc(DrgnObject_prog(self));
 	if (!res)
 		return NULL;
@@ -1345,6 +1449,57 @@ static DrgnObject *DrgnObject_member(DrgnObject *self, PyObject *args,
 	return res;
 }
 
+/*
+ * member_() is called in hot loops, so avoid building an argument tuple where
+ * the vectorcall protocol is available.
+ */
+#if PY_VERSION_HEX >= 0x030700a4
+#define DRGNOBJECT_MEMBER_FLAGS (METH_FASTCALL | METH_KEYWORDS)
+static DrgnObject *DrgnObject_member(DrgnObject *self, PyObject *const *args,
+				     Py_ssize_t nargs, PyObject *kwnames)
+{
+	PyObject *name_obj;
+	if (nargs == 1 && !kwnames) {
+		name_obj = args[0];
+	} else if (nargs == 0 && kwnames && PyTuple_GET_SIZE(kwnames) == 1 &&
+		   PyUnicode_CompareWithASCIIString(PyTuple_GET_ITEM(kwnames, 0),
+						    "name") == 0) {
+		name_obj = args[0];
+	} else {
+		PyErr_SetString(PyExc_TypeError,
+				"member_() takes exactly one argument (name)");
+		return NULL;
+	}
+	if (!PyUnicode_Check(name_obj)) {
+		PyErr_Format(PyExc_TypeError,
+			     "member_() argument 1 must be str, not %s",
+			     Py_TYPE(name_obj)->tp_name);
+		return NULL;
+	}
+	Py_ssize_t len;
+	const char *name = PyUnicode_AsUTF8AndSize(name_obj, &len);
+	if (!name)
+		return NULL;
+	if (strlen(name) != len) {
+		PyErr_SetString(PyExc_ValueError, "embedded null character");
+		return NULL;
+	}
+	return DrgnObject_member_impl(self, name);
+}
+#else
+#define DRGNOBJECT_MEMBER_FLAGS (METH_VARARGS | METH_KEYWORDS)
+static DrgnObject *DrgnObject_member(DrgnObject *self, PyObject *args,
+				     PyObject *kwds)
+{
+	static char *keywords[] = {"name", NULL};
+	const char *name;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "s:member_", keywords,
+					 &name))
+		return NULL;
+	return DrgnObject_member_impl(self, name);
+}
+#endif
+
 static PyObject *DrgnObject_getattro(DrgnObject *self, PyObject *attr_name)
 {
 	struct drgn_error *err;
@@ -1577,14 +1732,16 @@ static PyMethodDef DrgnObject_methods[] = {
 	 drgn_Object_value__DOC},
 	{"string_", (PyCFunction)DrgnObject_string, METH_NOARGS,
 	 drgn_Object_string__DOC},
-	{"member_", (PyCFunction)DrgnObject_member,
-	 METH_VARARGS | METH_KEYWORDS, drgn_Object_member__DOC},
+	{"member_", (PyCFunction)DrgnObject_member, DRGNOBJECT_MEMBER_FLAGS,
+	 drgn_Object_member__DOC},
 	{"address_of_", (PyCFunction)DrgnObject_address_of, METH_NOARGS,
 	 drgn_Object_address_of__DOC},
 	{"read_", (PyCFunction)DrgnObject_read, METH_NOARGS,
 	 drgn_Object_read__DOC},
 	{"format_", (PyCFunction)DrgnObject_format,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Object_format__DOC},
+	{"print_", (PyCFunction)DrgnObject_print,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Object_print__DOC},
 	{"__round__", (PyCFunction)DrgnObject_round,
 	 METH_VARARGS | METH_KEYWORDS},
 	{"__trunc__", (PyCFunction)DrgnObject_trunc, METH_NOARGS},
@@ -1620,6 +1777,85 @@ static PyMappingMethods DrgnObject_as_mapping = {
 	.mp_subscript = (binaryfunc)DrgnObject_subscript,
 };
 
+static int DrgnObject_getbuffer(DrgnObject *self, Py_buffer *view, int flags)
+{
+	struct drgn_error *err;
+
+	if (self->obj.encoding != DRGN_OBJECT_ENCODING_BUFFER) {
+		if (self->obj.encoding ==
+		    DRGN_OBJECT_ENCODING_INCOMPLETE_BUFFER) {
+			err = drgn_error_incomplete_type("cannot get buffer of object with %s type",
+							 self->obj.type);
+		} else {
+			err = drgn_qualified_type_error("'%s' is not an array, structure, union, or class",
+							drgn_object_qualified_type(&self->obj));
+		}
+		set_drgn_error(err);
+		view->obj = NULL;
+		return -1;
+	}
+
+	uint64_t size = drgn_object_size(&self->obj);
+	void *buf;
+	SWITCH_ENUM(self->obj.kind,
+	case DRGN_OBJECT_VALUE:
+		/* Values are immutable, so the buffer can be shared. */
+		buf = (void *)drgn_object_buffer(&self->obj);
+		view->internal = NULL;
+		break;
+	case DRGN_OBJECT_REFERENCE: {
+		/* References are read in one go into a buffer owned by the view. */
+		assert(self->obj.bit_offset == 0);
+		buf = malloc64(size ? size : 1);
+		if (!buf) {
+			PyErr_NoMemory();
+			view->obj = NULL;
+			return -1;
+		}
+		bool clear = set_drgn_in_python();
+		Program_BEGIN_ALLOW_THREADS(DrgnObject_prog(self))
+		err = drgn_program_read_memory(drgn_object_program(&self->obj),
+					       buf, self->obj.address, size,
+					       false);
+		Program_END_ALLOW_THREADS
+		if (clear)
+			clear_drgn_in_python();
+		if (err) {
+			free(buf);
+			set_drgn_error(err);
+			view->obj = NULL;
+			return -1;
+		}
+		view->internal = buf;
+		break;
+	}
+	case DRGN_OBJECT_ABSENT:
+		set_drgn_error(&drgn_error_object_absent);
+		view->obj = NULL;
+		return -1;
+	)
+
+	void *internal = view->internal;
+	if (PyBuffer_FillInfo(view, (PyObject *)self, buf, size, 1,
+			      flags) == -1) {
+		free(internal);
+		view->obj = NULL;
+		return -1;
+	}
+	view->internal = internal;
+	return 0;
+}
+
+static void DrgnObject_releasebuffer(DrgnObject *self, Py_buffer *view)
+{
+	free(view->internal);
+}
+
+static PyBufferProcs DrgnObject_as_buffer = {
+	.bf_getbuffer = (getbufferproc)DrgnObject_getbuffer,
+	.bf_releasebuffer = (releasebufferproc)DrgnObject_releasebuffer,
+};
+
 PyTypeObject DrgnObject_type = {
 	PyVarObject_HEAD_INIT(NULL, 0)
 	.tp_name = "_drgn.Object",
@@ -1630,6 +1866,7 @@ PyTypeObject DrgnObject_type = {
 	.tp_as_mapping = &DrgnObject_as_mapping,
 	.tp_str = (reprfunc)DrgnObject_str,
 	.tp_getattro = (getattrofunc)DrgnObject_getattro,
+	.tp_as_buffer = &DrgnObject_as_buffer,
 	.tp_flags = Py_TPFLAGS_DEFAULT,
 	.tp_doc = drgn_Object_DOC,
 	.tp_richcompare = DrgnObject_richcompare,
@@ -1720,6 +1957,26 @@ DrgnObject *reinterpret(PyObject *self, PyObject *args, PyObject *kwds)
 	return res;
 }
 
+PyObject *memcmp_(PyObject *self, PyObject *args, PyObject *kwds)
+{
+	static char *keywords[] = {"lhs", "rhs", NULL};
+	struct drgn_error *err;
+	DrgnObject *lhs, *rhs;
+	int ret;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O!:memcmp", keywords,
+					 &DrgnObject_type, &lhs,
+					 &DrgnObject_type, &rhs))
+		return NULL;
+
+	Program_BEGIN_ALLOW_THREADS(DrgnObject_prog(lhs))
+	err = drgn_object_memcmp(&lhs->obj, &rhs->obj, &ret);
+	Program_END_ALLOW_THREADS
+	if (err)
+		return set_drgn_error(err);
+	return PyLong_FromLong(ret < 0 ? -1 : ret > 0);
+}
+
 DrgnObject *DrgnObject_container_of(PyObject *self, PyObject *args,
 				    PyObject *kwds)
 {
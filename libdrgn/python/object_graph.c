@@ -0,0 +1,160 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// SPDX-License-Identifier: GPL-3.0+
+
+#include "drgnpy.h"
+
+static int ObjectGraphIterator_add_types(ObjectGraphIterator *it,
+					 PyObject *types)
+{
+	struct drgn_error *err;
+	PyObject *iter = PyObject_GetIter(types);
+	if (!iter)
+		return -1;
+	PyObject *item;
+	while ((item = PyIter_Next(iter))) {
+		struct drgn_qualified_type qualified_type;
+		int ret = Program_type_arg(it->prog, item, false,
+					   &qualified_type);
+		Py_DECREF(item);
+		if (ret)
+			goto err;
+		err = drgn_object_graph_iterator_add_type(it->it,
+							  qualified_type.type);
+		if (err) {
+			set_drgn_error(err);
+			goto err;
+		}
+	}
+	if (PyErr_Occurred())
+		goto err;
+	Py_DECREF(iter);
+	return 0;
+
+err:
+	Py_DECREF(iter);
+	return -1;
+}
+
+static int ObjectGraphIterator_add_members(ObjectGraphIterator *it,
+					   PyObject *members)
+{
+	struct drgn_error *err;
+	PyObject *iter = PyObject_GetIter(members);
+	if (!iter)
+		return -1;
+	PyObject *item;
+	while ((item = PyIter_Next(iter))) {
+		if (!PyUnicode_Check(item)) {
+			PyErr_SetString(PyExc_TypeError,
+					"member name must be str");
+			Py_DECREF(item);
+			goto err;
+		}
+		const char *name = PyUnicode_AsUTF8(item);
+		if (!name) {
+			Py_DECREF(item);
+			goto err;
+		}
+		err = drgn_object_graph_iterator_add_member(it->it, name);
+		Py_DECREF(item);
+		if (err) {
+			set_drgn_error(err);
+			goto err;
+		}
+	}
+	if (PyErr_Occurred())
+		goto err;
+	Py_DECREF(iter);
+	return 0;
+
+err:
+	Py_DECREF(iter);
+	return -1;
+}
+
+ObjectGraphIterator *object_graph(PyObject *self, PyObject *args,
+				  PyObject *kwds)
+{
+	static char *keywords[] = {
+		"root", "max_depth", "types", "members", "depth_first",
+		"paths", NULL,
+	};
+	struct drgn_error *err;
+	DrgnObject *root;
+	struct index_arg max_depth = { .allow_none = true, .is_none = true };
+	PyObject *types = Py_None, *members = Py_None;
+	int depth_first = 0, paths = 1;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|O&$OOpp:object_graph",
+					 keywords, &DrgnObject_type, &root,
+					 index_converter, &max_depth, &types,
+					 &members, &depth_first, &paths))
+		return NULL;
+
+	ObjectGraphIterator *it =
+		(ObjectGraphIterator *)ObjectGraphIterator_type.tp_alloc(&ObjectGraphIterator_type,
+									 0);
+	if (!it)
+		return NULL;
+	it->prog = DrgnObject_prog(root);
+	Py_INCREF(it->prog);
+	enum drgn_object_graph_flags flags = 0;
+	if (depth_first)
+		flags |= DRGN_OBJECT_GRAPH_DEPTH_FIRST;
+	if (!paths)
+		flags |= DRGN_OBJECT_GRAPH_NO_PATHS;
+	err = drgn_object_graph_iterator_create(&root->obj,
+						max_depth.is_none ?
+						UINT64_MAX : max_depth.uvalue,
+						flags, &it->it);
+	if (err) {
+		set_drgn_error(err);
+		goto err;
+	}
+	if ((types != Py_None && ObjectGraphIterator_add_types(it, types)) ||
+	    (members != Py_None &&
+	     ObjectGraphIterator_add_members(it, members)))
+		goto err;
+	return it;
+
+err:
+	Py_DECREF(it);
+	return NULL;
+}
+
+static void ObjectGraphIterator_dealloc(ObjectGraphIterator *self)
+{
+	drgn_object_graph_iterator_destroy(self->it);
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *ObjectGraphIterator_next(ObjectGraphIterator *self)
+{
+	struct drgn_error *err;
+	const struct drgn_object_graph_node *node;
+	if (iterator_begin_next(&self->running))
+		return NULL;
+	Program_BEGIN_ALLOW_THREADS(self->prog);
+	err = drgn_object_graph_iterator_next(self->it, &node);
+	Program_END_ALLOW_THREADS;
+	iterator_end_next(&self->running);
+	if (err)
+		return set_drgn_error(err);
+	if (!node)
+		return NULL;
+	PyObject *type_obj = DrgnType_wrap(node->qualified_type);
+	if (!type_obj)
+		return NULL;
+	return Py_BuildValue("KNz", (unsigned long long)node->address,
+			     type_obj, node->path);
+}
+
+PyTypeObject ObjectGraphIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._ObjectGraphIterator",
+	.tp_basicsize = sizeof(ObjectGraphIterator),
+	.tp_dealloc = (destructor)ObjectGraphIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)ObjectGraphIterator_next,
+};
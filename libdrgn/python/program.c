@@ -198,6 +198,7 @@ static PyObject *Program_add_memory_segment(Program *self, PyObject *args,
 
 	if (Program_hold_object(self, read_fn) == -1)
 		return NULL;
+	self->python_callbacks = true;
 	err = drgn_program_add_memory_segment(&self->prog, address.uvalue,
 					      size.uvalue, py_memory_read_fn,
 					      read_fn, physical);
@@ -295,6 +296,7 @@ static PyObject *Program_add_type_finder(Program *self, PyObject *args,
 	if (ret == -1)
 		return NULL;
 
+	self->python_callbacks = true;
 	err = drgn_program_add_type_finder(&self->prog, py_type_find_fn, arg);
 	if (err)
 		return set_drgn_error(err);
@@ -378,6 +380,7 @@ static PyObject *Program_add_object_finder(Program *self, PyObject *args,
 	if (ret == -1)
 		return NULL;
 
+	self->python_callbacks = true;
 	err = drgn_program_add_object_finder(&self->prog, py_object_find_fn,
 					     arg);
 	if (err)
@@ -495,8 +498,10 @@ static PyObject *Program_load_debug_info(Program *self, PyObject *args,
 		for (size_t i = 0; i < path_args.size; i++)
 			paths[i] = path_args.data[i].path;
 	}
+	Program_BEGIN_ALLOW_THREADS(self)
 	err = drgn_program_load_debug_info(&self->prog, paths, path_args.size,
 					   load_default, load_main);
+	Program_END_ALLOW_THREADS
 	free(paths);
 	if (err)
 		set_drgn_error(err);
@@ -514,12 +519,222 @@ static PyObject *Program_load_default_debug_info(Program *self)
 {
 	struct drgn_error *err;
 
+	Program_BEGIN_ALLOW_THREADS(self)
 	err = drgn_program_load_debug_info(&self->prog, NULL, 0, true, true);
+	Program_END_ALLOW_THREADS
 	if (err)
 		return set_drgn_error(err);
 	Py_RETURN_NONE;
 }
 
+/*
+ * Get the UTF-8 strings in a sequence of str. The strings are valid as long as
+ * the returned sequence (*seq_ret) is alive.
+ */
+static const char **str_sequence(PyObject *obj, PyObject **seq_ret,
+				 size_t *n_ret)
+{
+	PyObject *seq = PySequence_Fast(obj, "expected sequence of str");
+	if (!seq)
+		return NULL;
+	size_t n = PySequence_Fast_GET_SIZE(seq);
+	const char **strs = malloc_array(n ? n : 1, sizeof(*strs));
+	if (!strs) {
+		PyErr_NoMemory();
+		Py_DECREF(seq);
+		return NULL;
+	}
+	for (size_t i = 0; i < n; i++) {
+		PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+		if (!PyUnicode_Check(item)) {
+			PyErr_SetString(PyExc_TypeError,
+					"expected sequence of str");
+			goto err;
+		}
+		strs[i] = PyUnicode_AsUTF8(item);
+		if (!strs[i])
+			goto err;
+	}
+	*seq_ret = seq;
+	*n_ret = n;
+	return strs;
+
+err:
+	free(strs);
+	Py_DECREF(seq);
+	return NULL;
+}
+
+static PyObject *Program_prefetch(Program *self, PyObject *args,
+				  PyObject *kwds)
+{
+	static char *keywords[] = {"types", "objects", NULL};
+	struct drgn_error *err;
+	PyObject *types_obj = Py_None, *objects_obj = Py_None;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OO:prefetch", keywords,
+					 &types_obj, &objects_obj))
+		return NULL;
+
+	PyObject *ret = NULL;
+	PyObject *types_seq = NULL, *objects_seq = NULL;
+	const char **type_names = NULL, **object_names = NULL;
+	size_t num_type_names = 0, num_object_names = 0;
+	if (types_obj != Py_None &&
+	    !(type_names = str_sequence(types_obj, &types_seq,
+					&num_type_names)))
+		goto out;
+	if (objects_obj != Py_None &&
+	    !(object_names = str_sequence(objects_obj, &objects_seq,
+					  &num_object_names)))
+		goto out;
+
+	err = drgn_program_prefetch(&self->prog, type_names, num_type_names,
+				    object_names, num_object_names);
+	if (err) {
+		set_drgn_error(err);
+		goto out;
+	}
+	Py_INCREF(Py_None);
+	ret = Py_None;
+out:
+	free(object_names);
+	Py_XDECREF(objects_seq);
+	free(type_names);
+	Py_XDECREF(types_seq);
+	return ret;
+}
+
+static PyObject *Program_wait_prefetch(Program *self)
+{
+	Py_BEGIN_ALLOW_THREADS
+	drgn_program_wait_prefetch(&self->prog);
+	Py_END_ALLOW_THREADS
+	Py_RETURN_NONE;
+}
+
+static PyObject *Program_load_type_cache(Program *self, PyObject *args,
+					 PyObject *kwds)
+{
+	static char *keywords[] = {"path", NULL};
+	struct drgn_error *err;
+	struct path_arg path = {};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&:load_type_cache",
+					 keywords, path_converter, &path))
+		return NULL;
+
+	err = drgn_program_load_type_cache(&self->prog, path.path);
+	path_cleanup(&path);
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
+}
+
+static PyObject *Program_save_type_cache(Program *self, PyObject *args,
+					 PyObject *kwds)
+{
+	static char *keywords[] = {"path", NULL};
+	struct drgn_error *err;
+	struct path_arg path = {};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&:save_type_cache",
+					 keywords, path_converter, &path))
+		return NULL;
+
+	err = drgn_program_save_type_cache(&self->prog, path.path);
+	path_cleanup(&path);
+	if (err)
+		return set_drgn_error(err);
+	Py_RETURN_NONE;
+}
+
+static IndexedNamesIterator *
+Program_indexed_names_impl(Program *self, uint64_t type_kinds,
+			   enum drgn_find_object_flags object_flags,
+			   const char *module_name, bool objects)
+{
+	struct drgn_error *err;
+	IndexedNamesIterator *it =
+		(IndexedNamesIterator *)IndexedNamesIterator_type.tp_alloc(&IndexedNamesIterator_type,
+									   0);
+	if (!it)
+		return NULL;
+	Py_BEGIN_ALLOW_THREADS
+	err = drgn_program_indexed_names(&self->prog, type_kinds, object_flags,
+					 module_name, &it->names);
+	Py_END_ALLOW_THREADS
+	if (err) {
+		Py_DECREF(it);
+		return set_drgn_error(err);
+	}
+	it->prog = self;
+	Py_INCREF(self);
+	it->objects = objects;
+	return it;
+}
+
+static IndexedNamesIterator *Program_indexed_types(Program *self,
+						   PyObject *args,
+						   PyObject *kwds)
+{
+	static char *keywords[] = {"kinds", "module", NULL};
+	PyObject *kinds_obj = Py_None;
+	const char *module_name = NULL;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|Oz:indexed_types",
+					 keywords, &kinds_obj, &module_name))
+		return NULL;
+
+	uint64_t type_kinds = 0;
+	if (kinds_obj == Py_None) {
+		type_kinds = ((UINT64_C(1) << DRGN_TYPE_INT) |
+			      (UINT64_C(1) << DRGN_TYPE_BOOL) |
+			      (UINT64_C(1) << DRGN_TYPE_FLOAT) |
+			      (UINT64_C(1) << DRGN_TYPE_STRUCT) |
+			      (UINT64_C(1) << DRGN_TYPE_UNION) |
+			      (UINT64_C(1) << DRGN_TYPE_CLASS) |
+			      (UINT64_C(1) << DRGN_TYPE_ENUM) |
+			      (UINT64_C(1) << DRGN_TYPE_TYPEDEF));
+	} else {
+		PyObject *it = PyObject_GetIter(kinds_obj);
+		if (!it)
+			return NULL;
+		PyObject *item;
+		while ((item = PyIter_Next(it))) {
+			struct enum_arg kind = { .type = TypeKind_class };
+			int ret = enum_converter(item, &kind);
+			Py_DECREF(item);
+			if (!ret) {
+				Py_DECREF(it);
+				return NULL;
+			}
+			type_kinds |= UINT64_C(1) << kind.value;
+		}
+		Py_DECREF(it);
+		if (PyErr_Occurred())
+			return NULL;
+	}
+	return Program_indexed_names_impl(self, type_kinds, 0, module_name,
+					  false);
+}
+
+static IndexedNamesIterator *Program_indexed_objects(Program *self,
+						     PyObject *args,
+						     PyObject *kwds)
+{
+	static char *keywords[] = {"flags", "module", NULL};
+	struct enum_arg flags = {
+		.type = FindObjectFlags_class,
+		.value = DRGN_FIND_OBJECT_ANY,
+	};
+	const char *module_name = NULL;
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O&z:indexed_objects",
+					 keywords, enum_converter, &flags,
+					 &module_name))
+		return NULL;
+	return Program_indexed_names_impl(self, 0, flags.value, module_name,
+					  true);
+}
+
 static PyObject *Program_read(Program *self, PyObject *args, PyObject *kwds)
 {
 	static char *keywords[] = {"address", "size", "physical", NULL};
@@ -543,8 +758,10 @@ static PyObject *Program_read(Program *self, PyObject *args, PyObject *kwds)
 	if (!buf)
 		return NULL;
 	clear = set_drgn_in_python();
+	Program_BEGIN_ALLOW_THREADS(self)
 	err = drgn_program_read_memory(&self->prog, PyBytes_AS_STRING(buf),
 				       address.uvalue, size, physical);
+	Program_END_ALLOW_THREADS
 	if (clear)
 		clear_drgn_in_python();
 	if (err) {
@@ -568,8 +785,10 @@ static PyObject *Program_read_##x(Program *self, PyObject *args,		\
 					 index_converter, &address, &physical))	\
 	    return NULL;							\
 										\
+	Program_BEGIN_ALLOW_THREADS(self)					\
 	err = drgn_program_read_##x(&self->prog, address.uvalue, physical,	\
 				    &tmp);					\
+	Program_END_ALLOW_THREADS						\
 	if (err)								\
 		return set_drgn_error(err);					\
 	if (sizeof(tmp) <= sizeof(unsigned long))				\
@@ -598,8 +817,10 @@ static PyObject *Program_find_type(Program *self, PyObject *args, PyObject *kwds
 		return NULL;
 
 	clear = set_drgn_in_python();
+	Program_BEGIN_ALLOW_THREADS(self)
 	err = drgn_program_find_type(&self->prog, name, filename.path,
 				     &qualified_type);
+	Program_END_ALLOW_THREADS
 	if (clear)
 		clear_drgn_in_python();
 	path_cleanup(&filename);
@@ -621,8 +842,10 @@ static DrgnObject *Program_find_object(Program *self, const char *name,
 		return NULL;
 
 	clear = set_drgn_in_python();
+	Program_BEGIN_ALLOW_THREADS(self)
 	err = drgn_program_find_object(&self->prog, name, filename->path, flags,
 				       &ret->obj);
+	Program_END_ALLOW_THREADS
 	if (clear)
 		clear_drgn_in_python();
 	path_cleanup(filename);
@@ -697,6 +920,33 @@ static DrgnObject *Program_variable(Program *self, PyObject *args,
 				   DRGN_FIND_OBJECT_VARIABLE);
 }
 
+static DrgnObject *Program_eval(Program *self, PyObject *args,
+				PyObject *kwds)
+{
+	static char *keywords[] = {"expr", NULL};
+	struct drgn_error *err;
+	const char *expr;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "s:eval", keywords,
+					 &expr))
+		return NULL;
+
+	DrgnObject *ret = DrgnObject_alloc(self);
+	if (!ret)
+		return NULL;
+	bool clear = set_drgn_in_python();
+	Program_BEGIN_ALLOW_THREADS(self)
+	err = drgn_program_eval(&self->prog, expr, &ret->obj);
+	Program_END_ALLOW_THREADS
+	if (clear)
+		clear_drgn_in_python();
+	if (err) {
+		Py_DECREF(ret);
+		return set_drgn_error(err);
+	}
+	return ret;
+}
+
 static StackTrace *Program_stack_trace(Program *self, PyObject *args,
 				       PyObject *kwds)
 {
@@ -711,14 +961,18 @@ static StackTrace *Program_stack_trace(Program *self, PyObject *args,
 		return NULL;
 
 	if (PyObject_TypeCheck(thread, &DrgnObject_type)) {
+		Program_BEGIN_ALLOW_THREADS(self)
 		err = drgn_object_stack_trace(&((DrgnObject *)thread)->obj,
 					      &trace);
+		Program_END_ALLOW_THREADS
 	} else {
 		struct index_arg tid = {};
 
 		if (!index_converter(thread, &tid))
 			return NULL;
+		Program_BEGIN_ALLOW_THREADS(self)
 		err = drgn_program_stack_trace(&self->prog, tid.uvalue, &trace);
+		Program_END_ALLOW_THREADS
 	}
 	if (err)
 		return set_drgn_error(err);
@@ -859,6 +1113,29 @@ static PyObject *Program_get_language(Program *self, void *arg)
 	return Language_wrap(drgn_program_language(&self->prog));
 }
 
+static PyObject *Program_get_dedupe_compound_types(Program *self, void *arg)
+{
+	Py_RETURN_BOOL(drgn_program_dedupe_compound_types(&self->prog));
+}
+
+static int Program_set_dedupe_compound_types(Program *self, PyObject *value,
+					     void *arg)
+{
+	if (!value) {
+		PyErr_SetString(PyExc_AttributeError,
+				"can't delete dedupe_compound_types attribute");
+		return -1;
+	}
+	if (!PyBool_Check(value)) {
+		PyErr_SetString(PyExc_TypeError,
+				"dedupe_compound_types must be bool");
+		return -1;
+	}
+	drgn_program_set_dedupe_compound_types(&self->prog,
+					       value == Py_True);
+	return 0;
+}
+
 static PyMethodDef Program_methods[] = {
 	{"add_memory_segment", (PyCFunction)Program_add_memory_segment,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_add_memory_segment_DOC},
@@ -877,6 +1154,14 @@ static PyMethodDef Program_methods[] = {
 	{"load_default_debug_info",
 	 (PyCFunction)Program_load_default_debug_info, METH_NOARGS,
 	 drgn_Program_load_default_debug_info_DOC},
+	{"prefetch", (PyCFunction)Program_prefetch,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_prefetch_DOC},
+	{"wait_prefetch", (PyCFunction)Program_wait_prefetch, METH_NOARGS,
+	 drgn_Program_wait_prefetch_DOC},
+	{"load_type_cache", (PyCFunction)Program_load_type_cache,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_load_type_cache_DOC},
+	{"save_type_cache", (PyCFunction)Program_save_type_cache,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_save_type_cache_DOC},
 	{"__getitem__", (PyCFunction)Program_subscript, METH_O | METH_COEXIST,
 	 drgn_Program___getitem___DOC},
 	{"read", (PyCFunction)Program_read, METH_VARARGS | METH_KEYWORDS,
@@ -892,6 +1177,14 @@ static PyMethodDef Program_methods[] = {
 #undef METHOD_READ_U
 	{"type", (PyCFunction)Program_find_type, METH_VARARGS | METH_KEYWORDS,
 	 drgn_Program_type_DOC},
+	{"indexed_types", (PyCFunction)Program_indexed_types,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_indexed_types_DOC},
+	{"indexed_objects", (PyCFunction)Program_indexed_objects,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_indexed_objects_DOC},
+	{"accessor", (PyCFunction)Program_accessor,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_accessor_DOC},
+	{"columns", (PyCFunction)Program_columns,
+	 METH_VARARGS | METH_KEYWORDS, drgn_Program_columns_DOC},
 	{"object", (PyCFunction)Program_object, METH_VARARGS | METH_KEYWORDS,
 	 drgn_Program_object_DOC},
 	{"constant", (PyCFunction)Program_constant,
@@ -900,6 +1193,8 @@ static PyMethodDef Program_methods[] = {
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_function_DOC},
 	{"variable", (PyCFunction)Program_variable,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_variable_DOC},
+	{"eval", (PyCFunction)Program_eval, METH_VARARGS | METH_KEYWORDS,
+	 drgn_Program_eval_DOC},
 	{"stack_trace", (PyCFunction)Program_stack_trace,
 	 METH_VARARGS | METH_KEYWORDS, drgn_Program_stack_trace_DOC},
 	{"symbol", (PyCFunction)Program_symbol, METH_O,
@@ -943,6 +1238,9 @@ static PyGetSetDef Program_getset[] = {
 	 drgn_Program_platform_DOC},
 	{"language", (getter)Program_get_language, NULL,
 	 drgn_Program_language_DOC},
+	{"dedupe_compound_types", (getter)Program_get_dedupe_compound_types,
+	 (setter)Program_set_dedupe_compound_types,
+	 drgn_Program_dedupe_compound_types_DOC},
 	{},
 };
 
@@ -972,6 +1270,70 @@ PyTypeObject Program_type = {
 	.tp_new = (newfunc)Program_new,
 };
 
+static void IndexedNamesIterator_dealloc(IndexedNamesIterator *self)
+{
+	drgn_indexed_names_destroy(self->names);
+	Py_XDECREF(self->prog);
+	Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *IndexedNamesIterator_next(IndexedNamesIterator *self)
+{
+	struct drgn_error *err;
+	while (self->index < drgn_indexed_names_size(self->names)) {
+		size_t i = self->index++;
+		if (self->objects) {
+			DrgnObject *obj = DrgnObject_alloc(self->prog);
+			if (!obj)
+				return NULL;
+			err = drgn_indexed_names_object(self->names, i,
+							&obj->obj);
+			if (err) {
+				Py_DECREF(obj);
+				return set_drgn_error(err);
+			}
+			return Py_BuildValue("sN",
+					     drgn_indexed_names_name(self->names,
+								     i),
+					     obj);
+		} else {
+			struct drgn_qualified_type qualified_type;
+			err = drgn_indexed_names_type(self->names, i,
+						      &qualified_type);
+			/* Skip base types of kinds that weren't requested. */
+			if (err == &drgn_not_found)
+				continue;
+			if (err)
+				return set_drgn_error(err);
+			return DrgnType_wrap(qualified_type);
+		}
+	}
+	return NULL;
+}
+
+static PyObject *IndexedNamesIterator_length_hint(IndexedNamesIterator *self)
+{
+	return PyLong_FromSize_t(drgn_indexed_names_size(self->names) -
+				 self->index);
+}
+
+static PyMethodDef IndexedNamesIterator_methods[] = {
+	{"__length_hint__", (PyCFunction)IndexedNamesIterator_length_hint,
+	 METH_NOARGS},
+	{},
+};
+
+PyTypeObject IndexedNamesIterator_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "_drgn._IndexedNamesIterator",
+	.tp_basicsize = sizeof(IndexedNamesIterator),
+	.tp_dealloc = (destructor)IndexedNamesIterator_dealloc,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+	.tp_iter = PyObject_SelfIter,
+	.tp_iternext = (iternextfunc)IndexedNamesIterator_next,
+	.tp_methods = IndexedNamesIterator_methods,
+};
+
 Program *program_from_core_dump(PyObject *self, PyObject *args, PyObject *kwds)
 {
 	static char *keywords[] = {"path", NULL};
@@ -1603,6 +1603,7 @@ static int lazy_object_from_py(union drgn_lazy_object *lazy_obj,
 		drgn_lazy_object_init_thunk(lazy_obj, prog,
 					    py_lazy_object_thunk_fn,
 					    py_lazy_obj);
+		container_of(prog, Program, prog)->python_callbacks = true;
 		/*
 		 * We created a new thunk, so we can't reuse the passed
 		 * LazyObject. Don't cache the container so we create a new one
@@ -423,10 +423,10 @@ static const Dwfl_Thread_Callbacks drgn_linux_kernel_thread_callbacks = {
 	.set_initial_registers = drgn_thread_set_initial_registers,
 };
 
-static struct drgn_error *drgn_get_stack_trace(struct drgn_program *prog,
-					       uint32_t tid,
-					       const struct drgn_object *obj,
-					       struct drgn_stack_trace **ret)
+static struct drgn_error *
+drgn_get_stack_trace_impl(struct drgn_program *prog, uint32_t tid,
+			  const struct drgn_object *obj,
+			  struct drgn_stack_trace **ret)
 {
 	struct drgn_error *err;
 
@@ -509,6 +509,24 @@ err:
 	return err;
 }
 
+static struct drgn_error *drgn_get_stack_trace(struct drgn_program *prog,
+					       uint32_t tid,
+					       const struct drgn_object *obj,
+					       struct drgn_stack_trace **ret)
+{
+	/*
+	 * Unwinding uses libdwfl, which isn't safe to use concurrently with
+	 * loading debugging information or symbol lookups, and libdw, which
+	 * isn't safe to use concurrently with the prefetch thread.
+	 */
+	drgn_program_lock_dwfl(prog);
+	drgn_program_lock_types(prog);
+	struct drgn_error *err = drgn_get_stack_trace_impl(prog, tid, obj, ret);
+	drgn_program_unlock_types(prog);
+	drgn_program_unlock_dwfl(prog);
+	return err;
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_program_stack_trace(struct drgn_program *prog, uint32_t tid,
 			 struct drgn_stack_trace **ret)
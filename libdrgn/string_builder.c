@@ -93,3 +93,15 @@ bool string_builder_line_break(struct string_builder *sb)
 		return true;
 	return string_builder_appendc(sb, '\n');
 }
+
+struct drgn_error *string_builder_flush(struct string_builder *sb)
+{
+	if (!sb->flush_fn || !sb->len)
+		return NULL;
+	struct drgn_error *err = sb->flush_fn(sb->str, sb->len, sb->flush_arg);
+	if (err)
+		return err;
+	sb->flushed += sb->len;
+	sb->len = 0;
+	return NULL;
+}
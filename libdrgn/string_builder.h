@@ -15,6 +15,7 @@
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
 /**
@@ -27,6 +28,11 @@
  * @ref string_builder provides an append-only way to build a string piece by
  * piece. @ref string_callback provides an alternative to prepending pieces.
  *
+ * A string builder can also stream its output: if @ref
+ * string_builder::flush_fn is set, then @ref string_builder_flush() passes the
+ * string built so far to it and empties the buffer. Code which may rewind the
+ * buffer must only flush once the part it may rewind has been finalized.
+ *
  * @{
  */
 
@@ -58,8 +64,23 @@ struct string_builder {
 	 * It should be initialized to zero.
 	 */
 	size_t capacity;
+	/**
+	 * Callback to write flushed output to, or @c NULL if the string
+	 * shouldn't be flushed.
+	 */
+	struct drgn_error *(*flush_fn)(const char *str, size_t len, void *arg);
+	/** Argument to pass to @ref string_builder::flush_fn. */
+	void *flush_arg;
+	/** Total number of bytes flushed so far. */
+	uint64_t flushed;
 };
 
+/**
+ * Size at which @ref string_builder_maybe_flush() flushes a @ref
+ * string_builder.
+ */
+#define STRING_BUILDER_FLUSH_SIZE 4096
+
 /**
  * Null-terminate and return a string from a @ref string_builder.
  *
@@ -155,6 +176,29 @@ bool string_builder_vappendf(struct string_builder *sb, const char *format,
  */
 bool string_builder_line_break(struct string_builder *sb);
 
+/**
+ * Write the contents of a @ref string_builder to its @ref
+ * string_builder::flush_fn and empty it.
+ *
+ * This is a no-op if the string builder doesn't have a @ref
+ * string_builder::flush_fn.
+ */
+struct drgn_error *string_builder_flush(struct string_builder *sb);
+
+/**
+ * Flush a @ref string_builder if it holds at least @ref
+ * STRING_BUILDER_FLUSH_SIZE bytes.
+ *
+ * This should be called at points where everything appended so far is final.
+ */
+static inline struct drgn_error *
+string_builder_maybe_flush(struct string_builder *sb)
+{
+	if (sb->flush_fn && sb->len >= STRING_BUILDER_FLUSH_SIZE)
+		return string_builder_flush(sb);
+	return NULL;
+}
+
 /**
  * Callback to append to a string later.
  *
@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "error.h"
+#include "expression.h"
 #include "hash_table.h"
 #include "language.h"
 #include "lazy_object.h"
@@ -149,29 +150,120 @@ drgn_primitive_type_is_signed(enum drgn_primitive_type primitive)
 	}
 }
 
+static struct hash_pair
+drgn_interned_string_key_hash_pair(const struct drgn_interned_string_key *key)
+{
+	return hash_pair_from_avalanching_hash(key->hash);
+}
+
+static bool
+drgn_interned_string_key_eq(const struct drgn_interned_string_key *a,
+			    const struct drgn_interned_string_key *b)
+{
+	return (a->len == b->len &&
+		(a->len == 0 || memcmp(a->str, b->str, a->len) == 0));
+}
+
+DEFINE_HASH_TABLE_FUNCTIONS(drgn_interned_string_set,
+			    drgn_interned_string_key_hash_pair,
+			    drgn_interned_string_key_eq)
+
+struct drgn_error *drgn_program_intern_string(struct drgn_program *prog,
+					      const char *str, size_t len,
+					      const char **ret)
+{
+	if (!str) {
+		*ret = NULL;
+		return NULL;
+	}
+
+	struct drgn_interned_string_key key = {
+		.str = str,
+		.len = len,
+		.hash = hash_bytes(str, len),
+	};
+	struct hash_pair hp = drgn_interned_string_set_hash(&key);
+	struct drgn_error *err;
+	drgn_program_lock_types(prog);
+	struct drgn_interned_string_set_iterator it =
+		drgn_interned_string_set_search_hashed(&prog->interned_strings,
+						       &key, hp);
+	if (it.entry) {
+		*ret = (*it.entry)->str;
+		err = NULL;
+		goto out;
+	}
+
+	struct drgn_interned_string *interned;
+	size_t size;
+	if (__builtin_add_overflow(sizeof(*interned), len, &size) ||
+	    __builtin_add_overflow(size, 1, &size) ||
+	    !(interned = malloc(size))) {
+		err = &drgn_enomem;
+		goto out;
+	}
+	interned->hash = key.hash;
+	interned->len = len;
+	memcpy(interned->str, str, len);
+	interned->str[len] = '\0';
+	if (drgn_interned_string_set_insert_searched(&prog->interned_strings,
+						     &interned, hp,
+						     NULL) == -1) {
+		free(interned);
+		err = &drgn_enomem;
+		goto out;
+	}
+	*ret = interned->str;
+	err = NULL;
+out:
+	drgn_program_unlock_types(prog);
+	return err;
+}
+
+static inline struct drgn_error *
+drgn_program_intern_c_string(struct drgn_program *prog, const char *str,
+			     const char **ret)
+{
+	return drgn_program_intern_string(prog, str, str ? strlen(str) : 0,
+					  ret);
+}
+
+const char *drgn_program_find_interned_string(struct drgn_program *prog,
+					      const char *str, size_t len)
+{
+	struct drgn_interned_string_key key = {
+		.str = str,
+		.len = len,
+		.hash = hash_bytes(str, len),
+	};
+	drgn_program_lock_types(prog);
+	struct drgn_interned_string_set_iterator it =
+		drgn_interned_string_set_search(&prog->interned_strings, &key);
+	const char *ret = it.entry ? (*it.entry)->str : NULL;
+	drgn_program_unlock_types(prog);
+	return ret;
+}
+
 static struct hash_pair
 drgn_member_key_hash_pair(const struct drgn_member_key *key)
 {
-	size_t hash;
-	if (key->name)
-		hash = hash_bytes(key->name, key->name_len);
-	else
-		hash = 0;
-	hash = hash_combine((uintptr_t)key->type, hash);
+	size_t hash = hash_combine((uintptr_t)key->type,
+				   drgn_interned_string_hash(key->name));
 	return hash_pair_from_avalanching_hash(hash);
 }
 
 static bool drgn_member_key_eq(const struct drgn_member_key *a,
 			       const struct drgn_member_key *b)
 {
-	return (a->type == b->type && a->name_len == b->name_len &&
-		(!a->name_len || memcmp(a->name, b->name, a->name_len) == 0));
+	return a->type == b->type && a->name == b->name;
 }
 
 DEFINE_HASH_TABLE_FUNCTIONS(drgn_member_map, drgn_member_key_hash_pair,
 			    drgn_member_key_eq)
 
 DEFINE_HASH_TABLE_FUNCTIONS(drgn_type_set, ptr_key_hash_pair, scalar_key_eq)
+DEFINE_HASH_TABLE_FUNCTIONS(drgn_type_value_mask_map, ptr_key_hash_pair,
+			    scalar_key_eq)
 
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_member_object(struct drgn_type_member *member,
@@ -256,8 +348,10 @@ drgn_type_dedupe_hash_pair(struct drgn_type * const *entry)
 	size_t hash = hash_combine(drgn_type_kind(type),
 				   drgn_type_is_complete(type));
 	hash = hash_combine(hash, (uintptr_t)drgn_type_language(type));
-	if (drgn_type_has_name(type))
-		hash = hash_combine(hash, hash_c_string(drgn_type_name(type)));
+	if (drgn_type_has_name(type)) {
+		hash = hash_combine(hash,
+				    drgn_interned_string_hash(drgn_type_name(type)));
+	}
 	if (drgn_type_has_size(type))
 		hash = hash_combine(hash, drgn_type_size(type));
 	if (drgn_type_has_is_signed(type))
@@ -266,7 +360,7 @@ drgn_type_dedupe_hash_pair(struct drgn_type * const *entry)
 		hash = hash_combine(hash, drgn_type_little_endian(type));
 	const char *tag;
 	if (drgn_type_has_tag(type) && (tag = drgn_type_tag(type)))
-		hash = hash_combine(hash, hash_c_string(tag));
+		hash = hash_combine(hash, drgn_interned_string_hash(tag));
 	if (drgn_type_has_type(type)) {
 		struct drgn_qualified_type qualified_type =
 			drgn_type_type(type);
@@ -290,8 +384,8 @@ static bool drgn_type_dedupe_eq(struct drgn_type * const *entry_a,
 	    drgn_type_is_complete(a) != drgn_type_is_complete(b) ||
 	    drgn_type_language(a) != drgn_type_language(b))
 		return false;
-	if (drgn_type_has_name(a) &&
-	    strcmp(drgn_type_name(a), drgn_type_name(b)) != 0)
+	/* Names and tags are interned, so they can be compared by address. */
+	if (drgn_type_has_name(a) && drgn_type_name(a) != drgn_type_name(b))
 		return false;
 	if (drgn_type_has_size(a) && drgn_type_size(a) != drgn_type_size(b))
 		return false;
@@ -301,12 +395,8 @@ static bool drgn_type_dedupe_eq(struct drgn_type * const *entry_a,
 	if (drgn_type_has_little_endian(a) &&
 	    drgn_type_little_endian(a) != drgn_type_little_endian(b))
 		return false;
-	if (drgn_type_has_tag(a)) {
-		const char *tag_a = drgn_type_tag(a);
-		const char *tag_b = drgn_type_tag(b);
-		if ((!tag_a != !tag_b) || (tag_a && strcmp(tag_a, tag_b) != 0))
-			return false;
-	}
+	if (drgn_type_has_tag(a) && drgn_type_tag(a) != drgn_type_tag(b))
+		return false;
 	if (drgn_type_has_type(a)) {
 		struct drgn_qualified_type type_a = drgn_type_type(a);
 		struct drgn_qualified_type type_b = drgn_type_type(b);
@@ -335,28 +425,46 @@ DEFINE_VECTOR_FUNCTIONS(drgn_typep_vector)
 static struct drgn_error *find_or_create_type(struct drgn_type *key,
 					      struct drgn_type **ret)
 {
+	struct drgn_error *err;
 	struct drgn_program *prog = key->_private.program;
 	struct hash_pair hp = drgn_dedupe_type_set_hash(&key);
+	drgn_program_lock_types(prog);
 	struct drgn_dedupe_type_set_iterator it =
 		drgn_dedupe_type_set_search_hashed(&prog->dedupe_types, &key,
 						   hp);
 	if (it.entry) {
 		*ret = *it.entry;
-		return NULL;
+		err = NULL;
+		goto out;
 	}
 
 	struct drgn_type *type = malloc(sizeof(*type));
-	if (!type)
-		return &drgn_enomem;
+	if (!type) {
+		err = &drgn_enomem;
+		goto out;
+	}
 
 	*type = *key;
 	if (!drgn_dedupe_type_set_insert_searched(&prog->dedupe_types, &type,
 						  hp, NULL)) {
 		free(type);
-		return &drgn_enomem;
+		err = &drgn_enomem;
+		goto out;
 	}
 	*ret = type;
-	return NULL;
+	err = NULL;
+out:
+	drgn_program_unlock_types(prog);
+	return err;
+}
+
+/* Add a type which isn't deduplicated to drgn_program::created_types. */
+static bool add_created_type(struct drgn_program *prog, struct drgn_type *type)
+{
+	drgn_program_lock_types(prog);
+	bool ret = drgn_typep_vector_append(&prog->created_types, &type);
+	drgn_program_unlock_types(prog);
+	return ret;
 }
 
 struct drgn_type *drgn_void_type(struct drgn_program *prog,
@@ -403,6 +511,10 @@ struct drgn_error *drgn_int_type_create(struct drgn_program *prog,
 	else
 		primitive = DRGN_NOT_PRIMITIVE_TYPE;
 
+	err = drgn_program_intern_c_string(prog, name, &name);
+	if (err)
+		return err;
+
 	struct drgn_type key = {
 		{
 			.kind = DRGN_TYPE_INT,
@@ -436,6 +548,10 @@ struct drgn_error *drgn_bool_type_create(struct drgn_program *prog,
 	else
 		primitive = DRGN_NOT_PRIMITIVE_TYPE;
 
+	err = drgn_program_intern_c_string(prog, name, &name);
+	if (err)
+		return err;
+
 	struct drgn_type key = {
 		{
 			.kind = DRGN_TYPE_BOOL,
@@ -468,6 +584,10 @@ struct drgn_error *drgn_float_type_create(struct drgn_program *prog,
 	else
 		primitive = DRGN_NOT_PRIMITIVE_TYPE;
 
+	err = drgn_program_intern_c_string(prog, name, &name);
+	if (err)
+		return err;
+
 	struct drgn_type key = {
 		{
 			.kind = DRGN_TYPE_FLOAT,
@@ -556,6 +676,10 @@ drgn_compound_type_builder_add_member(struct drgn_compound_type_builder *builder
 					    builder->template_builder.prog);
 	if (err)
 		return err;
+	err = drgn_program_intern_c_string(builder->template_builder.prog,
+					   name, &name);
+	if (err)
+		return err;
 	struct drgn_type_member *member =
 		drgn_type_member_vector_append_entry(&builder->members);
 	if (!member)
@@ -586,6 +710,10 @@ drgn_compound_type_create(struct drgn_compound_type_builder *builder,
 		}
 	}
 
+	err = drgn_program_intern_c_string(prog, tag, &tag);
+	if (err)
+		return err;
+
 	if (!builder->members.size &&
 	    !builder->template_builder.parameters.size) {
 		struct drgn_type key = {
@@ -609,7 +737,7 @@ drgn_compound_type_create(struct drgn_compound_type_builder *builder,
 	struct drgn_type *type = malloc(sizeof(*type));
 	if (!type)
 		return &drgn_enomem;
-	if (!drgn_typep_vector_append(&prog->created_types, &type)) {
+	if (!add_created_type(prog, type)) {
 		free(type);
 		return &drgn_enomem;
 	}
@@ -652,6 +780,10 @@ struct drgn_error *
 drgn_enum_type_builder_add_signed(struct drgn_enum_type_builder *builder,
 				  const char *name, int64_t svalue)
 {
+	struct drgn_error *err = drgn_program_intern_c_string(builder->prog,
+							      name, &name);
+	if (err)
+		return err;
 	struct drgn_type_enumerator *enumerator =
 		drgn_type_enumerator_vector_append_entry(&builder->enumerators);
 	if (!enumerator)
@@ -665,6 +797,10 @@ struct drgn_error *
 drgn_enum_type_builder_add_unsigned(struct drgn_enum_type_builder *builder,
 				    const char *name, uint64_t uvalue)
 {
+	struct drgn_error *err = drgn_program_intern_c_string(builder->prog,
+							      name, &name);
+	if (err)
+		return err;
 	struct drgn_type_enumerator *enumerator =
 		drgn_type_enumerator_vector_append_entry(&builder->enumerators);
 	if (!enumerator)
@@ -691,6 +827,10 @@ struct drgn_error *drgn_enum_type_create(struct drgn_enum_type_builder *builder,
 					 "compatible type of enum type must be integer type");
 	}
 
+	err = drgn_program_intern_c_string(builder->prog, tag, &tag);
+	if (err)
+		return err;
+
 	if (!builder->enumerators.size) {
 		struct drgn_type key = {
 			{
@@ -713,7 +853,7 @@ struct drgn_error *drgn_enum_type_create(struct drgn_enum_type_builder *builder,
 	struct drgn_type *type = malloc(sizeof(*type));
 	if (!type)
 		return &drgn_enomem;
-	if (!drgn_typep_vector_append(&builder->prog->created_types, &type)) {
+	if (!add_created_type(builder->prog, type)) {
 		free(type);
 		return &drgn_enomem;
 	}
@@ -740,6 +880,10 @@ drgn_incomplete_enum_type_create(struct drgn_program *prog, const char *tag,
 				 const struct drgn_language *lang,
 				 struct drgn_type **ret)
 {
+	struct drgn_error *err = drgn_program_intern_c_string(prog, tag, &tag);
+	if (err)
+		return err;
+
 	struct drgn_type key = {
 		{
 			.kind = DRGN_TYPE_ENUM,
@@ -772,6 +916,11 @@ drgn_typedef_type_create(struct drgn_program *prog, const char *name,
 	else
 		primitive = DRGN_NOT_PRIMITIVE_TYPE;
 
+	struct drgn_error *err = drgn_program_intern_c_string(prog, name,
+							      &name);
+	if (err)
+		return err;
+
 	struct drgn_type key = {
 		{
 			.kind = DRGN_TYPE_TYPEDEF,
@@ -946,7 +1095,7 @@ drgn_function_type_create(struct drgn_function_type_builder *builder,
 	struct drgn_type *type = malloc(sizeof(*type));
 	if (!type)
 		return &drgn_enomem;
-	if (!drgn_typep_vector_append(&prog->created_types, &type)) {
+	if (!add_created_type(prog, type)) {
 		free(type);
 		return &drgn_enomem;
 	}
@@ -1149,6 +1298,114 @@ bool drgn_type_is_scalar(struct drgn_type *type)
 	}
 }
 
+static struct drgn_error *drgn_type_eq_impl(struct drgn_type *a,
+					    struct drgn_type *b, bool shallow,
+					    bool *ret)
+{
+	struct drgn_error *err;
+
+	a = drgn_underlying_type(a);
+	b = drgn_underlying_type(b);
+	*ret = false;
+	if (a == b) {
+		*ret = true;
+		return NULL;
+	}
+	if (drgn_type_kind(a) != drgn_type_kind(b) ||
+	    (!shallow &&
+	     drgn_type_is_complete(a) != drgn_type_is_complete(b)))
+		return NULL;
+	/* Names and tags are interned, so they can be compared by address. */
+	switch (drgn_type_kind(a)) {
+	case DRGN_TYPE_STRUCT:
+	case DRGN_TYPE_UNION:
+	case DRGN_TYPE_CLASS:
+		if (drgn_type_tag(a) != drgn_type_tag(b))
+			return NULL;
+		if (shallow || !drgn_type_is_complete(a)) {
+			*ret = true;
+			return NULL;
+		}
+		if (drgn_type_size(a) != drgn_type_size(b) ||
+		    drgn_type_num_members(a) != drgn_type_num_members(b))
+			return NULL;
+		for (size_t i = 0; i < drgn_type_num_members(a); i++) {
+			struct drgn_type_member *member_a =
+				&drgn_type_members(a)[i];
+			struct drgn_type_member *member_b =
+				&drgn_type_members(b)[i];
+			if (member_a->name != member_b->name ||
+			    member_a->bit_offset != member_b->bit_offset)
+				return NULL;
+			struct drgn_qualified_type type_a, type_b;
+			uint64_t bit_field_size_a, bit_field_size_b;
+			err = drgn_member_type(member_a, &type_a,
+					       &bit_field_size_a);
+			if (err)
+				return err;
+			err = drgn_member_type(member_b, &type_b,
+					       &bit_field_size_b);
+			if (err)
+				return err;
+			if (bit_field_size_a != bit_field_size_b)
+				return NULL;
+			err = drgn_type_eq_impl(type_a.type, type_b.type, false,
+						ret);
+			if (err || !*ret)
+				return err;
+		}
+		return NULL;
+	case DRGN_TYPE_ENUM:
+		if (drgn_type_tag(a) != drgn_type_tag(b))
+			return NULL;
+		if (!drgn_type_is_complete(a)) {
+			*ret = true;
+			return NULL;
+		}
+		if (drgn_type_num_enumerators(a) !=
+		    drgn_type_num_enumerators(b))
+			return NULL;
+		for (size_t i = 0; i < drgn_type_num_enumerators(a); i++) {
+			struct drgn_type_enumerator *enumerator_a =
+				&drgn_type_enumerators(a)[i];
+			struct drgn_type_enumerator *enumerator_b =
+				&drgn_type_enumerators(b)[i];
+			if (enumerator_a->name != enumerator_b->name ||
+			    enumerator_a->uvalue != enumerator_b->uvalue)
+				return NULL;
+		}
+		return drgn_type_eq_impl(drgn_type_type(a).type,
+					 drgn_type_type(b).type, false, ret);
+	case DRGN_TYPE_ARRAY:
+		if (drgn_type_is_complete(a) &&
+		    drgn_type_length(a) != drgn_type_length(b))
+			return NULL;
+		return drgn_type_eq_impl(drgn_type_type(a).type,
+					 drgn_type_type(b).type, shallow, ret);
+	case DRGN_TYPE_POINTER:
+		if (drgn_type_size(a) != drgn_type_size(b))
+			return NULL;
+		/*
+		 * Only compare the referenced types by name so that recursive
+		 * types terminate.
+		 */
+		return drgn_type_eq_impl(drgn_type_type(a).type,
+					 drgn_type_type(b).type, true, ret);
+	default:
+		/*
+		 * Other types are deduplicated when they are created, so equal
+		 * types are the same object.
+		 */
+		return NULL;
+	}
+}
+
+struct drgn_error *drgn_type_eq(struct drgn_type *a, struct drgn_type *b,
+				bool *ret)
+{
+	return drgn_type_eq_impl(a, b, false, ret);
+}
+
 LIBDRGN_PUBLIC struct drgn_error *drgn_type_sizeof(struct drgn_type *type,
 						   uint64_t *ret)
 {
@@ -1298,16 +1555,23 @@ void drgn_program_init_types(struct drgn_program *prog)
 		type->_private.program = prog;
 		type->_private.language = &drgn_languages[i];
 	}
+	drgn_interned_string_set_init(&prog->interned_strings);
 	drgn_dedupe_type_set_init(&prog->dedupe_types);
 	drgn_typep_vector_init(&prog->created_types);
 	drgn_member_map_init(&prog->members);
 	drgn_type_set_init(&prog->members_cached);
+	drgn_type_value_mask_map_init(&prog->value_masks);
 }
 
 void drgn_program_deinit_types(struct drgn_program *prog)
 {
 	drgn_member_map_deinit(&prog->members);
 	drgn_type_set_deinit(&prog->members_cached);
+	for (struct drgn_type_value_mask_map_iterator it =
+	     drgn_type_value_mask_map_first(&prog->value_masks);
+	     it.entry; it = drgn_type_value_mask_map_next(it))
+		free(it.entry->value);
+	drgn_type_value_mask_map_deinit(&prog->value_masks);
 
 	for (size_t i = 0; i < prog->created_types.size; i++) {
 		struct drgn_type *type = prog->created_types.data[i];
@@ -1339,6 +1603,12 @@ void drgn_program_deinit_types(struct drgn_program *prog)
 		free(*it.entry);
 	drgn_dedupe_type_set_deinit(&prog->dedupe_types);
 
+	for (struct drgn_interned_string_set_iterator it =
+	     drgn_interned_string_set_first(&prog->interned_strings);
+	     it.entry; it = drgn_interned_string_set_next(it))
+		free(*it.entry);
+	drgn_interned_string_set_deinit(&prog->interned_strings);
+
 	struct drgn_type_finder *finder = prog->type_finders;
 	while (finder) {
 		struct drgn_type_finder *next = finder->next;
@@ -1358,6 +1628,7 @@ drgn_program_add_type_finder(struct drgn_program *prog, drgn_type_find_fn fn,
 	finder->arg = arg;
 	finder->next = prog->type_finders;
 	prog->type_finders = finder;
+	drgn_program_clear_expressions(prog);
 	return NULL;
 }
 
@@ -1458,10 +1729,10 @@ default_size_t_or_ptrdiff_t(struct drgn_program *prog,
 				 drgn_primitive_type_spellings[type][0]);
 }
 
-struct drgn_error *
-drgn_program_find_primitive_type(struct drgn_program *prog,
-				 enum drgn_primitive_type type,
-				 struct drgn_type **ret)
+static struct drgn_error *
+drgn_program_find_primitive_type_locked(struct drgn_program *prog,
+					enum drgn_primitive_type type,
+					struct drgn_type **ret)
 {
 	struct drgn_error *err;
 	struct drgn_qualified_type qualified_type;
@@ -1581,10 +1852,25 @@ drgn_program_find_primitive_type(struct drgn_program *prog,
 	assert(drgn_type_primitive(*ret) == type);
 
 out:
-	prog->primitive_types[type] = *ret;
+	__atomic_store_n(&prog->primitive_types[type], *ret, __ATOMIC_RELEASE);
 	return NULL;
 }
 
+struct drgn_error *
+drgn_program_find_primitive_type(struct drgn_program *prog,
+				 enum drgn_primitive_type type,
+				 struct drgn_type **ret)
+{
+	*ret = __atomic_load_n(&prog->primitive_types[type], __ATOMIC_ACQUIRE);
+	if (*ret)
+		return NULL;
+	drgn_program_lock_types(prog);
+	struct drgn_error *err =
+		drgn_program_find_primitive_type_locked(prog, type, ret);
+	drgn_program_unlock_types(prog);
+	return err;
+}
+
 static struct drgn_error *
 drgn_type_cache_members(struct drgn_type *outer_type,
 			struct drgn_type *type, uint64_t bit_offset)
@@ -1603,7 +1889,6 @@ drgn_type_cache_members(struct drgn_type *outer_type,
 				.key = {
 					.type = outer_type,
 					.name = member->name,
-					.name_len = strlen(member->name),
 				},
 				.value = {
 					.member = member,
@@ -1653,21 +1938,33 @@ drgn_type_offsetof(struct drgn_type *type, const char *member_designator,
 }
 
 static struct drgn_error *
-drgn_type_find_member_impl(struct drgn_type *type, const char *member_name,
-			   size_t member_name_len,
-			   struct drgn_member_value **ret)
+drgn_type_find_member_locked(struct drgn_type *type, const char *member_name,
+			     size_t member_name_len,
+			     struct drgn_member_value *ret)
 {
 	struct drgn_program *prog = drgn_type_program(type);
 	const struct drgn_member_key key = {
 		.type = drgn_underlying_type(type),
-		.name = member_name,
-		.name_len = member_name_len,
+		.name = drgn_program_find_interned_string(prog, member_name,
+							  member_name_len),
 	};
+	/*
+	 * Member names are always interned, so if the name was never interned,
+	 * then no type has a member with that name.
+	 */
+	if (!key.name) {
+		if (!drgn_type_has_members(key.type)) {
+			return drgn_type_error("'%s' is not a structure, union, or class",
+					       type);
+		}
+		ret->member = NULL;
+		return NULL;
+	}
 	struct hash_pair hp = drgn_member_map_hash(&key);
 	struct drgn_member_map_iterator it =
 		drgn_member_map_search_hashed(&prog->members, &key, hp);
 	if (it.entry) {
-		*ret = &it.entry->value;
+		*ret = it.entry->value;
 		return NULL;
 	}
 
@@ -1688,7 +1985,7 @@ drgn_type_find_member_impl(struct drgn_type *type, const char *member_name,
 	struct hash_pair cached_hp = drgn_type_set_hash(&key.type);
 	if (drgn_type_set_search_hashed(&prog->members_cached, &key.type,
 					cached_hp).entry) {
-		*ret = NULL;
+		ret->member = NULL;
 		return NULL;
 	}
 
@@ -1702,14 +1999,32 @@ drgn_type_find_member_impl(struct drgn_type *type, const char *member_name,
 
 	it = drgn_member_map_search_hashed(&prog->members, &key, hp);
 	if (it.entry) {
-		*ret = &it.entry->value;
+		*ret = it.entry->value;
 		return NULL;
 	}
 
-	*ret = NULL;
+	ret->member = NULL;
 	return NULL;
 }
 
+/*
+ * The member cache may be modified by other threads, so the result is copied
+ * out while holding the types lock.
+ */
+static struct drgn_error *
+drgn_type_find_member_impl(struct drgn_type *type, const char *member_name,
+			   size_t member_name_len,
+			   struct drgn_member_value *ret)
+{
+	struct drgn_program *prog = drgn_type_program(type);
+	drgn_program_lock_types(prog);
+	struct drgn_error *err = drgn_type_find_member_locked(type, member_name,
+							      member_name_len,
+							      ret);
+	drgn_program_unlock_types(prog);
+	return err;
+}
+
 LIBDRGN_PUBLIC struct drgn_error *
 drgn_type_find_member_len(struct drgn_type *type, const char *member_name,
 			  size_t member_name_len,
@@ -1717,12 +2032,12 @@ drgn_type_find_member_len(struct drgn_type *type, const char *member_name,
 			  uint64_t *bit_offset_ret)
 {
 	struct drgn_error *err;
-	struct drgn_member_value *member;
+	struct drgn_member_value member;
 	err = drgn_type_find_member_impl(type, member_name, member_name_len,
 					 &member);
 	if (err)
 		return err;
-	if (!member) {
+	if (!member.member) {
 		struct drgn_qualified_type qualified_type = { type };
 		char *type_name;
 		err = drgn_format_type_name(qualified_type, &type_name);
@@ -1737,8 +2052,8 @@ drgn_type_find_member_len(struct drgn_type *type, const char *member_name,
 		free(type_name);
 		return err;
 	}
-	*member_ret = member->member;
-	*bit_offset_ret = member->bit_offset;
+	*member_ret = member.member;
+	*bit_offset_ret = member.bit_offset;
 	return NULL;
 }
 
@@ -1747,11 +2062,208 @@ drgn_type_has_member_len(struct drgn_type *type, const char *member_name,
 			 size_t member_name_len, bool *ret)
 {
 	struct drgn_error *err;
-	struct drgn_member_value *member;
+	struct drgn_member_value member;
 	err = drgn_type_find_member_impl(type, member_name, member_name_len,
 					 &member);
 	if (err)
 		return err;
-	*ret = member != NULL;
+	*ret = member.member != NULL;
 	return NULL;
 }
+
+/* Don't cache masks bigger than this; callers fall back to a slower path. */
+#define DRGN_TYPE_VALUE_MASK_MAX_SIZE (UINT64_C(16) * 1024 * 1024)
+
+static void set_value_mask_bits(unsigned char *mask, uint64_t bit_offset,
+				uint64_t bit_size, bool little_endian)
+{
+	while (bit_size && bit_offset % 8) {
+		mask[bit_offset / 8] |= (little_endian ?
+					 1 << (bit_offset % 8) :
+					 0x80 >> (bit_offset % 8));
+		bit_offset++;
+		bit_size--;
+	}
+	memset(&mask[bit_offset / 8], 0xff, bit_size / 8);
+	bit_offset += bit_size / 8 * 8;
+	for (uint64_t i = 0; i < bit_size % 8; i++) {
+		mask[bit_offset / 8] |= (little_endian ?
+					 1 << (bit_offset % 8) :
+					 0x80 >> (bit_offset % 8));
+		bit_offset++;
+	}
+}
+
+static struct drgn_error *
+set_value_mask(struct drgn_type *type, uint64_t bit_offset,
+	       uint64_t bit_field_size, bool little_endian, unsigned char *mask,
+	       bool *has_float)
+{
+	struct drgn_error *err;
+	struct drgn_type *underlying_type = drgn_underlying_type(type);
+	uint64_t bit_size;
+
+	switch (drgn_type_kind(underlying_type)) {
+	case DRGN_TYPE_FLOAT:
+		*has_float = true;
+		/* fallthrough */
+	case DRGN_TYPE_INT:
+	case DRGN_TYPE_BOOL:
+	case DRGN_TYPE_ENUM:
+	case DRGN_TYPE_POINTER:
+		if (bit_field_size) {
+			bit_size = bit_field_size;
+		} else {
+			err = drgn_type_bit_size(underlying_type, &bit_size);
+			if (err)
+				return err;
+		}
+		set_value_mask_bits(mask, bit_offset, bit_size, little_endian);
+		return NULL;
+	case DRGN_TYPE_STRUCT:
+	case DRGN_TYPE_UNION:
+	case DRGN_TYPE_CLASS: {
+		if (!drgn_type_is_complete(underlying_type)) {
+			return drgn_error_incomplete_type("cannot get value mask of %s type",
+							  underlying_type);
+		}
+		struct drgn_type_member *members =
+			drgn_type_members(underlying_type);
+		size_t num_members = drgn_type_num_members(underlying_type);
+		for (size_t i = 0; i < num_members; i++) {
+			struct drgn_qualified_type member_type;
+			uint64_t member_bit_field_size;
+			err = drgn_member_type(&members[i], &member_type,
+					       &member_bit_field_size);
+			if (err)
+				return err;
+			err = set_value_mask(member_type.type,
+					     bit_offset + members[i].bit_offset,
+					     member_bit_field_size,
+					     little_endian, mask, has_float);
+			if (err)
+				return err;
+		}
+		return NULL;
+	}
+	case DRGN_TYPE_ARRAY: {
+		uint64_t length = drgn_type_length(underlying_type);
+		if (!length)
+			return NULL;
+		struct drgn_type *element_type =
+			drgn_type_type(underlying_type).type;
+		uint64_t element_bit_size;
+		err = drgn_type_bit_size(element_type, &element_bit_size);
+		if (err)
+			return err;
+		err = set_value_mask(element_type, bit_offset, 0,
+				     little_endian, mask, has_float);
+		if (err)
+			return err;
+		if (bit_offset % 8 || element_bit_size % 8) {
+			for (uint64_t i = 1; i < length; i++) {
+				err = set_value_mask(element_type,
+						     bit_offset +
+						     i * element_bit_size,
+						     0, little_endian, mask,
+						     has_float);
+				if (err)
+					return err;
+			}
+		} else {
+			/* Replicate the mask of the first element. */
+			unsigned char *first = &mask[bit_offset / 8];
+			uint64_t element_size = element_bit_size / 8;
+			for (uint64_t i = 1; i < length; i++) {
+				unsigned char *element =
+					first + i * element_size;
+				for (uint64_t j = 0; j < element_size; j++)
+					element[j] |= first[j];
+			}
+		}
+		return NULL;
+	}
+	case DRGN_TYPE_VOID:
+	case DRGN_TYPE_FUNCTION:
+		return drgn_error_format(DRGN_ERROR_TYPE,
+					 "%s type has no value mask",
+					 drgn_type_kind_spelling[drgn_type_kind(underlying_type)]);
+	case DRGN_TYPE_TYPEDEF:
+	default:
+		UNREACHABLE();
+	}
+}
+
+static struct drgn_error *
+drgn_type_value_mask_locked(struct drgn_type *type,
+			    const struct drgn_type_value_mask **ret)
+{
+	struct drgn_error *err;
+	struct drgn_program *prog = drgn_type_program(type);
+
+	struct drgn_type_value_mask_map_entry entry = {
+		.key = drgn_underlying_type(type),
+	};
+	struct hash_pair hp = drgn_type_value_mask_map_hash(&entry.key);
+	struct drgn_type_value_mask_map_iterator it =
+		drgn_type_value_mask_map_search_hashed(&prog->value_masks,
+						       &entry.key, hp);
+	if (it.entry) {
+		*ret = it.entry->value;
+		return NULL;
+	}
+
+	uint64_t size;
+	err = drgn_type_sizeof(entry.key, &size);
+	if (err)
+		return err;
+	if (size > DRGN_TYPE_VALUE_MASK_MAX_SIZE)
+		return &drgn_not_found;
+	bool little_endian;
+	err = drgn_program_is_little_endian(prog, &little_endian);
+	if (err)
+		return err;
+
+	entry.value = calloc(1, sizeof(*entry.value) + size);
+	if (!entry.value)
+		return &drgn_enomem;
+	entry.value->size = size;
+	err = set_value_mask(entry.key, 0, 0, little_endian, entry.value->mask,
+			     &entry.value->has_float);
+	if (err) {
+		free(entry.value);
+		return err;
+	}
+	uint64_t i;
+	for (i = 0; i < size; i++) {
+		if (entry.value->mask[i] != 0xff)
+			break;
+	}
+	if (i == size) {
+		/* Don't keep a mask of all ones. */
+		struct drgn_type_value_mask *tmp =
+			realloc(entry.value, sizeof(*entry.value));
+		if (tmp)
+			entry.value = tmp;
+		entry.value->dense = true;
+	}
+
+	if (drgn_type_value_mask_map_insert_searched(&prog->value_masks,
+						     &entry, hp, NULL) == -1) {
+		free(entry.value);
+		return &drgn_enomem;
+	}
+	*ret = entry.value;
+	return NULL;
+}
+
+struct drgn_error *
+drgn_type_value_mask(struct drgn_type *type,
+		     const struct drgn_type_value_mask **ret)
+{
+	struct drgn_program *prog = drgn_type_program(type);
+	drgn_program_lock_types(prog);
+	struct drgn_error *err = drgn_type_value_mask_locked(type, ret);
+	drgn_program_unlock_types(prog);
+	return err;
+}
@@ -16,6 +16,7 @@
 
 #include "drgn.h"
 #include "hash_table.h"
+#include "util.h"
 #include "vector.h"
 
 struct drgn_language;
@@ -62,11 +63,82 @@ struct drgn_type_finder {
 
 DEFINE_HASH_SET_TYPE(drgn_dedupe_type_set, struct drgn_type *)
 
-/** <tt>(type, member name)</tt> pair. */
+/**
+ * String interned in a @ref drgn_program.
+ *
+ * Type names, tags, member names, and enumerator names are interned so that
+ * they can be compared by address and hashed without rehashing the string.
+ * Identical names from different files share one copy.
+ */
+struct drgn_interned_string {
+	/** Hash of @ref drgn_interned_string::str. */
+	size_t hash;
+	/** Length of @ref drgn_interned_string::str. */
+	size_t len;
+	/** Null-terminated string. */
+	char str[];
+};
+
+/** Key for looking up a @ref drgn_interned_string. */
+struct drgn_interned_string_key {
+	const char *str;
+	size_t len;
+	size_t hash;
+};
+
+static inline struct drgn_interned_string_key
+drgn_interned_string_to_key(struct drgn_interned_string * const *entry)
+{
+	return (struct drgn_interned_string_key){
+		.str = (*entry)->str,
+		.len = (*entry)->len,
+		.hash = (*entry)->hash,
+	};
+}
+
+DEFINE_HASH_TABLE_TYPE(drgn_interned_string_set,
+		       struct drgn_interned_string *,
+		       drgn_interned_string_to_key)
+
+/**
+ * Intern a string in a @ref drgn_program.
+ *
+ * @param[in] str String to intern. Not necessarily null-terminated. May be @c
+ * NULL, in which case @p ret is set to @c NULL.
+ * @param[in] len Length of @p str.
+ * @param[out] ret Returned interned copy of @p str, which is valid for the
+ * lifetime of @p prog.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_program_intern_string(struct drgn_program *prog,
+					      const char *str, size_t len,
+					      const char **ret);
+
+/**
+ * Find an already interned string in a @ref drgn_program.
+ *
+ * @return The interned string, or @c NULL if it has not been interned.
+ */
+const char *drgn_program_find_interned_string(struct drgn_program *prog,
+					      const char *str, size_t len);
+
+/**
+ * Get the precomputed hash of a string returned by @ref
+ * drgn_program_intern_string().
+ */
+static inline size_t drgn_interned_string_hash(const char *str)
+{
+	return container_of(str, struct drgn_interned_string, str[0])->hash;
+}
+
+/**
+ * <tt>(type, member name)</tt> pair.
+ *
+ * The name is interned, so it is hashed and compared by address.
+ */
 struct drgn_member_key {
 	struct drgn_type *type;
 	const char *name;
-	size_t name_len;
 };
 
 /** Type, offset, and bit field size of a type member. */
@@ -75,6 +147,26 @@ struct drgn_member_value {
 	uint64_t bit_offset;
 };
 
+/**
+ * Bits of the representation of a type which are part of its value.
+ *
+ * Padding between and after members and unused bits next to bit fields are
+ * not part of the value.
+ */
+struct drgn_type_value_mask {
+	/** Size of the type in bytes. */
+	uint64_t size;
+	/**
+	 * Whether every bit is part of the value, in which case @ref mask is
+	 * empty.
+	 */
+	bool dense;
+	/** Whether the type contains a floating-point value. */
+	bool has_float;
+	/** If not @ref dense, bytes with the bits of the value set. */
+	unsigned char mask[];
+};
+
 #ifdef DOXYGEN
 /**
  * @struct drgn_member_map
@@ -86,13 +178,33 @@ struct drgn_member_value {
  * @struct drgn_type_set
  *
  * Set of types compared by address.
+ *
+ * @struct drgn_type_value_mask_map
+ *
+ * Map from a type to its @ref drgn_type_value_mask.
  */
 #else
 DEFINE_HASH_MAP_TYPE(drgn_member_map, struct drgn_member_key,
 		      struct drgn_member_value)
 DEFINE_HASH_SET_TYPE(drgn_type_set, struct drgn_type *)
+DEFINE_HASH_MAP_TYPE(drgn_type_value_mask_map, struct drgn_type *,
+		     struct drgn_type_value_mask *)
 #endif
 
+/**
+ * Get the @ref drgn_type_value_mask of a type.
+ *
+ * The mask is computed from the layout of the type the first time and cached
+ * for the lifetime of the program.
+ *
+ * @param[out] ret Returned mask.
+ * @return @c NULL on success, &@ref drgn_not_found if the type is too large to
+ * cache a mask for, non-@c NULL on other error.
+ */
+struct drgn_error *
+drgn_type_value_mask(struct drgn_type *type,
+		     const struct drgn_type_value_mask **ret);
+
 /**
  * @defgroup TypeCreation Type creation
  *
@@ -126,8 +238,8 @@ struct drgn_type *drgn_void_type(struct drgn_program *prog,
  * Create an integer type.
  *
  * @param[in] prog Program owning type.
- * @param[in] name Name of the type. Not copied; must remain valid for the
- * lifetime of @p prog. Must not be @c NULL.
+ * @param[in] name Name of the type. Interned (see @ref
+ * drgn_program_intern_string()). Must not be @c NULL.
  * @param[in] size Size of the type in bytes.
  * @param[in] is_signed Whether the type is signed.
  * @param[in] lang Language of the type or @c NULL for the default language of
@@ -146,8 +258,8 @@ struct drgn_error *drgn_int_type_create(struct drgn_program *prog,
  * Create a boolean type.
  *
  * @param[in] prog Program owning type.
- * @param[in] name Name of the type. Not copied; must remain valid for the
- * lifetime of @p prog. Must not be @c NULL.
+ * @param[in] name Name of the type. Interned (see @ref
+ * drgn_program_intern_string()). Must not be @c NULL.
  * @param[in] size Size of the type in bytes.
  * @param[in] lang Language of the type or @c NULL for the default language of
  * @p prog.
@@ -164,8 +276,8 @@ struct drgn_error *drgn_bool_type_create(struct drgn_program *prog,
  * Create a floating-point type.
  *
  * @param[in] prog Program owning type.
- * @param[in] name Name of the type. Not copied; must remain valid for the
- * lifetime of @p prog. Must not be @c NULL.
+ * @param[in] name Name of the type. Interned (see @ref
+ * drgn_program_intern_string()). Must not be @c NULL.
  * @param[in] size Size of the type in bytes.
  * @param[in] lang Language of the type or @c NULL for the default language of
  * @p prog.
@@ -244,11 +356,11 @@ drgn_compound_type_builder_add_member(struct drgn_compound_type_builder *builder
  * On success, this takes ownership of @p builder.
  *
  * @param[in] builder Builder containing members and template parameters. @c
- * object/@c argument and @c name of each member and template parameter must
- * remain valid for the lifetime of @c prog. If incomplete, must not contain any
- * members.
- * @param[in] tag Name of the type. Not copied; must remain valid for the
- * lifetime of @c prog. May be @c NULL if the type is anonymous.
+ * object/@c argument of each member and template parameter and @c name of each
+ * template parameter must remain valid for the lifetime of @c prog. Member
+ * names are interned. If incomplete, must not contain any members.
+ * @param[in] tag Name of the type. Interned (see @ref
+ * drgn_program_intern_string()). May be @c NULL if the type is anonymous.
  * @param[in] size Size of the type in bytes. Must be zero if the type is
  * incomplete.
  * @param[in] is_complete Whether the type is complete.
@@ -303,10 +415,10 @@ drgn_enum_type_builder_add_unsigned(struct drgn_enum_type_builder *builder,
  *
  * On success, this takes ownership of @p builder.
  *
- * @param[in] builder Builder containing enumerators. @c name of each enumerator
- * must remain valid for the lifetime of @c builder->prog.
- * @param[in] tag Name of the type. This string is not copied. It may be @c NULL
- * if the type is anonymous.
+ * @param[in] builder Builder containing enumerators. Enumerator names are
+ * interned.
+ * @param[in] tag Name of the type. Interned (see @ref
+ * drgn_program_intern_string()). May be @c NULL if the type is anonymous.
  * @param[in] compatible_type Type compatible with this enumerated type. Must be
  * an integer type.
  * @param[in] lang Language of the type or @c NULL for the default language of
@@ -326,8 +438,8 @@ struct drgn_error *drgn_enum_type_create(struct drgn_enum_type_builder *builder,
  * @c compatible_type is set to @c NULL and @c num_enumerators is set to zero.
  *
  * @param[in] prog Program owning type.
- * @param[in] tag Name of the type. Not copied; must remain valid for the
- * lifetime of @p prog. May be @c NULL if the type is anonymous.
+ * @param[in] tag Name of the type. Interned (see @ref
+ * drgn_program_intern_string()). May be @c NULL if the type is anonymous.
  * @param[in] lang Language of the type or @c NULL for the default language of
  * @p prog.
  * @param[out] ret Returned type.
@@ -342,8 +454,8 @@ drgn_incomplete_enum_type_create(struct drgn_program *prog, const char *tag,
  * Create a typedef type.
  *
  * @param[in] prog Program owning type.
- * @param[in] name Name of the type. Not copied; must remain valid for the
- * lifetime of @p prog. Must not be @c NULL.
+ * @param[in] name Name of the type. Interned (see @ref
+ * drgn_program_intern_string()). Must not be @c NULL.
  * @param[in] aliased_type Type aliased by the typedef.
  * @param[in] lang Language of the type or @c NULL for the default language of
  * @p prog.
@@ -551,6 +663,19 @@ bool drgn_type_is_arithmetic(struct drgn_type *type);
  */
 bool drgn_type_is_scalar(struct drgn_type *type);
 
+/**
+ * Return whether two types are the same type.
+ *
+ * Typedefs are looked through. Structure, union, class, and enumerated types
+ * are compared by tag and layout, so equivalent definitions from different
+ * compilation units are equal. Types referenced through pointers are only
+ * compared by name.
+ *
+ * @param[out] ret Whether the types are equal.
+ */
+struct drgn_error *drgn_type_eq(struct drgn_type *a, struct drgn_type *b,
+				bool *ret);
+
 /**
  * Get the size of a type in bits.
  *
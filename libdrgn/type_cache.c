@@ -0,0 +1,330 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// SPDX-License-Identifier: GPL-3.0+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "error.h"
+#include "siphash.h"
+#include "type_cache.h"
+#include "util.h"
+
+DEFINE_VECTOR_FUNCTIONS(drgn_type_cache_entry_vector)
+
+/*
+ * File format (native byte order):
+ *
+ * struct drgn_type_cache_header header;
+ * struct drgn_type_cache_entry entries[header.num_entries];
+ * char records[header.records_size];
+ */
+struct drgn_type_cache_header {
+	char magic[8];
+	uint32_t version;
+	/* DRGN_TYPE_CACHE_BYTE_ORDER in the byte order of the writer. */
+	uint32_t byte_order;
+	uint64_t num_entries;
+	uint64_t records_size;
+};
+
+static const char drgn_type_cache_magic[8] = "DRGNTYPE";
+#define DRGN_TYPE_CACHE_VERSION 1
+#define DRGN_TYPE_CACHE_BYTE_ORDER UINT32_C(0x01020304)
+
+static struct drgn_error *
+drgn_type_cache_map(struct drgn_type_cache *cache, const char *path)
+{
+	struct drgn_error *err;
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		if (errno == ENOENT)
+			return NULL;
+		return drgn_error_create_os("open", errno, path);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		err = drgn_error_create_os("fstat", errno, path);
+		goto out;
+	}
+	if (st.st_size < 0 || st.st_size > SIZE_MAX) {
+		err = &drgn_enomem;
+		goto out;
+	}
+	if (st.st_size < sizeof(struct drgn_type_cache_header)) {
+		err = drgn_error_format(DRGN_ERROR_OTHER,
+					"%s: type cache is truncated", path);
+		goto out;
+	}
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		err = drgn_error_create_os("mmap", errno, path);
+		goto out;
+	}
+
+	const struct drgn_type_cache_header *header = map;
+	if (memcmp(header->magic, drgn_type_cache_magic,
+		   sizeof(header->magic)) != 0) {
+		err = drgn_error_format(DRGN_ERROR_OTHER,
+					"%s: not a type cache", path);
+		goto err;
+	}
+	/*
+	 * A cache written by a different version or on a host with a different
+	 * byte order is ignored and will be replaced when it is saved.
+	 */
+	if (header->version != DRGN_TYPE_CACHE_VERSION ||
+	    header->byte_order != DRGN_TYPE_CACHE_BYTE_ORDER) {
+		munmap(map, st.st_size);
+		err = NULL;
+		goto out;
+	}
+	size_t size = sizeof(*header);
+	uint64_t entries_size;
+	if (__builtin_mul_overflow(header->num_entries,
+				   sizeof(struct drgn_type_cache_entry),
+				   &entries_size) ||
+	    __builtin_add_overflow(size, entries_size, &size) ||
+	    __builtin_add_overflow(size, header->records_size, &size) ||
+	    size != st.st_size) {
+		err = drgn_error_format(DRGN_ERROR_OTHER,
+					"%s: type cache is truncated", path);
+		goto err;
+	}
+
+	cache->map = map;
+	cache->map_size = st.st_size;
+	cache->entries = (const struct drgn_type_cache_entry *)(header + 1);
+	cache->num_entries = header->num_entries;
+	cache->records = (const char *)(cache->entries + cache->num_entries);
+	cache->records_size = header->records_size;
+	err = NULL;
+	goto out;
+
+err:
+	munmap(map, st.st_size);
+out:
+	close(fd);
+	return err;
+}
+
+struct drgn_error *drgn_type_cache_create(const char *path,
+					  struct drgn_type_cache **ret)
+{
+	struct drgn_type_cache *cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return &drgn_enomem;
+	struct drgn_error *err = drgn_type_cache_map(cache, path);
+	if (err) {
+		free(cache);
+		return err;
+	}
+	drgn_type_cache_entry_vector_init(&cache->new_entries);
+	*ret = cache;
+	return NULL;
+}
+
+void drgn_type_cache_destroy(struct drgn_type_cache *cache)
+{
+	if (!cache)
+		return;
+	free(cache->new_records.str);
+	drgn_type_cache_entry_vector_deinit(&cache->new_entries);
+	if (cache->map)
+		munmap(cache->map, cache->map_size);
+	free(cache);
+}
+
+uint64_t drgn_type_cache_hash_build_id(const void *build_id,
+				       size_t build_id_len)
+{
+	static const uint64_t siphash_key[2];
+	struct siphash hash;
+	siphash_init(&hash, siphash_key);
+	siphash_update(&hash, build_id, build_id_len);
+	return siphash_final(&hash);
+}
+
+static int drgn_type_cache_entry_cmp(uint64_t build_id_hash,
+				     uint64_t die_offset,
+				     const struct drgn_type_cache_entry *entry)
+{
+	if (build_id_hash != entry->build_id_hash)
+		return build_id_hash < entry->build_id_hash ? -1 : 1;
+	if (die_offset != entry->die_offset)
+		return die_offset < entry->die_offset ? -1 : 1;
+	return 0;
+}
+
+bool drgn_type_cache_find(struct drgn_type_cache *cache,
+			  uint64_t build_id_hash, uint64_t die_offset,
+			  const char **record_ret, size_t *size_ret)
+{
+	size_t lo = 0, hi = cache->num_entries;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		const struct drgn_type_cache_entry *entry = &cache->entries[mid];
+		int cmp = drgn_type_cache_entry_cmp(build_id_hash, die_offset,
+						    entry);
+		if (cmp < 0) {
+			hi = mid;
+		} else if (cmp > 0) {
+			lo = mid + 1;
+		} else {
+			if (entry->record_offset > cache->records_size ||
+			    entry->record_size >
+			    cache->records_size - entry->record_offset)
+				return false;
+			*record_ret = cache->records + entry->record_offset;
+			*size_ret = entry->record_size;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool drgn_type_cache_add(struct drgn_type_cache *cache, uint64_t build_id_hash,
+			 uint64_t die_offset, const char *record, size_t size)
+{
+	struct drgn_type_cache_entry *entry =
+		drgn_type_cache_entry_vector_append_entry(&cache->new_entries);
+	if (!entry)
+		return false;
+	entry->build_id_hash = build_id_hash;
+	entry->die_offset = die_offset;
+	entry->record_offset = cache->new_records.len;
+	entry->record_size = size;
+	if (!string_builder_appendn(&cache->new_records, record, size)) {
+		cache->new_entries.size--;
+		return false;
+	}
+	return true;
+}
+
+struct drgn_type_cache_save_entry {
+	struct drgn_type_cache_entry entry;
+	const char *record;
+	/* Entries added since the file was mapped take precedence. */
+	bool is_new;
+};
+
+static int drgn_type_cache_save_entry_cmp(const void *_a, const void *_b)
+{
+	const struct drgn_type_cache_save_entry *a = _a, *b = _b;
+	int cmp = drgn_type_cache_entry_cmp(a->entry.build_id_hash,
+					    a->entry.die_offset, &b->entry);
+	if (cmp)
+		return cmp;
+	return (int)b->is_new - (int)a->is_new;
+}
+
+struct drgn_error *drgn_type_cache_save(struct drgn_type_cache *cache,
+					const char *path)
+{
+	struct drgn_error *err;
+
+	size_t num_entries = cache->num_entries + cache->new_entries.size;
+	struct drgn_type_cache_save_entry *entries =
+		malloc_array(num_entries ? num_entries : 1, sizeof(*entries));
+	if (!entries)
+		return &drgn_enomem;
+	for (size_t i = 0; i < cache->num_entries; i++) {
+		entries[i].entry = cache->entries[i];
+		entries[i].record = cache->records + cache->entries[i].record_offset;
+		entries[i].is_new = false;
+		/* Drop corrupt entries. */
+		if (entries[i].entry.record_offset > cache->records_size ||
+		    entries[i].entry.record_size >
+		    cache->records_size - entries[i].entry.record_offset)
+			entries[i].entry.record_size = 0;
+	}
+	for (size_t i = 0; i < cache->new_entries.size; i++) {
+		struct drgn_type_cache_save_entry *entry =
+			&entries[cache->num_entries + i];
+		entry->entry = cache->new_entries.data[i];
+		entry->record = (cache->new_records.str +
+				 entry->entry.record_offset);
+		entry->is_new = true;
+	}
+	qsort(entries, num_entries, sizeof(*entries),
+	      drgn_type_cache_save_entry_cmp);
+
+	/* Remove duplicates and empty records and assign record offsets. */
+	size_t n = 0;
+	uint64_t records_size = 0;
+	for (size_t i = 0; i < num_entries; i++) {
+		if (!entries[i].entry.record_size ||
+		    (n &&
+		     drgn_type_cache_entry_cmp(entries[i].entry.build_id_hash,
+					       entries[i].entry.die_offset,
+					       &entries[n - 1].entry) == 0))
+			continue;
+		entries[n] = entries[i];
+		entries[n].entry.record_offset = records_size;
+		records_size += entries[n].entry.record_size;
+		n++;
+	}
+
+	char *tmp_path;
+	if (asprintf(&tmp_path, "%s.XXXXXX", path) == -1) {
+		err = &drgn_enomem;
+		goto out_entries;
+	}
+	int fd = mkstemp(tmp_path);
+	if (fd == -1) {
+		err = drgn_error_create_os("mkstemp", errno, tmp_path);
+		goto out_tmp_path;
+	}
+	FILE *file = fdopen(fd, "w");
+	if (!file) {
+		err = drgn_error_create_os("fdopen", errno, tmp_path);
+		close(fd);
+		goto out_unlink;
+	}
+
+	struct drgn_type_cache_header header = {
+		.version = DRGN_TYPE_CACHE_VERSION,
+		.byte_order = DRGN_TYPE_CACHE_BYTE_ORDER,
+		.num_entries = n,
+		.records_size = records_size,
+	};
+	memcpy(header.magic, drgn_type_cache_magic, sizeof(header.magic));
+	fwrite(&header, sizeof(header), 1, file);
+	for (size_t i = 0; i < n; i++)
+		fwrite(&entries[i].entry, sizeof(entries[i].entry), 1, file);
+	for (size_t i = 0; i < n; i++) {
+		fwrite(entries[i].record, 1, entries[i].entry.record_size,
+		       file);
+	}
+	if (ferror(file)) {
+		err = drgn_error_create_os("fwrite", errno, tmp_path);
+		fclose(file);
+		goto out_unlink;
+	}
+	if (fclose(file) == EOF) {
+		err = drgn_error_create_os("fclose", errno, tmp_path);
+		goto out_unlink;
+	}
+	if (rename(tmp_path, path) == -1) {
+		err = drgn_error_create_os("rename", errno, path);
+		goto out_unlink;
+	}
+	err = NULL;
+	goto out_tmp_path;
+
+out_unlink:
+	unlink(tmp_path);
+out_tmp_path:
+	free(tmp_path);
+out_entries:
+	free(entries);
+	return err;
+}
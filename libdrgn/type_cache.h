@@ -0,0 +1,130 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// SPDX-License-Identifier: GPL-3.0+
+
+/**
+ * @file
+ *
+ * Persistent type cache.
+ *
+ * See @ref TypeCache.
+ */
+
+#ifndef DRGN_TYPE_CACHE_H
+#define DRGN_TYPE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "drgn.h"
+#include "string_builder.h"
+#include "vector.h"
+
+/**
+ * @ingroup Internals
+ *
+ * @defgroup TypeCache Type cache
+ *
+ * On-disk cache of types parsed from debugging information.
+ *
+ * A type cache file contains serialized type records keyed by the build ID of
+ * the module containing the type and the offset of the type's DIE in that
+ * module's debugging information. The file is mapped into memory, and records
+ * are only decoded when the type they describe is looked up. The record format
+ * is defined by the user of the cache (see @ref drgn_type_from_dwarf()); this
+ * only manages storage and lookup.
+ *
+ * @{
+ */
+
+/** Type cache index entry. */
+struct drgn_type_cache_entry {
+	/** Hash of the module build ID (see @ref drgn_type_cache_hash_build_id()). */
+	uint64_t build_id_hash;
+	/** Offset of the DIE in the module's debugging information. */
+	uint64_t die_offset;
+	/** Offset of the record from the beginning of the record data. */
+	uint64_t record_offset;
+	/** Size of the record in bytes. */
+	uint64_t record_size;
+};
+
+DEFINE_VECTOR_TYPE(drgn_type_cache_entry_vector, struct drgn_type_cache_entry)
+
+/** Persistent type cache. */
+struct drgn_type_cache {
+	/** Mapped cache file, or @c NULL if the file did not exist. */
+	void *map;
+	/** Size of @ref drgn_type_cache::map. */
+	size_t map_size;
+	/**
+	 * Entries in the mapped file, sorted by build ID hash and DIE offset.
+	 */
+	const struct drgn_type_cache_entry *entries;
+	/** Number of entries in @ref drgn_type_cache::entries. */
+	size_t num_entries;
+	/** Record data in the mapped file. */
+	const char *records;
+	/** Size of @ref drgn_type_cache::records. */
+	size_t records_size;
+	/** Entries added since the file was mapped. */
+	struct drgn_type_cache_entry_vector new_entries;
+	/** Record data for @ref drgn_type_cache::new_entries. */
+	struct string_builder new_records;
+};
+
+/**
+ * Create a @ref drgn_type_cache from a file.
+ *
+ * If the file does not exist, the cache is created empty.
+ *
+ * @param[in] path Path of cache file.
+ * @param[out] ret Returned cache.
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_type_cache_create(const char *path,
+					  struct drgn_type_cache **ret);
+
+/** Destroy a @ref drgn_type_cache. */
+void drgn_type_cache_destroy(struct drgn_type_cache *cache);
+
+/** Hash a module build ID for use as a type cache key. */
+uint64_t drgn_type_cache_hash_build_id(const void *build_id,
+				       size_t build_id_len);
+
+/**
+ * Find a record in the mapped cache file.
+ *
+ * @param[out] record_ret Returned record.
+ * @param[out] size_ret Returned record size.
+ * @return @c true if found, @c false if not.
+ */
+bool drgn_type_cache_find(struct drgn_type_cache *cache,
+			  uint64_t build_id_hash, uint64_t die_offset,
+			  const char **record_ret, size_t *size_ret);
+
+/**
+ * Add a record to a @ref drgn_type_cache.
+ *
+ * The record is not written to disk until @ref drgn_type_cache_save() is
+ * called.
+ *
+ * @return @c true on success, @c false on allocation failure.
+ */
+bool drgn_type_cache_add(struct drgn_type_cache *cache, uint64_t build_id_hash,
+			 uint64_t die_offset, const char *record, size_t size);
+
+/**
+ * Write the records in the mapped file and the added records to a file.
+ *
+ * The file is replaced atomically, so it may be the file that the cache was
+ * created from.
+ *
+ * @return @c NULL on success, non-@c NULL on error.
+ */
+struct drgn_error *drgn_type_cache_save(struct drgn_type_cache *cache,
+					const char *path);
+
+/** @} */
+
+#endif /* DRGN_TYPE_CACHE_H */
@@ -3,6 +3,7 @@
 
 from collections import namedtuple
 import os.path
+import struct
 
 from tests.dwarf import DW_AT, DW_FORM, DW_TAG
 from tests.elf import ET, PT, SHT
@@ -195,7 +196,7 @@ def _compile_debug_line(cu_die, little_endian):
     return buf
 
 
-def compile_dwarf(dies, little_endian=True, bits=64, *, lang=None):
+def compile_dwarf(dies, little_endian=True, bits=64, *, lang=None, build_id=None):
     if isinstance(dies, DwarfDie):
         dies = (dies,)
     assert all(isinstance(die, DwarfDie) for die in dies)
@@ -207,10 +208,21 @@ def compile_dwarf(dies, little_endian=True, bits=64, *, lang=None):
         cu_attribs.append(DwarfAttrib(DW_AT.language, DW_FORM.data1, lang))
     cu_die = DwarfDie(DW_TAG.compile_unit, cu_attribs, dies)
 
+    sections = []
+    if build_id is not None:
+        endian = "<" if little_endian else ">"
+        # namesz, descsz, type = NT_GNU_BUILD_ID, name
+        note = struct.pack(endian + "III4s", 4, len(build_id), 3, b"GNU\0")
+        note += build_id + bytes(-len(build_id) % 4)
+        sections.append(
+            ElfSection(name=".note.gnu.build-id", sh_type=SHT.NOTE, data=note)
+        )
+
     return create_elf_file(
         ET.EXEC,
         [
             ElfSection(p_type=PT.LOAD, vaddr=0xFFFF0000, data=b""),
+            *sections,
             ElfSection(
                 name=".debug_abbrev",
                 sh_type=SHT.PROGBITS,
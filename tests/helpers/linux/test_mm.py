@@ -16,6 +16,7 @@ from drgn.helpers.linux.mm import (
     access_remote_vm,
     cmdline,
     environ,
+    for_each_mapped_range,
     page_to_pfn,
     pfn_to_page,
     pfn_to_virt,
@@ -107,6 +108,20 @@ class TestMm(LinuxHelperTestCase):
                 access_process_vm(task, address + 1, len(map) - 2), map[1:-1]
             )
 
+    def test_for_each_mapped_range(self):
+        task = find_task(self.prog, os.getpid())
+        with self._pages() as (map, address, pfns):
+            ranges = list(for_each_mapped_range(task.mm, address, address + len(map)))
+            self.assertEqual(ranges[0].start, address)
+            self.assertEqual(ranges[-1].end, address + len(map))
+            for i, pfn in enumerate(pfns):
+                page_address = address + i * mmap.PAGESIZE
+                r = next(r for r in ranges if r.start <= page_address < r.end)
+                self.assertEqual(
+                    r.phys_addr + (page_address - r.start), pfn * mmap.PAGESIZE
+                )
+                self.assertTrue(r.user)
+
     @unittest.skipUnless(platform.machine() == "x86_64", "machine is not x86_64")
     def test_non_canonical_x86_64(self):
         task = find_task(self.prog, os.getpid())
@@ -2,7 +2,7 @@
 # SPDX-License-Identifier: GPL-3.0+
 
 from drgn.helpers.linux.cpumask import for_each_possible_cpu
-from drgn.helpers.linux.percpu import per_cpu
+from drgn.helpers.linux.percpu import per_cpu, per_cpu_values
 from tests.helpers.linux import LinuxHelperTestCase
 
 
@@ -10,3 +10,9 @@ class TestPerCpu(LinuxHelperTestCase):
     def test_per_cpu(self):
         for cpu in for_each_possible_cpu(self.prog):
             self.assertEqual(per_cpu(self.prog["runqueues"], cpu).cpu, cpu)
+
+    def test_per_cpu_values(self):
+        values = per_cpu_values(self.prog["runqueues"].address_of_(), "cpu")
+        self.assertEqual(list(values), list(for_each_possible_cpu(self.prog)))
+        for cpu, value in values.items():
+            self.assertEqual(value, cpu)
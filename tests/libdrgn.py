@@ -185,6 +185,28 @@ class C_TOKEN(enum.IntEnum):
     DOT = auto()
     NUMBER = auto()
     IDENTIFIER = auto()
+    ARROW = auto()
+    PLUS = auto()
+    MINUS = auto()
+    SLASH = auto()
+    PERCENT = auto()
+    AMPERSAND = auto()
+    PIPE = auto()
+    CARET = auto()
+    TILDE = auto()
+    EXCLAMATION = auto()
+    LSHIFT = auto()
+    RSHIFT = auto()
+    LT = auto()
+    GT = auto()
+    LE = auto()
+    GE = auto()
+    EQ = auto()
+    NE = auto()
+    LOGICAL_AND = auto()
+    LOGICAL_OR = auto()
+    INCREMENT = auto()
+    DECREMENT = auto()
 
 
 class Token:
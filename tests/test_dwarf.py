@@ -14,6 +14,7 @@ from drgn import (
     ProgramFlags,
     Qualifiers,
     TypeEnumerator,
+    TypeKind,
     TypeMember,
     TypeParameter,
     TypeTemplateParameter,
@@ -879,6 +880,243 @@ class TestTypes(TestCase):
             prog.type("TEST").type, prog.pointer_type(prog.struct_type("point"))
         )
 
+    def test_dedupe_compound_types(self):
+        def point_die(decl_file):
+            return DwarfDie(
+                DW_TAG.structure_type,
+                (
+                    DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                    DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+                    DwarfAttrib(DW_AT.decl_file, DW_FORM.udata, decl_file),
+                ),
+                (
+                    DwarfDie(
+                        DW_TAG.member,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                            DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 0),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, 6),
+                        ),
+                    ),
+                    DwarfDie(
+                        DW_TAG.member,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "y"),
+                            DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 4),
+                            DwarfAttrib(DW_AT.type, DW_FORM.ref4, 6),
+                        ),
+                    ),
+                ),
+            )
+
+        dies = (
+            *(
+                DwarfDie(
+                    DW_TAG.typedef,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, name),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, i + 3),
+                    ),
+                )
+                for i, name in enumerate(("a", "b", "c"))
+            ),
+            point_die("foo.c"),
+            point_die("foo.c"),
+            point_die("bar.c"),
+            int_die,
+        )
+
+        prog = dwarf_program(dies)
+        self.assertFalse(prog.dedupe_compound_types)
+        self.assertNotEqual(prog.type("a").type._ptr, prog.type("b").type._ptr)
+
+        prog = dwarf_program(dies)
+        prog.dedupe_compound_types = True
+        self.assertTrue(prog.dedupe_compound_types)
+        a = prog.type("a").type
+        self.assertEqual(a._ptr, prog.type("b").type._ptr)
+        self.assertNotEqual(a._ptr, prog.type("c").type._ptr)
+        self.assertIdentical(
+            a,
+            prog.struct_type(
+                "point",
+                8,
+                (
+                    TypeMember(prog.int_type("int", 4, True), "x"),
+                    TypeMember(prog.int_type("int", 4, True), "y", 32),
+                ),
+            ),
+        )
+
+        with self.assertRaises(TypeError):
+            prog.dedupe_compound_types = 1
+        with self.assertRaises(AttributeError):
+            del prog.dedupe_compound_types
+
+    def test_prefetch(self):
+        prog = dwarf_program(
+            test_type_dies(
+                (
+                    DwarfDie(
+                        DW_TAG.structure_type,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                            DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+                        ),
+                        (
+                            DwarfDie(
+                                DW_TAG.member,
+                                (
+                                    DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                                    DwarfAttrib(
+                                        DW_AT.data_member_location, DW_FORM.data1, 0
+                                    ),
+                                    DwarfAttrib(DW_AT.type, DW_FORM.ref4, 1),
+                                ),
+                            ),
+                        ),
+                    ),
+                    int_die,
+                )
+            )
+        )
+        self.assertRaises(TypeError, prog.prefetch, [1])
+        prog.prefetch(["struct point", "TEST", "struct missing"], ["missing"])
+        point = prog.type("struct point")
+        prog.wait_prefetch()
+        prog.wait_prefetch()
+        self.assertEqual(prog.type("TEST").type._ptr, point._ptr)
+        self.assertIdentical(
+            point,
+            prog.struct_type(
+                "point", 8, (TypeMember(prog.int_type("int", 4, True), "x"),)
+            ),
+        )
+
+    def test_type_cache(self):
+        def dies(member_name):
+            return (
+                DwarfDie(
+                    DW_TAG.structure_type,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                        DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+                    ),
+                    (
+                        DwarfDie(
+                            DW_TAG.member,
+                            (
+                                DwarfAttrib(DW_AT.name, DW_FORM.string, member_name),
+                                DwarfAttrib(DW_AT.data_member_location, DW_FORM.data1, 0),
+                                DwarfAttrib(DW_AT.type, DW_FORM.ref4, 1),
+                            ),
+                        ),
+                    ),
+                ),
+                int_die,
+                DwarfDie(
+                    DW_TAG.enumeration_type,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "color"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, 3),
+                        DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 4),
+                    ),
+                    (
+                        DwarfDie(
+                            DW_TAG.enumerator,
+                            (
+                                DwarfAttrib(DW_AT.name, DW_FORM.string, member_name),
+                                DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 1),
+                            ),
+                        ),
+                    ),
+                ),
+                unsigned_int_die,
+            )
+
+        def check(prog):
+            self.assertIdentical(
+                prog.type("struct point"),
+                prog.struct_type(
+                    "point", 8, (TypeMember(prog.int_type("int", 4, True), "x"),)
+                ),
+            )
+            self.assertIdentical(
+                prog.type("enum color"),
+                prog.enum_type(
+                    "color",
+                    prog.int_type("unsigned int", 4, False),
+                    (TypeEnumerator("x", 1),),
+                ),
+            )
+
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            path = os.path.join(tmp_dir, "types")
+
+            prog = dwarf_program(dies("x"), build_id=b"\x01\x02\x03\x04")
+            self.assertRaises(ValueError, prog.save_type_cache, path)
+            prog.load_type_cache(path)
+            check(prog)
+            prog.save_type_cache(path)
+
+            # The member and enumerator names differ, but the DIE offsets and
+            # build ID are the same, so the cached types should be returned.
+            prog = dwarf_program(dies("y"), build_id=b"\x01\x02\x03\x04")
+            prog.load_type_cache(path)
+            check(prog)
+
+            # A different build ID doesn't match.
+            prog = dwarf_program(dies("y"), build_id=b"\x05\x06\x07\x08")
+            prog.load_type_cache(path)
+            self.assertEqual(prog.type("struct point").members[0].name, "y")
+
+    def test_indexed_types(self):
+        prog = dwarf_program(
+            test_type_dies(
+                (
+                    DwarfDie(
+                        DW_TAG.structure_type,
+                        (
+                            DwarfAttrib(DW_AT.name, DW_FORM.string, "point"),
+                            DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 8),
+                        ),
+                        (
+                            DwarfDie(
+                                DW_TAG.member,
+                                (
+                                    DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                                    DwarfAttrib(
+                                        DW_AT.data_member_location, DW_FORM.data1, 0
+                                    ),
+                                    DwarfAttrib(DW_AT.type, DW_FORM.ref4, 1),
+                                ),
+                            ),
+                        ),
+                    ),
+                    int_die,
+                    bool_die,
+                )
+            )
+        )
+        point_type = prog.struct_type(
+            "point", 8, (TypeMember(prog.int_type("int", 4, True), "x"),)
+        )
+        types = list(prog.indexed_types())
+        self.assertEqual(len(types), 4)
+        self.assertEqual(
+            sorted(t.name if t.kind != TypeKind.STRUCT else t.tag for t in types),
+            ["TEST", "_Bool", "int", "point"],
+        )
+        self.assertIdentical(
+            list(prog.indexed_types({TypeKind.STRUCT})), [point_type]
+        )
+        self.assertIdentical(
+            list(prog.indexed_types([TypeKind.BOOL])), [prog.bool_type("_Bool", 1)]
+        )
+        self.assertEqual(list(prog.indexed_types(())), [])
+        self.assertEqual(list(prog.indexed_types(module="foo")), [])
+        self.assertRaises(TypeError, prog.indexed_types, [1])
+
     def test_filename(self):
         dies = list(base_type_dies) + [
             DwarfDie(
@@ -3547,6 +3785,67 @@ class TestObjects(TestCase):
             FindObjectFlags.VARIABLE,
         )
 
+    def test_indexed_objects(self):
+        prog = dwarf_program(
+            (
+                int_die,
+                DwarfDie(
+                    DW_TAG.enumeration_type,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "color"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, 0),
+                        DwarfAttrib(DW_AT.byte_size, DW_FORM.data1, 4),
+                    ),
+                    (
+                        DwarfDie(
+                            DW_TAG.enumerator,
+                            (
+                                DwarfAttrib(DW_AT.name, DW_FORM.string, "RED"),
+                                DwarfAttrib(DW_AT.const_value, DW_FORM.data1, 0),
+                            ),
+                        ),
+                    ),
+                ),
+                DwarfDie(
+                    DW_TAG.variable,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "x"),
+                        DwarfAttrib(DW_AT.type, DW_FORM.ref4, 0),
+                        DwarfAttrib(
+                            DW_AT.location,
+                            DW_FORM.exprloc,
+                            b"\x03\x04\x03\x02\x01\xff\xff\xff\xff",
+                        ),
+                    ),
+                ),
+                DwarfDie(
+                    DW_TAG.subprogram,
+                    (
+                        DwarfAttrib(DW_AT.name, DW_FORM.string, "abort"),
+                        DwarfAttrib(DW_AT.low_pc, DW_FORM.addr, 0x7FC3EB9B1C30),
+                    ),
+                ),
+            )
+        )
+        objects = dict(prog.indexed_objects())
+        self.assertEqual(objects.keys(), {"RED", "x", "abort"})
+        for name, obj in objects.items():
+            self.assertIdentical(obj, prog[name])
+        self.assertEqual(
+            [name for name, _ in prog.indexed_objects(FindObjectFlags.VARIABLE)],
+            ["x"],
+        )
+        self.assertEqual(
+            sorted(
+                name
+                for name, _ in prog.indexed_objects(
+                    FindObjectFlags.CONSTANT | FindObjectFlags.FUNCTION
+                )
+            ),
+            ["RED", "abort"],
+        )
+        self.assertEqual(list(prog.indexed_objects(module="foo")), [])
+
     def test_function_no_address(self):
         prog = dwarf_program(
             test_type_dies(
@@ -3,6 +3,7 @@
 
 from functools import reduce
 import operator
+import struct
 import unittest
 
 from drgn import (
@@ -15,7 +16,7 @@ from drgn import (
     cast,
     container_of,
 )
-from tests import MockProgramTestCase
+from tests import MockObject, MockProgramTestCase
 from tests.libdrgn import C_TOKEN, Lexer, drgn_lexer_c
 
 
@@ -666,7 +667,7 @@ class TestLexer(unittest.TestCase):
             self.assertEqual(lexer.pop().kind, C_TOKEN.EOF)
 
     def test_symbols(self):
-        s = "()[]*."
+        s = "()[]*. -> + - / % & | ^ ~ ! << >> < > <= >= == != && || ++ --"
         tokens = [
             C_TOKEN.LPAREN,
             C_TOKEN.RPAREN,
@@ -674,6 +675,28 @@ class TestLexer(unittest.TestCase):
             C_TOKEN.RBRACKET,
             C_TOKEN.ASTERISK,
             C_TOKEN.DOT,
+            C_TOKEN.ARROW,
+            C_TOKEN.PLUS,
+            C_TOKEN.MINUS,
+            C_TOKEN.SLASH,
+            C_TOKEN.PERCENT,
+            C_TOKEN.AMPERSAND,
+            C_TOKEN.PIPE,
+            C_TOKEN.CARET,
+            C_TOKEN.TILDE,
+            C_TOKEN.EXCLAMATION,
+            C_TOKEN.LSHIFT,
+            C_TOKEN.RSHIFT,
+            C_TOKEN.LT,
+            C_TOKEN.GT,
+            C_TOKEN.LE,
+            C_TOKEN.GE,
+            C_TOKEN.EQ,
+            C_TOKEN.NE,
+            C_TOKEN.LOGICAL_AND,
+            C_TOKEN.LOGICAL_OR,
+            C_TOKEN.INCREMENT,
+            C_TOKEN.DECREMENT,
         ]
         self.assertEqual([token.kind for token in self.lex(s)], tokens)
 
@@ -711,7 +734,7 @@ class TestLexer(unittest.TestCase):
         )
 
     def test_number(self):
-        s = "0 1234 0xdeadbeef"
+        s = "0 1234 0xdeadbeef 1u 2L 3ul 4LU 5ll 6ULL 7llu 0x8Ul"
         tokens = s.split()
         self.assertEqual(
             [(token.kind, token.value) for token in self.lex(s)],
@@ -719,11 +742,12 @@ class TestLexer(unittest.TestCase):
         )
 
     def test_invalid_number(self):
-        for s in ["0x", "1234y"]:
+        for s in ["0x", "1234y", "1uu", "1lL", "1lul", "1lll", "0xu"]:
             self.assertRaisesRegex(SyntaxError, "invalid number", list, self.lex(s))
 
     def test_invalid_character(self):
         self.assertRaisesRegex(SyntaxError, "invalid character", list, self.lex("@"))
+        self.assertRaisesRegex(SyntaxError, "invalid character", list, self.lex("="))
 
 
 class TestLiteral(MockProgramTestCase):
@@ -1614,6 +1638,159 @@ class TestOperators(MockProgramTestCase):
             )
 
 
+class TestEval(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        self.types.append(self.point_type)
+        self.types.append(self.pid_type)
+        self.add_memory_segment(
+            struct.pack("<2iQ3i", 1, 2, 0xFFFF0000, 10, 20, 30),
+            virt_addr=0xFFFF0000,
+        )
+        self.objects.extend(
+            [
+                MockObject("pt", self.point_type, address=0xFFFF0000),
+                MockObject(
+                    "ptr", self.prog.pointer_type(self.point_type), address=0xFFFF0008
+                ),
+                MockObject(
+                    "arr",
+                    self.prog.array_type(self.prog.int_type("int", 4, True), 3),
+                    address=0xFFFF0010,
+                ),
+                MockObject(
+                    "PAGE_SIZE", self.prog.int_type("int", 4, True), value=4096
+                ),
+            ]
+        )
+
+    def int(self, value):
+        return Object(self.prog, "int", value=value)
+
+    def test_member(self):
+        self.assertIdentical(
+            self.prog.eval("pt.y"), Object(self.prog, "int", address=0xFFFF0004)
+        )
+        self.assertIdentical(
+            self.prog.eval("ptr->y"), Object(self.prog, "int", address=0xFFFF0004)
+        )
+        self.assertIdentical(self.prog.eval("*ptr"), self.prog["pt"])
+        self.assertIdentical(
+            self.prog.eval("&pt"),
+            Object(
+                self.prog, self.prog.pointer_type(self.point_type), value=0xFFFF0000
+            ),
+        )
+
+    def test_subscript(self):
+        self.assertIdentical(
+            self.prog.eval("arr[2]"), Object(self.prog, "int", address=0xFFFF0018)
+        )
+        self.assertIdentical(self.prog.eval("arr[pt.x + 1]"), self.prog["arr"][2])
+
+    def test_arithmetic(self):
+        self.assertIdentical(self.prog.eval("PAGE_SIZE * 2 + 1"), self.int(8193))
+        self.assertIdentical(self.prog.eval("(1 << 4) | 0xfF"), self.int(255))
+        self.assertIdentical(self.prog.eval("1 + 2 * 3 - 8 / 2 % 3"), self.int(6))
+        self.assertIdentical(self.prog.eval("-pt.x ^ ~0"), self.int(0))
+        self.assertIdentical(self.prog.eval("arr[0] & 6"), self.int(2))
+        self.assertIdentical(self.prog.eval("1 - -1"), self.int(2))
+
+    def test_integer_suffixes(self):
+        self.assertIdentical(
+            self.prog.eval("10U - 11"),
+            Object(self.prog, "unsigned int", value=2 ** 32 - 1),
+        )
+        self.assertIdentical(self.prog.eval("1L"), Object(self.prog, "long", value=1))
+        self.assertIdentical(
+            self.prog.eval("1ul"), Object(self.prog, "unsigned long", value=1)
+        )
+        self.assertIdentical(
+            self.prog.eval("1LL"), Object(self.prog, "long long", value=1)
+        )
+        self.assertIdentical(
+            self.prog.eval("1llu"), Object(self.prog, "unsigned long long", value=1)
+        )
+        self.assertIdentical(
+            self.prog.eval("0x100000000u"),
+            Object(self.prog, "unsigned long", value=2 ** 32),
+        )
+
+    def test_logical(self):
+        self.assertIdentical(self.prog.eval("pt.x < pt.y"), self.int(1))
+        self.assertIdentical(self.prog.eval("pt.x >= pt.y"), self.int(0))
+        self.assertIdentical(self.prog.eval("!pt.x"), self.int(0))
+        self.assertIdentical(self.prog.eval("pt.x == 2 || arr[1] != 20"), self.int(0))
+        self.assertIdentical(self.prog.eval("pt.x && PAGE_SIZE"), self.int(1))
+        # The right operand would fault if it were evaluated.
+        self.assertIdentical(
+            self.prog.eval("pt.x == 2 && *(int *)0 == 0"), self.int(0)
+        )
+        self.assertIdentical(self.prog.eval("pt.x || *(int *)0"), self.int(1))
+
+    def test_cast(self):
+        self.assertIdentical(
+            self.prog.eval("(long)pt.y"), Object(self.prog, "long", value=2)
+        )
+        self.assertIdentical(
+            self.prog.eval("(pid_t)pt.x"), Object(self.prog, self.pid_type, value=1)
+        )
+        self.assertIdentical(
+            self.prog.eval("((struct point *)0xffff0000)->y"),
+            Object(self.prog, "int", address=0xFFFF0004),
+        )
+        # A parenthesized variable is not a cast.
+        self.assertIdentical(self.prog.eval("(PAGE_SIZE) - 1"), self.int(4095))
+
+    def test_cached(self):
+        for i in range(3):
+            self.assertIdentical(self.prog.eval("ptr->x + 1"), self.int(2))
+
+    def test_cache_eviction(self):
+        # Evaluate more distinct expressions than are cached, then evaluate
+        # both a recently used and an evicted expression again.
+        for i in range(1100):
+            self.assertIdentical(self.prog.eval(f"pt.x + {i}"), self.int(i + 1))
+            self.assertIdentical(self.prog.eval("pt.x + 0"), self.int(1))
+        self.assertIdentical(self.prog.eval("pt.x + 1"), self.int(2))
+        self.assertIdentical(self.prog.eval("pt.x + 1099"), self.int(1100))
+
+    def test_cache_cleared_by_finder(self):
+        self.assertIdentical(self.prog.eval("PAGE_SIZE"), self.int(4096))
+        # A new finder takes precedence, so the cached expression is stale.
+        self.prog.add_object_finder(
+            lambda prog, name, flags, filename: Object(prog, "int", value=8192)
+            if name == "PAGE_SIZE"
+            else None
+        )
+        self.assertIdentical(self.prog.eval("PAGE_SIZE"), self.int(8192))
+
+    def test_errors(self):
+        self.assertRaisesRegex(
+            SyntaxError, "extra tokens after expression", self.prog.eval, "pt pt"
+        )
+        self.assertRaisesRegex(
+            SyntaxError, "expected expression", self.prog.eval, "1 +"
+        )
+        self.assertRaisesRegex(SyntaxError, "expected '\\)'", self.prog.eval, "(1")
+        self.assertRaisesRegex(
+            SyntaxError, "expected identifier after '->'", self.prog.eval, "ptr->1"
+        )
+        self.assertRaises(LookupError, self.prog.eval, "foo")
+        self.assertRaisesRegex(
+            LookupError, "could not find", self.prog.eval, "(struct foo *)0"
+        )
+        self.assertRaises(TypeError, self.prog.eval, "pt + 1")
+        for expr in ("1--1", "--pt.x", "pt.x--"):
+            self.assertRaisesRegex(
+                SyntaxError, "'--' operator is not supported", self.prog.eval, expr
+            )
+        for expr in ("1++1", "++pt.x", "pt.x++"):
+            self.assertRaisesRegex(
+                SyntaxError, "'\\+\\+' operator is not supported", self.prog.eval, expr
+            )
+
+
 class TestPrettyPrintObject(MockProgramTestCase):
     def test_int(self):
         obj = Object(self.prog, "int", value=99)
@@ -1821,6 +1998,63 @@ class TestPrettyPrintObject(MockProgramTestCase):
 }""",
         )
 
+    def test_zero_members(self):
+        int_type = self.prog.int_type("int", 4, True)
+        padded_type = self.prog.struct_type(
+            "padded",
+            8,
+            (
+                TypeMember(self.prog.int_type("char", 1, True), "c"),
+                TypeMember(int_type, "i", 32),
+            ),
+        )
+        float_type = self.prog.struct_type(
+            "fp", 8, (TypeMember(self.prog.float_type("double", 8), "d"),)
+        )
+        bits_type = self.prog.struct_type(
+            "bits",
+            4,
+            (TypeMember(Object(self.prog, int_type, bit_field_size=4), "x"),),
+        )
+        type_ = self.prog.struct_type(
+            "foo",
+            4160,
+            (
+                TypeMember(padded_type, "p"),
+                TypeMember(self.prog.array_type(int_type, 1024), "arr", 64),
+                TypeMember(float_type, "f", 32832),
+                TypeMember(self.prog.array_type(padded_type, 4), "ps", 32896),
+                TypeMember(bits_type, "b", 33152),
+                TypeMember(self.prog.int_type("long", 8, True), "tail", 33216),
+            ),
+        )
+        # Padding and bits outside of bit fields are garbage, and -0.0 is zero.
+        buf = bytearray(4160)
+        buf[1:4] = b"\xff\xff\xff"
+        buf[4104:4112] = struct.pack("<d", -0.0)
+        for i in range(4):
+            buf[4113 + 8 * i : 4116 + 8 * i] = b"\xff\xff\xff"
+        buf[4144] = 0xF0
+        buf[4152] = 1
+        self.add_memory_segment(buf, virt_addr=0xFFFF0000)
+        obj = Object(self.prog, type_, address=0xFFFF0000)
+        expected = """\
+(struct foo){
+	.tail = (long)1,
+}"""
+        self.assertEqual(obj.format_(implicit_members=False), expected)
+        self.assertEqual(obj.read_().format_(implicit_members=False), expected)
+
+        buf[4136:4140] = (1).to_bytes(4, "little")
+        buf[4000] = 1
+        self.add_memory_segment(buf, virt_addr=0xFFFF0000)
+        for obj in (obj, obj.read_()):
+            formatted = obj.format_(implicit_members=False)
+            self.assertNotIn(".p =", formatted)
+            self.assertIn(".arr =", formatted)
+            self.assertIn(".ps =", formatted)
+            self.assertNotIn(".b =", formatted)
+
     def test_bit_field(self):
         self.add_memory_segment(b"\x07\x10\x5e\x5f\x1f\0\0\0", virt_addr=0xFFFF0000)
         type_ = self.prog.struct_type(
@@ -2177,6 +2411,51 @@ class TestPrettyPrintObject(MockProgramTestCase):
 }""",
         )
 
+    def test_print(self):
+        segment = bytearray()
+        for i in range(4000):
+            segment.extend(i.to_bytes(4, "little"))
+        self.add_memory_segment(segment, virt_addr=0xFFFF0000)
+        self.types.append(self.point_type)
+
+        class Writer:
+            def __init__(self):
+                self.chunks = []
+
+            def write(self, s):
+                self.chunks.append(s)
+
+        for obj in (
+            Object(self.prog, "struct point [2000]", address=0xFFFF0000),
+            Object(self.prog, "struct point (*)[2000]", value=0xFFFF0000),
+        ):
+            for kwds in ({}, {"columns": 80}, {"element_indices": True}):
+                with self.subTest(obj=obj.type_, **kwds):
+                    writer = Writer()
+                    obj.print_(writer, **kwds)
+                    self.assertGreater(len(writer.chunks), 2)
+                    self.assertEqual(
+                        "".join(writer.chunks), obj.format_(**kwds) + "\n"
+                    )
+
+        # Elements on the same line are only streamed once they wrap.
+        obj = Object(self.prog, "int [4000]", address=0xFFFF0000)
+        writer = Writer()
+        obj.print_(writer, columns=80)
+        self.assertGreater(len(writer.chunks), 2)
+        self.assertEqual("".join(writer.chunks), obj.format_(columns=80) + "\n")
+
+        obj = Object(self.prog, "int [2]", address=0xFFFF0000)
+        writer = Writer()
+        obj.print_(file=writer, type_name=False)
+        self.assertEqual(writer.chunks, ["{ 0, 1 }", "\n"])
+
+        def write(s):
+            raise ValueError("no space left")
+
+        writer.write = write
+        self.assertRaisesRegex(ValueError, "no space left", obj.print_, writer)
+
     def test_zero_length_array(self):
         self.assertEqual(str(Object(self.prog, "int []", address=0)), "(int []){}")
         self.assertEqual(str(Object(self.prog, "int [0]", address=0)), "(int [0]){}")
@@ -0,0 +1,427 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import os
+import struct
+import tempfile
+import unittest
+
+from drgn import Object, Program, TypeMember
+from drgn.helpers.linux.coredump import write_process_core
+from drgn.helpers.linux.mm import for_each_vma
+from tests.elf import ET, PT
+from tests.elfwriter import ElfSection, create_elf_file
+
+DIRECT_MAP = 0xFFFF888000000000
+PHYS_BASE = 0x100000
+PGD = PHYS_BASE
+PAGE_A = PHYS_BASE + 0x4000
+PAGE_B = PHYS_BASE + 0x5000
+PAGE_CMDLINE = PHYS_BASE + 0x6000
+MAPLE_NODE = PHYS_BASE + 0x7000
+TASKS = PHYS_BASE + 0x8000
+SIGNAL = TASKS + 0x300
+MM = TASKS + 0x400
+VMAS = TASKS + 0x500
+STACKS = PHYS_BASE + 0xC000
+THREAD_SIZE = 0x4000
+MEMORY_SIZE = 0x18000
+# Physical address which isn't in the kernel core dump.
+MISSING_PAGE = 0x900000
+
+CMDLINE = b"myprog\0--verbose\0"
+
+
+def task_address(i):
+    return DIRECT_MAP + TASKS + i * 0x100
+
+
+def pt_regs_address(i):
+    return DIRECT_MAP + STACKS + (i + 1) * THREAD_SIZE - 21 * 8
+
+
+class TestWriteProcessCore(unittest.TestCase):
+    # Whether struct mm_struct has mm_mt (since Linux 6.1) instead of mm_rb.
+    maple_tree = False
+
+    def setUp(self):
+        P, RW, US, NX = 0x1, 0x2, 0x4, 1 << 63
+        memory = bytearray(MEMORY_SIZE)
+
+        def write(phys_addr, fmt, *values):
+            struct.pack_into(fmt, memory, phys_addr - PHYS_BASE, *values)
+
+        def set_entry(table, index, entry):
+            write(PGD + table * 0x1000 + index * 8, "<Q", entry)
+
+        set_entry(0, 0, (PGD + 0x1000) | P | RW | US)
+        set_entry(1, 0, (PGD + 0x2000) | P | RW | US)
+        set_entry(2, 2, (PGD + 0x3000) | P | RW | US)
+        # Text: the first page is mapped and the second isn't.
+        set_entry(3, 0x0, PAGE_A | P | US)
+        # Data: the second page isn't in the kernel core dump.
+        set_entry(3, 0x10, PAGE_B | P | RW | US | NX)
+        set_entry(3, 0x11, MISSING_PAGE | P | RW | US | NX)
+        # Stack.
+        set_entry(3, 0x20, PAGE_CMDLINE | P | RW | US | NX)
+        memory[PAGE_A - PHYS_BASE : PAGE_A - PHYS_BASE + 0x1000] = b"A" * 0x1000
+        memory[PAGE_B - PHYS_BASE : PAGE_B - PHYS_BASE + 0x1000] = b"B" * 0x1000
+        write(PAGE_CMDLINE, f"{len(CMDLINE)}s", CMDLINE)
+
+        # Tasks 1 and 2 are threads of one process, and task 0 is their
+        # parent.
+        for i, pid, tgid, comm in (
+            (0, 100, 100, b"bash"),
+            (1, 101, 101, b"myprog"),
+            (2, 102, 101, b"worker"),
+        ):
+            if i == 0:
+                thread_node = (0, 0)
+            else:
+                thread_node = (
+                    task_address(2) + 56 if i == 1 else DIRECT_MAP + SIGNAL,
+                    task_address(1) + 56 if i == 2 else DIRECT_MAP + SIGNAL,
+                )
+            write(
+                task_address(i) - DIRECT_MAP,
+                "<ii16sQQQQQQQQHHHHQ",
+                pid,
+                tgid,
+                comm,
+                DIRECT_MAP + STACKS + i * THREAD_SIZE,  # stack
+                DIRECT_MAP + MM if i else 0,  # mm
+                task_address(0),  # real_parent
+                DIRECT_MAP + SIGNAL,  # signal
+                *thread_node,
+                0x7F0000 + pid,  # thread.fsbase
+                0x7E0000 + pid,  # thread.gsbase
+                0,  # thread.fsindex
+                0,  # thread.gsindex
+                0x2B,  # thread.ds
+                0x2B,  # thread.es
+                task_address(1 if i else 0),  # group_leader
+            )
+            write(
+                pt_regs_address(i) - DIRECT_MAP,
+                "<21Q",
+                *(pid << 16 | reg for reg in range(21)),
+            )
+        write(SIGNAL, "<QQ", task_address(1) + 56, task_address(2) + 56)
+
+        # The VMAs are in a single maple tree leaf, which is also the root.
+        vma_addresses = [DIRECT_MAP + VMAS + i * 0x40 for i in range(3)]
+        write(
+            MAPLE_NODE + 8,
+            "<6Q",
+            0x3FFFFF,
+            0x401FFF,
+            0x40FFFF,
+            0x411FFF,
+            0x41FFFF,
+            0x420FFF,
+        )
+        slots = (0, vma_addresses[0], 0, vma_addresses[1], 0, vma_addresses[2], 0)
+        write(MAPLE_NODE + 128, "<7Q", *slots)
+        if self.maple_tree:
+            # A leaf node, marked as the root.
+            mm_root = DIRECT_MAP + MAPLE_NODE | 1 << 3 | 0x6
+        else:
+            mm_root = DIRECT_MAP + VMAS + 0x40 + 16
+        # mm_struct: pgd, mm_mt or mm_rb, saved_auxv, arg_start, arg_end.
+        write(
+            MM,
+            "<QQ6QQQ",
+            DIRECT_MAP + PGD,
+            mm_root,
+            9,  # AT_ENTRY
+            0x400000,
+            0,  # AT_NULL
+            0,
+            0,
+            0,
+            0x420000,
+            0x420000 + len(CMDLINE),
+        )
+        # The data VMA is the root, the text VMA is its left child, and the
+        # stack VMA is its right child.
+        for i, start, end, parent, right, left, flags in (
+            (0, 0x400000, 0x402000, VMAS + 0x40 + 16, 0, 0, 0x5),
+            (
+                1,
+                0x410000,
+                0x412000,
+                0,
+                DIRECT_MAP + VMAS + 0x80 + 16,
+                DIRECT_MAP + VMAS + 16,
+                0x3,
+            ),
+            (2, 0x420000, 0x421000, VMAS + 0x40 + 16, 0, 0, 0x3),
+        ):
+            if parent:
+                parent += DIRECT_MAP
+            write(
+                VMAS + i * 0x40, "<8Q", start, end, parent, right, left, flags, 0, 0
+            )
+
+        vmcoreinfo = (
+            b"OSRELEASE=5.0.0\nPAGESIZE=4096\nKERNELOFFSET=0\n"
+            b"SYMBOL(swapper_pg_dir)=%x\n" % (DIRECT_MAP + PGD)
+        )
+        name = b"VMCOREINFO\0"
+        note = (
+            struct.pack("<3I", len(name), len(vmcoreinfo), 0)
+            + name
+            + bytes(-len(name) % 4)
+            + vmcoreinfo
+            + bytes(-len(vmcoreinfo) % 4)
+        )
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE,
+                    [
+                        ElfSection(p_type=PT.NOTE, data=note),
+                        ElfSection(
+                            p_type=PT.LOAD,
+                            vaddr=DIRECT_MAP + PHYS_BASE,
+                            paddr=PHYS_BASE,
+                            data=memory,
+                        ),
+                    ],
+                )
+            )
+            f.flush()
+            self.prog = Program()
+            self.prog.set_core_dump(f.name)
+        self.add_types()
+
+    def add_types(self):
+        prog = self.prog
+        int_type = prog.int_type("int", 4, True)
+        unsigned_long_type = prog.int_type("unsigned long", 8, False)
+        unsigned_short_type = prog.int_type("unsigned short", 2, False)
+        list_head_type = prog.struct_type(
+            "list_head",
+            16,
+            (
+                TypeMember(lambda: prog.pointer_type(list_head_type), "next"),
+                TypeMember(lambda: prog.pointer_type(list_head_type), "prev", 64),
+            ),
+        )
+        rb_node_type = prog.struct_type(
+            "rb_node",
+            24,
+            (
+                TypeMember(unsigned_long_type, "__rb_parent_color"),
+                TypeMember(lambda: prog.pointer_type(rb_node_type), "rb_right", 64),
+                TypeMember(lambda: prog.pointer_type(rb_node_type), "rb_left", 128),
+            ),
+        )
+        rb_root_type = prog.struct_type(
+            "rb_root", 8, (TypeMember(prog.pointer_type(rb_node_type), "rb_node"),)
+        )
+        voidp_type = prog.pointer_type(prog.void_type())
+        maple_range_64_type = prog.struct_type(
+            "maple_range_64",
+            256,
+            (
+                TypeMember(voidp_type, "parent"),
+                TypeMember(prog.array_type(unsigned_long_type, 15), "pivot", 64),
+                TypeMember(prog.array_type(voidp_type, 16), "slot", 1024),
+            ),
+        )
+        maple_arange_64_type = prog.struct_type(
+            "maple_arange_64",
+            256,
+            (
+                TypeMember(voidp_type, "parent"),
+                TypeMember(prog.array_type(unsigned_long_type, 9), "pivot", 64),
+                TypeMember(prog.array_type(voidp_type, 10), "slot", 640),
+            ),
+        )
+        maple_node_type = prog.struct_type(
+            "maple_node",
+            256,
+            (
+                TypeMember(maple_range_64_type, "mr64"),
+                TypeMember(maple_arange_64_type, "ma64"),
+            ),
+        )
+        if self.maple_tree:
+            mm_root_member = TypeMember(
+                prog.struct_type("maple_tree", 8, (TypeMember(voidp_type, "ma_root"),)),
+                "mm_mt",
+                64,
+            )
+        else:
+            mm_root_member = TypeMember(rb_root_type, "mm_rb", 64)
+        mm_struct_type = prog.struct_type(
+            "mm_struct",
+            80,
+            (
+                TypeMember(prog.pointer_type(unsigned_long_type), "pgd"),
+                mm_root_member,
+                TypeMember(
+                    prog.array_type(unsigned_long_type, 6), "saved_auxv", 128
+                ),
+                TypeMember(unsigned_long_type, "arg_start", 512),
+                TypeMember(unsigned_long_type, "arg_end", 576),
+            ),
+        )
+        signal_struct_type = prog.struct_type(
+            "signal_struct", 16, (TypeMember(list_head_type, "thread_head"),)
+        )
+        thread_struct_type = prog.struct_type(
+            "thread_struct",
+            24,
+            (
+                TypeMember(unsigned_long_type, "fsbase"),
+                TypeMember(unsigned_long_type, "gsbase", 64),
+                TypeMember(unsigned_short_type, "fsindex", 128),
+                TypeMember(unsigned_short_type, "gsindex", 144),
+                TypeMember(unsigned_short_type, "ds", 160),
+                TypeMember(unsigned_short_type, "es", 176),
+            ),
+        )
+        task_struct_type = prog.struct_type(
+            "task_struct",
+            104,
+            (
+                TypeMember(int_type, "pid"),
+                TypeMember(int_type, "tgid", 32),
+                TypeMember(
+                    prog.array_type(prog.int_type("char", 1, True), 16), "comm", 64
+                ),
+                TypeMember(prog.pointer_type(prog.void_type()), "stack", 192),
+                TypeMember(prog.pointer_type(mm_struct_type), "mm", 256),
+                TypeMember(
+                    lambda: prog.pointer_type(task_struct_type), "real_parent", 320
+                ),
+                TypeMember(prog.pointer_type(signal_struct_type), "signal", 384),
+                TypeMember(list_head_type, "thread_node", 448),
+                TypeMember(thread_struct_type, "thread", 576),
+                TypeMember(
+                    lambda: prog.pointer_type(task_struct_type), "group_leader", 768
+                ),
+            ),
+        )
+        types = [
+            list_head_type,
+            rb_node_type,
+            rb_root_type,
+            maple_node_type,
+            mm_struct_type,
+            task_struct_type,
+            prog.struct_type(
+                "vm_area_struct",
+                64,
+                (
+                    TypeMember(unsigned_long_type, "vm_start"),
+                    TypeMember(unsigned_long_type, "vm_end", 64),
+                    TypeMember(rb_node_type, "vm_rb", 128),
+                    TypeMember(unsigned_long_type, "vm_flags", 320),
+                    TypeMember(unsigned_long_type, "vm_pgoff", 384),
+                    TypeMember(
+                        prog.pointer_type(prog.struct_type("file")), "vm_file", 448
+                    ),
+                ),
+            ),
+            prog.struct_type("pt_regs", 21 * 8, ()),
+            prog.union_type("thread_union", THREAD_SIZE, ()),
+        ]
+
+        def find_type(kind, name, filename):
+            for type in types:
+                if type.kind == kind and type.tag == name:
+                    return type
+            return None
+
+        prog.add_type_finder(find_type)
+
+    def read_core(self, path):
+        with open(path, "rb") as f:
+            buf = f.read()
+        phoff, phentsize, phnum = (
+            struct.unpack_from("<Q", buf, 32)[0],
+            *struct.unpack_from("<HH", buf, 54),
+        )
+        segments = []
+        notes = []
+        for i in range(phnum):
+            p_type, p_flags, offset, vaddr, _, filesz, memsz, _ = struct.unpack_from(
+                "<IIQQQQQQ", buf, phoff + i * phentsize
+            )
+            if p_type == PT.NOTE:
+                pos = offset
+                while pos < offset + filesz:
+                    namesz, descsz, type = struct.unpack_from("<3I", buf, pos)
+                    pos += 12 + namesz + (-namesz % 4)
+                    notes.append((type, buf[pos : pos + descsz]))
+                    pos += descsz + (-descsz % 4)
+            else:
+                segments.append(
+                    (vaddr, memsz, p_flags, buf[offset : offset + filesz])
+                )
+        return segments, notes
+
+    def test_write_process_core(self):
+        task = Object(self.prog, "struct task_struct *", value=task_address(2))
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "core")
+            self.assertEqual(write_process_core(task, path), 0x3000)
+            segments, notes = self.read_core(path)
+
+            core_prog = Program()
+            core_prog.set_core_dump(path)
+            self.assertEqual(core_prog.read(0x410000, 4), b"BBBB")
+
+        self.assertEqual(
+            segments,
+            [
+                (0x400000, 0x2000, 0x5, b"A" * 0x1000 + bytes(0x1000)),
+                (0x410000, 0x2000, 0x6, b"B" * 0x1000 + bytes(0x1000)),
+                (
+                    0x420000,
+                    0x1000,
+                    0x6,
+                    CMDLINE + bytes(0x1000 - len(CMDLINE)),
+                ),
+            ],
+        )
+
+        self.assertEqual([type for type, _ in notes], [1, 1, 3, 6, 0x46494C45])
+        for (_, prstatus), pid in zip(notes, (102, 101)):
+            self.assertEqual(struct.unpack_from("<2i", prstatus, 32), (pid, 100))
+            regs = struct.unpack_from("<27Q", prstatus, 112)
+            self.assertEqual(regs[:21], tuple(pid << 16 | reg for reg in range(21)))
+            self.assertEqual(
+                regs[21:], (0x7F0000 + pid, 0x7E0000 + pid, 0x2B, 0x2B, 0, 0)
+            )
+        prpsinfo = notes[2][1]
+        self.assertEqual(struct.unpack_from("<2i", prpsinfo, 24), (101, 100))
+        self.assertEqual(prpsinfo[40:56].rstrip(b"\0"), b"myprog")
+        self.assertEqual(prpsinfo[56:136].rstrip(b"\0"), b"myprog --verbose")
+        self.assertEqual(notes[3][1], struct.pack("<4Q", 9, 0x400000, 0, 0))
+        self.assertEqual(notes[4][1], struct.pack("<QQ", 0, 4096))
+
+    def test_for_each_vma(self):
+        mm = Object(self.prog, "struct mm_struct *", value=DIRECT_MAP + MM)
+        self.assertEqual(
+            [(vma.vm_start.value_(), vma.vm_end.value_()) for vma in for_each_vma(mm)],
+            [(0x400000, 0x402000), (0x410000, 0x412000), (0x420000, 0x421000)],
+        )
+
+    def test_kernel_thread(self):
+        task = Object(self.prog, "struct task_struct *", value=task_address(0))
+        with tempfile.TemporaryDirectory() as tmp:
+            self.assertRaisesRegex(
+                ValueError,
+                "no address space",
+                write_process_core,
+                task,
+                os.path.join(tmp, "core"),
+            )
+
+
+class TestWriteProcessCoreMapleTree(TestWriteProcessCore):
+    maple_tree = True
@@ -0,0 +1,563 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import struct
+
+from drgn import Object, TypeMember
+from drgn.helpers.linux.fs import (
+    TaskFile,
+    TaskMapping,
+    d_path,
+    dentry_path,
+    for_each_open_file,
+)
+from tests import MockObject, MockProgramTestCase
+
+
+def dentry_address(i):
+    return 0xFFFF1000 + i * 0x40
+
+
+def mount_address(i):
+    return 0xFFFF3000 + i * 0x20
+
+
+def vfsmount_address(i):
+    return mount_address(i) + 16
+
+
+OPS = 0xFFFF4000
+SB = 0xFFFF4100
+FS_TYPE = 0xFFFF4200
+FS_NAME = 0xFFFF4300
+PATH = 0xFFFF4400
+
+# (parent, name, d_op) for each dentry.
+DENTRIES = [
+    (0, b"/", 0),
+    (0, b"usr", 0),
+    (1, b"lib", 0),
+    (2, b"libc.so", 0),
+    (0, b"home", 0),
+    # Root of the filesystem mounted on /home.
+    (5, b"/", 0),
+    (5, b"user", 0),
+    (6, b"file", 0),
+    (8, b"pipe:[1234]", OPS),
+    (2, b"libm.so", 0),
+]
+
+# (parent, mountpoint, root) for each mount.
+MOUNTS = [(0, 0, 0), (0, 4, 5)]
+
+
+class DPathTestCase(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        u32 = self.prog.int_type("unsigned int", 4, False)
+        char_p = self.prog.pointer_type(self.prog.int_type("char", 1, True))
+        void_p = self.prog.pointer_type(self.prog.void_type())
+        dentry_type = self.prog.struct_type("dentry")
+        dentry_p = self.prog.pointer_type(dentry_type)
+        vfsmount_type = self.prog.struct_type(
+            "vfsmount", 8, (TypeMember(dentry_p, "mnt_root"),)
+        )
+        mount_type = self.prog.struct_type("mount")
+        file_system_type_type = self.prog.struct_type(
+            "file_system_type", 8, (TypeMember(char_p, "name"),)
+        )
+        super_block_type = self.prog.struct_type(
+            "super_block",
+            8,
+            (TypeMember(self.prog.pointer_type(file_system_type_type), "s_type"),),
+        )
+        self.types.extend(
+            (
+                self.prog.struct_type(
+                    "mount",
+                    24,
+                    (
+                        TypeMember(self.prog.pointer_type(mount_type), "mnt_parent"),
+                        TypeMember(dentry_p, "mnt_mountpoint", 64),
+                        TypeMember(vfsmount_type, "mnt", 128),
+                    ),
+                ),
+                self.prog.struct_type(
+                    "dentry",
+                    48,
+                    (
+                        TypeMember(u32, "d_flags"),
+                        TypeMember(dentry_p, "d_parent", 64),
+                        TypeMember(
+                            self.prog.struct_type(
+                                "qstr",
+                                16,
+                                (
+                                    TypeMember(u32, "hash"),
+                                    TypeMember(u32, "len", 32),
+                                    TypeMember(char_p, "name", 64),
+                                ),
+                            ),
+                            "d_name",
+                            128,
+                        ),
+                        TypeMember(void_p, "d_op", 256),
+                        TypeMember(
+                            self.prog.pointer_type(super_block_type), "d_sb", 320
+                        ),
+                    ),
+                ),
+                self.prog.struct_type(
+                    "dentry_operations", 8, (TypeMember(void_p, "d_dname"),)
+                ),
+                self.prog.struct_type(
+                    "path",
+                    16,
+                    (
+                        TypeMember(self.prog.pointer_type(vfsmount_type), "mnt"),
+                        TypeMember(dentry_p, "dentry", 64),
+                    ),
+                ),
+                vfsmount_type,
+                super_block_type,
+                file_system_type_type,
+            )
+        )
+
+        dentries = bytearray()
+        names = bytearray()
+        for i, (parent, name, d_op) in enumerate(DENTRIES):
+            dentries.extend(
+                struct.pack(
+                    "<I4xQIIQQQ16x",
+                    0,
+                    dentry_address(parent),
+                    0,
+                    len(name),
+                    0xFFFF2000 + len(names),
+                    d_op,
+                    SB,
+                )
+            )
+            names.extend(name + b"\0")
+        self.dentry_reads = []
+
+        def read_dentries(address, count, offset, physical):
+            self.dentry_reads.append(address)
+            return dentries[offset : offset + count]
+
+        self.prog.add_memory_segment(dentry_address(0), len(dentries), read_dentries)
+        self.add_memory_segment(names, virt_addr=0xFFFF2000)
+        self.add_memory_segment(
+            b"".join(
+                struct.pack(
+                    "<QQQ8x",
+                    mount_address(parent),
+                    dentry_address(mountpoint),
+                    dentry_address(root),
+                )
+                for parent, mountpoint, root in MOUNTS
+            ),
+            virt_addr=mount_address(0),
+        )
+        self.add_memory_segment(struct.pack("<Q", 1), virt_addr=OPS)
+        self.add_memory_segment(struct.pack("<Q", FS_TYPE), virt_addr=SB)
+        self.add_memory_segment(struct.pack("<Q", FS_NAME), virt_addr=FS_TYPE)
+        self.add_memory_segment(b"pipefs\0", virt_addr=FS_NAME)
+        self.add_memory_segment(
+            struct.pack("<QQ", vfsmount_address(1), dentry_address(7)),
+            virt_addr=PATH,
+        )
+
+    def dentry(self, i):
+        return Object(self.prog, "struct dentry *", value=dentry_address(i))
+
+    def vfsmount(self, i):
+        return Object(self.prog, "struct vfsmount *", value=vfsmount_address(i))
+
+
+class TestDPath(DPathTestCase):
+    def test_d_path(self):
+        self.assertEqual(d_path(self.vfsmount(0), self.dentry(3)), b"/usr/lib/libc.so")
+        self.assertEqual(d_path(self.vfsmount(0), self.dentry(0)), b"/")
+        self.assertEqual(d_path(self.vfsmount(0), self.dentry(4)), b"/home")
+
+    def test_d_path_mount(self):
+        self.assertEqual(d_path(self.vfsmount(1), self.dentry(7)), b"/home/user/file")
+        self.assertEqual(d_path(self.vfsmount(1), self.dentry(5)), b"/home")
+
+    def test_d_path_struct_path(self):
+        path = Object(self.prog, "struct path", address=PATH)
+        self.assertEqual(d_path(path), b"/home/user/file")
+        self.assertEqual(d_path(path.address_of_()), b"/home/user/file")
+
+    def test_d_path_dname(self):
+        self.assertEqual(d_path(self.vfsmount(0), self.dentry(8)), b"[pipefs]")
+
+    def test_d_path_memoized(self):
+        d_path(self.vfsmount(0), self.dentry(3))
+        self.dentry_reads.clear()
+        self.assertEqual(d_path(self.vfsmount(0), self.dentry(9)), b"/usr/lib/libm.so")
+        # Only the new dentry is read; /usr/lib is remembered.
+        self.assertEqual(len(self.dentry_reads), 1)
+        self.dentry_reads.clear()
+        self.assertEqual(d_path(self.vfsmount(0), self.dentry(9)), b"/usr/lib/libm.so")
+        self.assertEqual(self.dentry_reads, [])
+
+    def test_dentry_path(self):
+        self.assertEqual(dentry_path(self.dentry(7)), b"user/file")
+        self.assertEqual(dentry_path(self.dentry(5)), b"")
+        self.assertEqual(dentry_path(self.dentry(3)), b"usr/lib/libc.so")
+
+    def test_invalid(self):
+        self.assertRaisesRegex(
+            TypeError,
+            "must be a pointer",
+            d_path,
+            self.vfsmount(0),
+            Object(self.prog, "unsigned int", value=0),
+        )
+
+
+PID_HASH = 0xFFFF5000
+INIT_PID_NS = 0xFFFF5100
+PIDS = 0xFFFF6000
+TASKS = 0xFFFF7000
+FILES = 0xFFFF8000
+FDTABLE = 0xFFFF8100
+FD_ARRAY = 0xFFFF8200
+OPEN_FDS = 0xFFFF8800
+MM = 0xFFFF9000
+VMAS = 0xFFFF9100
+FILE_LIBC = 0xFFFFA000
+FILE_PIPE = 0xFFFFA100
+FILE_USER = 0xFFFFA200
+MAPLE_NODES = 0xFFFFB000
+
+
+def pid_address(i):
+    return PIDS + i * 0x40
+
+
+def task_address(i):
+    return TASKS + i * 0x40
+
+
+def vma_address(i):
+    return VMAS + i * 0x40
+
+
+def maple_node_address(i):
+    return MAPLE_NODES + i * 0x100
+
+
+class TestForEachOpenFile(DPathTestCase):
+    def setUp(self):
+        super().setUp()
+        char_type = self.prog.int_type("char", 1, True)
+        int_type = self.prog.int_type("int", 4, True)
+        unsigned_int_type = self.prog.int_type("unsigned int", 4, False)
+        unsigned_long_type = self.prog.int_type("unsigned long", 8, False)
+        voidp_type = self.prog.pointer_type(self.prog.void_type())
+        hlist_node_type = self.prog.struct_type(
+            "hlist_node",
+            16,
+            (
+                TypeMember(lambda: self.prog.pointer_type(hlist_node_type), "next"),
+                TypeMember(voidp_type, "pprev", 64),
+            ),
+        )
+        hlist_head_type = self.prog.struct_type(
+            "hlist_head",
+            8,
+            (TypeMember(self.prog.pointer_type(hlist_node_type), "first"),),
+        )
+        pid_namespace_type = self.prog.struct_type(
+            "pid_namespace", 4, (TypeMember(unsigned_int_type, "level"),)
+        )
+        upid_type = self.prog.struct_type(
+            "upid",
+            32,
+            (
+                TypeMember(int_type, "nr"),
+                TypeMember(self.prog.pointer_type(pid_namespace_type), "ns", 64),
+                TypeMember(hlist_node_type, "pid_chain", 128),
+            ),
+        )
+        rb_node_type = self.prog.struct_type(
+            "rb_node",
+            24,
+            (
+                TypeMember(unsigned_long_type, "__rb_parent_color"),
+                TypeMember(
+                    lambda: self.prog.pointer_type(rb_node_type), "rb_right", 64
+                ),
+                TypeMember(
+                    lambda: self.prog.pointer_type(rb_node_type), "rb_left", 128
+                ),
+            ),
+        )
+        rb_root_type = self.prog.struct_type(
+            "rb_root", 8, (TypeMember(self.prog.pointer_type(rb_node_type), "rb_node"),)
+        )
+        file_type = self.prog.struct_type(
+            "file", 16, (TypeMember(self.prog.type("struct path"), "f_path"),)
+        )
+        file_pp = self.prog.pointer_type(self.prog.pointer_type(file_type))
+        fdtable_type = self.prog.struct_type(
+            "fdtable",
+            24,
+            (
+                TypeMember(unsigned_int_type, "max_fds"),
+                TypeMember(file_pp, "fd", 64),
+                TypeMember(self.prog.pointer_type(unsigned_long_type), "open_fds", 128),
+            ),
+        )
+        files_struct_type = self.prog.struct_type(
+            "files_struct",
+            8,
+            (TypeMember(self.prog.pointer_type(fdtable_type), "fdt"),),
+        )
+        mm_struct_type = self.prog.struct_type(
+            "mm_struct", 8, (TypeMember(rb_root_type, "mm_rb"),)
+        )
+        self.types.extend(
+            (
+                upid_type,
+                rb_node_type,
+                rb_root_type,
+                self.prog.struct_type(
+                    "pid",
+                    40,
+                    (
+                        TypeMember(self.prog.array_type(hlist_head_type, 1), "tasks"),
+                        TypeMember(self.prog.array_type(upid_type, 1), "numbers", 64),
+                    ),
+                ),
+                self.prog.struct_type(
+                    "task_struct",
+                    56,
+                    (
+                        TypeMember(int_type, "pid"),
+                        TypeMember(self.prog.array_type(char_type, 16), "comm", 32),
+                        TypeMember(
+                            self.prog.array_type(hlist_node_type, 1), "pid_links", 192
+                        ),
+                        TypeMember(
+                            self.prog.pointer_type(files_struct_type), "files", 320
+                        ),
+                        TypeMember(self.prog.pointer_type(mm_struct_type), "mm", 384),
+                    ),
+                ),
+                pid_namespace_type,
+                files_struct_type,
+                fdtable_type,
+                file_type,
+                mm_struct_type,
+                self.prog.struct_type(
+                    "vm_area_struct",
+                    64,
+                    (
+                        TypeMember(unsigned_long_type, "vm_start"),
+                        TypeMember(unsigned_long_type, "vm_end", 64),
+                        TypeMember(rb_node_type, "vm_rb", 128),
+                        TypeMember(unsigned_long_type, "vm_flags", 320),
+                        TypeMember(unsigned_long_type, "vm_pgoff", 384),
+                        TypeMember(self.prog.pointer_type(file_type), "vm_file", 448),
+                    ),
+                ),
+            )
+        )
+        self.objects.extend(
+            (
+                MockObject("PIDTYPE_PID", int_type, value=0),
+                MockObject(
+                    "pid_hash", self.prog.pointer_type(hlist_head_type), value=PID_HASH
+                ),
+                MockObject("pidhash_shift", unsigned_int_type, value=2),
+                MockObject("init_pid_ns", pid_namespace_type, address=INIT_PID_NS),
+            )
+        )
+
+        # PID 1 has open files and mappings, PID 2 is a thread of PID 1, and
+        # PID 3 is a kernel thread.
+        self.add_memory_segment(struct.pack("<I", 0), virt_addr=INIT_PID_NS)
+        self.add_memory_segment(
+            struct.pack("<4Q", 0, *(pid_address(i) + 24 for i in (1, 2, 3))),
+            virt_addr=PID_HASH,
+        )
+        pids = bytearray(0x100)
+        tasks = bytearray(0x100)
+        for i, comm, files, mm in (
+            (1, b"init", FILES, MM),
+            (2, b"init", FILES, MM),
+            (3, b"kthreadd", 0, 0),
+        ):
+            struct.pack_into(
+                "<Qi4xQQQ",
+                pids,
+                pid_address(i) - PIDS,
+                task_address(i) + 24,
+                i,
+                INIT_PID_NS,
+                0,
+                0,
+            )
+            struct.pack_into(
+                "<i16s4xQQQQ", tasks, task_address(i) - TASKS, i, comm, 0, 0, files, mm
+            )
+        self.add_memory_segment(pids, virt_addr=PIDS)
+        self.add_memory_segment(tasks, virt_addr=TASKS)
+
+        self.add_memory_segment(struct.pack("<Q", FDTABLE), virt_addr=FILES)
+        self.add_memory_segment(
+            struct.pack("<I4xQQ", 128, FD_ARRAY, OPEN_FDS), virt_addr=FDTABLE
+        )
+        # fd 3 is allocated but not installed yet.
+        self.add_memory_segment(
+            struct.pack("<QQ", 0b1101, 0b10), virt_addr=OPEN_FDS
+        )
+        fds = [0] * 128
+        fds[0] = FILE_LIBC
+        fds[2] = FILE_PIPE
+        fds[65] = FILE_USER
+        self.add_memory_segment(struct.pack("<128Q", *fds), virt_addr=FD_ARRAY)
+        for file, vfsmount, dentry in (
+            (FILE_LIBC, 0, 3),
+            (FILE_PIPE, 0, 8),
+            (FILE_USER, 1, 7),
+        ):
+            self.add_memory_segment(
+                struct.pack("<QQ", vfsmount_address(vfsmount), dentry_address(dentry)),
+                virt_addr=file,
+            )
+
+        # VMA 0 is the root with VMA 1 as its right child.
+        self.add_memory_segment(struct.pack("<Q", vma_address(0) + 16), virt_addr=MM)
+        vmas = bytearray()
+        for start, end, parent, right, flags, pgoff, file in (
+            (0x400000, 0x401000, 0, vma_address(1) + 16, 0x5, 0, FILE_LIBC),
+            (0x7FF000, 0x800000, vma_address(0) + 16, 0, 0x3, 0x7FF, 0),
+        ):
+            vmas.extend(
+                struct.pack(
+                    "<8Q", start, end, parent, right, 0, flags, pgoff, file
+                )
+            )
+        self.add_memory_segment(vmas, virt_addr=VMAS)
+
+        self.files = [
+            TaskFile(1, b"init", task_address(1), 0, FILE_LIBC, b"/usr/lib/libc.so"),
+            TaskFile(1, b"init", task_address(1), 2, FILE_PIPE, b"[pipefs]"),
+            TaskFile(1, b"init", task_address(1), 65, FILE_USER, b"/home/user/file"),
+        ]
+        self.mappings = [
+            TaskMapping(
+                1,
+                b"init",
+                task_address(1),
+                vma_address(0),
+                0x400000,
+                0x401000,
+                0x5,
+                0,
+                FILE_LIBC,
+                b"/usr/lib/libc.so",
+            ),
+            TaskMapping(
+                1,
+                b"init",
+                task_address(1),
+                vma_address(1),
+                0x7FF000,
+                0x800000,
+                0x3,
+                0x7FF,
+                0,
+                None,
+            ),
+        ]
+
+    def test_for_each_open_file(self):
+        self.assertEqual(
+            list(for_each_open_file(self.prog)), self.files + self.mappings
+        )
+
+    def test_fds(self):
+        self.assertEqual(
+            list(for_each_open_file(self.prog, mappings=False)), self.files
+        )
+
+    def test_mappings(self):
+        self.assertEqual(
+            list(for_each_open_file(self.prog, fds=False)), self.mappings
+        )
+
+
+class TestForEachOpenFileMapleTree(TestForEachOpenFile):
+    def setUp(self):
+        super().setUp()
+        unsigned_int_type = self.prog.int_type("unsigned int", 4, False)
+        unsigned_long_type = self.prog.int_type("unsigned long", 8, False)
+        voidp_type = self.prog.pointer_type(self.prog.void_type())
+        maple_range_64_type = self.prog.struct_type(
+            "maple_range_64",
+            256,
+            (
+                TypeMember(voidp_type, "parent"),
+                TypeMember(self.prog.array_type(unsigned_long_type, 15), "pivot", 64),
+                TypeMember(self.prog.array_type(voidp_type, 16), "slot", 1024),
+            ),
+        )
+        maple_arange_64_type = self.prog.struct_type(
+            "maple_arange_64",
+            256,
+            (
+                TypeMember(voidp_type, "parent"),
+                TypeMember(self.prog.array_type(unsigned_long_type, 9), "pivot", 64),
+                TypeMember(self.prog.array_type(voidp_type, 10), "slot", 640),
+                TypeMember(self.prog.array_type(unsigned_long_type, 10), "gap", 1280),
+            ),
+        )
+        maple_tree_type = self.prog.struct_type(
+            "maple_tree",
+            16,
+            (
+                TypeMember(unsigned_int_type, "ma_flags", 32),
+                TypeMember(voidp_type, "ma_root", 64),
+            ),
+        )
+        # Since Linux 6.1, struct mm_struct has mm_mt instead of mm_rb.
+        self.types[:0] = (
+            self.prog.struct_type(
+                "maple_node",
+                256,
+                (
+                    TypeMember(maple_range_64_type, "mr64"),
+                    TypeMember(maple_arange_64_type, "ma64"),
+                ),
+            ),
+            self.prog.struct_type(
+                "mm_struct", 16, (TypeMember(maple_tree_type, "mm_mt"),)
+            ),
+        )
+
+        # The root is an allocation range node with two leaves. The first
+        # leaf has VMA 0. The second leaf has a reserved entry, VMA 1, and a
+        # stale entry after its last slot.
+        def add_node(i, type, pivots, slots):
+            buf = bytearray(256)
+            struct.pack_into(f"<{len(pivots)}Q", buf, 8, *pivots)
+            struct.pack_into(f"<{len(slots)}Q", buf, 80 if type == 3 else 128, *slots)
+            self.add_memory_segment(buf, virt_addr=maple_node_address(i))
+            return maple_node_address(i) | type << 3 | 0x4
+
+        leaf0 = add_node(1, 1, (0x3FFFFF, 0x400FFF), (0, vma_address(0)))
+        leaf1 = add_node(
+            2,
+            1,
+            (0x5FFFFF, 0x600FFF, 0x7FEFFF, 0x7FFFFF),
+            (0, 0x406, 0, vma_address(1), 0, vma_address(0)),
+        )
+        root = add_node(0, 3, (0x400FFF,), (leaf0, leaf1))
+        self.add_memory_segment(struct.pack("<IIQ", 0, 0, root | 0x2), virt_addr=MM)
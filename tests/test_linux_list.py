@@ -0,0 +1,236 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import struct
+
+from _drgn import _linux_helper_list_for_each_entry
+from drgn import FaultError, Object, TypeMember
+from drgn.helpers.linux.list import (
+    hlist_for_each,
+    hlist_for_each_entry,
+    list_for_each,
+    list_for_each_entry,
+    list_for_each_entry_reverse,
+    list_for_each_reverse,
+)
+from tests import MockProgramTestCase
+
+HEAD = 0xFFFF0000
+ITEMS = 0xFFFF1000
+
+
+def item_address(i):
+    return ITEMS + i * 24
+
+
+class TestList(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        self.list_head_type = self.prog.struct_type(
+            "list_head",
+            16,
+            (
+                TypeMember(
+                    lambda: self.prog.pointer_type(self.list_head_type), "next"
+                ),
+                TypeMember(
+                    lambda: self.prog.pointer_type(self.list_head_type), "prev", 64
+                ),
+            ),
+        )
+        self.hlist_node_type = self.prog.struct_type(
+            "hlist_node",
+            16,
+            (
+                TypeMember(
+                    lambda: self.prog.pointer_type(self.hlist_node_type), "next"
+                ),
+                TypeMember(
+                    lambda: self.prog.pointer_type(
+                        self.prog.pointer_type(self.hlist_node_type)
+                    ),
+                    "pprev",
+                    64,
+                ),
+            ),
+        )
+        self.hlist_head_type = self.prog.struct_type(
+            "hlist_head",
+            8,
+            (TypeMember(self.prog.pointer_type(self.hlist_node_type), "first"),),
+        )
+        self.item_type = self.prog.struct_type(
+            "item",
+            24,
+            (
+                TypeMember(self.prog.int_type("int", 4, True), "value"),
+                TypeMember(self.list_head_type, "node", 64),
+            ),
+        )
+        self.hitem_type = self.prog.struct_type(
+            "hitem",
+            24,
+            (
+                TypeMember(self.prog.int_type("int", 4, True), "value"),
+                TypeMember(self.hlist_node_type, "node", 64),
+            ),
+        )
+        self.types.extend((self.item_type, self.hitem_type))
+
+    def node(self, i):
+        return HEAD if i is None else item_address(i) + 8
+
+    def add_list(self, order):
+        # Link the items in the given order into a circular list.
+        nodes = [None] + list(order)
+        head = struct.pack(
+            "<QQ", self.node(nodes[1 % len(nodes)]), self.node(nodes[-1])
+        )
+        items = bytearray(24 * 8)
+        for j, i in enumerate(nodes[1:], 1):
+            struct.pack_into(
+                "<iiQQ",
+                items,
+                24 * i,
+                i,
+                0,
+                self.node(nodes[(j + 1) % len(nodes)]),
+                self.node(nodes[j - 1]),
+            )
+        self.add_memory_segment(head, virt_addr=HEAD)
+        self.add_memory_segment(items, virt_addr=ITEMS)
+        return Object(self.prog, self.prog.pointer_type(self.list_head_type), HEAD)
+
+    def values(self, it):
+        return [entry.value.value_() for entry in it]
+
+    def test_list_for_each(self):
+        head = self.add_list([2, 0, 1])
+        self.assertEqual(
+            [pos.value_() for pos in list_for_each(head)],
+            [self.node(2), self.node(0), self.node(1)],
+        )
+        self.assertEqual(
+            [pos.value_() for pos in list_for_each_reverse(head)],
+            [self.node(1), self.node(0), self.node(2)],
+        )
+        for pos in list_for_each(head):
+            self.assertEqual(pos.type_.type_name(), "struct list_head *")
+
+    def test_list_for_each_entry(self):
+        head = self.add_list([2, 0, 1])
+        self.assertEqual(
+            self.values(list_for_each_entry("struct item", head, "node")), [2, 0, 1]
+        )
+        self.assertEqual(
+            self.values(list_for_each_entry(self.item_type, head, "node")), [2, 0, 1]
+        )
+        self.assertEqual(
+            self.values(list_for_each_entry_reverse("struct item", head, "node")),
+            [1, 0, 2],
+        )
+        for entry in list_for_each_entry("struct item", head, "node"):
+            self.assertEqual(entry.type_.type_name(), "struct item *")
+
+    def test_empty(self):
+        head = self.add_list([])
+        self.assertEqual(list(list_for_each(head)), [])
+        self.assertEqual(list(list_for_each_entry("struct item", head, "node")), [])
+
+    def test_max_length(self):
+        head = self.add_list(range(5))
+        self.assertEqual(len(list(list_for_each(head, max_length=5))), 5)
+        self.assertRaisesRegex(
+            ValueError,
+            "list has more than 4 entries",
+            list,
+            list_for_each(head, max_length=4),
+        )
+
+    def test_cycle(self):
+        self.add_list(range(4))
+        # Make item 3 point back to item 1 instead of to the head.
+        self.add_memory_segment(
+            struct.pack("<Q", self.node(1)), virt_addr=item_address(3) + 8
+        )
+        head = Object(self.prog, self.prog.pointer_type(self.list_head_type), HEAD)
+        self.assertRaisesRegex(
+            ValueError,
+            "list contains a cycle",
+            list,
+            list_for_each(head, validate=True),
+        )
+        # Without validation, only max_length stops the iteration.
+        self.assertRaisesRegex(
+            ValueError,
+            "list has more than 10 entries",
+            list,
+            list_for_each(head, max_length=10),
+        )
+
+    def test_null_next(self):
+        self.add_memory_segment(bytes(16), virt_addr=HEAD)
+        head = Object(self.prog, self.prog.pointer_type(self.list_head_type), HEAD)
+        self.assertRaises(FaultError, list, list_for_each(head))
+
+    def test_hlist(self):
+        items = bytearray(24 * 3)
+        # first -> 1 -> 0 -> 2
+        for i, next in ((1, 0), (0, 2), (2, None)):
+            struct.pack_into(
+                "<iiQQ",
+                items,
+                24 * i,
+                i,
+                0,
+                0 if next is None else item_address(next) + 8,
+                0,
+            )
+        self.add_memory_segment(items, virt_addr=ITEMS)
+        self.add_memory_segment(struct.pack("<Q", item_address(1) + 8), virt_addr=HEAD)
+        head = Object(self.prog, self.prog.pointer_type(self.hlist_head_type), HEAD)
+        self.assertEqual(
+            [pos.value_() for pos in hlist_for_each(head)],
+            [item_address(i) + 8 for i in (1, 0, 2)],
+        )
+        self.assertEqual(
+            self.values(hlist_for_each_entry("struct hitem", head, "node")),
+            [1, 0, 2],
+        )
+        self.assertRaisesRegex(
+            ValueError,
+            "list has more than 2 entries",
+            list,
+            hlist_for_each(head, max_length=2),
+        )
+
+    def test_empty_hlist(self):
+        self.add_memory_segment(bytes(8), virt_addr=HEAD)
+        head = Object(self.prog, self.prog.pointer_type(self.hlist_head_type), HEAD)
+        self.assertEqual(list(hlist_for_each(head)), [])
+
+    def test_invalid_head(self):
+        self.assertRaisesRegex(
+            TypeError,
+            "list head must be a pointer",
+            list,
+            list_for_each(Object(self.prog, "int", 0)),
+        )
+
+    def test_reentrant_next(self):
+        head = self.add_list(range(2))
+        it = _linux_helper_list_for_each_entry(None, head, None)
+        errors = []
+        items = self.prog.read(ITEMS, 24 * 8)
+
+        def read_items(address, count, offset, physical):
+            try:
+                next(it)
+            except ValueError as e:
+                errors.append(str(e))
+            return items[offset : offset + count]
+
+        self.prog.add_memory_segment(ITEMS, len(items), read_items)
+        self.assertEqual(next(it).value_(), self.node(0))
+        self.assertEqual(next(it).value_(), self.node(1))
+        self.assertEqual(errors, ["iterator already executing"] * 2)
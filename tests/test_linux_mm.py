@@ -0,0 +1,236 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import struct
+import tempfile
+import unittest
+
+from drgn import Object, Program, TypeEnumerator, TypeMember
+from drgn.helpers.linux.mm import (
+    MappedRange,
+    for_each_mapped_range,
+    for_each_page_with_flags,
+    page_stats,
+)
+from tests import MockObject, MockProgramTestCase
+from tests.elf import ET, PT
+from tests.elfwriter import ElfSection, create_elf_file
+
+VMEMMAP = 0xFFFF0000
+
+
+def page_address(pfn):
+    return VMEMMAP + 32 * pfn
+
+
+class TestPageScanner(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        unsigned_int_type = self.prog.int_type("unsigned int", 4, False)
+        unsigned_long_type = self.prog.int_type("unsigned long", 8, False)
+        pageflags = (
+            ("PG_locked", 0),
+            ("PG_referenced", 1),
+            ("PG_dirty", 2),
+            ("PG_slab", 3),
+            ("PG_owner_priv_1", 4),
+            ("PG_checked", 4),
+            ("__NR_PAGEFLAGS", 5),
+        )
+        self.pageflags_type = self.prog.enum_type(
+            "pageflags",
+            unsigned_int_type,
+            [TypeEnumerator(name, value) for name, value in pageflags],
+        )
+        self.page_type = self.prog.struct_type(
+            "page",
+            32,
+            (
+                TypeMember(unsigned_long_type, "flags"),
+                TypeMember(unsigned_long_type, "compound_head", 64),
+                TypeMember(
+                    self.prog.pointer_type(self.prog.void_type()), "mapping", 128
+                ),
+            ),
+        )
+        self.types.extend((self.pageflags_type, self.page_type))
+        self.objects.extend(
+            MockObject(name, self.pageflags_type, value=value)
+            for name, value in pageflags
+        )
+        self.objects.extend(
+            (
+                MockObject(
+                    "vmemmap", self.prog.pointer_type(self.page_type), value=VMEMMAP
+                ),
+                MockObject("max_pfn", unsigned_long_type, value=8),
+            )
+        )
+
+        def page(flags, compound_head=0, mapping=0):
+            return struct.pack("<QQQ8x", flags, compound_head, mapping)
+
+        # PFNs 2 and 3 are a hole in the memory map. The high bits of the flags
+        # aren't page flags.
+        self.add_memory_segment(
+            page(0b101 | (1 << 60)) + page(0b1000, mapping=0xFFFF8000),
+            virt_addr=page_address(0),
+        )
+        self.add_memory_segment(
+            page(0b100, mapping=0xFFFF9001)
+            + page(0, compound_head=page_address(4) | 1)
+            + page(0b10100, mapping=0xFFFFA003)
+            + page(0, mapping=0xFFFFB002),
+            virt_addr=page_address(4),
+        )
+
+    def test_page_stats(self):
+        stats = page_stats(self.prog)
+        self.assertEqual(stats.pages, 6)
+        self.assertEqual(
+            stats.flags,
+            {
+                "PG_locked": 1,
+                "PG_referenced": 0,
+                "PG_dirty": 3,
+                "PG_slab": 1,
+                "PG_owner_priv_1": 1,
+            },
+        )
+        self.assertEqual(
+            stats.mapping,
+            {"none": 1, "file": 1, "anon": 1, "movable": 1, "ksm": 1, "tail": 1},
+        )
+
+    def test_page_stats_range(self):
+        stats = page_stats(self.prog, 4, 6)
+        self.assertEqual(stats.pages, 2)
+        self.assertEqual(stats.flags["PG_dirty"], 1)
+        self.assertEqual(page_stats(self.prog, 2, 4).pages, 0)
+
+    def pfns(self, *args, **kwds):
+        return [
+            (page.value_() - VMEMMAP) // 32
+            for page in for_each_page_with_flags(self.prog, *args, **kwds)
+        ]
+
+    def test_for_each_page_with_flags(self):
+        self.assertEqual(self.pfns(), [0, 1, 4, 5, 6, 7])
+        self.assertEqual(self.pfns(["PG_dirty"]), [0, 4, 6])
+        self.assertEqual(self.pfns(["PG_dirty"], ["PG_locked"]), [4, 6])
+        self.assertEqual(self.pfns(["PG_dirty"], start_pfn=5), [6])
+        self.assertEqual(self.pfns(clear_flags=["PG_dirty"], end_pfn=6), [1, 5])
+        for page in for_each_page_with_flags(self.prog, ["PG_slab"]):
+            self.assertEqual(page.type_.type_name(), "struct page *")
+
+    def test_no_pageflags(self):
+        # Without enum pageflags, all of the flag bits are used.
+        self.types.remove(self.pageflags_type)
+        self.assertEqual(self.pfns(), [0, 1, 4, 5, 6, 7])
+        self.assertEqual(self.pfns(clear_flags=["PG_dirty"]), [1, 5, 7])
+
+
+PGTABLE_PHYS = 0x100000
+PGTABLE = 0xFFFF888000000000 + PGTABLE_PHYS
+
+
+class TestForEachMappedRange(unittest.TestCase):
+    def setUp(self):
+        P, RW, US, PSE, NX = 0x1, 0x2, 0x4, 0x80, 1 << 63
+        tables = bytearray(4 * 4096)
+
+        def set_entry(table, index, entry):
+            struct.pack_into("<Q", tables, table * 4096 + index * 8, entry)
+
+        # The lower half and PML4 entry 273 in the upper half share a PDPT.
+        set_entry(0, 0, (PGTABLE_PHYS + 0x1000) | P | RW | US)
+        set_entry(0, 273, (PGTABLE_PHYS + 0x1000) | P | RW)
+        set_entry(1, 0, (PGTABLE_PHYS + 0x2000) | P | RW | US)
+        set_entry(2, 2, (PGTABLE_PHYS + 0x3000) | P | RW | US)
+        # Two physically contiguous 2 MB pages.
+        set_entry(2, 3, 0x200000 | P | RW | US | PSE | NX)
+        set_entry(2, 4, 0x400000 | P | RW | US | PSE | NX)
+        for i in range(4):
+            set_entry(3, i, (0x10000 + i * 0x1000) | P | RW | US)
+        set_entry(3, 4, 0x20000 | P | RW | US)
+        set_entry(3, 5, 0x21000 | P | US)
+
+        vmcoreinfo = (
+            b"OSRELEASE=5.0.0\nPAGESIZE=4096\nKERNELOFFSET=0\n"
+            b"SYMBOL(swapper_pg_dir)=%x\n" % PGTABLE
+        )
+        name = b"VMCOREINFO\0"
+        note = (
+            struct.pack("<3I", len(name), len(vmcoreinfo), 0)
+            + name
+            + bytes(-len(name) % 4)
+            + vmcoreinfo
+            + bytes(-len(vmcoreinfo) % 4)
+        )
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE,
+                    [
+                        ElfSection(p_type=PT.NOTE, data=note),
+                        ElfSection(
+                            p_type=PT.LOAD,
+                            vaddr=PGTABLE,
+                            paddr=PGTABLE_PHYS,
+                            data=tables,
+                        ),
+                    ],
+                )
+            )
+            f.flush()
+            self.prog = Program()
+            self.prog.set_core_dump(f.name)
+        mm_type = self.prog.struct_type(
+            "mm_struct",
+            8,
+            (
+                TypeMember(
+                    self.prog.pointer_type(
+                        self.prog.int_type("unsigned long", 8, False)
+                    ),
+                    "pgd",
+                ),
+            ),
+        )
+        self.mm = Object(self.prog, mm_type, value={"pgd": PGTABLE})
+
+    def test_for_each_mapped_range(self):
+        user_ranges = [
+            MappedRange(0x400000, 0x404000, 0x10000, True, True, True, False),
+            MappedRange(0x404000, 0x405000, 0x20000, True, True, True, False),
+            MappedRange(0x405000, 0x406000, 0x21000, False, True, True, False),
+            MappedRange(0x600000, 0xA00000, 0x200000, True, True, False, True),
+        ]
+        kernel_ranges = [
+            r._replace(
+                start=0xFFFF888000000000 + r.start,
+                end=0xFFFF888000000000 + r.end,
+                user=False,
+            )
+            for r in user_ranges
+        ]
+        self.assertEqual(
+            list(for_each_mapped_range(self.mm)), user_ranges + kernel_ranges
+        )
+
+    def test_subrange(self):
+        self.assertEqual(
+            list(for_each_mapped_range(self.mm, 0x401800, 0x405800)),
+            [
+                MappedRange(0x401800, 0x404000, 0x11800, True, True, True, False),
+                MappedRange(0x404000, 0x405000, 0x20000, True, True, True, False),
+                MappedRange(0x405000, 0x405800, 0x21000, False, True, True, False),
+            ],
+        )
+        ranges = list(for_each_mapped_range(self.mm, 0x7FF000))
+        self.assertEqual(
+            ranges[0],
+            MappedRange(0x7FF000, 0xA00000, 0x3FF000, True, True, False, True),
+        )
+        self.assertEqual(len(ranges), 5)
+        self.assertEqual(list(for_each_mapped_range(self.mm, 0x5000, 0x5000)), [])
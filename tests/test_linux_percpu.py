@@ -0,0 +1,139 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import struct
+
+from drgn import Object, OutOfBoundsError, TypeMember
+from drgn.helpers.linux.percpu import (
+    per_cpu_ptr,
+    per_cpu_sum,
+    per_cpu_values,
+    percpu_counter_sum,
+)
+from tests import MockObject, MockProgramTestCase
+
+PER_CPU_OFFSET = 0xFFFF0000
+CPU_POSSIBLE_MASK = 0xFFFF0100
+CPU_ONLINE_MASK = 0xFFFF0108
+PERCPU_COUNTER = 0xFFFF0200
+CPU_OFFSETS = (0x10000, 0x20000, 0x30000, 0x40000)
+STATS = 0x100
+COUNTERS = 0x200
+
+
+class TestPerCpuValues(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        int_type = self.prog.int_type("int", 4, True)
+        long_type = self.prog.int_type("long", 8, True)
+        unsigned_long_type = self.prog.int_type("unsigned long", 8, False)
+        self.stats_type = self.prog.struct_type(
+            "stats",
+            24,
+            (
+                TypeMember(int_type, "a"),
+                TypeMember(self.prog.array_type(unsigned_long_type, 2), "counts", 64),
+            ),
+        )
+        self.percpu_counter_type = self.prog.struct_type(
+            "percpu_counter",
+            16,
+            (
+                TypeMember(long_type, "count"),
+                TypeMember(self.prog.pointer_type(int_type), "counters", 64),
+            ),
+        )
+        self.cpumask_type = self.prog.struct_type(
+            "cpumask",
+            8,
+            (TypeMember(self.prog.array_type(unsigned_long_type, 1), "bits"),),
+        )
+        self.types.extend(
+            (self.stats_type, self.percpu_counter_type, self.cpumask_type)
+        )
+        self.objects.extend(
+            (
+                MockObject(
+                    "__per_cpu_offset",
+                    self.prog.array_type(unsigned_long_type, 4),
+                    address=PER_CPU_OFFSET,
+                ),
+                MockObject(
+                    "__cpu_possible_mask", self.cpumask_type, address=CPU_POSSIBLE_MASK
+                ),
+                MockObject(
+                    "__cpu_online_mask", self.cpumask_type, address=CPU_ONLINE_MASK
+                ),
+                MockObject("stats", self.stats_type, address=STATS),
+            )
+        )
+        self.add_memory_segment(
+            struct.pack("<4Q", *CPU_OFFSETS), virt_addr=PER_CPU_OFFSET
+        )
+        # CPUs 0, 1, and 3 are possible. CPUs 0 and 1 are online.
+        self.add_memory_segment(
+            struct.pack("<QQ", 0b1011, 0b11), virt_addr=CPU_POSSIBLE_MASK
+        )
+        for cpu, offset in enumerate(CPU_OFFSETS):
+            self.add_memory_segment(
+                struct.pack("<i4xQQ", -cpu, cpu, 10 * cpu), virt_addr=STATS + offset
+            )
+            self.add_memory_segment(
+                struct.pack("<i", cpu + 1), virt_addr=COUNTERS + offset
+            )
+        self.add_memory_segment(
+            struct.pack("<qQ", 100, COUNTERS), virt_addr=PERCPU_COUNTER
+        )
+        self.stats = self.prog["stats"].address_of_()
+
+    def test_per_cpu_ptr(self):
+        ptr = per_cpu_ptr(self.stats, 3)
+        self.assertEqual(ptr.type_.type_name(), "struct stats *")
+        self.assertEqual(ptr.value_(), STATS + CPU_OFFSETS[3])
+        self.assertEqual(ptr.counts[1], 30)
+        self.assertRaisesRegex(
+            OutOfBoundsError, "out of range", per_cpu_ptr, self.stats, 4
+        )
+
+    def test_per_cpu_values(self):
+        values = per_cpu_values(self.stats)
+        self.assertEqual(list(values), [0, 1, 3])
+        self.assertEqual(values[3].a, -3)
+        self.assertEqual(values[3].counts[1], 30)
+
+    def test_per_cpu_values_member(self):
+        self.assertEqual(
+            per_cpu_values(self.stats, "counts[1]"),
+            {
+                cpu: Object(self.prog, "unsigned long", value=10 * cpu)
+                for cpu in (0, 1, 3)
+            },
+        )
+        self.assertEqual(
+            per_cpu_values(self.stats, "a", online=True),
+            {
+                0: Object(self.prog, "int", value=0),
+                1: Object(self.prog, "int", value=-1),
+            },
+        )
+
+    def test_per_cpu_values_invalid(self):
+        self.assertRaisesRegex(
+            SyntaxError, "invalid member designator", per_cpu_values, self.stats, "a."
+        )
+        self.assertRaisesRegex(
+            LookupError, "has no member", per_cpu_values, self.stats, "b"
+        )
+        self.assertRaisesRegex(
+            TypeError, "must be a pointer", per_cpu_values, self.prog["stats"]
+        )
+
+    def test_per_cpu_sum(self):
+        self.assertEqual(per_cpu_sum(self.stats, "a"), -4)
+        self.assertEqual(per_cpu_sum(self.stats, "a", online=True), -1)
+        self.assertEqual(per_cpu_sum(self.stats, "counts[0]"), 4)
+        self.assertRaisesRegex(TypeError, "cannot sum", per_cpu_sum, self.stats)
+
+    def test_percpu_counter_sum(self):
+        fbc = Object(self.prog, "struct percpu_counter *", value=PERCPU_COUNTER)
+        self.assertEqual(percpu_counter_sum(fbc), 103)
@@ -0,0 +1,209 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import struct
+
+from drgn import Object, TypeMember
+from drgn.helpers.linux.pid import for_each_pid, for_each_task
+from tests import MockObject, MockProgramTestCase
+
+PID_HASH = 0xFFFF0000
+NS_A = 0xFFFF1000
+NS_B = 0xFFFF1100
+NS_IDR = 0xFFFF1200
+XA_NODE = 0xFFFF1300
+PIDS = 0xFFFF2000
+TASKS = 0xFFFF3000
+
+
+def pid_address(i):
+    return PIDS + i * 0x100
+
+
+def task_address(i):
+    return TASKS + i * 0x100
+
+
+def upid_address(i, level):
+    return pid_address(i) + 8 + 32 * level
+
+
+class TestForEachPid(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        int_type = self.prog.int_type("int", 4, True)
+        unsigned_int_type = self.prog.int_type("unsigned int", 4, False)
+        voidp_type = self.prog.pointer_type(self.prog.void_type())
+        hlist_node_type = self.prog.struct_type(
+            "hlist_node",
+            16,
+            (
+                TypeMember(lambda: self.prog.pointer_type(hlist_node_type), "next"),
+                TypeMember(voidp_type, "pprev", 64),
+            ),
+        )
+        hlist_head_type = self.prog.struct_type(
+            "hlist_head",
+            8,
+            (TypeMember(self.prog.pointer_type(hlist_node_type), "first"),),
+        )
+        xa_node_type = self.prog.struct_type(
+            "xa_node",
+            40,
+            (
+                TypeMember(self.prog.int_type("unsigned char", 1, False), "shift"),
+                TypeMember(self.prog.array_type(voidp_type, 4), "slots", 64),
+            ),
+        )
+        idr_type = self.prog.struct_type(
+            "idr",
+            8,
+            (
+                TypeMember(
+                    self.prog.struct_type(
+                        "radix_tree_root", 8, (TypeMember(voidp_type, "xa_head"),)
+                    ),
+                    "idr_rt",
+                ),
+            ),
+        )
+        # Before Linux v4.15, PID namespaces don't have an IDR.
+        pid_namespace_type = self.prog.struct_type(
+            "pid_namespace", 4, (TypeMember(unsigned_int_type, "level"),)
+        )
+        self.pid_namespace_idr_type = self.prog.struct_type(
+            "pid_namespace",
+            12,
+            (TypeMember(idr_type, "idr"), TypeMember(unsigned_int_type, "level", 64)),
+        )
+        upid_type = self.prog.struct_type(
+            "upid",
+            32,
+            (
+                TypeMember(int_type, "nr"),
+                TypeMember(self.prog.pointer_type(pid_namespace_type), "ns", 64),
+                TypeMember(hlist_node_type, "pid_chain", 128),
+            ),
+        )
+        pid_type = self.prog.struct_type(
+            "pid",
+            72,
+            (
+                TypeMember(self.prog.array_type(hlist_head_type, 1), "tasks"),
+                TypeMember(self.prog.array_type(upid_type, 2), "numbers", 64),
+            ),
+        )
+        task_struct_type = self.prog.struct_type(
+            "task_struct",
+            24,
+            (
+                TypeMember(int_type, "pid"),
+                TypeMember(self.prog.array_type(hlist_node_type, 1), "pid_links", 64),
+            ),
+        )
+        self.types.extend(
+            (upid_type, pid_type, task_struct_type, xa_node_type, pid_namespace_type)
+        )
+        self.objects.extend(
+            (
+                MockObject("PIDTYPE_PID", int_type, value=0),
+                MockObject(
+                    "pid_hash", self.prog.pointer_type(hlist_head_type), value=PID_HASH
+                ),
+                MockObject("pidhash_shift", unsigned_int_type, value=2),
+                MockObject("init_pid_ns", pid_namespace_type, address=NS_A),
+            )
+        )
+        self.ns_a = Object(self.prog, self.prog.pointer_type(pid_namespace_type), NS_A)
+        self.ns_b = Object(self.prog, self.prog.pointer_type(pid_namespace_type), NS_B)
+
+        # PID 1 is only in namespace A. PID 2 is 2 in namespace A and 1 in
+        # namespace B. PID 3 has no task.
+        self.add_memory_segment(struct.pack("<I", 0), virt_addr=NS_A)
+        self.add_memory_segment(struct.pack("<I", 1), virt_addr=NS_B)
+        # Bucket 1: PID 1 -> PID 2 in B, bucket 2: PID 2, bucket 3: PID 3.
+        self.add_memory_segment(
+            struct.pack(
+                "<4Q",
+                0,
+                upid_address(1, 0) + 16,
+                upid_address(2, 0) + 16,
+                upid_address(3, 0) + 16,
+            ),
+            virt_addr=PID_HASH,
+        )
+        upids = {
+            (1, 0): (1, NS_A, upid_address(2, 1) + 16),
+            (2, 0): (2, NS_A, 0),
+            (2, 1): (1, NS_B, 0),
+            (3, 0): (3, NS_A, 0),
+        }
+        pids = bytearray(0x400)
+        for i in (1, 2, 3):
+            first = task_address(i) + 8 if i != 3 else 0
+            struct.pack_into("<Q", pids, pid_address(i) - PIDS, first)
+        for (i, level), (nr, ns, next) in upids.items():
+            struct.pack_into(
+                "<i4xQQQ", pids, upid_address(i, level) - PIDS, nr, ns, next, 0
+            )
+        self.add_memory_segment(pids, virt_addr=PIDS)
+        tasks = bytearray(0x300)
+        for i in (1, 2):
+            struct.pack_into("<i", tasks, task_address(i) - TASKS, i)
+        self.add_memory_segment(tasks, virt_addr=TASKS)
+
+    def test_pid_hash(self):
+        self.assertEqual(
+            [pid.value_() for pid in for_each_pid(self.ns_a)],
+            [pid_address(i) for i in (1, 2, 3)],
+        )
+        self.assertEqual(
+            [pid.value_() for pid in for_each_pid(self.prog)],
+            [pid_address(i) for i in (1, 2, 3)],
+        )
+        self.assertEqual(
+            [pid.value_() for pid in for_each_pid(self.ns_b)], [pid_address(2)]
+        )
+
+    def test_pid_hash_tasks(self):
+        self.assertEqual(
+            [task.pid.value_() for task in for_each_task(self.ns_a)], [1, 2]
+        )
+        self.assertEqual([task.pid.value_() for task in for_each_task(self.ns_b)], [2])
+
+    def test_pid_hash_cycle(self):
+        # Make PID 2 in namespace B point back to PID 1 in bucket 1.
+        self.add_memory_segment(
+            struct.pack("<Q", upid_address(1, 0) + 16),
+            virt_addr=upid_address(2, 1) + 16,
+        )
+        self.assertRaisesRegex(
+            ValueError,
+            "pid_hash chain contains a cycle",
+            list,
+            for_each_pid(self.ns_a),
+        )
+
+    def test_idr(self):
+        self.add_memory_segment(struct.pack("<QI", XA_NODE | 2, 0), virt_addr=NS_IDR)
+        self.add_memory_segment(
+            struct.pack("<B7x4Q", 0, 0, pid_address(1), pid_address(3), 0),
+            virt_addr=XA_NODE,
+        )
+        ns = Object(
+            self.prog, self.prog.pointer_type(self.pid_namespace_idr_type), NS_IDR
+        )
+        self.assertEqual(
+            [pid.value_() for pid in for_each_pid(ns)],
+            [pid_address(1), pid_address(3)],
+        )
+        self.assertEqual([task.pid.value_() for task in for_each_task(ns)], [1])
+
+    def test_lazy(self):
+        # The namespace isn't read until the iterator is advanced.
+        ns = Object(
+            self.prog, self.prog.pointer_type(self.pid_namespace_idr_type), NS_IDR
+        )
+        it = for_each_pid(ns)
+        self.add_memory_segment(struct.pack("<QI", 0, 0), virt_addr=NS_IDR)
+        self.assertEqual(list(it), [])
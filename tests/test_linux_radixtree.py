@@ -0,0 +1,104 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import struct
+
+from drgn import Object, TypeMember
+from drgn.helpers.linux.radixtree import radix_tree_for_each
+from drgn.helpers.linux.xarray import xa_for_each
+from tests import MockProgramTestCase
+
+ROOT = 0xFFFF0000
+NODE_A = 0xFFFF1000
+NODE_B = 0xFFFF2000
+
+
+class TestRadixTree(MockProgramTestCase):
+    def node_type(self, name):
+        # Nodes with 4 slots to keep the test trees small.
+        return self.prog.struct_type(
+            name,
+            40,
+            (
+                TypeMember(self.prog.int_type("unsigned char", 1, False), "shift"),
+                TypeMember(
+                    self.prog.array_type(
+                        self.prog.pointer_type(self.prog.void_type()), 4
+                    ),
+                    "slots",
+                    64,
+                ),
+            ),
+        )
+
+    def setUp(self):
+        super().setUp()
+        self.xa_node_type = self.node_type("xa_node")
+        self.radix_tree_node_type = self.node_type("radix_tree_node")
+        self.xarray_type = self.prog.struct_type(
+            "xarray",
+            8,
+            (TypeMember(self.prog.pointer_type(self.prog.void_type()), "xa_head"),),
+        )
+        self.radix_tree_root_type = self.prog.struct_type(
+            "radix_tree_root",
+            8,
+            (TypeMember(self.prog.pointer_type(self.radix_tree_node_type), "rnode"),),
+        )
+        self.types.extend((self.xa_node_type, self.radix_tree_node_type))
+        self.xa = Object(self.prog, self.prog.pointer_type(self.xarray_type), ROOT)
+        self.radix_tree = Object(
+            self.prog, self.prog.pointer_type(self.radix_tree_root_type), ROOT
+        )
+
+    def add_node(self, address, shift, slots):
+        self.add_memory_segment(struct.pack("<B7x4Q", shift, *slots), virt_addr=address)
+
+    def entries(self, it):
+        return [(index, entry.value_()) for index, entry in it]
+
+    def test_xarray(self):
+        self.add_memory_segment(struct.pack("<Q", NODE_A | 2), virt_addr=ROOT)
+        # Slot 3 is a value entry.
+        self.add_node(NODE_A, 2, (0x10000, 0, NODE_B | 2, 0xB))
+        # Slot 1 is a sibling entry, and slot 2 is a retry entry.
+        self.add_node(NODE_B, 0, (0x20000, 2, 0x402, 0x30000))
+        self.assertEqual(
+            self.entries(xa_for_each(self.xa)),
+            [(0, 0x10000), (8, 0x20000), (11, 0x30000), (12, 0xB)],
+        )
+
+    def test_radix_tree(self):
+        self.add_memory_segment(struct.pack("<Q", NODE_A | 1), virt_addr=ROOT)
+        # Slot 1 is a retry entry.
+        self.add_node(NODE_A, 2, (0x10000, 1, NODE_B | 1, 0))
+        # Slot 1 is a sibling entry pointing to slot 0.
+        self.add_node(NODE_B, 0, (0x20000, (NODE_B + 8) | 1, 0, 0x30000))
+        self.assertEqual(
+            self.entries(radix_tree_for_each(self.radix_tree)),
+            [(0, 0x10000), (8, 0x20000), (11, 0x30000)],
+        )
+
+    def test_root_entry(self):
+        self.add_memory_segment(struct.pack("<Q", 0x10000), virt_addr=ROOT)
+        self.assertEqual(self.entries(xa_for_each(self.xa)), [(0, 0x10000)])
+        self.assertEqual(
+            self.entries(radix_tree_for_each(self.radix_tree)), [(0, 0x10000)]
+        )
+
+    def test_empty(self):
+        self.add_memory_segment(bytes(8), virt_addr=ROOT)
+        self.assertEqual(list(xa_for_each(self.xa)), [])
+        self.assertEqual(list(radix_tree_for_each(self.radix_tree)), [])
+
+    def test_lazy(self):
+        # The root isn't read until the iterator is advanced.
+        it = xa_for_each(self.xa)
+        self.add_memory_segment(bytes(8), virt_addr=ROOT)
+        self.assertEqual(list(it), [])
+
+    def test_invalid_shift(self):
+        self.add_memory_segment(struct.pack("<Q", NODE_A | 2), virt_addr=ROOT)
+        self.add_node(NODE_A, 2, (NODE_B | 2, 0, 0, 0))
+        self.add_node(NODE_B, 2, (0x10000, 0, 0, 0))
+        self.assertRaisesRegex(ValueError, "invalid shift", list, xa_for_each(self.xa))
@@ -0,0 +1,145 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import struct
+
+from drgn import Object, TypeMember
+from drgn.helpers.linux.rbtree import (
+    rbtree_inorder_for_each,
+    rbtree_inorder_for_each_entry,
+)
+from tests import MockProgramTestCase
+
+ROOT = 0xFFFF0000
+ENTRIES = 0xFFFF1000
+
+
+def node_address(key):
+    return ENTRIES + key * 32 + 8
+
+
+class TestRbtree(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        self.rb_node_type = self.prog.struct_type(
+            "rb_node",
+            24,
+            (
+                TypeMember(
+                    self.prog.int_type("unsigned long", 8, False), "__rb_parent_color"
+                ),
+                TypeMember(
+                    lambda: self.prog.pointer_type(self.rb_node_type), "rb_right", 64
+                ),
+                TypeMember(
+                    lambda: self.prog.pointer_type(self.rb_node_type), "rb_left", 128
+                ),
+            ),
+        )
+        self.rb_root_type = self.prog.struct_type(
+            "rb_root",
+            8,
+            (TypeMember(self.prog.pointer_type(self.rb_node_type), "rb_node"),),
+        )
+        self.entry_type = self.prog.struct_type(
+            "entry",
+            32,
+            (
+                TypeMember(self.prog.int_type("int", 4, True), "key"),
+                TypeMember(self.rb_node_type, "node", 64),
+            ),
+        )
+        self.types.append(self.entry_type)
+        self.root = Object(self.prog, self.prog.pointer_type(self.rb_root_type), ROOT)
+
+    def add_tree(self, nodes, root):
+        # nodes maps a key to (parent, left, right) keys.
+        buf = bytearray(32 * (max(nodes) + 1))
+        for key, (parent, left, right) in nodes.items():
+            struct.pack_into(
+                "<iiQQQ",
+                buf,
+                32 * key,
+                key,
+                0,
+                0 if parent is None else node_address(parent) | 1,
+                0 if right is None else node_address(right),
+                0 if left is None else node_address(left),
+            )
+        self.add_memory_segment(buf, virt_addr=ENTRIES)
+        self.add_memory_segment(
+            struct.pack("<Q", 0 if root is None else node_address(root)),
+            virt_addr=ROOT,
+        )
+
+    def add_balanced_tree(self):
+        #       3
+        #     /   \
+        #    1     5
+        #   / \   /
+        #  0   2 4
+        self.add_tree(
+            {
+                3: (None, 1, 5),
+                1: (3, 0, 2),
+                5: (3, 4, None),
+                0: (1, None, None),
+                2: (1, None, None),
+                4: (5, None, None),
+            },
+            3,
+        )
+
+    def test_inorder(self):
+        self.add_balanced_tree()
+        self.assertEqual(
+            [node.value_() for node in rbtree_inorder_for_each(self.root)],
+            [node_address(key) for key in range(6)],
+        )
+        self.assertEqual(
+            [
+                entry.key.value_()
+                for entry in rbtree_inorder_for_each_entry(
+                    "struct entry", self.root, "node"
+                )
+            ],
+            list(range(6)),
+        )
+
+    def test_empty(self):
+        self.add_tree({0: (None, None, None)}, None)
+        self.assertEqual(list(rbtree_inorder_for_each(self.root)), [])
+
+    def test_max_length(self):
+        self.add_balanced_tree()
+        self.assertEqual(len(list(rbtree_inorder_for_each(self.root, max_length=6))), 6)
+        self.assertRaisesRegex(
+            ValueError,
+            "more than 5 nodes",
+            list,
+            rbtree_inorder_for_each(self.root, max_length=5),
+        )
+
+    def test_invalid_parent(self):
+        # Node 2's right child points back up to node 1.
+        self.add_tree({1: (None, None, 2), 2: (1, None, 1)}, 1)
+        self.assertRaisesRegex(
+            ValueError,
+            "has invalid parent",
+            list,
+            rbtree_inorder_for_each(self.root, validate=True),
+        )
+
+    def test_wrong_parent(self):
+        # Node 2's parent pointer points to node 3 instead of node 1.
+        self.add_tree({1: (None, None, 2), 2: (3, None, None)}, 1)
+        self.assertEqual(
+            [node.value_() for node in rbtree_inorder_for_each(self.root)],
+            [node_address(1), node_address(2)],
+        )
+        self.assertRaisesRegex(
+            ValueError,
+            "has invalid parent",
+            list,
+            rbtree_inorder_for_each(self.root, validate=True),
+        )
@@ -0,0 +1,320 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import struct
+
+from drgn import Object, TypeMember
+from drgn.helpers.linux.slab import (
+    find_slab_cache,
+    for_each_allocated_slab_object,
+    for_each_slab_cache,
+    slab_cache_for_each_allocated_object,
+    slab_cache_for_each_free_object,
+    slab_object_info,
+)
+from tests import MockObject, MockProgramTestCase
+
+PAGE_OFFSET = 0xFFFF888000000000
+VMEMMAP = 0xFFFFEA0000000000
+PAGE_STRUCT_SIZE = 48
+PER_CPU_OFFSET = 0xFFFF0000
+CPU_POSSIBLE_MASK = 0xFFFF0100
+CPU_OFFSETS = (0x10000, 0x20000)
+SLAB_CACHES = 0xFFFF0200
+CACHE_A = 0xFFFF1000
+CACHE_B = 0xFFFF1100
+CPU_SLAB_A = 0x100
+CPU_SLAB_B = 0x200
+RANDOM = 0x5A5A5A5A5A5A5A5A
+
+
+def page_address(pfn):
+    return VMEMMAP + pfn * PAGE_STRUCT_SIZE
+
+
+def object_address(pfn, size, i):
+    return PAGE_OFFSET + (pfn << 12) + i * size
+
+
+def swab(value):
+    return int.from_bytes(value.to_bytes(8, "little"), "big")
+
+
+class TestSlab(MockProgramTestCase):
+    hardened = False
+
+    def setUp(self):
+        super().setUp()
+        unsigned_int_type = self.prog.int_type("unsigned int", 4, False)
+        unsigned_long_type = self.prog.int_type("unsigned long", 8, False)
+        void_pointer_type = self.prog.pointer_type(self.prog.void_type())
+        char_pointer_type = self.prog.pointer_type(self.prog.int_type("char", 1, True))
+        self.list_head_type = self.prog.struct_type(
+            "list_head",
+            16,
+            (
+                TypeMember(
+                    lambda: self.prog.pointer_type(self.list_head_type), "next"
+                ),
+                TypeMember(
+                    lambda: self.prog.pointer_type(self.list_head_type), "prev", 64
+                ),
+            ),
+        )
+        self.page_type = self.prog.struct_type(
+            "page",
+            PAGE_STRUCT_SIZE,
+            (
+                TypeMember(unsigned_long_type, "flags"),
+                TypeMember(unsigned_long_type, "compound_head", 64),
+                TypeMember(
+                    lambda: self.prog.pointer_type(self.kmem_cache_type),
+                    "slab_cache",
+                    128,
+                ),
+                TypeMember(void_pointer_type, "freelist", 192),
+                TypeMember(
+                    self.prog.struct_type(
+                        None,
+                        4,
+                        (
+                            TypeMember(
+                                Object(self.prog, unsigned_int_type, bit_field_size=16),
+                                "inuse",
+                            ),
+                            TypeMember(
+                                Object(self.prog, unsigned_int_type, bit_field_size=15),
+                                "objects",
+                                16,
+                            ),
+                            TypeMember(
+                                Object(self.prog, unsigned_int_type, bit_field_size=1),
+                                "frozen",
+                                31,
+                            ),
+                        ),
+                    ),
+                    None,
+                    256,
+                ),
+            ),
+        )
+        self.kmem_cache_cpu_type = self.prog.struct_type(
+            "kmem_cache_cpu",
+            16,
+            (
+                TypeMember(self.prog.pointer_type(void_pointer_type), "freelist"),
+                TypeMember(self.prog.pointer_type(self.page_type), "page", 64),
+            ),
+        )
+        members = [
+            TypeMember(self.prog.pointer_type(self.kmem_cache_cpu_type), "cpu_slab"),
+            TypeMember(unsigned_int_type, "size", 64),
+            TypeMember(unsigned_int_type, "offset", 96),
+            TypeMember(char_pointer_type, "name", 128),
+            TypeMember(self.list_head_type, "list", 192),
+        ]
+        if self.hardened:
+            members.append(TypeMember(unsigned_long_type, "random", 320))
+        self.kmem_cache_type = self.prog.struct_type("kmem_cache", 48, members)
+        self.cpumask_type = self.prog.struct_type(
+            "cpumask",
+            8,
+            (TypeMember(self.prog.array_type(unsigned_long_type, 1), "bits"),),
+        )
+        self.types.extend(
+            (
+                self.list_head_type,
+                self.page_type,
+                self.kmem_cache_cpu_type,
+                self.kmem_cache_type,
+                self.cpumask_type,
+            )
+        )
+        self.objects.extend(
+            (
+                MockObject("PAGE_OFFSET", unsigned_long_type, value=PAGE_OFFSET),
+                MockObject("PG_slab", unsigned_int_type, value=3),
+                MockObject(
+                    "vmemmap", self.prog.pointer_type(self.page_type), value=VMEMMAP
+                ),
+                MockObject("max_pfn", unsigned_long_type, value=5),
+                MockObject(
+                    "__per_cpu_offset",
+                    self.prog.array_type(unsigned_long_type, 4),
+                    address=PER_CPU_OFFSET,
+                ),
+                MockObject(
+                    "__cpu_possible_mask", self.cpumask_type, address=CPU_POSSIBLE_MASK
+                ),
+                MockObject("slab_caches", self.list_head_type, address=SLAB_CACHES),
+            )
+        )
+
+        # Only the first two of four CPUs are possible.
+        self.add_memory_segment(
+            struct.pack("<4Q", *CPU_OFFSETS, 0, 0), virt_addr=PER_CPU_OFFSET
+        )
+        self.add_memory_segment(struct.pack("<Q", 0b11), virt_addr=CPU_POSSIBLE_MASK)
+
+        def cache(cpu_slab, size, offset, name, next, prev):
+            return struct.pack(
+                "<QIIQQQQ",
+                cpu_slab,
+                size,
+                offset,
+                name,
+                next,
+                prev,
+                RANDOM if self.hardened else 0,
+            )
+
+        self.add_memory_segment(
+            struct.pack("<QQ", CACHE_A + 24, CACHE_B + 24), virt_addr=SLAB_CACHES
+        )
+        self.add_memory_segment(
+            cache(CPU_SLAB_A, 256, 0, 0xFFFF2000, CACHE_B + 24, SLAB_CACHES),
+            virt_addr=CACHE_A,
+        )
+        self.add_memory_segment(
+            cache(CPU_SLAB_B, 1024, 8, 0xFFFF2010, SLAB_CACHES, CACHE_A + 24),
+            virt_addr=CACHE_B,
+        )
+        self.add_memory_segment(b"kmalloc-256\0", virt_addr=0xFFFF2000)
+        self.add_memory_segment(b"kmalloc-1k\0", virt_addr=0xFFFF2010)
+
+        # CPU 1 is using the slab in PFN 1 for cache A. CPU 0 is using the
+        # full slab in PFN 3 for cache B.
+        def cpu_slab(freelist, page):
+            return struct.pack("<QQ", freelist, page)
+
+        self.add_memory_segment(cpu_slab(0, 0), virt_addr=CPU_SLAB_A + CPU_OFFSETS[0])
+        self.add_memory_segment(
+            cpu_slab(object_address(1, 256, 0), page_address(1)),
+            virt_addr=CPU_SLAB_A + CPU_OFFSETS[1],
+        )
+        self.add_memory_segment(
+            cpu_slab(0, page_address(3)), virt_addr=CPU_SLAB_B + CPU_OFFSETS[0]
+        )
+        self.add_memory_segment(cpu_slab(0, 0), virt_addr=CPU_SLAB_B + CPU_OFFSETS[1])
+
+        def page(flags, compound_head=0, slab_cache=0, freelist=0, objects=0):
+            return struct.pack(
+                "<QQQQI12x", flags, compound_head, slab_cache, freelist, objects << 16
+            )
+
+        def slab_page(slab_cache, objects, freelist=0):
+            return page(1 << 3, 0, slab_cache, freelist, objects)
+
+        # PFN 2 isn't a slab. PFNs 3 and 4 are one slab of order 1.
+        self.add_memory_segment(
+            slab_page(CACHE_A, 16, object_address(0, 256, 3))
+            + slab_page(CACHE_A, 16, object_address(1, 256, 2))
+            + page(0)
+            + slab_page(CACHE_B, 8)
+            + page(0, compound_head=page_address(3) | 1),
+            virt_addr=VMEMMAP,
+        )
+
+        # Free objects: 3 and 7 in PFN 0 and 0, 2, and 5 in PFN 1.
+        self.add_memory_segment(
+            self.slab(0, {3: 7, 7: None}), virt_addr=object_address(0, 256, 0)
+        )
+        self.add_memory_segment(
+            self.slab(1, {0: 5, 5: None, 2: None}),
+            virt_addr=object_address(1, 256, 0),
+        )
+
+    def slab(self, pfn, freelist):
+        buf = bytearray(4096)
+        for i, next in freelist.items():
+            ptr = 0 if next is None else object_address(pfn, 256, next)
+            if self.hardened:
+                ptr ^= RANDOM ^ swab(object_address(pfn, 256, i))
+            struct.pack_into("<Q", buf, i * 256, ptr)
+        return buf
+
+    def test_for_each_slab_cache(self):
+        self.assertEqual(
+            [s.value_() for s in for_each_slab_cache(self.prog)], [CACHE_A, CACHE_B]
+        )
+
+    def test_find_slab_cache(self):
+        self.assertEqual(find_slab_cache(self.prog, "kmalloc-1k").value_(), CACHE_B)
+        self.assertIsNone(find_slab_cache(self.prog, "kmalloc-512"))
+
+    def test_allocated_objects(self):
+        cache = Object(self.prog, "struct kmem_cache *", value=CACHE_A)
+        objects = list(slab_cache_for_each_allocated_object(cache, "int"))
+        self.assertEqual(
+            [obj.value_() for obj in objects],
+            [object_address(0, 256, i) for i in range(16) if i not in (3, 7)]
+            + [object_address(1, 256, i) for i in range(16) if i not in (0, 2, 5)],
+        )
+        self.assertEqual(objects[0].type_.type_name(), "int *")
+
+    def test_free_objects(self):
+        cache = Object(self.prog, "struct kmem_cache *", value=CACHE_A)
+        self.assertEqual(
+            [obj.value_() for obj in slab_cache_for_each_free_object(cache, "int")],
+            [
+                object_address(0, 256, 3),
+                object_address(0, 256, 7),
+                object_address(1, 256, 0),
+                object_address(1, 256, 2),
+                object_address(1, 256, 5),
+            ],
+        )
+        cache = Object(self.prog, "struct kmem_cache *", value=CACHE_B)
+        self.assertEqual(list(slab_cache_for_each_free_object(cache, "int")), [])
+
+    def test_for_each_allocated_slab_object(self):
+        counts = {}
+        for cache, obj in for_each_allocated_slab_object(self.prog):
+            counts[cache.value_()] = counts.get(cache.value_(), 0) + 1
+        self.assertEqual(counts, {CACHE_A: 27, CACHE_B: 8})
+
+    def test_slab_object_info(self):
+        info = slab_object_info(self.prog, object_address(0, 256, 5) + 10)
+        self.assertEqual(info.slab_cache.value_(), CACHE_A)
+        self.assertEqual(info.slab.value_(), page_address(0))
+        self.assertEqual(info.address, object_address(0, 256, 5))
+        self.assertTrue(info.allocated)
+
+        self.assertFalse(
+            slab_object_info(self.prog, object_address(0, 256, 7)).allocated
+        )
+        self.assertFalse(
+            slab_object_info(self.prog, object_address(1, 256, 0) + 255).allocated
+        )
+
+    def test_slab_object_info_tail_page(self):
+        info = slab_object_info(self.prog, object_address(3, 1024, 5) + 1)
+        self.assertEqual(info.slab_cache.value_(), CACHE_B)
+        self.assertEqual(info.slab.value_(), page_address(3))
+        self.assertEqual(info.address, object_address(3, 1024, 5))
+        self.assertTrue(info.allocated)
+
+    def test_slab_object_info_repeated(self):
+        # The allocator state is reused between calls, so alternate between
+        # slabs and caches.
+        objects = [
+            (CACHE_A, object_address(pfn, 256, i), i not in free)
+            for pfn, free in ((0, (3, 7)), (1, (0, 2, 5)))
+            for i in range(16)
+        ] + [(CACHE_B, object_address(3, 1024, i), True) for i in range(8)]
+        for _ in range(2):
+            for cache, address, allocated in objects[::2] + objects[1::2]:
+                info = slab_object_info(self.prog, address)
+                self.assertEqual(info.slab_cache.value_(), cache)
+                self.assertEqual(info.address, address)
+                self.assertEqual(info.allocated, allocated)
+
+    def test_slab_object_info_not_slab(self):
+        self.assertIsNone(slab_object_info(self.prog, object_address(2, 256, 0)))
+        self.assertIsNone(slab_object_info(self.prog, object_address(7, 256, 0)))
+        self.assertIsNone(slab_object_info(self.prog, 0xFFFF0000))
+
+
+class TestSlabHardened(TestSlab):
+    hardened = True
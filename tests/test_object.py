@@ -1,6 +1,7 @@
 # Copyright (c) Facebook, Inc. and its affiliates.
 # SPDX-License-Identifier: GPL-3.0+
 
+import array
 import math
 import operator
 import struct
@@ -14,6 +15,7 @@ from drgn import (
     Type,
     TypeMember,
     cast,
+    memcmp,
     reinterpret,
     sizeof,
 )
@@ -443,6 +445,31 @@ class TestReference(MockProgramTestCase):
             Object(self.prog, self.point_type, address=0xFFFF0004),
         )
 
+    def test_buffer(self):
+        self.add_memory_segment(struct.pack("<4i", 1, 2, 3, 4), virt_addr=0xFFFF0000)
+        obj = Object(self.prog, "int [4]", address=0xFFFF0000)
+        self.assertEqual(memoryview(obj).tobytes(), struct.pack("<4i", 1, 2, 3, 4))
+        self.assertEqual(struct.unpack_from("<4i", obj), (1, 2, 3, 4))
+        obj = Object(self.prog, self.line_segment_type, address=0xFFFF0000)
+        self.assertEqual(bytes(obj.b), struct.pack("<2i", 3, 4))
+        self.assertTrue(memoryview(obj).readonly)
+
+        self.assertRaises(
+            FaultError, memoryview, Object(self.prog, "int [4]", address=0xFFFF0004)
+        )
+        self.assertRaisesRegex(
+            TypeError,
+            "'int' is not an array",
+            memoryview,
+            Object(self.prog, "int", address=0xFFFF0000),
+        )
+        self.assertRaisesRegex(
+            TypeError,
+            "incomplete",
+            memoryview,
+            Object(self.prog, "int []", address=0xFFFF0000),
+        )
+
 
 class TestValue(MockProgramTestCase):
     def test_positional(self):
@@ -781,6 +808,16 @@ class TestValue(MockProgramTestCase):
             ValueError, "non-scalar must be byte-aligned", obj.member_, "point"
         )
 
+    def test_buffer(self):
+        obj = Object(self.prog, self.point_type, value={"x": 1, "y": -2})
+        self.assertEqual(bytes(obj), struct.pack("<2i", 1, -2))
+        obj = Object(self.prog, "int [4]", value=[1, 2, 3, 4])
+        self.assertEqual(memoryview(obj).cast("i").tolist(), [1, 2, 3, 4])
+        self.assertRaises(TypeError, memoryview, Object(self.prog, "int", value=1))
+        self.assertRaises(
+            ObjectAbsentError, memoryview, Object(self.prog, self.point_type)
+        )
+
 
 class TestAbsent(MockProgramTestCase):
     def test_basic(self):
@@ -1147,6 +1184,87 @@ class TestGenericOperators(MockProgramTestCase):
             ),
         )
 
+    def test_memcmp(self):
+        arr = Object(self.prog, "int [2]", address=0xFFFF0000)
+        other = Object(self.prog, "int [2]", address=0xFFFF0008)
+        self.assertEqual(memcmp(arr, arr.read_()), 0)
+        self.assertEqual(memcmp(arr, other), -1)
+        self.assertEqual(memcmp(other.read_(), arr), 1)
+
+        # Padding is ignored.
+        padded_type = self.prog.struct_type(
+            "padded",
+            8,
+            (
+                TypeMember(self.prog.int_type("char", 1, True), "c"),
+                TypeMember(self.prog.int_type("int", 4, True), "i", 32),
+            ),
+        )
+        self.add_memory_segment(b"\0\xff\xff\xff\x01\0\0\0", virt_addr=0xFFFF1000)
+        self.assertEqual(
+            memcmp(
+                Object(self.prog, padded_type, address=0xFFFF1000),
+                Object(self.prog, padded_type, {"c": 0, "i": 1}),
+            ),
+            0,
+        )
+
+        self.assertRaisesRegex(
+            TypeError, "requires structure", memcmp, arr[0], other[0]
+        )
+        self.assertRaisesRegex(
+            ValueError,
+            "different sizes",
+            memcmp,
+            arr,
+            Object(self.prog, "int [3]", address=0xFFFF0000),
+        )
+        self.assertRaisesRegex(
+            TypeError,
+            "different types",
+            memcmp,
+            arr,
+            Object(self.prog, "unsigned int [2]", address=0xFFFF0000),
+        )
+
+        # Equivalent definitions of a structure are the same type.
+        self.assertEqual(
+            memcmp(
+                Object(self.prog, padded_type, address=0xFFFF1000),
+                Object(
+                    self.prog,
+                    self.prog.struct_type(
+                        "padded",
+                        8,
+                        (
+                            TypeMember(self.prog.int_type("char", 1, True), "c"),
+                            TypeMember(self.prog.int_type("int", 4, True), "i", 32),
+                        ),
+                    ),
+                    {"c": 0, "i": 1},
+                ),
+            ),
+            0,
+        )
+        self.assertRaisesRegex(
+            TypeError,
+            "different types",
+            memcmp,
+            Object(self.prog, padded_type, address=0xFFFF1000),
+            Object(
+                self.prog,
+                self.prog.struct_type(
+                    "padded",
+                    8,
+                    (
+                        TypeMember(self.prog.int_type("char", 1, True), "d"),
+                        TypeMember(self.prog.int_type("int", 4, True), "i", 32),
+                    ),
+                ),
+                {"d": 0, "i": 1},
+            ),
+        )
+
     def test_member(self):
         reference = Object(self.prog, self.point_type, address=0xFFFF0000)
         unnamed_reference = Object(
@@ -1334,3 +1452,123 @@ class TestSpecialMethods(MockProgramTestCase):
             iter,
             Object(self.prog, "int []", address=0),
         )
+
+
+class TestAccessor(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        self.node_type = self.prog.struct_type(
+            "node",
+            24,
+            (
+                TypeMember(self.prog.array_type(self.point_type, 2), "pts", 0),
+                TypeMember(
+                    lambda: self.prog.pointer_type(self.node_type),
+                    "next",
+                    128,
+                ),
+            ),
+        )
+        self.add_memory_segment(
+            struct.pack("<4iQ4iQ", 1, 2, 3, 4, 0xFFFF0018, 5, 6, 7, 8, 0),
+            virt_addr=0xFFFF0000,
+        )
+
+    def test_call(self):
+        accessor = self.prog.accessor(self.node_type, "pts[1].y")
+        self.assertIdentical(accessor.type_, self.point_type.members[1].type)
+        expected = Object(self.prog, "int", address=0xFFFF000C)
+        self.assertIdentical(accessor(0xFFFF0000), expected)
+        self.assertIdentical(
+            accessor(Object(self.prog, self.node_type, address=0xFFFF0000)), expected
+        )
+
+        accessor = self.prog.accessor(
+            self.prog.pointer_type(self.node_type), "next->pts[0].x"
+        )
+        ptr = Object(
+            self.prog, self.prog.pointer_type(self.node_type), value=0xFFFF0000
+        )
+        self.assertIdentical(
+            accessor(ptr), Object(self.prog, "int", address=0xFFFF0018)
+        )
+        self.assertEqual(accessor.read(ptr), 5)
+
+    def test_batch(self):
+        accessor = self.prog.accessor(self.node_type, "next.pts[1]")
+        objects = accessor.objects([0xFFFF0000, 0xFFFF0000])
+        self.assertEqual(len(objects), 2)
+        for obj in objects:
+            self.assertIdentical(
+                obj, Object(self.prog, self.point_type, address=0xFFFF0020)
+            )
+        accessor = self.prog.accessor(self.node_type, "pts[0].y")
+        self.assertEqual(accessor.values([0xFFFF0000, 0xFFFF0018]), [2, 6])
+        self.assertEqual(accessor.values([]), [])
+        self.assertRaises(FaultError, accessor.values, [0xFFFF0000, 0])
+
+    def test_columns(self):
+        xs, next_xs, pts = self.prog.columns(
+            self.node_type,
+            ["pts[0].x", self.prog.accessor(self.node_type, "next->pts[1].x"), "pts"],
+            [0xFFFF0000],
+        )
+        self.assertEqual(xs, array.array("q", [1]))
+        self.assertEqual(next_xs, array.array("q", [7]))
+        self.assertEqual(pts, [struct.pack("<4i", 1, 2, 3, 4)])
+
+        xs, nexts = self.prog.columns(
+            self.prog.pointer_type(self.node_type),
+            ["pts[1].x", "next"],
+            [0xFFFF0000, 0xFFFF0018],
+        )
+        self.assertEqual(xs, array.array("q", [3, 7]))
+        self.assertEqual(nexts, array.array("Q", [0xFFFF0018, 0]))
+
+        self.assertEqual(self.prog.columns(self.node_type, [], [0]), [])
+        self.assertRaises(
+            FaultError, self.prog.columns, self.node_type, ["pts"], [0xFFFF0000, 0]
+        )
+
+    def test_columns_string(self):
+        self.add_memory_segment(b"foo\0\0\0\0\0barbazqu", virt_addr=0xFFFE0000)
+        self.assertEqual(
+            self.prog.columns("char [8]", ["[0]"], [0xFFFE0000, 0xFFFE0008]),
+            [array.array("q", [ord("f"), ord("b")])],
+        )
+        self.assertEqual(
+            self.prog.columns(
+                self.prog.struct_type(
+                    "foo",
+                    8,
+                    (TypeMember(self.prog.type("char [8]"), "s"),),
+                ),
+                ["s"],
+                [0xFFFE0000, 0xFFFE0008],
+            ),
+            [[b"foo", b"barbazqu"]],
+        )
+
+    def test_errors(self):
+        self.assertRaisesRegex(
+            LookupError,
+            "'struct node' has no member 'foo'",
+            self.prog.accessor,
+            self.node_type,
+            "foo",
+        )
+        self.assertRaisesRegex(
+            TypeError,
+            "is not a pointer",
+            self.prog.accessor,
+            self.node_type,
+            "pts[0]->x",
+        )
+        self.assertRaises(SyntaxError, self.prog.accessor, self.node_type, "pts[")
+        self.assertRaises(SyntaxError, self.prog.accessor, self.node_type, "pts x")
+        self.assertRaisesRegex(
+            TypeError,
+            "is not an integer",
+            self.prog.accessor(self.node_type, "pts[0]").read,
+            0xFFFF0000,
+        )
@@ -0,0 +1,179 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+from drgn import NULL, Object, TypeMember, object_graph
+from tests import MockProgramTestCase
+
+NODE_SIZE = 32
+
+
+def node_address(i):
+    return 0xFFFF0000 + i * NODE_SIZE
+
+
+class TestObjectGraph(MockProgramTestCase):
+    def setUp(self):
+        super().setUp()
+        self.node_type = self.prog.struct_type(
+            "node",
+            NODE_SIZE,
+            (
+                TypeMember(self.prog.int_type("int", 4, True), "value"),
+                TypeMember(lambda: self.prog.pointer_type(self.node_type), "next", 64),
+                TypeMember(
+                    lambda: self.prog.array_type(
+                        self.prog.pointer_type(self.node_type), 2
+                    ),
+                    "children",
+                    128,
+                ),
+            ),
+        )
+        # node 0 -> next: 1, children: [2, NULL]
+        # node 1 -> next: 0, children: [NULL, 3]
+        # node 2 -> next: 3
+        # node 3 -> children: [0xdead0000 (unmapped), NULL]
+        edges = [
+            (1, 2, None),
+            (0, None, 3),
+            (3, None, None),
+            (None, 0xDEAD0000, None),
+        ]
+        buf = bytearray()
+        for i, pointers in enumerate(edges):
+            buf.extend(i.to_bytes(8, "little"))
+            for p in pointers:
+                if p is None:
+                    p = 0
+                elif p < len(edges):
+                    p = node_address(p)
+                buf.extend(p.to_bytes(8, "little"))
+        self.add_memory_segment(buf, virt_addr=node_address(0))
+        self.root = Object(
+            self.prog, self.prog.pointer_type(self.node_type), value=node_address(0)
+        )
+
+    def graph(self, *args, **kwds):
+        return [
+            (address, type_.type_name(), path)
+            for address, type_, path in object_graph(*args, **kwds)
+        ]
+
+    def test_breadth_first(self):
+        self.assertEqual(
+            self.graph(self.root),
+            [
+                (node_address(0), "struct node", ""),
+                (node_address(1), "struct node", "->next"),
+                (node_address(2), "struct node", "->children[0]"),
+                (node_address(3), "struct node", "->next->children[1]"),
+                (0xDEAD0000, "struct node", "->next->children[1]->children[0]"),
+            ],
+        )
+
+    def test_depth_first(self):
+        self.assertEqual(
+            [address for address, _, _ in self.graph(self.root, depth_first=True)],
+            [
+                node_address(0),
+                node_address(1),
+                node_address(3),
+                0xDEAD0000,
+                node_address(2),
+            ],
+        )
+
+    def test_depth_first_paths(self):
+        self.assertEqual(
+            [path for _, _, path in self.graph(self.root, depth_first=True)],
+            [
+                "",
+                "->next",
+                "->next->children[1]",
+                "->next->children[1]->children[0]",
+                "->children[0]",
+            ],
+        )
+
+    def test_no_paths(self):
+        self.assertEqual(
+            self.graph(self.root, paths=False),
+            [
+                (address, type_name, None)
+                for address, type_name, _ in self.graph(self.root)
+            ],
+        )
+
+    def test_max_depth(self):
+        self.assertEqual(
+            [path for _, _, path in self.graph(self.root, 1)],
+            ["", "->next", "->children[0]"],
+        )
+        self.assertEqual([path for _, _, path in self.graph(self.root, 0)], [""])
+
+    def test_members(self):
+        self.assertEqual(
+            [path for _, _, path in self.graph(self.root, members=["children"])],
+            ["", "->children[0]"],
+        )
+        self.assertEqual(
+            [path for _, _, path in self.graph(self.root, members=["next"])],
+            ["", "->next"],
+        )
+
+    def test_types(self):
+        self.assertEqual(len(self.graph(self.root, types=[self.node_type])), 5)
+        self.assertEqual(
+            len(self.graph(self.root, types=[self.prog.struct_type("node")])), 5
+        )
+        self.assertEqual(
+            len(self.graph(self.root, types=[self.prog.struct_type("other")])), 1
+        )
+
+    def test_reference_root(self):
+        self.assertEqual(
+            self.graph(Object(self.prog, self.node_type, address=node_address(0))),
+            self.graph(self.root),
+        )
+
+    def test_null_root(self):
+        self.assertEqual(
+            self.graph(NULL(self.prog, self.prog.pointer_type(self.node_type))), []
+        )
+
+    def test_fault(self):
+        self.assertEqual(
+            self.graph(Object(self.prog, self.node_type, address=0xDEAD0000)),
+            [(0xDEAD0000, "struct node", "")],
+        )
+
+    def test_reentrant_next(self):
+        it = object_graph(self.root)
+        errors = []
+        buf = self.prog.read(node_address(0), 4 * NODE_SIZE)
+
+        def read_nodes(address, count, offset, physical):
+            try:
+                next(it)
+            except ValueError as e:
+                errors.append(str(e))
+            return buf[offset : offset + count]
+
+        self.prog.add_memory_segment(node_address(0), len(buf), read_nodes)
+        self.assertEqual(len(list(it)), 5)
+        self.assertTrue(errors)
+        self.assertEqual(set(errors), {"iterator already executing"})
+
+    def test_invalid_root(self):
+        self.assertRaisesRegex(
+            TypeError,
+            "must be a pointer or reference",
+            object_graph,
+            Object(self.prog, "int", value=1),
+        )
+        self.assertRaisesRegex(
+            TypeError,
+            "must be a complete structure, union, or class",
+            object_graph,
+            Object(self.prog, "int *", value=node_address(0)),
+        )
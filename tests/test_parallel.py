@@ -0,0 +1,117 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+# SPDX-License-Identifier: GPL-3.0+
+
+import os
+
+from drgn import Object, parallel_map
+from tests import MockMemorySegment, TestCase, mock_program
+
+
+class TestParallelMap(TestCase):
+    def setUp(self):
+        super().setUp()
+        self.prog = mock_program(
+            segments=[
+                MockMemorySegment(
+                    b"".join(i.to_bytes(4, "little") for i in range(1000)),
+                    virt_addr=0xFFFF0000,
+                )
+            ]
+        )
+
+    def elements(self, n=1000):
+        arr = Object(self.prog, "int [1000]", address=0xFFFF0000)
+        return (arr[i] for i in range(n))
+
+    def test_map(self):
+        for workers in (1, 3, 8):
+            for chunksize in (1, 7, 2000):
+                self.assertEqual(
+                    list(
+                        parallel_map(
+                            self.prog,
+                            lambda x: x.value_() * 2,
+                            self.elements(),
+                            workers=workers,
+                            chunksize=chunksize,
+                        )
+                    ),
+                    [i * 2 for i in range(1000)],
+                )
+
+    def test_sequence(self):
+        arr = Object(self.prog, "int [1000]", address=0xFFFF0000)
+        for workers in (1, 3, 8):
+            for chunksize in (1, 7, 2000):
+                self.assertEqual(
+                    list(
+                        parallel_map(
+                            self.prog,
+                            lambda i: arr[i].value_() * 2,
+                            range(1000),
+                            workers=workers,
+                            chunksize=chunksize,
+                        )
+                    ),
+                    [i * 2 for i in range(1000)],
+                )
+
+    def test_partitions(self):
+        arr = Object(self.prog, "int [1000]", address=0xFFFF0000)
+        partitions = [
+            range(start, min(start + 300, 1000)) for start in range(0, 1000, 300)
+        ]
+        self.assertEqual(
+            sum(
+                parallel_map(
+                    self.prog,
+                    lambda r: sum(arr[i].value_() for i in r),
+                    partitions,
+                    workers=2,
+                    chunksize=1,
+                )
+            ),
+            sum(range(1000)),
+        )
+
+    def test_empty(self):
+        self.assertEqual(
+            list(parallel_map(self.prog, lambda x: x, self.elements(0), workers=4)),
+            [],
+        )
+
+    def test_workers_differ(self):
+        pids = set(
+            parallel_map(
+                self.prog, lambda x: os.getpid(), self.elements(), chunksize=10
+            )
+        )
+        self.assertNotIn(os.getpid(), pids)
+
+    def test_exception(self):
+        def f(x):
+            if x.value_() == 500:
+                raise ValueError("bad element")
+            return x.value_()
+
+        it = parallel_map(self.prog, f, self.elements(), workers=4, chunksize=16)
+        self.assertEqual([next(it) for _ in range(496)], list(range(496)))
+        self.assertRaisesRegex(ValueError, "bad element", list, it)
+
+    def test_unpicklable_result(self):
+        self.assertRaises(
+            TypeError, list, parallel_map(self.prog, lambda x: x, self.elements())
+        )
+
+    def test_close(self):
+        it = parallel_map(self.prog, lambda x: x.value_(), self.elements(), workers=2)
+        self.assertEqual(next(it), 0)
+        it.close()
+
+    def test_invalid(self):
+        self.assertRaises(
+            ValueError, list, parallel_map(self.prog, id, [], workers=0)
+        )
+        self.assertRaises(
+            ValueError, list, parallel_map(self.prog, id, [], chunksize=0)
+        )
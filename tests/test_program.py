@@ -1,6 +1,7 @@
 # Copyright (c) Facebook, Inc. and its affiliates.
 # SPDX-License-Identifier: GPL-3.0+
 
+from concurrent.futures import ThreadPoolExecutor
 import ctypes
 import itertools
 import os
@@ -297,6 +298,15 @@ class TestMemory(TestCase):
         segment1.assert_not_called()
         segment2.assert_called_once_with(0xFFFF0000, 128, 0, False)
 
+    def test_concurrent_python_reads(self):
+        data = b"hello, world"
+        prog = mock_program(segments=[MockMemorySegment(data, virt_addr=0xFFFF0000)])
+        with ThreadPoolExecutor(4) as executor:
+            for result in executor.map(
+                lambda _: prog.read(0xFFFF0000, len(data)), range(64)
+            ):
+                self.assertEqual(result, data)
+
     def test_invalid_read_fn(self):
         prog = mock_program()
 
@@ -549,6 +559,12 @@ class TestTypes(MockProgramTestCase):
             self.prog.array_type(self.prog.int_type("int", 4, True), 32),
         )
 
+    def test_array_hexadecimal_letters(self):
+        self.assertIdentical(
+            self.prog.type("int [0xaB]"),
+            self.prog.array_type(self.prog.int_type("int", 4, True), 171),
+        )
+
     def test_array_octal(self):
         self.assertIdentical(
             self.prog.type("int [020]"),
@@ -767,6 +783,31 @@ class TestCoreDump(TestCase):
         self.assertEqual(prog.read(0xFFFF0000, len(data)), data)
         self.assertEqual(prog.read(0xA0, len(data), physical=True), data)
 
+    def test_concurrent_reads(self):
+        segments = [
+            (0xFFFF0000 + i * 0x1000, bytes([i]) * (0x100 + i)) for i in range(16)
+        ]
+        prog = Program()
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(
+                create_elf_file(
+                    ET.CORE,
+                    [
+                        ElfSection(p_type=PT.LOAD, vaddr=address, data=data)
+                        for address, data in segments
+                    ],
+                )
+            )
+            f.flush()
+            prog.set_core_dump(f.name)
+
+        def read_all(_):
+            return [prog.read(address, len(data)) for address, data in segments]
+
+        with ThreadPoolExecutor(8) as executor:
+            for result in executor.map(read_all, range(64)):
+                self.assertEqual(result, [data for _, data in segments])
+
     def test_zero_fill(self):
         data = b"hello, world"
         prog = Program()
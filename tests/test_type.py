@@ -562,6 +562,9 @@ class TestType(MockProgramTestCase):
             t.member("y"), TypeMember(self.prog.int_type("int", 4, True), "y", 32)
         )
         self.assertRaises(LookupError, t.member, "z")
+        # Names of other types and members are interned but still not members.
+        self.assertRaises(LookupError, t.member, "int")
+        self.assertRaises(LookupError, t.members[1].type.member, "x")
 
         self.assertIdentical(
             t.members[1].type.member("y"),
@@ -569,6 +572,7 @@ class TestType(MockProgramTestCase):
         )
 
         self.assertRaises(TypeError, self.prog.int_type("int", 4, True).member, "foo")
+        self.assertRaises(TypeError, self.prog.int_type("int", 4, True).member, "x")
 
     def test_offsetof(self):
         self.assertEqual(offsetof(self.line_segment_type, "b"), 8)